@@ -0,0 +1,799 @@
+/* *****************************************************************************
+ *
+ * Copyright (c) 2012-2023 Alexis Naveros.
+ * Portions developed under contract to the SURVICE Engineering Company.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * *****************************************************************************
+ */
+
+
+/*
+ * Decimation and optimization benchmark suite.
+ *
+ * A fixed corpus of generated meshes, a tessellated sphere, a noisy terrain
+ * grid, a CAD-like box of flat faces and sharp edges, and a terrain with
+ * non-manifold fins, plus any mesh file given with -i. Each mesh is decimated
+ * by mdMeshDecimation() and reordered by moOptimizeMesh() at thread counts
+ * from 1 to the maximum, reporting triangles per second, parallel efficiency
+ * relative to the single thread run, and peak resident memory.
+ *
+ * On Linux, the cache misses of each decimation are sampled through
+ * perf_event_open() and reported per collapse, to compare the vertex storage
+ * layouts selected by MMESH_SPLIT_VERTEX_QUADRICS. The peak resident memory
+ * is reset before each run through /proc/self/clear_refs, elsewhere it is the
+ * peak of the whole process.
+ */
+
+#if defined(__linux__)
+ #define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#if defined(__linux__)
+ #include <unistd.h>
+ #include <sys/ioctl.h>
+ #include <sys/syscall.h>
+ #include <linux/perf_event.h>
+ #define BENCH_PERF_SUPPORT (1)
+#else
+ #define BENCH_PERF_SUPPORT (0)
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+ #include <sys/resource.h>
+ #define BENCH_RUSAGE_SUPPORT (1)
+#else
+ #define BENCH_RUSAGE_SUPPORT (0)
+#endif
+
+#include "meshdecimation.h"
+#include "meshoptimizer.h"
+#include "meshloader.h"
+
+
+#ifndef MD_CONF_SPLIT_VERTEX_QUADRICS
+ #define MD_CONF_SPLIT_VERTEX_QUADRICS (0)
+#endif
+
+/* Vertices per side of the terrain, other meshes are sized for a similar triangle count, about 2M each */
+#define BENCH_SIZE_DEFAULT (1024)
+
+#define BENCH_MESH_MAX (32)
+#define BENCH_THREAD_STEP_MAX (32)
+
+#define BENCH_VERTEX_CACHE_SIZE (32)
+
+#define BENCH_PI (3.14159265358979323846)
+
+
+
+////
+
+
+#define BENCH_COUNTER_CACHEMISS (0)
+#define BENCH_COUNTER_L1DMISS (1)
+#define BENCH_COUNTER_COUNT (2)
+
+typedef struct
+{
+  int fd[BENCH_COUNTER_COUNT];
+} benchCounters;
+
+#if BENCH_PERF_SUPPORT
+
+static int benchCounterOpen( uint32_t type, uint64_t config )
+{
+  struct perf_event_attr attr;
+  memset( &attr, 0, sizeof(struct perf_event_attr) );
+  attr.size = sizeof(struct perf_event_attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;
+  /* Count the decimation worker threads spawned after the counter is opened */
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return (int)syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 );
+}
+
+static void benchCountersStart( benchCounters *counters )
+{
+  int index;
+  counters->fd[BENCH_COUNTER_CACHEMISS] = benchCounterOpen( PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES );
+  counters->fd[BENCH_COUNTER_L1DMISS] = benchCounterOpen( PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 ) );
+  for( index = 0 ; index < BENCH_COUNTER_COUNT ; index++ )
+  {
+    if( counters->fd[index] < 0 )
+      continue;
+    ioctl( counters->fd[index], PERF_EVENT_IOC_RESET, 0 );
+    ioctl( counters->fd[index], PERF_EVENT_IOC_ENABLE, 0 );
+  }
+  return;
+}
+
+static void benchCountersStop( benchCounters *counters, int64_t *values )
+{
+  int index;
+  uint64_t value;
+  for( index = 0 ; index < BENCH_COUNTER_COUNT ; index++ )
+  {
+    values[index] = -1;
+    if( counters->fd[index] < 0 )
+      continue;
+    ioctl( counters->fd[index], PERF_EVENT_IOC_DISABLE, 0 );
+    if( read( counters->fd[index], &value, sizeof(uint64_t) ) == sizeof(uint64_t) )
+      values[index] = (int64_t)value;
+    close( counters->fd[index] );
+  }
+  return;
+}
+
+#else
+
+static void benchCountersStart( benchCounters *counters )
+{
+  int index;
+  for( index = 0 ; index < BENCH_COUNTER_COUNT ; index++ )
+    counters->fd[index] = -1;
+  return;
+}
+
+static void benchCountersStop( benchCounters *counters, int64_t *values )
+{
+  int index;
+  for( index = 0 ; index < BENCH_COUNTER_COUNT ; index++ )
+    values[index] = -1;
+  return;
+}
+
+#endif
+
+
+////
+
+
+static long benchGetMilliseconds( void )
+{
+  struct timespec ts;
+  timespec_get( &ts, TIME_UTC );
+  return ( (long)ts.tv_sec * 1000 ) + ( (long)ts.tv_nsec / 1000000 );
+}
+
+/* Reset the peak resident memory, only possible on Linux */
+static void benchPeakMemoryReset( void )
+{
+#if defined(__linux__)
+  FILE *file;
+  file = fopen( "/proc/self/clear_refs", "w" );
+  if( file )
+  {
+    fputs( "5", file );
+    fclose( file );
+  }
+#endif
+  return;
+}
+
+/* Peak resident memory in bytes, -1 if unknown */
+static int64_t benchPeakMemory( void )
+{
+#if defined(__linux__)
+  long long value;
+  char line[256];
+  FILE *file;
+  file = fopen( "/proc/self/status", "r" );
+  if( file )
+  {
+    while( fgets( line, sizeof(line), file ) )
+    {
+      if( sscanf( line, "VmHWM: %lld kB", &value ) == 1 )
+      {
+        fclose( file );
+        return (int64_t)value * 1024;
+      }
+    }
+    fclose( file );
+  }
+#endif
+#if BENCH_RUSAGE_SUPPORT
+  struct rusage usage;
+  if( !( getrusage( RUSAGE_SELF, &usage ) ) )
+ #if defined(__APPLE__)
+    return (int64_t)usage.ru_maxrss;
+ #else
+    return (int64_t)usage.ru_maxrss * 1024;
+ #endif
+#endif
+  return -1;
+}
+
+
+////
+
+
+typedef struct
+{
+  char name[64];
+  long vertexcount;
+  long tricount;
+  long vertexalloc;
+  long trialloc;
+  float *vertex;
+  uint32_t *indices;
+} benchMesh;
+
+static int benchMeshAlloc( benchMesh *mesh, const char *name, long vertexcount, long tricount )
+{
+  snprintf( mesh->name, sizeof(mesh->name), "%s", name );
+  mesh->vertexcount = 0;
+  mesh->tricount = 0;
+  mesh->vertexalloc = vertexcount;
+  mesh->trialloc = tricount;
+  mesh->vertex = malloc( vertexcount * 3 * sizeof(float) );
+  mesh->indices = malloc( tricount * 3 * sizeof(uint32_t) );
+  return ( ( mesh->vertex ) && ( mesh->indices ) );
+}
+
+static void benchMeshFree( benchMesh *mesh )
+{
+  free( mesh->vertex );
+  free( mesh->indices );
+  mesh->vertex = 0;
+  mesh->indices = 0;
+  return;
+}
+
+static uint32_t benchAddVertex( benchMesh *mesh, float x, float y, float z )
+{
+  float *point;
+  point = &mesh->vertex[ mesh->vertexcount * 3 ];
+  point[0] = x;
+  point[1] = y;
+  point[2] = z;
+  return (uint32_t)( mesh->vertexcount++ );
+}
+
+static void benchAddTriangle( benchMesh *mesh, uint32_t v0, uint32_t v1, uint32_t v2 )
+{
+  uint32_t *indices;
+  indices = &mesh->indices[ mesh->tricount * 3 ];
+  indices[0] = v0;
+  indices[1] = v1;
+  indices[2] = v2;
+  mesh->tricount++;
+  return;
+}
+
+/* Two triangles of a quad, a b on the first row, c d on the next */
+static void benchAddQuad( benchMesh *mesh, uint32_t a, uint32_t b, uint32_t c, uint32_t d )
+{
+  benchAddTriangle( mesh, a, b, d );
+  benchAddTriangle( mesh, a, d, c );
+  return;
+}
+
+
+/* UV sphere, rings of vertices between two poles */
+static int benchBuildSphere( benchMesh *mesh, long size )
+{
+  long ring, segment, ringcount, segmentcount;
+  uint32_t top, bottom, base;
+  float theta, phi;
+
+  ringcount = size;
+  segmentcount = size;
+  if( !( benchMeshAlloc( mesh, "sphere", ( ( ringcount - 1 ) * segmentcount ) + 2, 2 * segmentcount * ( ringcount - 1 ) ) ) )
+    return 0;
+  top = benchAddVertex( mesh, 0.0f, 0.0f, 0.5f );
+  for( ring = 1 ; ring < ringcount ; ring++ )
+  {
+    theta = (float)BENCH_PI * (float)ring / (float)ringcount;
+    for( segment = 0 ; segment < segmentcount ; segment++ )
+    {
+      phi = 2.0f * (float)BENCH_PI * (float)segment / (float)segmentcount;
+      benchAddVertex( mesh, 0.5f * sinf( theta ) * cosf( phi ), 0.5f * sinf( theta ) * sinf( phi ), 0.5f * cosf( theta ) );
+    }
+  }
+  bottom = benchAddVertex( mesh, 0.0f, 0.0f, -0.5f );
+  for( segment = 0 ; segment < segmentcount ; segment++ )
+  {
+    benchAddTriangle( mesh, top, 1 + segment, 1 + ( ( segment + 1 ) % segmentcount ) );
+    base = 1 + ( ( ringcount - 2 ) * segmentcount );
+    benchAddTriangle( mesh, bottom, base + ( ( segment + 1 ) % segmentcount ), base + segment );
+  }
+  for( ring = 0 ; ring < ringcount - 2 ; ring++ )
+  {
+    base = 1 + ( ring * segmentcount );
+    for( segment = 0 ; segment < segmentcount ; segment++ )
+      benchAddQuad( mesh, base + segment, base + ( ( segment + 1 ) % segmentcount ), base + segmentcount + segment, base + segmentcount + ( ( segment + 1 ) % segmentcount ) );
+  }
+  return 1;
+}
+
+/* Height field with a smooth wave and some deterministic noise, so that collapses are not all of equal cost */
+static void benchBuildGrid( benchMesh *mesh, long gridsize )
+{
+  long x, y;
+  uint32_t a;
+  float z;
+
+  for( y = 0 ; y < gridsize ; y++ )
+  {
+    for( x = 0 ; x < gridsize ; x++ )
+    {
+      z = 0.05f * sinf( (float)x * ( 100.0f / (float)gridsize ) ) * cosf( (float)y * ( 140.0f / (float)gridsize ) );
+      z += 0.0005f * (float)( ( ( x * 7919 ) + ( y * 104729 ) ) % 97 ) / 97.0f;
+      benchAddVertex( mesh, (float)x / (float)gridsize, (float)y / (float)gridsize, z );
+    }
+  }
+  for( y = 0 ; y < gridsize - 1 ; y++ )
+  {
+    for( x = 0 ; x < gridsize - 1 ; x++ )
+    {
+      a = (uint32_t)( ( y * gridsize ) + x );
+      benchAddQuad( mesh, a, a + 1, a + (uint32_t)gridsize, a + (uint32_t)gridsize + 1 );
+    }
+  }
+  return;
+}
+
+static int benchBuildTerrain( benchMesh *mesh, long size )
+{
+  if( !( benchMeshAlloc( mesh, "terrain", size * size, 2 * ( size - 1 ) * ( size - 1 ) ) ) )
+    return 0;
+  benchBuildGrid( mesh, size );
+  return 1;
+}
+
+/* Box of flat tessellated faces meeting at sharp edges, vertices shared between faces through a lattice hash */
+static uint32_t benchBoxVertex( benchMesh *mesh, uint32_t *hashtable, uint64_t hashmask, long n, long i, long j, long k )
+{
+  uint64_t key, slot;
+  uint32_t index;
+  key = ( ( ( (uint64_t)i * ( n + 1 ) ) + (uint64_t)j ) * ( n + 1 ) ) + (uint64_t)k;
+  for( slot = ( key * 0x9e3779b97f4a7c15ULL ) >> 20 ; ; slot++ )
+  {
+    slot &= hashmask;
+    index = hashtable[slot];
+    if( index == 0xffffffff )
+      break;
+    if( ( mesh->vertex[ ( index * 3 ) + 0 ] == (float)i / (float)n ) && ( mesh->vertex[ ( index * 3 ) + 1 ] == 0.75f * (float)j / (float)n ) && ( mesh->vertex[ ( index * 3 ) + 2 ] == 0.5f * (float)k / (float)n ) )
+      return index;
+  }
+  index = benchAddVertex( mesh, (float)i / (float)n, 0.75f * (float)j / (float)n, 0.5f * (float)k / (float)n );
+  hashtable[slot] = index;
+  return index;
+}
+
+static int benchBuildBox( benchMesh *mesh, long size )
+{
+  int face, axis, u, v;
+  long n, a, b, vertexcount;
+  long coord[3];
+  uint32_t q[4];
+  uint64_t hashsize;
+  uint32_t *hashtable;
+
+  n = size >> 1;
+  if( n < 2 )
+    n = 2;
+  vertexcount = ( 6 * n * n ) + 2;
+  if( !( benchMeshAlloc( mesh, "cad-box", vertexcount, 12 * n * n ) ) )
+    return 0;
+  for( hashsize = 1024 ; hashsize < (uint64_t)( vertexcount << 1 ) ; hashsize <<= 1 );
+  hashtable = malloc( hashsize * sizeof(uint32_t) );
+  if( !( hashtable ) )
+    return 0;
+  memset( hashtable, 0xff, hashsize * sizeof(uint32_t) );
+  /* Each face is a grid on the plane of axis at 0 or n, spanned by the two other axes */
+  for( face = 0 ; face < 6 ; face++ )
+  {
+    axis = face >> 1;
+    u = ( axis + 1 ) % 3;
+    v = ( axis + 2 ) % 3;
+    coord[axis] = ( face & 1 ? n : 0 );
+    for( a = 0 ; a < n ; a++ )
+    {
+      for( b = 0 ; b < n ; b++ )
+      {
+        coord[u] = a; coord[v] = b;
+        q[0] = benchBoxVertex( mesh, hashtable, hashsize - 1, n, coord[0], coord[1], coord[2] );
+        coord[u] = a + 1; coord[v] = b;
+        q[1] = benchBoxVertex( mesh, hashtable, hashsize - 1, n, coord[0], coord[1], coord[2] );
+        coord[u] = a; coord[v] = b + 1;
+        q[2] = benchBoxVertex( mesh, hashtable, hashsize - 1, n, coord[0], coord[1], coord[2] );
+        coord[u] = a + 1; coord[v] = b + 1;
+        q[3] = benchBoxVertex( mesh, hashtable, hashsize - 1, n, coord[0], coord[1], coord[2] );
+        /* Keep the winding facing outwards */
+        if( face & 1 )
+          benchAddQuad( mesh, q[0], q[1], q[2], q[3] );
+        else
+          benchAddQuad( mesh, q[0], q[2], q[1], q[3] );
+      }
+    }
+  }
+  free( hashtable );
+  return 1;
+}
+
+/* Terrain with vertical fins above and below every 16th row, the row edges are shared by four triangles */
+static int benchBuildNonManifold( benchMesh *mesh, long size )
+{
+  int side;
+  long x, y, fincount;
+  uint32_t row, fin;
+  float *point;
+
+  fincount = 2 * ( ( size + 7 ) >> 4 );
+  if( !( benchMeshAlloc( mesh, "non-manifold", ( size * size ) + ( fincount * size ), ( 2 * ( size - 1 ) * ( size - 1 ) ) + ( fincount * 2 * ( size - 1 ) ) ) ) )
+    return 0;
+  benchBuildGrid( mesh, size );
+  for( y = 8 ; y < size ; y += 16 )
+  {
+    row = (uint32_t)( y * size );
+    for( side = 0 ; side < 2 ; side++ )
+    {
+      fin = (uint32_t)mesh->vertexcount;
+      for( x = 0 ; x < size ; x++ )
+      {
+        point = &mesh->vertex[ ( row + x ) * 3 ];
+        benchAddVertex( mesh, point[0], point[1], point[2] + ( side ? -0.02f : 0.02f ) );
+      }
+      for( x = 0 ; x < size - 1 ; x++ )
+        benchAddQuad( mesh, row + (uint32_t)x, row + (uint32_t)x + 1, fin + (uint32_t)x, fin + (uint32_t)x + 1 );
+    }
+  }
+  return 1;
+}
+
+static int benchLoadMesh( benchMesh *mesh, const char *path )
+{
+  size_t index;
+  float *point;
+  uint32_t *indices;
+  const char *name;
+  mlMesh data;
+
+  if( !( mlMeshLoad( &data, path, ML_FILE_AUTO, 0, ML_FLAGS_NO_ZERO_COPY ) ) )
+    return 0;
+  for( name = path ; *path ; path++ )
+  {
+    if( ( *path == '/' ) || ( *path == '\\' ) )
+      name = path + 1;
+  }
+  if( !( benchMeshAlloc( mesh, name, (long)data.vertexcount, (long)data.tricount ) ) )
+  {
+    mlMeshFree( &data );
+    return 0;
+  }
+  for( index = 0 ; index < data.vertexcount ; index++ )
+  {
+    point = (float *)( (char *)data.vertex + ( index * data.vertexstride ) );
+    benchAddVertex( mesh, point[0], point[1], point[2] );
+  }
+  for( index = 0 ; index < data.tricount ; index++ )
+  {
+    indices = (uint32_t *)( (char *)data.indices + ( index * data.indicesstride ) );
+    benchAddTriangle( mesh, indices[0], indices[1], indices[2] );
+  }
+  mlMeshFree( &data );
+  return 1;
+}
+
+
+////
+
+
+enum
+{
+  BENCH_STAGE_DECIMATION,
+  BENCH_STAGE_OPTIMIZATION,
+
+  BENCH_STAGE_COUNT
+};
+
+static const char *benchStageName[BENCH_STAGE_COUNT] =
+{
+  "decimation",
+  "optimization"
+};
+
+typedef struct
+{
+  int threadcount;
+  int flags;
+  int precision;
+  double featuresize;
+  FILE *report;
+  /* Per-thread lock contention and barrier waits of decimations, with MD_FLAGS_PROFILE_CONTENTION */
+  int profileflag;
+  mdStatistics statistics;
+} benchConfig;
+
+typedef struct
+{
+  int threadcount;
+  long msecs;
+  double tripersec;
+  double efficiency;
+  long outtricount;
+  int64_t peakmemory;
+  double misspercollapse;
+  double acmr;
+} benchResult;
+
+/* Run one stage on a fresh copy of the mesh, returns 0 on failure */
+static int benchRunStage( benchConfig *config, benchMesh *mesh, int stage, int threadcount, float *vertex, uint32_t *indices, benchResult *result )
+{
+  long msecs;
+  benchCounters counters;
+  int64_t values[BENCH_COUNTER_COUNT];
+  mdOperation op;
+
+  memcpy( vertex, mesh->vertex, mesh->vertexcount * 3 * sizeof(float) );
+  memcpy( indices, mesh->indices, mesh->tricount * 3 * sizeof(uint32_t) );
+  memset( result, 0, sizeof(benchResult) );
+  result->threadcount = threadcount;
+  result->misspercollapse = -1.0;
+  result->acmr = -1.0;
+  benchPeakMemoryReset();
+
+  if( stage == BENCH_STAGE_DECIMATION )
+  {
+    mdOperationInit( &op );
+    mdOperationData( &op, mesh->vertexcount, vertex, MD_FORMAT_FLOAT, 3 * sizeof(float), mesh->tricount, indices, MD_FORMAT_UINT32, 3 * sizeof(uint32_t) );
+    mdOperationStrength( &op, config->featuresize );
+    mdOperationPrecision( &op, config->precision );
+    if( config->profileflag )
+      mdOperationStatistics( &op, &config->statistics );
+    benchCountersStart( &counters );
+    msecs = benchGetMilliseconds();
+    if( !( mdMeshDecimation( &op, threadcount, config->flags | ( config->profileflag ? MD_FLAGS_PROFILE_CONTENTION : 0 ) ) ) )
+    {
+      benchCountersStop( &counters, values );
+      return 0;
+    }
+    msecs = benchGetMilliseconds() - msecs;
+    benchCountersStop( &counters, values );
+    result->outtricount = (long)op.tricount;
+    if( ( values[BENCH_COUNTER_CACHEMISS] >= 0 ) && ( op.decimationcount ) )
+      result->misspercollapse = (double)values[BENCH_COUNTER_CACHEMISS] / (double)op.decimationcount;
+  }
+  else
+  {
+    msecs = benchGetMilliseconds();
+    if( !( moOptimizeMesh( mesh->vertexcount, mesh->tricount, indices, sizeof(uint32_t), 3 * sizeof(uint32_t), 0, 0, BENCH_VERTEX_CACHE_SIZE, threadcount, 0 ) ) )
+      return 0;
+    msecs = benchGetMilliseconds() - msecs;
+    result->outtricount = mesh->tricount;
+    result->acmr = moEvaluateMesh( mesh->tricount, indices, sizeof(uint32_t), 3 * sizeof(uint32_t), BENCH_VERTEX_CACHE_SIZE, 0 );
+  }
+
+  result->msecs = msecs;
+  result->tripersec = (double)mesh->tricount * 1000.0 / (double)( msecs > 0 ? msecs : 1 );
+  result->peakmemory = benchPeakMemory();
+  return 1;
+}
+
+/* Where each thread lost its time, in millions of cycles */
+static void benchPrintProfile( mdStatistics *statistics )
+{
+  int threadindex;
+  mdThreadProfile *profile;
+  for( threadindex = 0 ; ( threadindex < statistics->threadcount ) && ( threadindex < MD_STATISTICS_THREAD_MAX ) ; threadindex++ )
+  {
+    profile = &statistics->threadprofile[threadindex];
+    printf( "      thread %-3d %9ld collapses, locks %ld failed %ld retried %.1fM, barriers %ld %.1fM, global lock %ld %.1fM, stopped %ld %.1fM\n", threadindex, statistics->threadcollapsecount[threadindex], profile->lockfailcount, profile->lockretrycount, (double)profile->lockcycles / 1000000.0, profile->barriersynccount, (double)profile->barriersynccycles / 1000000.0, profile->globallockcount, (double)profile->globallockcycles / 1000000.0, profile->globalstopcount, (double)profile->globalstopcycles / 1000000.0 );
+  }
+  return;
+}
+
+static void benchPrintResult( benchConfig *config, benchMesh *mesh, int stage, benchResult *result )
+{
+  char extra[64];
+  if( stage == BENCH_STAGE_DECIMATION )
+  {
+    if( result->misspercollapse >= 0.0 )
+      snprintf( extra, sizeof(extra), "%ld tris, %.1f misses/collapse", result->outtricount, result->misspercollapse );
+    else
+      snprintf( extra, sizeof(extra), "%ld tris", result->outtricount );
+  }
+  else
+    snprintf( extra, sizeof(extra), "ACMR %.3f", result->acmr );
+  printf( "  %-13s %3d %8ld %12.0f %9.1f%% %9.1f  %s\n", benchStageName[stage], result->threadcount, result->msecs, result->tripersec, 100.0 * result->efficiency, ( result->peakmemory >= 0 ? (double)result->peakmemory / ( 1024.0 * 1024.0 ) : -1.0 ), extra );
+  if( config->report )
+    fprintf( config->report, "\"%s\",%ld,%s,%d,%ld,%.0f,%.4f,%lld,%ld\n", mesh->name, mesh->tricount, benchStageName[stage], result->threadcount, result->msecs, result->tripersec, result->efficiency, (long long)result->peakmemory, result->outtricount );
+  if( ( stage == BENCH_STAGE_DECIMATION ) && ( config->profileflag ) )
+    benchPrintProfile( &config->statistics );
+  return;
+}
+
+/* Run both stages at 1, 2, 4... threads up to the maximum */
+static int benchRunMesh( benchConfig *config, benchMesh *mesh )
+{
+  int stage, stepindex, stepcount, threadcount, failcount;
+  int threadlist[BENCH_THREAD_STEP_MAX];
+  long basemsecs;
+  float *vertex;
+  uint32_t *indices;
+  benchResult result;
+
+  stepcount = 0;
+  for( threadcount = 1 ; ( threadcount < config->threadcount ) && ( stepcount < BENCH_THREAD_STEP_MAX - 1 ) ; threadcount <<= 1 )
+    threadlist[stepcount++] = threadcount;
+  threadlist[stepcount++] = config->threadcount;
+
+  vertex = malloc( mesh->vertexcount * 3 * sizeof(float) );
+  indices = malloc( mesh->tricount * 3 * sizeof(uint32_t) );
+  if( !( vertex ) || !( indices ) )
+  {
+    free( vertex );
+    free( indices );
+    return 0;
+  }
+  printf( "Mesh %s : %ld vertices, %ld triangles\n", mesh->name, mesh->vertexcount, mesh->tricount );
+  printf( "  %-13s %3s %8s %12s %10s %9s\n", "stage", "thr", "msecs", "tris/sec", "efficiency", "peak MB" );
+  failcount = 0;
+  for( stage = 0 ; stage < BENCH_STAGE_COUNT ; stage++ )
+  {
+    basemsecs = 0;
+    for( stepindex = 0 ; stepindex < stepcount ; stepindex++ )
+    {
+      if( !( benchRunStage( config, mesh, stage, threadlist[stepindex], vertex, indices, &result ) ) )
+      {
+        fprintf( stderr, "ERROR: %s of %s failed with %d threads\n", benchStageName[stage], mesh->name, threadlist[stepindex] );
+        failcount++;
+        continue;
+      }
+      /* Efficiency is the speedup over the single thread run, divided by the thread count */
+      if( result.threadcount == 1 )
+        basemsecs = ( result.msecs > 0 ? result.msecs : 1 );
+      if( basemsecs )
+        result.efficiency = (double)basemsecs / ( (double)( result.msecs > 0 ? result.msecs : 1 ) * (double)result.threadcount );
+      benchPrintResult( config, mesh, stage, &result );
+    }
+  }
+  free( vertex );
+  free( indices );
+  return ( failcount == 0 );
+}
+
+
+////
+
+
+static void benchUsage( const char *argv0 )
+{
+  printf( "Usage: %s [options]\n", argv0 );
+  printf( "  -s size         Vertices per side of the terrain, other meshes are sized to match (default %d)\n", BENCH_SIZE_DEFAULT );
+  printf( "  -m meshes       Comma separated generated meshes, sphere,terrain,cad-box,non-manifold or none (default all)\n" );
+  printf( "  -i path         Also benchmark a OBJ, PLY or STL mesh file, may be repeated\n" );
+  printf( "  -t threadcount  Maximum thread count, runs at 1, 2, 4... up to it (default 4)\n" );
+  printf( "  -f featuresize  Decimation feature size (default 0.02)\n" );
+  printf( "  -p precision    Decimation precision, double or float (default double)\n" );
+  printf( "  -F flags        Decimation MD_FLAGS_* value (default 0)\n" );
+  printf( "  -r report       Write all results to a CSV file\n" );
+  printf( "  -P              Profile lock contention and barrier waits of each decimation thread\n" );
+  return;
+}
+
+
+int main( int argc, char **argv )
+{
+  int argindex, meshindex, meshcount, retval;
+  long size;
+  const char *meshselect, *reportpath;
+  const char *pathlist[BENCH_MESH_MAX];
+  int pathcount;
+  static benchConfig config;
+  benchMesh meshlist[BENCH_MESH_MAX];
+
+  memset( &config, 0, sizeof(benchConfig) );
+  size = BENCH_SIZE_DEFAULT;
+  config.threadcount = 4;
+  config.featuresize = 0.02;
+  config.precision = MD_PRECISION_DOUBLE;
+  meshselect = "sphere,terrain,cad-box,non-manifold";
+  reportpath = 0;
+  pathcount = 0;
+  for( argindex = 1 ; argindex < argc ; argindex++ )
+  {
+    if( ( !( strcmp( argv[argindex], "-s" ) ) ) && ( argindex + 1 < argc ) )
+      size = atol( argv[++argindex] );
+    else if( ( !( strcmp( argv[argindex], "-m" ) ) ) && ( argindex + 1 < argc ) )
+      meshselect = argv[++argindex];
+    else if( ( !( strcmp( argv[argindex], "-i" ) ) ) && ( argindex + 1 < argc ) && ( pathcount < BENCH_MESH_MAX - 4 ) )
+      pathlist[pathcount++] = argv[++argindex];
+    else if( ( !( strcmp( argv[argindex], "-t" ) ) ) && ( argindex + 1 < argc ) )
+      config.threadcount = atoi( argv[++argindex] );
+    else if( ( !( strcmp( argv[argindex], "-f" ) ) ) && ( argindex + 1 < argc ) )
+      config.featuresize = atof( argv[++argindex] );
+    else if( ( !( strcmp( argv[argindex], "-p" ) ) ) && ( argindex + 1 < argc ) )
+      config.precision = ( strcmp( argv[++argindex], "float" ) ? MD_PRECISION_DOUBLE : MD_PRECISION_FLOAT );
+    else if( ( !( strcmp( argv[argindex], "-F" ) ) ) && ( argindex + 1 < argc ) )
+      config.flags = (int)strtol( argv[++argindex], 0, 0 );
+    else if( ( !( strcmp( argv[argindex], "-r" ) ) ) && ( argindex + 1 < argc ) )
+      reportpath = argv[++argindex];
+    else if( !( strcmp( argv[argindex], "-P" ) ) )
+      config.profileflag = 1;
+    else
+    {
+      benchUsage( argv[0] );
+      return 1;
+    }
+  }
+  if( size < 4 )
+    size = 4;
+  if( config.threadcount < 1 )
+    config.threadcount = 1;
+
+  /* Build the corpus */
+  meshcount = 0;
+  if( ( strstr( meshselect, "sphere" ) ) && !( benchBuildSphere( &meshlist[meshcount++], size ) ) )
+    goto allocerror;
+  if( ( strstr( meshselect, "terrain" ) ) && !( benchBuildTerrain( &meshlist[meshcount++], size ) ) )
+    goto allocerror;
+  if( ( strstr( meshselect, "cad-box" ) ) && !( benchBuildBox( &meshlist[meshcount++], size ) ) )
+    goto allocerror;
+  if( ( strstr( meshselect, "non-manifold" ) ) && !( benchBuildNonManifold( &meshlist[meshcount++], size ) ) )
+    goto allocerror;
+  for( argindex = 0 ; argindex < pathcount ; argindex++ )
+  {
+    if( !( benchLoadMesh( &meshlist[meshcount], pathlist[argindex] ) ) )
+    {
+      fprintf( stderr, "ERROR: Failed to load %s\n", pathlist[argindex] );
+      continue;
+    }
+    meshcount++;
+  }
+
+  if( reportpath )
+  {
+    config.report = fopen( reportpath, "w" );
+    if( !( config.report ) )
+    {
+      fprintf( stderr, "ERROR: Failed to open report %s\n", reportpath );
+      return 1;
+    }
+    fprintf( config.report, "mesh,triangles,stage,threads,msecs,tris_per_sec,efficiency,peak_bytes,triangles_out\n" );
+  }
+
+  printf( "Vertex layout : %s\n", ( MD_CONF_SPLIT_VERTEX_QUADRICS ? "split quadrics" : "packed" ) );
+  printf( "Precision : %s\n", ( config.precision == MD_PRECISION_FLOAT ? "float" : "double" ) );
+  printf( "Threads : 1 to %d\n", config.threadcount );
+  retval = 0;
+  for( meshindex = 0 ; meshindex < meshcount ; meshindex++ )
+  {
+    if( !( benchRunMesh( &config, &meshlist[meshindex] ) ) )
+      retval = 1;
+    benchMeshFree( &meshlist[meshindex] );
+  }
+  if( config.report )
+    fclose( config.report );
+  return retval;
+
+  allocerror:
+  fprintf( stderr, "ERROR: Failed to allocate the corpus of size %ld\n", size );
+  return 1;
+}
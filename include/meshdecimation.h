@@ -26,6 +26,8 @@
 extern "C" {
 #endif
 
+#include <stdint.h> /* for uint32_t, uint64_t */
+
 #ifndef COMPILER_DLLEXPORT
 # if defined(_WIN32)
 #  define COMPILER_DLLEXPORT __declspec(dllexport)
@@ -71,6 +73,137 @@ enum
 };
 
 
+/* Per-thread counts are kept for up to that many threads */
+#define MD_STATISTICS_THREAD_MAX (256)
+
+/* Lock contention and barrier waits of a thread, only counted with MD_FLAGS_PROFILE_CONTENTION */
+/* Cycles are read from the CPU timestamp counter where available, nanoseconds otherwise */
+typedef struct
+{
+  /* Vertex locks found owned by another thread, in mdLockBufferTryLock() or mdLockBufferLock() */
+  long lockfailcount;
+  /* Retries of the lock loops resolving ops, and times the loops fell back to the global vertex lock */
+  long lockretrycount;
+  long globalvertexlockcount;
+  /* Cycles spent in the lock loops resolving ops, retries included */
+  uint64_t lockcycles;
+  /* Count of and cycles spent in barrier syncs between stages and steps */
+  long barriersynccount;
+  uint64_t barriersynccycles;
+  /* Count of and cycles spent acquiring global locks, waiting for all other threads to stop */
+  long globallockcount;
+  uint64_t globallockcycles;
+  /* Count of and cycles spent stopped by global locks of other threads */
+  long globalstopcount;
+  uint64_t globalstopcycles;
+} mdThreadProfile;
+
+/* Accesses to the edge hash table summed over threads, to size hashsizefactor and lockpageshift for the data */
+typedef struct
+{
+  /* Count of entries of the table, entries covered by each lock page and count of lock pages */
+  size_t hashsize;
+  size_t lockpagesize;
+  size_t lockpagecount;
+  /* Count of accesses, total and longest count of entries skipped searching for an edge or a free entry */
+  long accesscount;
+  long probecount;
+  long probemax;
+  /* Count of edges deleted, steps backwards to the start of their stream of entries, entries moved to fill the gaps */
+  long deletecount;
+  long delrewindcount;
+  long relocationcount;
+  /* Accesses aborted on a lock page held by another thread, and accesses retried under the global lock of the table */
+  long pagelockfailcount;
+  long globallockcount;
+} mdHashStatistics;
+
+/* Statistics of a decimation, filled by mdMeshDecimationEnd() when requested with mdOperationStatistics() */
+typedef struct
+{
+  /* Wall time spent in each stage, indexed by MD_STATUS_STAGE_* ; stages skipped are zero */
+  double stagemsecs[MD_STATUS_STAGE_COUNT];
+
+  /* Count of threads and count of edge collapses performed by each thread */
+  int threadcount;
+  long threadcollapsecount[MD_STATISTICS_THREAD_MAX];
+
+  /* Lock contention and barrier waits of each thread, set if profileflag */
+  int profileflag;
+  mdThreadProfile threadprofile[MD_STATISTICS_THREAD_MAX];
+
+  /* Count of collapse ops recomputed after collapses of neighboring edges */
+  long opupdatecount;
+  /* Count of collapses denied by the penalty, for flipping or degenerating triangles, when queued or updated */
+  long denycount;
+  /* Count of collapses rejected when performed by mdEdgeCollisionCheck(), as they would have joined two triangles on one edge */
+  long edgecollisioncount;
+
+  /* Edge hash table, zero if the decimation was skipped */
+  mdHashStatistics edgehash;
+} mdStatistics;
+
+
+/* Level of detail, snapshot of the mesh taken during the decimation */
+typedef struct
+{
+  /* Take the snapshot once the count of vertices drops to targetvertexcount.  Set zero to disable */
+  size_t targetvertexcount;
+  /* Take the snapshot once all collapses cheaper than for that feature size are done, must be below the operation's featuresize.  Set zero to disable */
+  double featuresize;
+
+  /* Output vertex data, in the vertexformat of the operation */
+  void *vertex;
+  size_t vertexstride;
+  size_t vertexalloc;
+
+  /* Output indices data, in the indicesformat of the operation */
+  void *indices;
+  size_t indicesstride;
+  size_t trialloc;
+
+  /* Optional output per-triangle custom data, tridatasize bytes per triangle */
+  void *tridata;
+
+  /* Optional output, for each vertex of the level, the index of the input vertex it derives from, vertexalloc entries */
+  /* Vertex attributes such as texture coordinates or colors of the level can be gathered from the input through it */
+  uint32_t *vertexsource;
+
+  /* Output: Count of vertices and triangles of the level ~ if above vertexalloc or trialloc, nothing was written */
+  size_t vertexcount;
+  size_t tricount;
+} mdLevel;
+
+
+/* Progressive mesh stream, written as a mdCollapseHeader followed by recordcount mdCollapseRecord */
+#define MD_COLLAPSE_STREAM_MAGIC (0x4d50444d)
+#define MD_COLLAPSE_STREAM_VERSION (1)
+
+typedef struct
+{
+  uint32_t magic;
+  uint32_t version;
+  /* Count of vertices and triangles of the input mesh, all indices of the records refer to the input mesh */
+  uint64_t vertexcount;
+  uint64_t tricount;
+  uint64_t recordcount;
+} mdCollapseHeader;
+
+/* Edge collapse, replaying records in stream order from the input mesh rebuilds the mesh at any step of the decimation */
+typedef struct
+{
+  /* Vertex moved to the collapse point */
+  int32_t v0;
+  /* Vertex removed, all its remaining triangles now reference v0 */
+  int32_t v1;
+  /* Triangles deleted on both sides of the edge, -1 if none */
+  int32_t tri0;
+  int32_t tri1;
+  /* New position of v0 */
+  double point[3];
+} mdCollapseRecord;
+
+
 typedef struct
 {
   /* Input vertex data */
@@ -170,6 +303,16 @@ typedef struct
   /* Output: Time spent performing the decimation */
   long msecs;
 
+  /* Output: Count of edge reductions performed on ops stolen from the queues of other threads, only with MD_FLAGS_WORK_STEALING */
+  long stealcount;
+  /* Output: Time spent by all threads idle, waiting for the next sync step, summed over threads */
+  long idlemsecs;
+  /* Output: Count of times a thread stopped all other threads to take the global lock */
+  long globallockcount;
+  /* Output: Set when the decimation failed and mdMeshDecimation() returns zero, for mdMeshDecimationInit() check it after mdMeshDecimationEnd() */
+  /* Running out of memory for a collapse stops the decimation early, the mesh written back is still valid but less decimated */
+  int failureflag;
+
   /* Status callback */
   long statusmilliseconds;
   void *statuscontext;
@@ -187,8 +330,22 @@ typedef struct
   int syncstepabort;
   /* For optional normal smoothing, maximum angle in degrees for merged smoothing */
   double normalsearchangle;
-  /* Maximum memory usage, if possible ~ mdMeshDecimation() may still allocate more than that if necessary */
+  /* Maximum memory usage, mdMeshDecimation() fails rather than exceed it ; zero for no limit ~ default is 75% of system memory */
+  /* The mesh-sized buffers of the flags and settings in use are counted up front, trirefs grown by collapses stop the decimation when over the limit */
   size_t maxmemoryusage;
+  /* Precision of vertex positions and collapse maths, MD_PRECISION_DOUBLE or MD_PRECISION_FLOAT ~ default is MD_PRECISION_DOUBLE */
+  int precision;
+
+  /* Optional levels of detail to snapshot during the decimation, from finest to coarsest */
+  mdLevel *levellist;
+  int levelcount;
+
+  /* Optional progressive mesh stream of all edge collapses */
+  void *streamcontext;
+  void (*collapsestream)( void *streamcontext, const void *data, size_t size );
+
+  /* Optional statistics to fill at the end of the decimation */
+  mdStatistics *statistics;
 
 } mdOperation;
 
@@ -215,6 +372,14 @@ enum
   MD_FORMAT_INT_2_10_10_10_REV
 };
 
+enum
+{
+  /* Precision of the decimation, for mdOperation.precision */
+  MD_PRECISION_DOUBLE,
+  /* Half the vertex storage, quadrics are still accumulated in double precision ; fine for most scanned meshes */
+  MD_PRECISION_FLOAT
+};
+
 
 /* Initialize mdOperation with default values */
 MMESH_EXPORT void mdOperationInit( mdOperation *op );
@@ -225,6 +390,9 @@ MMESH_EXPORT void mdOperationData( mdOperation *op, size_t vertexcount, void *ve
 /* Set decimation strength, feature size proportional to scale of model */
 MMESH_EXPORT void mdOperationStrength( mdOperation *op, double featuresize );
 
+/* Set precision of the decimation, MD_PRECISION_DOUBLE or MD_PRECISION_FLOAT ; default is MD_PRECISION_DOUBLE */
+MMESH_EXPORT void mdOperationPrecision( mdOperation *op, int precision );
+
 /* Set optional boundary weight, default is 4.0 */
 MMESH_EXPORT void mdOperationBoundaryWeight( mdOperation *op, double boundaryweight );
 
@@ -252,11 +420,31 @@ MMESH_EXPORT void mdOperationLockVertex( mdOperation *op, long vertexindex );
 /* Optional, free op->lockmap if allocated and set to zero */
 MMESH_EXPORT void mdOperationFreeLocks( mdOperation *op );
 
+/* Set optional levels of detail, snapshots of the mesh taken as the decimation progresses, before the final mesh is stored in the operation */
+/* A level not reached by the end of the decimation receives the final mesh ; MD_FLAGS_ASYNC_STEPS is ignored when levels are requested */
+MMESH_EXPORT void mdOperationLevels( mdOperation *op, mdLevel *levellist, int levelcount );
+
+/* Set optional callback to receive the progressive mesh stream of all edge collapses, written in chunks once the decimation is complete */
+MMESH_EXPORT void mdOperationCollapseStream( mdOperation *op, void (*collapsestream)( void *streamcontext, const void *data, size_t size ), void *streamcontext );
+
+/* Set optional statistics to fill at the end of the decimation, stage timings and per-thread counters */
+MMESH_EXPORT void mdOperationStatistics( mdOperation *op, mdStatistics *statistics );
+
 
 
 /* Decimate the mesh specified by the mdOperation struct */
 MMESH_EXPORT int mdMeshDecimation( mdOperation *operation, int threadcount, int flags );
 
+/* Estimate the memory mdMeshDecimation() needs for the operation and flags, not counting the operation's own arrays, to compare with maxmemoryusage */
+/* Counts the buffers of all threads for MD_FLAGS_SPATIAL_PARTITION, and of normals, levels and the collapse stream when set in the operation */
+MMESH_EXPORT size_t mdMeshDecimationMemoryUsage( mdOperation *operation, int flags );
+
+/* Decimate meshes too large for maxmemoryusage in spatial chunks, each decimated with its boundary vertices and their neighbors locked, then seams in a second pass */
+/* The vertex and indices arrays are modified in place, they can be memory mapped files ; triangles are reordered by chunk */
+/* Only supports MD_FORMAT_FLOAT and MD_FORMAT_DOUBLE vertices, no tridata, vertex callbacks, normals, levels, collapse stream or target vertex counts */
+/* Same as mdMeshDecimation() if the whole mesh fits in maxmemoryusage ; a mesh too dense to be cut in chunks within the budget fails untouched, other failures may leave the mesh data partially decimated */
+MMESH_EXPORT int mdMeshDecimationChunked( mdOperation *operation, int threadcount, int flags );
+
 
 /* Slightly increase the quality of aggressive mesh decimations, about 50% slower (or >100% slower without SSE) */
 #define MD_FLAGS_CONTINUOUS_UPDATE (0x1)
@@ -273,6 +461,35 @@ MMESH_EXPORT int mdMeshDecimation( mdOperation *operation, int threadcount, int
 #define MD_FLAGS_PLANAR_MODE (0x40)
 /* Disable allocating memory strictly from local NUMA nodes on which threads are locked */
 #define MD_FLAGS_DISABLE_NUMA (0x80)
+/* Let threads running out of ops for a sync step steal ops from the queues of other threads instead of waiting */
+#define MD_FLAGS_WORK_STEALING (0x100)
+/* Don't synchronize all threads at each sync step, threads raise a shared cost ceiling as they run out of ops */
+/* Threads never work more than 2 sync steps apart, see syncstepcount, the cost ordering of collapses may differ by that much */
+#define MD_FLAGS_ASYNC_STEPS (0x200)
+/* Allow the vertexcopy() callback to be called concurrently from all threads, in no particular order */
+/* The callback must then not read attributes it may have overwritten, as when copying them in place */
+#define MD_FLAGS_CONCURRENT_VERTEXCOPY (0x400)
+/* Build the mesh topology by radix sorting the directed edges of all triangles rather than through locked edge hash insertions */
+/* Needs 32 bytes per triangle edge during the build, non-manifold edges are always owned by their lowest triangle index */
+#define MD_FLAGS_SORTED_TOPOLOGY (0x800)
+/* Count vertex lock conflicts and time lock loops and barrier waits per thread, reported in mdStatistics */
+/* Costs a few timestamp reads per collapse */
+#define MD_FLAGS_PROFILE_CONTENTION (0x1000)
+/* Assign triangles to the op queues of threads by the Morton order of their centroids rather than by index ranges */
+/* Each thread then collapses a spatially coherent region, for meshes stored in random triangle order; needs 32 bytes per triangle */
+#define MD_FLAGS_SPATIAL_PARTITION (0x2000)
+/* Reorder vertices and triangles along a Morton curve before decimation, for the memory locality of meshes stored in random order */
+/* Output and level vertices keep the relative order of the input, triangles follow the curve ; all indices passed to callbacks and */
+/* written to the collapse stream remain those of the input mesh ; needs 12 bytes per vertex and 4 bytes per triangle, plus 32 */
+/* bytes per vertex or triangle during the build */
+#define MD_FLAGS_REORDER_MESH (0x4000)
+/* Bit-identical output for a given input whatever the count of threads or their timing, with the sorted topology build and a single */
+/* op queue processed by one thread ; the build and store stages remain threaded ; implies MD_FLAGS_SORTED_TOPOLOGY and disables */
+/* MD_FLAGS_WORK_STEALING, MD_FLAGS_ASYNC_STEPS and MD_FLAGS_SPATIAL_PARTITION ; vertex clones of MD_FLAGS_NORMAL_VERTEX_SPLITTING */
+/* are placed per thread range, output with vertex splitting is only reproducible for a given count of threads ; the runtime picked */
+/* AVX2 and AVX-512 kernels are not used, output is reproducible across CPUs for a given build of the library, not across builds */
+/* with different compilers, compiler flags or instruction sets */
+#define MD_FLAGS_DETERMINISTIC (0x8000)
 
 
 /* Low-level mesh decimation interface, allows reuse of external threads */
@@ -289,6 +506,45 @@ MMESH_EXPORT void mdMeshDecimationThread( mdState *state, int threadindex );
 MMESH_EXPORT void mdMeshDecimationEnd( mdState *state );
 
 
+/* Reusable decimation context, keeps memory pools allocated between decimations to avoid allocation and page faulting costs */
+
+typedef struct mdContext mdContext;
+
+/* Create an empty context, pools are allocated and grown on demand */
+MMESH_EXPORT mdContext *mdContextCreate( void );
+
+/* Release all memory held by the context's pools, the context remains usable */
+MMESH_EXPORT void mdContextTrim( mdContext *context );
+
+/* Release all memory and destroy the context */
+MMESH_EXPORT void mdContextDestroy( mdContext *context );
+
+/* Decimate the mesh specified by the mdOperation struct like mdMeshDecimation(), reusing the memory pools of the context */
+/* A context can only run one decimation at a time */
+MMESH_EXPORT int mdMeshDecimationRun( mdContext *context, mdOperation *operation, int threadcount, int flags );
+
+
+/* Batch decimation of many meshes on a shared pool of threads */
+
+typedef struct
+{
+  /* Count of meshes decimated and meshes that failed */
+  long meshcount;
+  long failcount;
+  /* Count of meshes large enough to be decimated by all threads together, the others are packed one per thread */
+  long parallelcount;
+  /* Sum of input triangles of all meshes */
+  size_t tricount;
+  /* Time spent for the whole batch and throughput in input triangles per second */
+  long msecs;
+  double tripersec;
+} mdBatchReport;
+
+/* Decimate all operations of the list with the same flags, report is optional ; returns 1 if all meshes were decimated */
+/* The failureflag of each operation tells which meshes failed */
+MMESH_EXPORT int mdMeshDecimationBatch( mdOperation *operationlist, int operationcount, int threadcount, int flags, mdBatchReport *report );
+
+
 #ifdef __cplusplus
 }
 #endif
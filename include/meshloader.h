@@ -0,0 +1,114 @@
+/* *****************************************************************************
+ *
+ * Copyright (c) 2012-2023 Alexis Naveros.
+ * Portions developed under contract to the SURVICE Engineering Company.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * *****************************************************************************
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h> /* for size_t */
+
+#ifndef COMPILER_DLLEXPORT
+# if defined(_WIN32)
+#  define COMPILER_DLLEXPORT __declspec(dllexport)
+#  define COMPILER_DLLIMPORT __declspec(dllimport)
+# else
+#  define COMPILER_DLLEXPORT __attribute__ ((visibility ("default")))
+#  define COMPILER_DLLIMPORT __attribute__ ((visibility ("default")))
+# endif
+#endif
+
+#ifndef MMESH_EXPORT
+#  if defined(MMESH_DLL_EXPORTS) && defined(MMESH_DLL_IMPORTS)
+#    error "Only MMESH_DLL_EXPORTS or MMESH_DLL_IMPORTS can be defined, not both."
+#  elif defined(MMESH_DLL_EXPORTS)
+#    define MMESH_EXPORT COMPILER_DLLEXPORT
+#  elif defined(MMESH_DLL_IMPORTS)
+#    define MMESH_EXPORT COMPILER_DLLIMPORT
+#  else
+#    define MMESH_EXPORT
+#  endif
+#endif
+
+
+
+enum
+{
+  ML_FILE_AUTO,
+  ML_FILE_OBJ,
+  ML_FILE_PLY,
+  ML_FILE_STL
+};
+
+/* Always copy to allocated arrays, never point into the file mapping */
+#define ML_FLAGS_NO_ZERO_COPY (0x1)
+/* For STL files, don't weld vertices of equal positions, each triangle keeps its own 3 vertices */
+#define ML_FLAGS_NO_WELD (0x2)
+
+/* Set in mlMesh.zerocopyflags when the arrays point directly into the file mapping */
+#define ML_ZERO_COPY_VERTEX (0x1)
+#define ML_ZERO_COPY_INDICES (0x2)
+
+
+typedef struct
+{
+  /* Output vertex data, 3 floats per vertex at vertexstride bytes, for MD_FORMAT_FLOAT */
+  size_t vertexcount;
+  void *vertex;
+  size_t vertexstride;
+
+  /* Output indices data, 3 uint32_t per triangle at indicesstride bytes, for MD_FORMAT_UINT32 */
+  size_t tricount;
+  void *indices;
+  size_t indicesstride;
+
+  /* Output: File format loaded, and whether vertex or indices point into the file mapping */
+  int fileformat;
+  int zerocopyflags;
+  /* Output: Time spent loading the file */
+  long msecs;
+
+  /* Private: file mapping, a private copy-on-write mapping, the arrays can be modified in place */
+  void *mapaddress;
+  size_t mapsize;
+  void *filehandle;
+  void *maphandle;
+  /* Private: allocated arrays */
+  void *vertexalloc;
+  void *indicesalloc;
+} mlMesh;
+
+
+/* Load a Wavefront OBJ, ASCII or binary PLY, or ASCII or binary STL mesh file with the specified count of threads */
+/* The file is memory mapped ; text formats are parsed in parallel chunks split at line boundaries */
+/* Binary PLY files with float x,y,z vertex properties and triangle faces of 32 bits indices are used in place, without copy */
+/* Polygons are triangulated as fans, fileformat can be ML_FILE_AUTO to pick by file extension or content */
+MMESH_EXPORT int mlMeshLoad( mlMesh *mesh, const char *path, int fileformat, int threadcount, int flags );
+
+/* Release the arrays and the file mapping of a loaded mesh */
+MMESH_EXPORT void mlMeshFree( mlMesh *mesh );
+
+
+#ifdef __cplusplus
+}
+#endif
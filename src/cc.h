@@ -1198,6 +1198,21 @@ static inline CC_ALWAYSINLINE uint64_t ccMortonNumber64( uint32_t x, uint32_t y
   return z;
 }
 
+/* Interleave the low 21 bits of x, y and z */
+static inline CC_ALWAYSINLINE uint64_t ccMortonNumber3D64( uint32_t x, uint32_t y, uint32_t z )
+{
+  int i;
+  uint64_t m;
+  m = 0;
+  for( i = 0 ; i < 21 ; i++ )
+  {
+    m |= ( (uint64_t)x & ( ((uint64_t)1) << i ) ) << ( 2 * i );
+    m |= ( (uint64_t)y & ( ((uint64_t)1) << i ) ) << ( ( 2 * i ) + 1 );
+    m |= ( (uint64_t)z & ( ((uint64_t)1) << i ) ) << ( ( 2 * i ) + 2 );
+  }
+  return m;
+}
+
 
 ////
 
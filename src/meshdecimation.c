@@ -68,6 +68,24 @@
  #define CPU_SSE4_1_SUPPORT (1)
 #endif
 
+/* Build the AVX2 and AVX-512 kernels with target attributes, pick them at runtime from mmcore.cpuid.isaflags */
+#if ( ( defined(__GNUC__) || defined(__clang__) ) && defined(__x86_64__) ) || ( defined(_MSC_VER) && defined(_M_X64) )
+ #include <immintrin.h>
+ #define CPU_DISPATCH_SUPPORT (1)
+#endif
+/* The kernels round as the SSE2 and scalar ones : no FMA, and no contraction of mul/add pairs into FMA by GCC */
+/* Clang only contracts within a single expression, the intrinsics are never fused */
+#if CPU_DISPATCH_SUPPORT && defined(__clang__)
+ #define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+ #define CPU_TARGET_AVX512 __attribute__((target("avx512f,avx512vl,avx2")))
+#elif CPU_DISPATCH_SUPPORT && defined(__GNUC__)
+ #define CPU_TARGET_AVX2 __attribute__((target("avx2"),optimize("fp-contract=off")))
+ #define CPU_TARGET_AVX512 __attribute__((target("avx512f,avx512vl,avx2"),optimize("fp-contract=off")))
+#else
+ #define CPU_TARGET_AVX2
+ #define CPU_TARGET_AVX512
+#endif
+
 
 #if defined(__GNUC__) || defined(__INTEL_COMPILER)
  #define CPU_ALIGN16 __attribute__((aligned(16)))
@@ -92,8 +110,17 @@
 ////
 
 
-/* Define to use double floating point precision */
-#define MD_CONF_DOUBLE_PRECISION (1)
+/* Defined by meshdecimationf.c to build this file a second time as the single precision variant */
+#ifndef MD_CONF_FLOAT_VARIANT
+ #define MD_CONF_FLOAT_VARIANT (0)
+#endif
+
+/* Define to use double floating point precision, the float variant is selected at run time through mdOperation.precision */
+#if MD_CONF_FLOAT_VARIANT
+ #define MD_CONF_DOUBLE_PRECISION (0)
+#else
+ #define MD_CONF_DOUBLE_PRECISION (1)
+#endif
 
 /* Define to use double floating point precision */
 #define MD_CONF_USE_SHEWCHUK_SUMMATION (1)
@@ -114,6 +141,12 @@
 /* Greatly improves the numerical accuracy when the dataset is gigantic and highly accurate results are expected */
 #define MD_CONF_LOCAL_VERTEX_ORIGINS (1)
 
+/* Store vertex quadrics in a separate array, away from the vertex owner, point and triref header */
+/* Keeps the vertex fields touched by locking and triref walks compact, 48 instead of 136 bytes in double precision */
+#ifndef MD_CONF_SPLIT_VERTEX_QUADRICS
+ #define MD_CONF_SPLIT_VERTEX_QUADRICS (0)
+#endif
+
 /* Try to use some crazy __float128 precision to track the d^2 accumulated error, if available */
 /* Not needed anymore thanks to local quadric origins */
 #define MD_CONFIG_HIGH_QUADRICS (0)
@@ -141,6 +174,10 @@
 
 #define MD_SYNC_STEP_COUNT (64)
 
+/* With MD_FLAGS_ASYNC_STEPS, maximum count of sync steps between the slowest thread and the shared step watermark */
+/* While any thread works on step s, no op above the cost ceiling of step s+MD_ASYNC_STEP_LAG is collapsed */
+#define MD_ASYNC_STEP_LAG (2)
+
 #define MD_QUADRIC_DETERMINANT_MIN (0.0000000001)
 
 #define MD_GLOBAL_LOCK_THRESHOLD (16)
@@ -149,7 +186,7 @@
 
 #define MD_THREAD_COUNT_MAX (256)
 
-#define MD_TRIREF_AVAIL_MIN_COUNT (256*8)
+#define MD_TRIREF_CHUNK_SIZE (16384)
 
 #define MD_OP_FAIL_VALUE (0.25*FLT_MAX)
 
@@ -229,6 +266,36 @@
 ////
 
 
+#if MD_CONF_FLOAT_VARIANT
+/* The single precision variant exports its entry points with a mdf prefix, the public API dispatches to them */
+ #define mdMeshDecimationInit mdfMeshDecimationInit
+ #define mdMeshDecimationThread mdfMeshDecimationThread
+ #define mdMeshDecimationEnd mdfMeshDecimationEnd
+ #define mdMeshDecimationInline mdfMeshDecimationInline
+ #define mdMeshDecimation mdfMeshDecimation
+ #define mdMeshDecimationMemoryUsage mdfMeshDecimationMemoryUsage
+ #define mdContextCreate mdfContextCreate
+ #define mdContextTrim mdfContextTrim
+ #define mdContextDestroy mdfContextDestroy
+ #define mdMeshDecimationRun mdfMeshDecimationRun
+#else
+/* Entry points of the single precision variant, its mdState and mdContext are opaque here */
+mdState *mdfMeshDecimationInit( mdOperation *operation, int threadcount, int flags );
+void mdfMeshDecimationThread( mdState *state, int threadindex );
+void mdfMeshDecimationEnd( mdState *state );
+int mdfMeshDecimationInline( mdContext *context, mdOperation *operation, int flags );
+int mdfMeshDecimation( mdOperation *operation, int threadcount, int flags );
+size_t mdfMeshDecimationMemoryUsage( mdOperation *operation, int flags );
+mdContext *mdfContextCreate( void );
+void mdfContextTrim( mdContext *context );
+void mdfContextDestroy( mdContext *context );
+int mdfMeshDecimationRun( mdContext *context, mdOperation *operation, int threadcount, int flags );
+#endif
+
+
+////
+
+
 #if MD_CONF_DOUBLE_PRECISION
 typedef double mdf;
  #define mdfmin(x,y) fmin((x),(y))
@@ -449,7 +516,8 @@ If scale is 10x, then:
 */
   areascale = q->area * q->area;
   areascale = areascale * areascale * areascale;
-  if( mdfabs( det ) <= ( MD_QUADRIC_DETERMINANT_MIN * areascale ) )
+  /* The determinant is of quadric precision, mdqf, don't truncate it to mdf */
+  if( fabs( det ) <= ( MD_QUADRIC_DETERMINANT_MIN * areascale ) )
   {
 #if DEBUG_VERBOSE_QUADRIC
     printf( "        Solve Det : %.16f ; Fail (<= %.16f)\n", (double)det, MD_QUADRIC_DETERMINANT_MIN * areascale );
@@ -636,6 +704,8 @@ typedef struct
   volatile int lockcount;
   mtSignal locksignal;
   mtSignal lockwakesignal;
+  /* Count of global locks acquired, protected by mutex */
+  long globallockcount;
 } mdBarrier;
 
 #define MD_BARRIER_LOCK_READY(barrier) (((barrier)->count[(barrier)->index])-(((barrier)->lockcount))==1)
@@ -650,6 +720,7 @@ static void mdBarrierInit( mdBarrier *barrier, int count )
   barrier->count[1] = count;
   barrier->lockflag = 0;
   barrier->lockcount = 0;
+  barrier->globallockcount = 0;
   mtSignalInit( &barrier->locksignal );
   mtSignalInit( &barrier->lockwakesignal );
   return;
@@ -758,6 +829,7 @@ static void mdBarrierLockGlobal( mdBarrier *barrier )
     barrier->lockcount--;
   }
   barrier->lockflag = 1;
+  barrier->globallockcount++;
   while( !MD_BARRIER_LOCK_READY(barrier) )
     mtSignalWait( &barrier->locksignal, &barrier->mutex );
   mtMutexUnlock( &barrier->mutex );
@@ -803,7 +875,22 @@ typedef struct MD_PACKED_EDGE_STRUCT
   void *op;
 } mdEdge;
 
-/* Double precision storage: 48 + 88 bytes (mathQuadric) = 136 bytes */
+/* Directed edge of a triangle for the sorted topology build, key is v[0] * vertexcount + v[1] */
+/* Also the Morton key of a triangle's centroid for the spatial partition of op queues */
+typedef struct
+{
+  uint64_t key;
+  mdi triindex;
+} mdEdgeKey;
+
+#define MD_EDGEKEY_RADIX_BITS (11)
+#define MD_EDGEKEY_RADIX_SIZE (1<<MD_EDGEKEY_RADIX_BITS)
+
+/* Points are quantized to 10 bits per axis along Morton curves, 30 bits keys sorted in 3 radix passes */
+#define MD_MORTON_CELL_BITS (10)
+#define MD_MORTON_PASS_COUNT (((3*MD_MORTON_CELL_BITS)+MD_EDGEKEY_RADIX_BITS-1)/MD_EDGEKEY_RADIX_BITS)
+
+/* Double precision storage: 48 + 88 bytes (mathQuadric) = 136 bytes, or 48 bytes when quadrics are split */
 #if CPU_SSE_SUPPORT && !MD_CONF_DOUBLE_PRECISION
 typedef struct CPU_ALIGN16
 #else
@@ -815,7 +902,7 @@ typedef struct
 #else
   mdf point[3];
 #endif
-  size_t trirefbase;
+  mdi *trireflist;
 #if MD_CONFIG_ATOMIC_SUPPORT
   mmAtomic32 atomicowner;
 #else
@@ -827,7 +914,9 @@ typedef struct
 #if MD_CONFIG_DISTANCE_BIAS
   mdf sumbias;
 #endif
+#if !MD_CONF_SPLIT_VERTEX_QUADRICS
   mathQuadric quadric;
+#endif
 } mdVertex;
 
 
@@ -844,6 +933,74 @@ typedef struct CPU_ALIGN64
 } mdUpdateBuffer;
 
 
+/* Per-thread op queue as visible to other threads, only allocated for MD_FLAGS_WORK_STEALING */
+typedef struct CPU_ALIGN64
+{
+  void *binsort;
+#if MD_CONFIG_ATOMIC_SUPPORT
+  mmAtomic32 atomlock;
+#else
+  mtSpin spinlock;
+#endif
+} mdStealQueue;
+
+
+/* Sync step a thread is working on, only allocated for MD_FLAGS_ASYNC_STEPS */
+typedef struct CPU_ALIGN64
+{
+#if MD_CONFIG_ATOMIC_SUPPORT
+  mmAtomic32 stepindex;
+#else
+  int stepindex;
+#endif
+} mdThreadStep;
+
+/* Thread is done with the decimation loop, it doesn't hold back the step watermark */
+#define MD_THREAD_STEP_DONE (0x7fffffff)
+
+
+/* Edge collapse record with its logical clock, ordering it after all previous collapses sharing vertices */
+typedef struct
+{
+  mdCollapseRecord record;
+  uint32_t clock;
+  size_t order;
+} mdCollapseEntry;
+
+/* Per-thread list of edge collapse records, only allocated for a progressive mesh stream */
+typedef struct CPU_ALIGN64
+{
+  mdCollapseEntry *entrylist;
+  size_t entrycount;
+  size_t entryalloc;
+} mdCollapseLog;
+
+/* Chunk of triref storage, trirefs follow the header */
+typedef struct mdTriRefChunk mdTriRefChunk;
+struct mdTriRefChunk
+{
+  mdTriRefChunk *next;
+  size_t alloc;
+};
+
+/* Per-thread chunks of triref storage, for vertices whose trirefs outgrow their previous storage as edges collapse */
+typedef struct CPU_ALIGN64
+{
+  mdTriRefChunk *chunklist;
+  mdi *trireflist;
+  size_t trirefavail;
+} mdTriRefArena;
+
+#define MD_COLLAPSE_LOG_ALLOC_MIN (4096)
+
+/* Normal of a triangle, with the weights of its corners for vertex normals */
+typedef struct
+{
+  mdf normal[3];
+  mdf factor[3];
+} mdTriNormal;
+
+
 typedef struct
 {
 #if MD_CONFIG_ATOMIC_SUPPORT
@@ -877,12 +1034,51 @@ typedef struct
 #define MD_OP_FLAGS_DELETED (0x10)
 
 
+/* Per-thread counts of packed vertices and triangles, for the prefix sums of the threaded store */
+typedef struct
+{
+  mdi vertexcount;
+  mdi tricount;
+  /* Count of vertex clones appended in the thread's reserved range */
+  mdi clonecount;
+} mdPackCount;
+
+/* Vertices a thread may reuse or append as clones when splitting normals */
+typedef struct
+{
+  mdi searchindex;
+  mdi searchmax;
+  mdi appendindex;
+  mdi appendmax;
+} mdCloneRange;
+
+/* Vertex flagged as kept by the threaded store, until it receives its packed index */
+#define MD_VERTEX_STORE_KEEP (-2)
+
+/* Triangles gathered around a collapse for batched penalty evaluation, coordinates stored as structure of arrays */
+#define MD_PENALTY_BATCH_MAX (8)
+
+typedef struct CPU_ALIGN64
+{
+  mdf oldpoint[3][MD_PENALTY_BATCH_MAX];
+  mdf leftpoint[3][MD_PENALTY_BATCH_MAX];
+  mdf rightpoint[3][MD_PENALTY_BATCH_MAX];
+  mdf penalty[MD_PENALTY_BATCH_MAX];
+  /* Penalty sum to accumulate each triangle's penalty into */
+  int group[MD_PENALTY_BATCH_MAX];
+  int count;
+} mdPenaltyBatch;
+
+
 typedef struct
 {
   int threadcount;
   uint32_t operationflags;
   int updatestatusflag;
 
+  /* Optional context owning memory pools reused between decimations, null if none */
+  mdContext *context;
+
   /* User supplied raw data */
   void *point;
   size_t pointstride;
@@ -905,23 +1101,64 @@ typedef struct
   void *copycontext;
   void (*writenormal)( void *dst, mdf *src );
 
-  /* Per-vertex triangle references */
+  /* Per-vertex triangle references, as initially built */
   mdi *trireflist;
-  size_t trireflistcount;
   size_t trireflistalloc;
-  char paddingA[64];
-#if MD_CONFIG_ATOMIC_SUPPORT
-  mmAtomic32 trireflock;
-#else
-  mtSpin trirefspinlock;
-#endif
-  char paddingB[64];
+  /* Per-thread arenas for the trirefs outgrowing their storage */
+  mdTriRefArena *trirefarena;
+  /* Per-thread triref counts of vertex ranges, for the prefix sum of vertex trireflist */
+  size_t *trirefthreadcount;
+  /* Sorted topology build, directed edge keys of all triangles and radix sort buffer, null when building through the edge hash */
+  mdEdgeKey *edgekeylist;
+  mdEdgeKey *edgekeybuffer;
+  /* Array holding the sorted keys once all radix passes are done, the other one then holds per-corner deny marks followed by the */
+  /* indices of the sorted run heads grouped by the thread filling their range of the edge hash */
+  mdEdgeKey *edgekeysorted;
+  unsigned char *edgekeydeny;
+  /* Per-thread digit counts of the current radix pass */
+  size_t *edgekeyhistogram;
+  int edgekeypasscount;
+  /* Morton keys and radix sort buffer for the spatial partition of op queues or the reordering, null if neither is requested */
+  mdEdgeKey *mortonkeylist;
+  mdEdgeKey *mortonkeybuffer;
+  size_t *mortonhistogram;
+  /* Per-thread bounds of the points sorted, minimum then maximum */
+  mdf *mortonbounds;
+  /* Op queues are populated from ranges of triangles in Morton order */
+  int partitionflag;
+  /* Vertices and triangles reordered along a Morton curve, user index of each vertex and triangle, null if not reordered */
+  mdi *vertexmap;
+  mdi *trimap;
+  /* Vertex index of each user vertex, and count of vertices mapped, vertices past it such as clones are not reordered */
+  mdi *vertexremap;
+  mdi mapvertexcount;
+  /* Worker threads write the final mesh */
+  mdPackCount *packcount;
+  mtMutex copymutex;
 
   /* Synchronization stuff */
   mdBarrier workbarrier;
   int updatebuffercount;
   int updatebuffershift;
 
+  /* Per-thread op queues to steal ops from, null if work stealing is disabled */
+  mdStealQueue *stealqueue;
+
+  /* Per-thread sync steps and shared step watermark, null if asynchronous steps are disabled */
+  mdThreadStep *threadstep;
+  char paddingG[64];
+#if MD_CONFIG_ATOMIC_SUPPORT
+  mmAtomic32 stepwatermark;
+#else
+  int stepwatermark;
+  mtSpin stepspinlock;
+#endif
+  /* Set when a thread reached a target vertex count, all threads leave the decimation loop at the next step */
+  volatile int targetexitflag;
+  /* Set when a thread could not allocate the memory for a collapse, the decimation stops and fails */
+  volatile int allocfailflag;
+  char paddingH[64];
+
   /* List of triangles */
   void *trilist;
   long tricount;
@@ -930,6 +1167,9 @@ typedef struct
 
   /* List of vertices */
   mdVertex *vertexlist;
+#if MD_CONF_SPLIT_VERTEX_QUADRICS
+  mathQuadric *quadriclist;
+#endif
   long vertexcount;
   long vertexalloc;
   long vertexpackcount;
@@ -939,6 +1179,9 @@ typedef struct
 
   /* Collapse penalty function */
   mdf (*collapsepenalty)( mdf *newpoint, mdf *oldpoint, mdf *leftpoint, mdf *rightpoint, int *denyflag, mdf compactnesstarget, int meshflags );
+  /* Batched collapse penalty function, evaluating penaltybatchwidth triangles at once, or NULL */
+  void (*collapsepenaltybatch)( mdPenaltyBatch *batch, mdf *newpoint, int *denyflag, mdf compactnesstarget, int meshflags );
+  int penaltybatchwidth;
 
   /* To compute vertex normals */
   void *normalbase;
@@ -984,9 +1227,35 @@ typedef struct
 #endif
   char paddingF[64];
 
+  /* Count of trirefs allocated by all arenas, limited to trirefarenalimit if non-zero to stay within the memory budget */
+#if MD_CONFIG_ATOMIC_SUPPORT
+  mmAtomicL trirefarenacount;
+#else
+  long trirefarenacount;
+  mtSpin trirefarenaspinlock;
+#endif
+  size_t trirefarenalimit;
+  char paddingI[64];
+
+  /* Optional buffers counted in memory estimates, MD_MEMORY_* */
+  int memorybuffers;
+
   /* Optional vertex locking map, can be null if not used */
   uint32_t *lockmap;
 
+  /* Levels of detail to snapshot, pending level index, its target vertex count and its cost ceiling */
+  mdLevel *levellist;
+  int levelcount;
+  int levelindex;
+  volatile long levelvertexcount;
+  volatile mdf levelmaxcost;
+
+  /* Progressive mesh stream, per-thread collapse logs and per-vertex logical clocks */
+  void *streamcontext;
+  void (*collapsestream)( void *streamcontext, const void *data, size_t size );
+  mdCollapseLog *collapselog;
+  uint32_t *vertexclock;
+
   /* Advanced configuration options */
   mdf compactnesstarget;
   mdf compactnesspenalty;
@@ -998,7 +1267,6 @@ typedef struct
   mdf normalsearchangle;
 
   /* Normal recomputation buffers */
-  int clonesearchindex;
   void *vertexnormal;
   void *trinormal;
 
@@ -1007,8 +1275,40 @@ typedef struct
   mtMutex finishmutex;
   mtSignal finishsignal;
 
+  /* Start time in microseconds of each stage, zero for stages not reached */
+  uint64_t stageusecs[MD_STATUS_STAGE_COUNT];
+
 } mdMesh;
 
+#if MD_CONF_SPLIT_VERTEX_QUADRICS
+ #define MD_VertexQuadric(mesh,vertex) (&(mesh)->quadriclist[(vertex)-(mesh)->vertexlist])
+#else
+ /* Still evaluate mesh, functions taking the mesh only for the split quadrics don't warn of an unused parameter */
+ #define MD_VertexQuadric(mesh,vertex) ((void)(mesh),&(vertex)->quadric)
+#endif
+
+/* Translate between user vertex indices and internal vertex indices when the mesh has been reordered */
+static inline mdi mdMeshVertexIndex( mdMesh *mesh, mdi userindex )
+{
+  if( ( mesh->vertexremap ) && ( userindex < mesh->mapvertexcount ) )
+    return mesh->vertexremap[ userindex ];
+  return userindex;
+}
+
+static inline mdi mdMeshVertexUserIndex( mdMesh *mesh, mdi vertexindex )
+{
+  if( ( mesh->vertexmap ) && ( vertexindex < mesh->mapvertexcount ) )
+    return mesh->vertexmap[ vertexindex ];
+  return vertexindex;
+}
+
+static inline mdi mdMeshTriangleUserIndex( mdMesh *mesh, mdi triindex )
+{
+  if( mesh->trimap )
+    return mesh->trimap[ triindex ];
+  return triindex;
+}
+
 
 ////
 
@@ -1522,15 +1822,15 @@ static void mdTriangleComputeLocalQuadric( mdMesh *mesh, mdTriangle *tri, mathQu
 
 #if MD_CONF_LOCAL_VERTEX_ORIGINS
 
-static mdf mdEdgeSolvePoint( mdVertex *vertex0, mdVertex *vertex1, mdf *point, int solveflags )
+static mdf mdEdgeSolvePoint( mdMesh *mesh, mdVertex *vertex0, mdVertex *vertex1, mdf *point, int solveflags )
 {
   mdf cost, bestcost;
   mdf trypoint[3];
   mathQuadric q;
 
   /* Translate v1->q into v0's frame of reference */
-  mathQuadricTranslateStore( &q, &vertex1->quadric, vertex0->point[0] - vertex1->point[0], vertex0->point[1] - vertex1->point[1], vertex0->point[2] - vertex1->point[2] );
-  mathQuadricAddQuadric( &q, &vertex0->quadric );
+  mathQuadricTranslateStore( &q, MD_VertexQuadric( mesh, vertex1 ), vertex0->point[0] - vertex1->point[0], vertex0->point[1] - vertex1->point[1], vertex0->point[2] - vertex1->point[2] );
+  mathQuadricAddQuadric( &q, MD_VertexQuadric( mesh, vertex0 ) );
   bestcost = MD_OP_FAIL_VALUE;
 
   if( solveflags & MD_POINT_SOLVE_FLAGS_QUADRIC )
@@ -1607,15 +1907,15 @@ static mdf mdEdgeSolvePoint( mdVertex *vertex0, mdVertex *vertex1, mdf *point, i
   return bestcost;
 }
 
-static mdf mdEdgeSolvePointAdjust( mdVertex *vertex0, mdVertex *vertex1, mdf *point, int solveflags, int (*adjustcollapse)( void *adjustcontext, mdf *collapsepoint, mdf *v0point, mdf *v1point ), void *adjustcontext )
+static mdf mdEdgeSolvePointAdjust( mdMesh *mesh, mdVertex *vertex0, mdVertex *vertex1, mdf *point, int solveflags, int (*adjustcollapse)( void *adjustcontext, mdf *collapsepoint, mdf *v0point, mdf *v1point ), void *adjustcontext )
 {
   mdf cost, bestcost;
   mdf trypoint[3], localpoint[3];
   mathQuadric q;
 
   /* Translate v1->q into v0's frame of reference */
-  mathQuadricTranslateStore( &q, &vertex1->quadric, vertex0->point[0] - vertex1->point[0], vertex0->point[1] - vertex1->point[1], vertex0->point[2] - vertex1->point[2] );
-  mathQuadricAddQuadric( &q, &vertex0->quadric );
+  mathQuadricTranslateStore( &q, MD_VertexQuadric( mesh, vertex1 ), vertex0->point[0] - vertex1->point[0], vertex0->point[1] - vertex1->point[1], vertex0->point[2] - vertex1->point[2] );
+  mathQuadricAddQuadric( &q, MD_VertexQuadric( mesh, vertex0 ) );
   bestcost = MD_OP_FAIL_VALUE;
 
   if( solveflags & MD_POINT_SOLVE_FLAGS_QUADRIC )
@@ -1721,13 +2021,13 @@ static mdf mdEdgeSolvePointAdjust( mdVertex *vertex0, mdVertex *vertex1, mdf *po
 
 #else
 
-static mdf mdEdgeSolvePoint( mdVertex *vertex0, mdVertex *vertex1, mdf *point, int solveflags )
+static mdf mdEdgeSolvePoint( mdMesh *mesh, mdVertex *vertex0, mdVertex *vertex1, mdf *point, int solveflags )
 {
   mdf cost, bestcost;
   mdf trypoint[3];
   mathQuadric q;
 
-  mathQuadricAddStoreQuadric( &q, &vertex0->quadric, &vertex1->quadric );
+  mathQuadricAddStoreQuadric( &q, MD_VertexQuadric( mesh, vertex0 ), MD_VertexQuadric( mesh, vertex1 ) );
   bestcost = MD_OP_FAIL_VALUE;
 
   if( solveflags & MD_POINT_SOLVE_FLAGS_QUADRIC )
@@ -1798,13 +2098,13 @@ static mdf mdEdgeSolvePoint( mdVertex *vertex0, mdVertex *vertex1, mdf *point, i
   return bestcost;
 }
 
-static mdf mdEdgeSolvePointAdjust( mdVertex *vertex0, mdVertex *vertex1, mdf *point, int solveflags, int (*adjustcollapse)( void *adjustcontext, mdf *collapsepoint, mdf *v0point, mdf *v1point ), void *adjustcontext )
+static mdf mdEdgeSolvePointAdjust( mdMesh *mesh, mdVertex *vertex0, mdVertex *vertex1, mdf *point, int solveflags, int (*adjustcollapse)( void *adjustcontext, mdf *collapsepoint, mdf *v0point, mdf *v1point ), void *adjustcontext )
 {
   mdf cost, bestcost;
   mdf trypoint[3];
   mathQuadric q;
 
-  mathQuadricAddStoreQuadric( &q, &vertex0->quadric, &vertex1->quadric );
+  mathQuadricAddStoreQuadric( &q, MD_VertexQuadric( mesh, vertex0 ), MD_VertexQuadric( mesh, vertex1 ) );
   bestcost = MD_OP_FAIL_VALUE;
 
   if( solveflags & MD_POINT_SOLVE_FLAGS_QUADRIC )
@@ -1900,10 +2200,10 @@ static mdf mdEdgeSolvePointAdjust( mdVertex *vertex0, mdVertex *vertex1, mdf *po
 ////
 
 
-static void mdMeshAccumulateBoundary( mdVertex *vertex0, mdVertex *vertex1, mdVertex *vertex2, mdf boundaryareafactor, mdf boundaryedgeexpand )
+/* Quadric of the plane through the edge vertex0,vertex1 perpendicular to the triangle, returns zero for degenerate triangles */
+static int mdMeshBoundaryQuadric( mdVertex *vertex0, mdVertex *vertex1, mdVertex *vertex2, mdf boundaryareafactor, mdf boundaryedgeexpand, mathQuadric *q )
 {
   mdf normal[3], sideplane[4], vecta[3], vectb[3], length, expandfactor;
-  mathQuadric q;
 
   MD_VectorSubStore( vecta, vertex1->point, vertex0->point );
   MD_VectorSubStore( vectb, vertex2->point, vertex0->point );
@@ -1911,7 +2211,7 @@ static void mdMeshAccumulateBoundary( mdVertex *vertex0, mdVertex *vertex1, mdVe
   length = MD_VectorMagnitude( vecta );
 
   if( ( length == 0.0 ) || ( MD_VectorMagnitude( normal ) == 0.0 ) )
-    return;
+    return 0;
 
   MD_VectorNormalize( normal );
 #if DEBUG_VERBOSE_BOUNDARY
@@ -1942,24 +2242,33 @@ static void mdMeshAccumulateBoundary( mdVertex *vertex0, mdVertex *vertex1, mdVe
   printf( "  Boundary expand %f\n", boundaryareafactor );
   printf( "  Boundary plane %f %f %f %f : Length %f\n", sideplane[0], sideplane[1], sideplane[2], sideplane[3], length );
 #endif
-  mathQuadricInit( &q, sideplane[0], sideplane[1], sideplane[2], sideplane[3], length * boundaryareafactor );
+  mathQuadricInit( q, sideplane[0], sideplane[1], sideplane[2], sideplane[3], length * boundaryareafactor );
 
+  return 1;
+}
+
+static void mdMeshAccumulateBoundary( mdMesh *mesh, mdVertex *vertex0, mdVertex *vertex1, mdVertex *vertex2, mdf boundaryareafactor, mdf boundaryedgeexpand )
+{
+  mathQuadric q;
+
+  if( !( mdMeshBoundaryQuadric( vertex0, vertex1, vertex2, boundaryareafactor, boundaryedgeexpand, &q ) ) )
+    return;
 #if MD_CONFIG_ATOMIC_SUPPORT
   mmAtomicSpin32( &vertex0->atomicowner, -1, 0xffff );
-  mathQuadricAddQuadric( &vertex0->quadric, &q );
+  mathQuadricAddQuadric( MD_VertexQuadric( mesh, vertex0 ), &q );
   mmAtomicWrite32( &vertex0->atomicowner, -1 );
 #else
   mtSpinLock( &vertex0->ownerspinlock );
-  mathQuadricAddQuadric( &vertex0->quadric, &q );
+  mathQuadricAddQuadric( MD_VertexQuadric( mesh, vertex0 ), &q );
   mtSpinUnlock( &vertex0->ownerspinlock );
 #endif
 #if MD_CONFIG_ATOMIC_SUPPORT
   mmAtomicSpin32( &vertex1->atomicowner, -1, 0xffff );
-  mathQuadricAddQuadric( &vertex1->quadric, &q );
+  mathQuadricAddQuadric( MD_VertexQuadric( mesh, vertex1 ), &q );
   mmAtomicWrite32( &vertex1->atomicowner, -1 );
 #else
   mtSpinLock( &vertex1->ownerspinlock );
-  mathQuadricAddQuadric( &vertex1->quadric, &q );
+  mathQuadricAddQuadric( MD_VertexQuadric( mesh, vertex1 ), &q );
   mtSpinUnlock( &vertex1->ownerspinlock );
 #endif
 
@@ -2032,66 +2341,6 @@ static mmHashAccess mdEdgeHashAccess =
   .entrycmp = mdEdgeHashEntryCmp
 };
 
-static int mdMeshHashInit( mdMesh *mesh, size_t trianglecount, mdf hashsizefactor, uint32_t lockpageshift, size_t maxmemoryusage )
-{
-  size_t edgecount, hashmemsize, meshmemsize, trirefmemsize, jobmemsize, basememsize, totalmemorysize;
-  size_t hashsize;
-
-  /* lockpageshift = 7; works great, 128 hash entries per lock page */
-  if( lockpageshift < 3 )
-    lockpageshift = 3;
-  else if( lockpageshift > 16 )
-    lockpageshift = 16;
-
-  edgecount = trianglecount * 3;
-  hashsizefactor = fmax( hashsizefactor, 1.1 );
-
-  /* Memory usage for mesh vertices and indices */
-  meshmemsize = ( mesh->tricount * mesh->trisize ) + ( mesh->vertexcount * sizeof(mdVertex) );
-  /* Memory usage for trirefs */
-  trirefmemsize = ( 2 * 6 * mesh->tricount ) * sizeof(mdi);
-  /* Memory usage for job queue */
-  jobmemsize = ( ( mesh->tricount * 3 ) >> 1 ) * sizeof(mdOp);
-  /* Base fixed memory usage */
-  basememsize = meshmemsize + trirefmemsize + jobmemsize;
-
-  for( ; ; hashsizefactor -= 0.1 )
-  {
-    hashsize = (size_t)( edgecount * hashsizefactor );
-    if( hashsize < 4096 )
-      hashsize = 4096;
-
-    /* Memory usage for edge hash table */
-    hashmemsize = mmHashRequiredSize( sizeof(mdEdge), hashsize, lockpageshift );
-
-    totalmemorysize = hashmemsize + basememsize;
-
-    /* Increase estimate of memory consumption by 25% to account for extra stuff not counted here */
-    totalmemorysize += totalmemorysize >> 2;
-
-#if DEBUG_VERBOSE_MEMORY
-    printf( "  Hash size : %lld (%lld)\n", (long long)hashsize, (long long)edgecount );
-    printf( "    Estimated Memory Requirements : %lld bytes (%lld MB)\n", (long long)totalmemorysize, (long long)totalmemorysize >> 20 );
-    printf( "    Memory Hard Limit : %lld bytes (%lld MB)\n", (long long)maxmemoryusage, (long long)maxmemoryusage >> 20 );
-#endif
-
-    if( ( maxmemoryusage ) && ( totalmemorysize > maxmemoryusage ) && ( hashsizefactor > 1.15 ) )
-      continue;
-    mesh->edgehashtable = malloc( hashmemsize );
-    if( mesh->edgehashtable )
-      break;
-  }
-
-  mmHashInit( mesh->edgehashtable, &mdEdgeHashAccess, sizeof(mdEdge), hashsize, lockpageshift, MM_HASH_FLAGS_NO_COUNT, 0 );
-
-  return 1;
-}
-
-static void mdMeshHashEnd( mdMesh *mesh )
-{
-  free( mesh->edgehashtable );
-  return;
-}
 
 
 ////
@@ -2109,6 +2358,8 @@ typedef struct CPU_ALIGN64
 
   /* Hierarchical bucket sort of ops */
   void *binsort;
+  /* Lock protecting binsort when other threads may steal from it, null if work stealing is disabled */
+  mdStealQueue *stealqueue;
 
   /* List of ops flagged by other threads in need of update */
   mdUpdateBuffer updatebuffer[MD_THREAD_UPDATE_BUFFER_COUNTMAX];
@@ -2119,95 +2370,394 @@ typedef struct CPU_ALIGN64
   volatile long statuspopulatecount;
   volatile long statusdeletioncount;
   volatile long statuscollisioncount;
+  volatile long statusstealcount;
+  volatile long statusidleusecs;
+
+  /* Per-thread counters for mdStatistics */
+  long statusupdatecount;
+  long statusdenycount;
+  long statusedgecollisioncount;
+
+  /* Lock contention and barrier wait profiling, only with MD_FLAGS_PROFILE_CONTENTION */
+  int profileflag;
+  mdThreadProfile profile;
+
+  /* Accesses to the edge hash table, always counted */
+  mmHashStatistics edgehashstat;
+
+  /* Collapse log of the thread and logical clock of the collapse being performed, null if no progressive mesh stream */
+  mdCollapseLog *collapselog;
+  uint32_t collapseclock;
+
+  /* Arena of the thread for trirefs outgrowing their storage */
+  mdTriRefArena *trirefarena;
+
+  /* Pools above are initialized, they persist across decimations when owned by a mdContext */
+  int poolready;
+  int poolnodeindex;
+  int poolbinsortmode;
+  int poolupdatebuffercount;
 
 } mdThreadData;
 
 
-static void mdUpdateBufferInit( mdUpdateBuffer *updatebuffer, int opalloc )
+/* Barrier operations of the worker threads, timed with MD_FLAGS_PROFILE_CONTENTION */
+static int mdThreadBarrierSync( mdMesh *mesh, mdThreadData *tdata )
 {
-  updatebuffer->opbuffer = malloc( opalloc * sizeof(mdOp *) );
-  updatebuffer->opcount = 0;
-  updatebuffer->opalloc = opalloc;
-#if MD_CONFIG_ATOMIC_SUPPORT
-  mmAtomicWrite32( &updatebuffer->atomlock, 0x0 );
-#else
-  mtSpinInit( &updatebuffer->spinlock );
-#endif
-  return;
+  int ret;
+  uint64_t cycles;
+  if( !( tdata->profileflag ) )
+    return mdBarrierSync( &mesh->workbarrier );
+  cycles = mmReadCycleCounter();
+  ret = mdBarrierSync( &mesh->workbarrier );
+  tdata->profile.barriersynccount++;
+  tdata->profile.barriersynccycles += mmReadCycleCounter() - cycles;
+  return ret;
 }
 
-static void mdUpdateBufferEnd( mdUpdateBuffer *updatebuffer )
+static void mdThreadBarrierCheckGlobal( mdMesh *mesh, mdThreadData *tdata )
 {
-#ifndef MD_CONFIG_ATOMIC_SUPPORT
-  mtSpinDestroy( &updatebuffer->spinlock );
-#endif
-  free( updatebuffer->opbuffer );
+  uint64_t cycles;
+  if( !( tdata->profileflag ) || !( mesh->workbarrier.lockflag ) )
+  {
+    mdBarrierCheckGlobal( &mesh->workbarrier );
+    return;
+  }
+  cycles = mmReadCycleCounter();
+  mdBarrierCheckGlobal( &mesh->workbarrier );
+  tdata->profile.globalstopcount++;
+  tdata->profile.globalstopcycles += mmReadCycleCounter() - cycles;
   return;
 }
 
-static void mdUpdateBufferAdd( mdUpdateBuffer *updatebuffer, mdOp *op, int orflags )
+static void mdThreadBarrierLockGlobal( mdMesh *mesh, mdThreadData *tdata )
 {
-  int32_t flags;
-#if MD_CONFIG_ATOMIC_SUPPORT
-  for( ; ; )
-  {
-    flags = mmAtomicRead32( &op->flags );
-    if( flags & MD_OP_FLAGS_UPDATE_QUEUED )
-    {
-      if( !( flags & MD_OP_FLAGS_UPDATE_NEEDED ) || ( orflags ) )
-        mmAtomicOr32( &op->flags, orflags | MD_OP_FLAGS_UPDATE_NEEDED );
-      return;
-    }
-    if( mmAtomicCmpReplace32( &op->flags, flags, flags | orflags | MD_OP_FLAGS_UPDATE_QUEUED | MD_OP_FLAGS_UPDATE_NEEDED ) )
-      break;
-  }
-  /* TODO: Avoid spin lock, use atomic increment for write offset? Careful with this realloc, pointer could become invalid */
-  mmAtomicSpin32( &updatebuffer->atomlock, 0x0, 0x1 );
-  if( updatebuffer->opcount >= updatebuffer->opalloc )
-  {
-    updatebuffer->opalloc <<= 1;
-    updatebuffer->opbuffer = realloc( updatebuffer->opbuffer, updatebuffer->opalloc * sizeof(mdOp *) );
-  }
-  updatebuffer->opbuffer[ updatebuffer->opcount++ ] = op;
-  mmAtomicWrite32( &updatebuffer->atomlock, 0x0 );
-#else
-  mtSpinLock( &op->spinlock );
-  op->flags |= orflags;
-  flags = op->flags;
-  if( flags & MD_OP_FLAGS_UPDATE_QUEUED )
+  uint64_t cycles;
+  if( !( tdata->profileflag ) )
   {
-    if( !( flags & MD_OP_FLAGS_UPDATE_NEEDED ) )
-      op->flags |= MD_OP_FLAGS_UPDATE_NEEDED;
-    mtSpinUnlock( &op->spinlock );
+    mdBarrierLockGlobal( &mesh->workbarrier );
     return;
   }
-  op->flags |= MD_OP_FLAGS_UPDATE_QUEUED | MD_OP_FLAGS_UPDATE_NEEDED;
-  mtSpinUnlock( &op->spinlock );
-  mtSpinLock( &updatebuffer->spinlock );
-  if( updatebuffer->opcount >= updatebuffer->opalloc )
-  {
-    updatebuffer->opalloc <<= 1;
-    updatebuffer->opbuffer = realloc( updatebuffer->opbuffer, updatebuffer->opalloc * sizeof(mdOp *) );
-  }
-  updatebuffer->opbuffer[ updatebuffer->opcount++ ] = op;
-  mtSpinUnlock( &updatebuffer->spinlock );
-#endif
+  cycles = mmReadCycleCounter();
+  mdBarrierLockGlobal( &mesh->workbarrier );
+  tdata->profile.globallockcount++;
+  tdata->profile.globallockcycles += mmReadCycleCounter() - cycles;
   return;
 }
 
 
+/* Memory pools kept between decimations, grown on demand */
+struct mdContext
+{
+  mdState *state;
+#if !MD_CONF_FLOAT_VARIANT
+  /* Context of the single precision variant, created on first use */
+  mdContext *floatcontext;
+#endif
+
+  /* Mesh storage */
+  mdVertex *vertexlist;
+  long vertexalloc;
+#if MD_CONF_SPLIT_VERTEX_QUADRICS
+  mathQuadric *quadriclist;
+#endif
+  mdi *trireflist;
+  size_t trireflistalloc;
+  void *trilist;
+  size_t trilistsize;
+  void *edgehashtable;
+  size_t edgehashsize;
+
+  /* Per-thread op blocks, op queues and update buffers */
+  mdThreadData *threaddata[MD_THREAD_COUNT_MAX];
+};
+
 
 ////
 
 
+/* Buffers allocated depending on the flags and settings of the operation, counted by mdMeshEstimateMemory() */
+#define MD_MEMORY_EDGE_KEYS (0x1)
+#define MD_MEMORY_MORTON_KEYS (0x2)
+#define MD_MEMORY_REORDER_MAPS (0x4)
+#define MD_MEMORY_NORMALS (0x8)
+#define MD_MEMORY_COLLAPSE_LOG (0x10)
+#define MD_MEMORY_LEVELS (0x20)
 
-#define MD_COMPACTNESS_NORMALIZATION_FACTOR (0.5*4.0*1.732050808)
+/* Buffers mdMeshInit() and later stages allocate, flags must be adjusted as by mdMeshDecimationSetup() */
+static int mdMeshMemoryBuffers( int flags, int threadcount, int normalflag, int streamflag, int levelflag )
+{
+  int buffers;
+  buffers = 0;
+  if( flags & MD_FLAGS_SORTED_TOPOLOGY )
+    buffers |= MD_MEMORY_EDGE_KEYS;
+  if( ( ( flags & MD_FLAGS_SPATIAL_PARTITION ) && !( flags & MD_FLAGS_NO_DECIMATION ) && ( threadcount > 1 ) ) || ( flags & MD_FLAGS_REORDER_MESH ) )
+    buffers |= MD_MEMORY_MORTON_KEYS;
+  if( flags & MD_FLAGS_REORDER_MESH )
+    buffers |= MD_MEMORY_REORDER_MAPS;
+  if( normalflag )
+    buffers |= MD_MEMORY_NORMALS;
+  if( ( streamflag ) && !( flags & MD_FLAGS_NO_DECIMATION ) )
+    buffers |= MD_MEMORY_COLLAPSE_LOG;
+  if( levelflag )
+    buffers |= MD_MEMORY_LEVELS;
+  return buffers;
+}
 
-static mdf mdEdgeCollapsePenaltyTriangle( mdf *newpoint, mdf *oldpoint, mdf *leftpoint, mdf *rightpoint, int *denyflag, mdf compactnesstarget, int meshflags )
+/* Estimate of the memory required to decimate a mesh with an edge hash table of hashsize entries, or without any hash if zero */
+static size_t mdMeshEstimateMemory( size_t vertexcount, size_t tricount, size_t trisize, size_t hashsize, uint32_t lockpageshift, int buffers )
 {
-  mdf penalty, compactness, oldcompactness, newcompactness, vecta2, norm;
-  mdf vecta[3], oldvectb[3], oldvectc[3], newvectb[3], newvectc[3], oldnormal[3], newnormal[3];
-  mdf oldmagnitude, newmagnitude;
+  size_t meshmemsize, trirefmemsize, jobmemsize, hashmemsize, buffermemsize, keycount, totalmemorysize;
+
+  /* Memory usage for mesh vertices and indices */
+  meshmemsize = ( tricount * trisize ) + ( vertexcount * sizeof(mdVertex) );
+#if MD_CONF_SPLIT_VERTEX_QUADRICS
+  meshmemsize += vertexcount * sizeof(mathQuadric);
+#endif
+  /* Memory usage for trirefs, twice the initial count, the per-thread arenas can't allocate beyond the budget */
+  trirefmemsize = ( 2 * 3 * tricount ) * sizeof(mdi);
+  /* Memory usage for job queue and edge hash table */
+  jobmemsize = 0;
+  hashmemsize = 0;
+  if( hashsize )
+  {
+    jobmemsize = ( ( tricount * 3 ) >> 1 ) * sizeof(mdOp);
+    hashmemsize = mmHashRequiredSize( sizeof(mdEdge), hashsize, lockpageshift );
+  }
+
+  /* Optional buffers */
+  buffermemsize = 0;
+  if( buffers & MD_MEMORY_EDGE_KEYS )
+    buffermemsize += 2 * ( 3 * tricount ) * sizeof(mdEdgeKey);
+  if( buffers & MD_MEMORY_MORTON_KEYS )
+  {
+    keycount = ( vertexcount > tricount ? vertexcount : tricount );
+    buffermemsize += 2 * keycount * sizeof(mdEdgeKey);
+  }
+  if( buffers & MD_MEMORY_REORDER_MAPS )
+    buffermemsize += ( ( 2 * vertexcount ) + tricount ) * sizeof(mdi);
+  if( buffers & MD_MEMORY_NORMALS )
+    buffermemsize += ( tricount * sizeof(mdTriNormal) ) + ( vertexcount * 3 * sizeof(mdf) );
+  /* Logs grow by doubling up to one collapse per vertex, then merged in one list, plus per-vertex clocks */
+  if( buffers & MD_MEMORY_COLLAPSE_LOG )
+    buffermemsize += ( 3 * vertexcount * sizeof(mdCollapseEntry) ) + ( vertexcount * sizeof(uint32_t) );
+  /* Map of vertices written for each level snapshot */
+  if( buffers & MD_MEMORY_LEVELS )
+    buffermemsize += vertexcount * sizeof(mdi);
+
+  totalmemorysize = meshmemsize + trirefmemsize + jobmemsize + hashmemsize + buffermemsize;
+  /* Increase estimate of memory consumption by 25% to account for per-thread buffers and extra stuff not counted here */
+  totalmemorysize += totalmemorysize >> 2;
+
+  return totalmemorysize;
+}
+
+/* Smallest edge hash table size tried by mdMeshHashInit() */
+static size_t mdMeshHashSizeMin( size_t trianglecount )
+{
+  size_t hashsize;
+  hashsize = (size_t)( ( trianglecount * 3 ) * 1.1 );
+  if( hashsize < 4096 )
+    hashsize = 4096;
+  return hashsize;
+}
+
+static int mdMeshHashInit( mdMesh *mesh, size_t trianglecount, mdf hashsizefactor, uint32_t lockpageshift, size_t maxmemoryusage )
+{
+  size_t edgecount, hashmemsize, totalmemorysize;
+  size_t hashsize;
+
+  /* lockpageshift = 7; works great, 128 hash entries per lock page */
+  if( lockpageshift < 3 )
+    lockpageshift = 3;
+  else if( lockpageshift > 16 )
+    lockpageshift = 16;
+
+  edgecount = trianglecount * 3;
+  hashsizefactor = fmax( hashsizefactor, 1.1 );
+
+  mesh->edgehashtable = 0;
+  for( ; ; hashsizefactor -= 0.1 )
+  {
+    hashsize = (size_t)( edgecount * hashsizefactor );
+    if( hashsize < 4096 )
+      hashsize = 4096;
+
+    /* Memory usage for edge hash table */
+    hashmemsize = mmHashRequiredSize( sizeof(mdEdge), hashsize, lockpageshift );
+    totalmemorysize = mdMeshEstimateMemory( mesh->vertexalloc, mesh->tricount, mesh->trisize, hashsize, lockpageshift, mesh->memorybuffers );
+
+#if DEBUG_VERBOSE_MEMORY
+    printf( "  Hash size : %lld (%lld)\n", (long long)hashsize, (long long)edgecount );
+    printf( "    Estimated Memory Requirements : %lld bytes (%lld MB)\n", (long long)totalmemorysize, (long long)totalmemorysize >> 20 );
+    printf( "    Memory Hard Limit : %lld bytes (%lld MB)\n", (long long)maxmemoryusage, (long long)maxmemoryusage >> 20 );
+#endif
+
+    if( ( maxmemoryusage ) && ( totalmemorysize > maxmemoryusage ) )
+    {
+      /* Shrink the hash table down to its minimum size, then give up */
+      if( hashsizefactor > 1.15 )
+        continue;
+      return 0;
+    }
+    if( mesh->context )
+    {
+      /* Reuse the context's table if large enough */
+      if( mesh->context->edgehashsize < hashmemsize )
+      {
+        free( mesh->context->edgehashtable );
+        mesh->context->edgehashtable = malloc( hashmemsize );
+        mesh->context->edgehashsize = ( mesh->context->edgehashtable ? hashmemsize : 0 );
+      }
+      mesh->edgehashtable = mesh->context->edgehashtable;
+    }
+    else
+      mesh->edgehashtable = malloc( hashmemsize );
+    if( mesh->edgehashtable )
+      break;
+    if( hashsizefactor <= 1.15 )
+      return 0;
+  }
+
+  mmHashInit( mesh->edgehashtable, &mdEdgeHashAccess, sizeof(mdEdge), hashsize, lockpageshift, MM_HASH_FLAGS_NO_COUNT, 0 );
+
+  return 1;
+}
+
+static void mdMeshHashEnd( mdMesh *mesh )
+{
+  if( !( mesh->context ) )
+    free( mesh->edgehashtable );
+  return;
+}
+
+
+
+////
+
+
+
+static inline void mdStealQueueLock( mdStealQueue *queue )
+{
+#if MD_CONFIG_ATOMIC_SUPPORT
+  mmAtomicSpin32( &queue->atomlock, 0x0, 0x1 );
+#else
+  mtSpinLock( &queue->spinlock );
+#endif
+  return;
+}
+
+static inline void mdStealQueueUnlock( mdStealQueue *queue )
+{
+#if MD_CONFIG_ATOMIC_SUPPORT
+  mmAtomicWrite32( &queue->atomlock, 0x0 );
+#else
+  mtSpinUnlock( &queue->spinlock );
+#endif
+  return;
+}
+
+/* The thread's own binsort only needs locking if other threads can steal from it */
+static inline void mdThreadQueueLock( mdThreadData *tdata )
+{
+  if( tdata->stealqueue )
+    mdStealQueueLock( tdata->stealqueue );
+  return;
+}
+
+static inline void mdThreadQueueUnlock( mdThreadData *tdata )
+{
+  if( tdata->stealqueue )
+    mdStealQueueUnlock( tdata->stealqueue );
+  return;
+}
+
+
+static void mdUpdateBufferInit( mdUpdateBuffer *updatebuffer, int opalloc )
+{
+  updatebuffer->opbuffer = malloc( opalloc * sizeof(mdOp *) );
+  updatebuffer->opcount = 0;
+  updatebuffer->opalloc = opalloc;
+#if MD_CONFIG_ATOMIC_SUPPORT
+  mmAtomicWrite32( &updatebuffer->atomlock, 0x0 );
+#else
+  mtSpinInit( &updatebuffer->spinlock );
+#endif
+  return;
+}
+
+static void mdUpdateBufferEnd( mdUpdateBuffer *updatebuffer )
+{
+#ifndef MD_CONFIG_ATOMIC_SUPPORT
+  mtSpinDestroy( &updatebuffer->spinlock );
+#endif
+  free( updatebuffer->opbuffer );
+  return;
+}
+
+static void mdUpdateBufferAdd( mdUpdateBuffer *updatebuffer, mdOp *op, int orflags )
+{
+  int32_t flags;
+#if MD_CONFIG_ATOMIC_SUPPORT
+  for( ; ; )
+  {
+    flags = mmAtomicRead32( &op->flags );
+    if( flags & MD_OP_FLAGS_UPDATE_QUEUED )
+    {
+      if( !( flags & MD_OP_FLAGS_UPDATE_NEEDED ) || ( orflags ) )
+        mmAtomicOr32( &op->flags, orflags | MD_OP_FLAGS_UPDATE_NEEDED );
+      return;
+    }
+    if( mmAtomicCmpReplace32( &op->flags, flags, flags | orflags | MD_OP_FLAGS_UPDATE_QUEUED | MD_OP_FLAGS_UPDATE_NEEDED ) )
+      break;
+  }
+  /* TODO: Avoid spin lock, use atomic increment for write offset? Careful with this realloc, pointer could become invalid */
+  mmAtomicSpin32( &updatebuffer->atomlock, 0x0, 0x1 );
+  if( updatebuffer->opcount >= updatebuffer->opalloc )
+  {
+    updatebuffer->opalloc <<= 1;
+    updatebuffer->opbuffer = realloc( updatebuffer->opbuffer, updatebuffer->opalloc * sizeof(mdOp *) );
+  }
+  updatebuffer->opbuffer[ updatebuffer->opcount++ ] = op;
+  mmAtomicWrite32( &updatebuffer->atomlock, 0x0 );
+#else
+  mtSpinLock( &op->spinlock );
+  op->flags |= orflags;
+  flags = op->flags;
+  if( flags & MD_OP_FLAGS_UPDATE_QUEUED )
+  {
+    if( !( flags & MD_OP_FLAGS_UPDATE_NEEDED ) )
+      op->flags |= MD_OP_FLAGS_UPDATE_NEEDED;
+    mtSpinUnlock( &op->spinlock );
+    return;
+  }
+  op->flags |= MD_OP_FLAGS_UPDATE_QUEUED | MD_OP_FLAGS_UPDATE_NEEDED;
+  mtSpinUnlock( &op->spinlock );
+  mtSpinLock( &updatebuffer->spinlock );
+  if( updatebuffer->opcount >= updatebuffer->opalloc )
+  {
+    updatebuffer->opalloc <<= 1;
+    updatebuffer->opbuffer = realloc( updatebuffer->opbuffer, updatebuffer->opalloc * sizeof(mdOp *) );
+  }
+  updatebuffer->opbuffer[ updatebuffer->opcount++ ] = op;
+  mtSpinUnlock( &updatebuffer->spinlock );
+#endif
+  return;
+}
+
+
+
+////
+
+
+
+#define MD_COMPACTNESS_NORMALIZATION_FACTOR (0.5*4.0*1.732050808)
+
+static mdf mdEdgeCollapsePenaltyTriangle( mdf *newpoint, mdf *oldpoint, mdf *leftpoint, mdf *rightpoint, int *denyflag, mdf compactnesstarget, int meshflags )
+{
+  mdf penalty, compactness, oldcompactness, newcompactness, vecta2, norm;
+  mdf vecta[3], oldvectb[3], oldvectc[3], newvectb[3], newvectc[3], oldnormal[3], newnormal[3];
+  mdf oldmagnitude, newmagnitude;
 
   /* Normal of old triangle */
   MD_VectorSubStore( vecta, rightpoint, leftpoint );
@@ -2350,7 +2900,7 @@ static float mdEdgeCollapsePenaltyTriangleSSE4p1f( float *newpoint, float *oldpo
   newvectc = _mm_dp_ps( newvectc, newvectc, 0x1 | 0x70 );
   norm = _mm_add_ss( _mm_add_ss( vecta, newvectb ), newvectc );
   newcompactness = _mm_mul_ss( _mm_set_ss( MD_COMPACTNESS_NORMALIZATION_FACTOR ), newmagnitude );
-  if( _mm_comile_ss( newcompactness, _mm_mul_ss( compactnesstarget, norm ) ) )
+  if( _mm_comile_ss( newcompactness, _mm_mul_ss( _mm_set_ss( compactnesstarget ), norm ) ) )
   {
   #if MD_CONFIG_APPROX_MATH
     newcompactness = _mm_mul_ss( newcompactness, _mm_rcp_ss( norm ) );
@@ -2424,7 +2974,7 @@ static double mdEdgeCollapsePenaltyTriangleSSE4p1d( double *newpoint, double *ol
   else
   {
     /* Detect normal inversion */
-    invcheck = _mm_add_sd( _mm_dp_pd( oldnormal0, oldnormal0, 0x1 | 0x30 ), _mm_mul_sd( oldnormal1, newnormal1 ) );
+    invcheck = _mm_add_sd( _mm_dp_pd( oldnormal0, newnormal0, 0x1 | 0x30 ), _mm_mul_sd( oldnormal1, newnormal1 ) );
     if( _mm_comilt_sd( invcheck, _mm_set_sd( 0.0 ) ) )
     {
 #if DEBUG_VERBOSE_COST >= 2
@@ -2552,7 +3102,7 @@ static float mdEdgeCollapsePenaltyTriangleSSE3f( float *newpoint, float *oldpoin
   newvectc = _mm_movehdup_ps( newvectb );
   norm = _mm_add_ss( _mm_add_ss( vecta, newvectb ), newvectc );
   newcompactness = _mm_mul_ss( _mm_set_ss( MD_COMPACTNESS_NORMALIZATION_FACTOR ), newmagnitude );
-  if( _mm_comile_ss( newcompactness, _mm_mul_ss( compactnesstarget, norm ) ) )
+  if( _mm_comile_ss( newcompactness, _mm_mul_ss( _mm_set_ss( compactnesstarget ), norm ) ) )
   {
   #if MD_CONFIG_APPROX_MATH
     newcompactness = _mm_mul_ss( newcompactness, _mm_rcp_ss( norm ) );
@@ -2693,7 +3243,7 @@ static double mdEdgeCollapsePenaltyTriangleSSE3d( double *newpoint, double *oldp
 
 static float mdEdgeCollapsePenaltyTriangleSSE2f( float *newpoint, float *oldpoint, float *leftpoint, float *rightpoint, int *denyflag, float compactnesstarget, int meshflags )
 {
-  return mdEdgeCollapsePenaltyTriangle( newpoint, oldpoint, leftpoint, rightpoint, denyflag, compactnesstarget );
+  return mdEdgeCollapsePenaltyTriangle( newpoint, oldpoint, leftpoint, rightpoint, denyflag, compactnesstarget, meshflags );
 }
 
  #else
@@ -2806,84 +3356,630 @@ static double mdEdgeCollapsePenaltyTriangleSSE2d( double *newpoint, double *oldp
 
 #endif
 
+#if CPU_DISPATCH_SUPPORT
 
-////
-
-
-static mdf mdEdgeCollapsePenaltyTriRefs( mdMesh *mesh, mdThreadData *tdata, mdi *trireflist, mdi trirefcount, mdi pivotindex, mdi skipindex, mdf *collapsepoint, int *denyflag )
-{
-  int index;
-  mdf penalty, tripenalty;
-  mdi triindex;
-  mdTriangle *tri;
-  mdf (*collapsepenalty)( mdf *newpoint, mdf *oldpoint, mdf *leftpoint, mdf *rightpoint, int *denyflag, mdf compactnesstarget, int meshflags );
+ #if !MD_CONF_DOUBLE_PRECISION
 
-  collapsepenalty = mesh->collapsepenalty;
-  penalty = 0.0;
-  for( index = 0 ; index < trirefcount ; index++ )
+/* Old and new triangles are processed together, the old one in the low 128 bits, the new one in the high 128 bits */
+static CPU_TARGET_AVX2 float mdEdgeCollapsePenaltyTriangleAVX2f( float *newpoint, float *oldpoint, float *leftpoint, float *rightpoint, int *denyflag, float compactnesstarget, int meshflags )
+{
+  float penalty, compactness, oldcompactness, newcompactness, oldmagnitude, newmagnitude, norm, invcheck;
+  float dotnormal[8], dotcross[8], dotedge[8];
+  __m128i mask;
+  __m128 left128, right128;
+  __m256 left, right, points, vecta, vectb, vectc, normal, cross;
+
+  mask = _mm_set_epi32( 0, -1, -1, -1 );
+  left128 = _mm_maskload_ps( leftpoint, mask );
+  right128 = _mm_maskload_ps( rightpoint, mask );
+  left = _mm256_insertf128_ps( _mm256_castps128_ps256( left128 ), left128, 1 );
+  right = _mm256_insertf128_ps( _mm256_castps128_ps256( right128 ), right128, 1 );
+  points = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_maskload_ps( oldpoint, mask ) ), _mm_maskload_ps( newpoint, mask ), 1 );
+  vecta = _mm256_sub_ps( right, left );
+  vectb = _mm256_sub_ps( points, left );
+  vectc = _mm256_sub_ps( points, right );
+  /* Normals of old and new triangles, vecta.yzx * vectb.zxy - vecta.zxy * vectb.yzx */
+  normal = _mm256_sub_ps(
+    _mm256_mul_ps( _mm256_permute_ps( vecta, _MM_SHUFFLE(3,0,2,1) ), _mm256_permute_ps( vectb, _MM_SHUFFLE(3,1,0,2) ) ),
+    _mm256_mul_ps( _mm256_permute_ps( vecta, _MM_SHUFFLE(3,1,0,2) ), _mm256_permute_ps( vectb, _MM_SHUFFLE(3,0,2,1) ) )
+  );
+  cross = _mm256_mul_ps( normal, _mm256_permute2f128_ps( normal, normal, 0x01 ) );
+  _mm256_storeu_ps( dotcross, cross );
+  _mm256_storeu_ps( dotnormal, _mm256_dp_ps( normal, normal, 0x71 ) );
+  if( meshflags & MD_FLAGS_PLANAR_MODE )
   {
-    if( *denyflag )
-      break;
-    triindex = trireflist[ index ];
-    tri = ADDRESS( mesh->trilist, triindex * mesh->trisize );
-    if( tri->v[0] == -1 )
-      continue;
-
-#if DEBUG_DEBUG_CHECK_SOMETHING
-    mdi triv[3];
-    triv[0] = tri->v[0];
-    triv[1] = tri->v[1];
-    triv[2] = tri->v[2];
-#endif
-
-#if DEBUG_VERBOSE_COST >= 2
-    printf( "    Penalty Tri %d,%d,%d ( Pivot %d ; Skip %d )\n", tri->v[0], tri->v[1], tri->v[2], pivotindex, skipindex );
-#endif
-    if( tri->v[0] == pivotindex )
+    /* Detect planar normal Z inversion */
+    if( dotcross[2] < 0.0 )
     {
-      if( ( tri->v[1] == skipindex ) || ( tri->v[2] == skipindex ) )
-        continue;
-      tripenalty = collapsepenalty( collapsepoint, mesh->vertexlist[ tri->v[0] ].point, mesh->vertexlist[ tri->v[2] ].point, mesh->vertexlist[ tri->v[1] ].point, denyflag, mesh->compactnesstarget, mesh->operationflags );
 #if DEBUG_VERBOSE_COST >= 2
-      printf( "      Penalty %f\n", tripenalty );
+      printf( "      !! Normal Z inversion denied in planar mode\n" );
 #endif
-      penalty += tripenalty;
+      *denyflag = 1;
+      return 0.0;
     }
-    else if( tri->v[1] == pivotindex )
+  }
+  else
+  {
+    /* Detect normal inversion */
+    invcheck = ( dotcross[0] + dotcross[1] ) + dotcross[2];
+    if( invcheck < 0.0 )
     {
-      if( ( tri->v[2] == skipindex ) || ( tri->v[0] == skipindex ) )
-        continue;
-      tripenalty = collapsepenalty( collapsepoint, mesh->vertexlist[ tri->v[1] ].point, mesh->vertexlist[ tri->v[0] ].point, mesh->vertexlist[ tri->v[2] ].point, denyflag, mesh->compactnesstarget, mesh->operationflags );
 #if DEBUG_VERBOSE_COST >= 2
-      printf( "      Penalty %f\n", tripenalty );
+      printf( "      !! Normal inversion denied\n" );
 #endif
-      penalty += tripenalty;
+      *denyflag = 1;
+      return 0.0;
     }
-    else if( tri->v[2] == pivotindex )
-    {
-      if( ( tri->v[0] == skipindex ) || ( tri->v[1] == skipindex ) )
-        continue;
-      tripenalty = collapsepenalty( collapsepoint, mesh->vertexlist[ tri->v[2] ].point, mesh->vertexlist[ tri->v[1] ].point, mesh->vertexlist[ tri->v[0] ].point, denyflag, mesh->compactnesstarget, mesh->operationflags );
+  }
+  /* Prevent near-zero area triangles */
+  oldmagnitude = sqrtf( dotnormal[0] );
+  newmagnitude = sqrtf( dotnormal[4] );
+  if( !( newmagnitude > ( MD_COLINEAR_REJECTION * oldmagnitude ) ) )
+  {
 #if DEBUG_VERBOSE_COST >= 2
-      printf( "      Penalty %f\n", tripenalty );
+    printf( "      !! Colinear magnitude denied\n" );
 #endif
-      penalty += tripenalty;
-    }
-    else
-    {
-#if DEBUG_DEBUG_CHECK_SOMETHING
-      MD_ERROR( "SHOULD NOT HAPPEN %s:%d\n", 1, __FILE__, __LINE__ );
-      {
-        int32_t debugowner;
-        mdVertex *debugvertex;
-
-        printf( "Failure to locate pivot %d in triref %d / %d\n", pivotindex, index, trirefcount );
-
-        debugvertex = &mesh->vertexlist[ pivotindex ];
-        debugowner = mmAtomicRead32( &debugvertex->atomicowner );
-        printf( "  Pivot owner %d (self %d), redirect -> %d\n", debugowner, tdata->threadid, debugvertex->redirectindex );
-
-        debugvertex = &mesh->vertexlist[ tri->v[0] ];
+    *denyflag = 1;
+    return 0.0;
+  }
+  /* Penalize long thin triangles ; vecta^2 in lane 1, vectb^2 in lanes 0 and 4, vectc^2 in lanes 2 and 6 */
+  penalty = 0.0;
+  _mm256_storeu_ps( dotedge, _mm256_add_ps( _mm256_add_ps( _mm256_dp_ps( vecta, vecta, 0x72 ), _mm256_dp_ps( vectb, vectb, 0x71 ) ), _mm256_dp_ps( vectc, vectc, 0x74 ) ) );
+  newcompactness = MD_COMPACTNESS_NORMALIZATION_FACTOR * newmagnitude;
+  norm = ( dotedge[1] + dotedge[4] ) + dotedge[6];
+  if( newcompactness < ( compactnesstarget * norm ) )
+  {
+    newcompactness /= norm;
+    oldcompactness = ( MD_COMPACTNESS_NORMALIZATION_FACTOR * oldmagnitude ) / ( ( dotedge[1] + dotedge[0] ) + dotedge[2] );
+    compactness = fmin( compactnesstarget, oldcompactness ) - newcompactness;
+    penalty = fmaxf( penalty, compactness );
+  }
+  return penalty;
+}
+
+
+/* Lanes of x * factor, the product taken in double precision and rounded to single, as the scalar kernel does with double constants */
+static inline CPU_TARGET_AVX2 __m256 mdAVX2ScaleDoubleps( __m256 x, double factor )
+{
+  __m256d scale;
+  scale = _mm256_set1_pd( factor );
+  return _mm256_insertf128_ps( _mm256_castps128_ps256( _mm256_cvtpd_ps( _mm256_mul_pd( _mm256_cvtps_pd( _mm256_castps256_ps128( x ) ), scale ) ) ), _mm256_cvtpd_ps( _mm256_mul_pd( _mm256_cvtps_pd( _mm256_extractf128_ps( x, 1 ) ), scale ) ), 1 );
+}
+
+/* Lanes of ( x * factor ) / divisor, evaluated in double precision and rounded to single */
+static inline CPU_TARGET_AVX2 __m256 mdAVX2ScaleDivDoubleps( __m256 x, double factor, __m256 divisor )
+{
+  __m256d scale, low, high;
+  scale = _mm256_set1_pd( factor );
+  low = _mm256_div_pd( _mm256_mul_pd( _mm256_cvtps_pd( _mm256_castps256_ps128( x ) ), scale ), _mm256_cvtps_pd( _mm256_castps256_ps128( divisor ) ) );
+  high = _mm256_div_pd( _mm256_mul_pd( _mm256_cvtps_pd( _mm256_extractf128_ps( x, 1 ) ), scale ), _mm256_cvtps_pd( _mm256_extractf128_ps( divisor, 1 ) ) );
+  return _mm256_insertf128_ps( _mm256_castps128_ps256( _mm256_cvtpd_ps( low ) ), _mm256_cvtpd_ps( high ), 1 );
+}
+
+/* Bit mask of the lanes where !( x > ( factor * y ) ), the product and comparison in double precision */
+static inline CPU_TARGET_AVX2 int mdAVX2NotGreaterScaleDoubleps( __m256 x, double factor, __m256 y )
+{
+  __m256d scale, low, high;
+  scale = _mm256_set1_pd( factor );
+  low = _mm256_cmp_pd( _mm256_cvtps_pd( _mm256_castps256_ps128( x ) ), _mm256_mul_pd( scale, _mm256_cvtps_pd( _mm256_castps256_ps128( y ) ) ), _CMP_NGT_UQ );
+  high = _mm256_cmp_pd( _mm256_cvtps_pd( _mm256_extractf128_ps( x, 1 ) ), _mm256_mul_pd( scale, _mm256_cvtps_pd( _mm256_extractf128_ps( y, 1 ) ) ), _CMP_NGT_UQ );
+  return _mm256_movemask_pd( low ) | ( _mm256_movemask_pd( high ) << 4 );
+}
+
+/* Eight triangles sharing the same new point, one per lane */
+static CPU_TARGET_AVX2 void mdEdgeCollapsePenaltyBatchAVX2f( mdPenaltyBatch *batch, float *newpoint, int *denyflag, float compactnesstarget, int meshflags )
+{
+  __m256 newx, newy, newz, ax, ay, az, obx, oby, obz, nbx, nby, nbz, ocx, ocy, ocz, ncx, ncy, ncz;
+  __m256 onx, ony, onz, nnx, nny, nnz, oldmagnitude, newmagnitude, vecta2, vectb2, vectc2, norm, newcompactness, oldcompactness, penalty;
+  __m256 deny, penalize, target;
+  int denymask;
+
+  newx = _mm256_broadcast_ss( &newpoint[0] );
+  newy = _mm256_broadcast_ss( &newpoint[1] );
+  newz = _mm256_broadcast_ss( &newpoint[2] );
+  ax = _mm256_sub_ps( _mm256_load_ps( batch->rightpoint[0] ), _mm256_load_ps( batch->leftpoint[0] ) );
+  ay = _mm256_sub_ps( _mm256_load_ps( batch->rightpoint[1] ), _mm256_load_ps( batch->leftpoint[1] ) );
+  az = _mm256_sub_ps( _mm256_load_ps( batch->rightpoint[2] ), _mm256_load_ps( batch->leftpoint[2] ) );
+  obx = _mm256_sub_ps( _mm256_load_ps( batch->oldpoint[0] ), _mm256_load_ps( batch->leftpoint[0] ) );
+  oby = _mm256_sub_ps( _mm256_load_ps( batch->oldpoint[1] ), _mm256_load_ps( batch->leftpoint[1] ) );
+  obz = _mm256_sub_ps( _mm256_load_ps( batch->oldpoint[2] ), _mm256_load_ps( batch->leftpoint[2] ) );
+  nbx = _mm256_sub_ps( newx, _mm256_load_ps( batch->leftpoint[0] ) );
+  nby = _mm256_sub_ps( newy, _mm256_load_ps( batch->leftpoint[1] ) );
+  nbz = _mm256_sub_ps( newz, _mm256_load_ps( batch->leftpoint[2] ) );
+  /* Normals of old and new triangles */
+  onx = _mm256_sub_ps( _mm256_mul_ps( ay, obz ), _mm256_mul_ps( az, oby ) );
+  ony = _mm256_sub_ps( _mm256_mul_ps( az, obx ), _mm256_mul_ps( ax, obz ) );
+  onz = _mm256_sub_ps( _mm256_mul_ps( ax, oby ), _mm256_mul_ps( ay, obx ) );
+  nnx = _mm256_sub_ps( _mm256_mul_ps( ay, nbz ), _mm256_mul_ps( az, nby ) );
+  nny = _mm256_sub_ps( _mm256_mul_ps( az, nbx ), _mm256_mul_ps( ax, nbz ) );
+  nnz = _mm256_sub_ps( _mm256_mul_ps( ax, nby ), _mm256_mul_ps( ay, nbx ) );
+  /* Detect normal inversion, or planar normal Z inversion */
+  if( meshflags & MD_FLAGS_PLANAR_MODE )
+    deny = _mm256_cmp_ps( _mm256_mul_ps( onz, nnz ), _mm256_setzero_ps(), _CMP_LT_OQ );
+  else
+    deny = _mm256_cmp_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( onx, nnx ), _mm256_mul_ps( ony, nny ) ), _mm256_mul_ps( onz, nnz ) ), _mm256_setzero_ps(), _CMP_LT_OQ );
+  /* Prevent near-zero area triangles */
+  oldmagnitude = _mm256_sqrt_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( onx, onx ), _mm256_mul_ps( ony, ony ) ), _mm256_mul_ps( onz, onz ) ) );
+  newmagnitude = _mm256_sqrt_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( nnx, nnx ), _mm256_mul_ps( nny, nny ) ), _mm256_mul_ps( nnz, nnz ) ) );
+  denymask = _mm256_movemask_ps( deny ) | mdAVX2NotGreaterScaleDoubleps( newmagnitude, MD_COLINEAR_REJECTION, oldmagnitude );
+  if( denymask )
+  {
+#if DEBUG_VERBOSE_COST >= 2
+    printf( "      !! Batch collapse denied, mask 0x%x\n", denymask );
+#endif
+    *denyflag = 1;
+    return;
+  }
+  /* Penalize long thin triangles */
+  ncx = _mm256_sub_ps( newx, _mm256_load_ps( batch->rightpoint[0] ) );
+  ncy = _mm256_sub_ps( newy, _mm256_load_ps( batch->rightpoint[1] ) );
+  ncz = _mm256_sub_ps( newz, _mm256_load_ps( batch->rightpoint[2] ) );
+  vecta2 = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( ax, ax ), _mm256_mul_ps( ay, ay ) ), _mm256_mul_ps( az, az ) );
+  vectb2 = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( nbx, nbx ), _mm256_mul_ps( nby, nby ) ), _mm256_mul_ps( nbz, nbz ) );
+  vectc2 = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( ncx, ncx ), _mm256_mul_ps( ncy, ncy ) ), _mm256_mul_ps( ncz, ncz ) );
+  norm = _mm256_add_ps( _mm256_add_ps( vecta2, vectb2 ), vectc2 );
+  target = _mm256_set1_ps( compactnesstarget );
+  newcompactness = mdAVX2ScaleDoubleps( newmagnitude, MD_COMPACTNESS_NORMALIZATION_FACTOR );
+  penalize = _mm256_cmp_ps( newcompactness, _mm256_mul_ps( target, norm ), _CMP_LT_OQ );
+  if( !( _mm256_movemask_ps( penalize ) ) )
+  {
+    _mm256_store_ps( batch->penalty, _mm256_setzero_ps() );
+    return;
+  }
+  newcompactness = _mm256_div_ps( newcompactness, norm );
+  ocx = _mm256_sub_ps( _mm256_load_ps( batch->oldpoint[0] ), _mm256_load_ps( batch->rightpoint[0] ) );
+  ocy = _mm256_sub_ps( _mm256_load_ps( batch->oldpoint[1] ), _mm256_load_ps( batch->rightpoint[1] ) );
+  ocz = _mm256_sub_ps( _mm256_load_ps( batch->oldpoint[2] ), _mm256_load_ps( batch->rightpoint[2] ) );
+  vectb2 = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( obx, obx ), _mm256_mul_ps( oby, oby ) ), _mm256_mul_ps( obz, obz ) );
+  vectc2 = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( ocx, ocx ), _mm256_mul_ps( ocy, ocy ) ), _mm256_mul_ps( ocz, ocz ) );
+  norm = _mm256_add_ps( _mm256_add_ps( vecta2, vectb2 ), vectc2 );
+  oldcompactness = mdAVX2ScaleDivDoubleps( oldmagnitude, MD_COMPACTNESS_NORMALIZATION_FACTOR, norm );
+  /* Operand order picks the target if oldcompactness is NaN, and zero if the difference is, as fmin() and fmaxf() */
+  penalty = _mm256_sub_ps( _mm256_min_ps( oldcompactness, target ), newcompactness );
+  penalty = _mm256_max_ps( penalty, _mm256_setzero_ps() );
+  _mm256_store_ps( batch->penalty, _mm256_and_ps( penalty, penalize ) );
+  return;
+}
+
+ #else
+
+/* Load a xyz vector, w is zero */
+static inline CPU_TARGET_AVX2 __m256d mdAVX2Load3d( double *point )
+{
+  return _mm256_insertf128_pd( _mm256_castpd128_pd256( _mm_loadu_pd( point+0 ) ), _mm_load_sd( point+2 ), 1 );
+}
+
+/* Sums of the xyz lanes of four vectors, returned in the four lanes */
+static inline CPU_TARGET_AVX2 __m256d mdAVX2Dot3x4d( __m256d p0, __m256d p1, __m256d p2, __m256d p3 )
+{
+  __m256d sum01, sum23;
+  sum01 = _mm256_hadd_pd( p0, p1 );
+  sum23 = _mm256_hadd_pd( p2, p3 );
+  return _mm256_add_pd( _mm256_permute2f128_pd( sum01, sum23, 0x20 ), _mm256_permute2f128_pd( sum01, sum23, 0x31 ) );
+}
+
+static CPU_TARGET_AVX2 double mdEdgeCollapsePenaltyTriangleAVX2d( double *newpoint, double *oldpoint, double *leftpoint, double *rightpoint, int *denyflag, double compactnesstarget, int meshflags )
+{
+  double penalty, compactness, oldcompactness, newcompactness, oldmagnitude, newmagnitude, norm, vecta2;
+  __m128d dotlow, dothigh;
+  __m256d left, right, oldpt, newpt, vecta, oldvectb, newvectb, oldvectc, newvectc;
+  __m256d vectayzx, vectazxy, oldnormal, newnormal, cross, dotnormal, dotedge;
+
+  left = mdAVX2Load3d( leftpoint );
+  right = mdAVX2Load3d( rightpoint );
+  oldpt = mdAVX2Load3d( oldpoint );
+  newpt = mdAVX2Load3d( newpoint );
+  vecta = _mm256_sub_pd( right, left );
+  oldvectb = _mm256_sub_pd( oldpt, left );
+  newvectb = _mm256_sub_pd( newpt, left );
+  /* Normals of old and new triangles, vecta.yzx * vectb.zxy - vecta.zxy * vectb.yzx */
+  vectayzx = _mm256_permute4x64_pd( vecta, _MM_SHUFFLE(3,0,2,1) );
+  vectazxy = _mm256_permute4x64_pd( vecta, _MM_SHUFFLE(3,1,0,2) );
+  oldnormal = _mm256_sub_pd( _mm256_mul_pd( vectayzx, _mm256_permute4x64_pd( oldvectb, _MM_SHUFFLE(3,1,0,2) ) ), _mm256_mul_pd( vectazxy, _mm256_permute4x64_pd( oldvectb, _MM_SHUFFLE(3,0,2,1) ) ) );
+  newnormal = _mm256_sub_pd( _mm256_mul_pd( vectayzx, _mm256_permute4x64_pd( newvectb, _MM_SHUFFLE(3,1,0,2) ) ), _mm256_mul_pd( vectazxy, _mm256_permute4x64_pd( newvectb, _MM_SHUFFLE(3,0,2,1) ) ) );
+  cross = _mm256_mul_pd( oldnormal, newnormal );
+  dotnormal = mdAVX2Dot3x4d( cross, _mm256_mul_pd( oldnormal, oldnormal ), _mm256_mul_pd( newnormal, newnormal ), _mm256_mul_pd( vecta, vecta ) );
+  dotlow = _mm256_castpd256_pd128( dotnormal );
+  if( meshflags & MD_FLAGS_PLANAR_MODE )
+  {
+    /* Detect planar normal Z inversion */
+    if( _mm_cvtsd_f64( _mm256_extractf128_pd( cross, 1 ) ) < 0.0 )
+    {
+#if DEBUG_VERBOSE_COST >= 2
+      printf( "      !! Normal Z inversion denied in planar mode\n" );
+#endif
+      *denyflag = 1;
+      return 0.0;
+    }
+  }
+  else
+  {
+    /* Detect normal inversion */
+    if( _mm_cvtsd_f64( dotlow ) < 0.0 )
+    {
+#if DEBUG_VERBOSE_COST >= 2
+      printf( "      !! Normal inversion denied\n" );
+#endif
+      *denyflag = 1;
+      return 0.0;
+    }
+  }
+  /* Prevent near-zero area triangles */
+  dothigh = _mm256_extractf128_pd( dotnormal, 1 );
+  oldmagnitude = sqrt( _mm_cvtsd_f64( _mm_unpackhi_pd( dotlow, dotlow ) ) );
+  newmagnitude = sqrt( _mm_cvtsd_f64( dothigh ) );
+  if( !( newmagnitude > ( MD_COLINEAR_REJECTION * oldmagnitude ) ) )
+  {
+#if DEBUG_VERBOSE_COST >= 2
+    printf( "      !! Colinear magnitude denied\n" );
+#endif
+    *denyflag = 1;
+    return 0.0;
+  }
+  /* Penalize long thin triangles */
+  penalty = 0.0;
+  newvectc = _mm256_sub_pd( newpt, right );
+  oldvectc = _mm256_sub_pd( oldpt, right );
+  dotedge = mdAVX2Dot3x4d( _mm256_mul_pd( newvectb, newvectb ), _mm256_mul_pd( newvectc, newvectc ), _mm256_mul_pd( oldvectb, oldvectb ), _mm256_mul_pd( oldvectc, oldvectc ) );
+  newcompactness = MD_COMPACTNESS_NORMALIZATION_FACTOR * newmagnitude;
+  vecta2 = _mm_cvtsd_f64( _mm_unpackhi_pd( dothigh, dothigh ) );
+  dotlow = _mm256_castpd256_pd128( dotedge );
+  norm = vecta2 + ( _mm_cvtsd_f64( dotlow ) + _mm_cvtsd_f64( _mm_unpackhi_pd( dotlow, dotlow ) ) );
+  if( newcompactness < ( compactnesstarget * norm ) )
+  {
+    newcompactness /= norm;
+    dothigh = _mm256_extractf128_pd( dotedge, 1 );
+    oldcompactness = ( MD_COMPACTNESS_NORMALIZATION_FACTOR * oldmagnitude ) / ( vecta2 + ( _mm_cvtsd_f64( dothigh ) + _mm_cvtsd_f64( _mm_unpackhi_pd( dothigh, dothigh ) ) ) );
+    compactness = fmin( compactnesstarget, oldcompactness ) - newcompactness;
+    penalty = fmaxf( penalty, compactness );
+  }
+  return penalty;
+}
+
+/* Sums of the xyz lanes of p and q for both 256 bits halves, returned as { p, q, p, q } in each half */
+static inline CPU_TARGET_AVX512 __m512d mdAVX512Dot3x2d( __m512d p, __m512d q )
+{
+  __m512d sum;
+  sum = _mm512_add_pd( _mm512_unpacklo_pd( p, q ), _mm512_unpackhi_pd( p, q ) );
+  return _mm512_add_pd( sum, _mm512_permutex_pd( sum, _MM_SHUFFLE(1,0,3,2) ) );
+}
+
+/* Old and new triangles are processed together, the old one in the low 256 bits, the new one in the high 256 bits */
+static CPU_TARGET_AVX512 double mdEdgeCollapsePenaltyTriangleAVX512d( double *newpoint, double *oldpoint, double *leftpoint, double *rightpoint, int *denyflag, double compactnesstarget, int meshflags )
+{
+  double penalty, compactness, oldcompactness, newcompactness, oldmagnitude, newmagnitude, norm, vecta2;
+  __m128d dotlow, dothigh;
+  __m512d left, right, points, vecta, vectb, vectc, normal, cross, dotnormal, dotedge;
+
+  left = _mm512_broadcast_f64x4( mdAVX2Load3d( leftpoint ) );
+  right = _mm512_broadcast_f64x4( mdAVX2Load3d( rightpoint ) );
+  points = _mm512_insertf64x4( _mm512_castpd256_pd512( mdAVX2Load3d( oldpoint ) ), mdAVX2Load3d( newpoint ), 1 );
+  vecta = _mm512_sub_pd( right, left );
+  vectb = _mm512_sub_pd( points, left );
+  vectc = _mm512_sub_pd( points, right );
+  /* Normals of old and new triangles, vecta.yzx * vectb.zxy - vecta.zxy * vectb.yzx */
+  normal = _mm512_sub_pd(
+    _mm512_mul_pd( _mm512_permutex_pd( vecta, _MM_SHUFFLE(3,0,2,1) ), _mm512_permutex_pd( vectb, _MM_SHUFFLE(3,1,0,2) ) ),
+    _mm512_mul_pd( _mm512_permutex_pd( vecta, _MM_SHUFFLE(3,1,0,2) ), _mm512_permutex_pd( vectb, _MM_SHUFFLE(3,0,2,1) ) )
+  );
+  cross = _mm512_mul_pd( normal, _mm512_shuffle_f64x2( normal, normal, _MM_SHUFFLE(1,0,3,2) ) );
+  /* Lanes 0,1 : oldnormal.newnormal, oldnormal^2 ; lanes 4,5 : vecta^2, newnormal^2 */
+  dotnormal = mdAVX512Dot3x2d( _mm512_mask_blend_pd( 0xf0, cross, _mm512_mul_pd( vecta, vecta ) ), _mm512_mul_pd( normal, normal ) );
+  dotlow = _mm512_castpd512_pd128( dotnormal );
+  if( meshflags & MD_FLAGS_PLANAR_MODE )
+  {
+    /* Detect planar normal Z inversion */
+    if( _mm_cvtsd_f64( _mm256_extractf128_pd( _mm512_castpd512_pd256( cross ), 1 ) ) < 0.0 )
+    {
+#if DEBUG_VERBOSE_COST >= 2
+      printf( "      !! Normal Z inversion denied in planar mode\n" );
+#endif
+      *denyflag = 1;
+      return 0.0;
+    }
+  }
+  else
+  {
+    /* Detect normal inversion */
+    if( _mm_cvtsd_f64( dotlow ) < 0.0 )
+    {
+#if DEBUG_VERBOSE_COST >= 2
+      printf( "      !! Normal inversion denied\n" );
+#endif
+      *denyflag = 1;
+      return 0.0;
+    }
+  }
+  /* Prevent near-zero area triangles */
+  dothigh = _mm256_castpd256_pd128( _mm512_extractf64x4_pd( dotnormal, 1 ) );
+  oldmagnitude = sqrt( _mm_cvtsd_f64( _mm_unpackhi_pd( dotlow, dotlow ) ) );
+  newmagnitude = sqrt( _mm_cvtsd_f64( _mm_unpackhi_pd( dothigh, dothigh ) ) );
+  if( !( newmagnitude > ( MD_COLINEAR_REJECTION * oldmagnitude ) ) )
+  {
+#if DEBUG_VERBOSE_COST >= 2
+    printf( "      !! Colinear magnitude denied\n" );
+#endif
+    *denyflag = 1;
+    return 0.0;
+  }
+  /* Penalize long thin triangles ; lanes 0,1 : old vectb^2, vectc^2 ; lanes 4,5 : new vectb^2, vectc^2 */
+  penalty = 0.0;
+  dotedge = mdAVX512Dot3x2d( _mm512_mul_pd( vectb, vectb ), _mm512_mul_pd( vectc, vectc ) );
+  vecta2 = _mm_cvtsd_f64( dothigh );
+  dothigh = _mm256_castpd256_pd128( _mm512_extractf64x4_pd( dotedge, 1 ) );
+  newcompactness = MD_COMPACTNESS_NORMALIZATION_FACTOR * newmagnitude;
+  norm = vecta2 + ( _mm_cvtsd_f64( dothigh ) + _mm_cvtsd_f64( _mm_unpackhi_pd( dothigh, dothigh ) ) );
+  if( newcompactness < ( compactnesstarget * norm ) )
+  {
+    newcompactness /= norm;
+    dotlow = _mm512_castpd512_pd128( dotedge );
+    oldcompactness = ( MD_COMPACTNESS_NORMALIZATION_FACTOR * oldmagnitude ) / ( vecta2 + ( _mm_cvtsd_f64( dotlow ) + _mm_cvtsd_f64( _mm_unpackhi_pd( dotlow, dotlow ) ) ) );
+    compactness = fmin( compactnesstarget, oldcompactness ) - newcompactness;
+    penalty = fmaxf( penalty, compactness );
+  }
+  return penalty;
+}
+
+
+/* Four triangles sharing the same new point, one per lane */
+static CPU_TARGET_AVX2 void mdEdgeCollapsePenaltyBatchAVX2d( mdPenaltyBatch *batch, double *newpoint, int *denyflag, double compactnesstarget, int meshflags )
+{
+  __m256d newx, newy, newz, ax, ay, az, obx, oby, obz, nbx, nby, nbz, ocx, ocy, ocz, ncx, ncy, ncz;
+  __m256d onx, ony, onz, nnx, nny, nnz, oldmagnitude, newmagnitude, vecta2, vectb2, vectc2, norm, newcompactness, oldcompactness, penalty;
+  __m256d deny, penalize, target;
+
+  newx = _mm256_broadcast_sd( &newpoint[0] );
+  newy = _mm256_broadcast_sd( &newpoint[1] );
+  newz = _mm256_broadcast_sd( &newpoint[2] );
+  ax = _mm256_sub_pd( _mm256_load_pd( batch->rightpoint[0] ), _mm256_load_pd( batch->leftpoint[0] ) );
+  ay = _mm256_sub_pd( _mm256_load_pd( batch->rightpoint[1] ), _mm256_load_pd( batch->leftpoint[1] ) );
+  az = _mm256_sub_pd( _mm256_load_pd( batch->rightpoint[2] ), _mm256_load_pd( batch->leftpoint[2] ) );
+  obx = _mm256_sub_pd( _mm256_load_pd( batch->oldpoint[0] ), _mm256_load_pd( batch->leftpoint[0] ) );
+  oby = _mm256_sub_pd( _mm256_load_pd( batch->oldpoint[1] ), _mm256_load_pd( batch->leftpoint[1] ) );
+  obz = _mm256_sub_pd( _mm256_load_pd( batch->oldpoint[2] ), _mm256_load_pd( batch->leftpoint[2] ) );
+  nbx = _mm256_sub_pd( newx, _mm256_load_pd( batch->leftpoint[0] ) );
+  nby = _mm256_sub_pd( newy, _mm256_load_pd( batch->leftpoint[1] ) );
+  nbz = _mm256_sub_pd( newz, _mm256_load_pd( batch->leftpoint[2] ) );
+  /* Normals of old and new triangles */
+  onx = _mm256_sub_pd( _mm256_mul_pd( ay, obz ), _mm256_mul_pd( az, oby ) );
+  ony = _mm256_sub_pd( _mm256_mul_pd( az, obx ), _mm256_mul_pd( ax, obz ) );
+  onz = _mm256_sub_pd( _mm256_mul_pd( ax, oby ), _mm256_mul_pd( ay, obx ) );
+  nnx = _mm256_sub_pd( _mm256_mul_pd( ay, nbz ), _mm256_mul_pd( az, nby ) );
+  nny = _mm256_sub_pd( _mm256_mul_pd( az, nbx ), _mm256_mul_pd( ax, nbz ) );
+  nnz = _mm256_sub_pd( _mm256_mul_pd( ax, nby ), _mm256_mul_pd( ay, nbx ) );
+  /* Detect normal inversion, or planar normal Z inversion */
+  if( meshflags & MD_FLAGS_PLANAR_MODE )
+    deny = _mm256_cmp_pd( _mm256_mul_pd( onz, nnz ), _mm256_setzero_pd(), _CMP_LT_OQ );
+  else
+    deny = _mm256_cmp_pd( _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( onx, nnx ), _mm256_mul_pd( ony, nny ) ), _mm256_mul_pd( onz, nnz ) ), _mm256_setzero_pd(), _CMP_LT_OQ );
+  /* Prevent near-zero area triangles */
+  oldmagnitude = _mm256_sqrt_pd( _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( onx, onx ), _mm256_mul_pd( ony, ony ) ), _mm256_mul_pd( onz, onz ) ) );
+  newmagnitude = _mm256_sqrt_pd( _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( nnx, nnx ), _mm256_mul_pd( nny, nny ) ), _mm256_mul_pd( nnz, nnz ) ) );
+  deny = _mm256_or_pd( deny, _mm256_cmp_pd( newmagnitude, _mm256_mul_pd( oldmagnitude, _mm256_set1_pd( MD_COLINEAR_REJECTION ) ), _CMP_NGT_UQ ) );
+  if( _mm256_movemask_pd( deny ) )
+  {
+#if DEBUG_VERBOSE_COST >= 2
+    printf( "      !! Batch collapse denied, mask 0x%x\n", _mm256_movemask_pd( deny ) );
+#endif
+    *denyflag = 1;
+    return;
+  }
+  /* Penalize long thin triangles */
+  ncx = _mm256_sub_pd( newx, _mm256_load_pd( batch->rightpoint[0] ) );
+  ncy = _mm256_sub_pd( newy, _mm256_load_pd( batch->rightpoint[1] ) );
+  ncz = _mm256_sub_pd( newz, _mm256_load_pd( batch->rightpoint[2] ) );
+  vecta2 = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( ax, ax ), _mm256_mul_pd( ay, ay ) ), _mm256_mul_pd( az, az ) );
+  vectb2 = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( nbx, nbx ), _mm256_mul_pd( nby, nby ) ), _mm256_mul_pd( nbz, nbz ) );
+  vectc2 = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( ncx, ncx ), _mm256_mul_pd( ncy, ncy ) ), _mm256_mul_pd( ncz, ncz ) );
+  norm = _mm256_add_pd( vecta2, _mm256_add_pd( vectb2, vectc2 ) );
+  target = _mm256_set1_pd( compactnesstarget );
+  newcompactness = _mm256_mul_pd( _mm256_set1_pd( MD_COMPACTNESS_NORMALIZATION_FACTOR ), newmagnitude );
+  penalize = _mm256_cmp_pd( newcompactness, _mm256_mul_pd( target, norm ), _CMP_LT_OQ );
+  if( !( _mm256_movemask_pd( penalize ) ) )
+  {
+    _mm256_store_pd( batch->penalty, _mm256_setzero_pd() );
+    return;
+  }
+  newcompactness = _mm256_div_pd( newcompactness, norm );
+  ocx = _mm256_sub_pd( _mm256_load_pd( batch->oldpoint[0] ), _mm256_load_pd( batch->rightpoint[0] ) );
+  ocy = _mm256_sub_pd( _mm256_load_pd( batch->oldpoint[1] ), _mm256_load_pd( batch->rightpoint[1] ) );
+  ocz = _mm256_sub_pd( _mm256_load_pd( batch->oldpoint[2] ), _mm256_load_pd( batch->rightpoint[2] ) );
+  vectb2 = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( obx, obx ), _mm256_mul_pd( oby, oby ) ), _mm256_mul_pd( obz, obz ) );
+  vectc2 = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( ocx, ocx ), _mm256_mul_pd( ocy, ocy ) ), _mm256_mul_pd( ocz, ocz ) );
+  norm = _mm256_add_pd( vecta2, _mm256_add_pd( vectb2, vectc2 ) );
+  oldcompactness = _mm256_div_pd( _mm256_mul_pd( _mm256_set1_pd( MD_COMPACTNESS_NORMALIZATION_FACTOR ), oldmagnitude ), norm );
+  /* Operand order picks the target if oldcompactness is NaN, and zero if the difference is, as fmin() and fmaxf() */
+  penalty = _mm256_sub_pd( _mm256_min_pd( oldcompactness, target ), newcompactness );
+  /* Round through single precision, as fmaxf() does for the other kernels */
+  penalty = _mm256_max_pd( _mm256_cvtps_pd( _mm256_cvtpd_ps( penalty ) ), _mm256_setzero_pd() );
+  _mm256_store_pd( batch->penalty, _mm256_and_pd( penalty, penalize ) );
+  return;
+}
+
+/* Eight triangles sharing the same new point, one per lane */
+static CPU_TARGET_AVX512 void mdEdgeCollapsePenaltyBatchAVX512d( mdPenaltyBatch *batch, double *newpoint, int *denyflag, double compactnesstarget, int meshflags )
+{
+  __m512d newx, newy, newz, ax, ay, az, obx, oby, obz, nbx, nby, nbz, ocx, ocy, ocz, ncx, ncy, ncz;
+  __m512d onx, ony, onz, nnx, nny, nnz, oldmagnitude, newmagnitude, vecta2, vectb2, vectc2, norm, newcompactness, oldcompactness, penalty;
+  __m512d target;
+  __mmask8 deny, penalize;
+
+  newx = _mm512_set1_pd( newpoint[0] );
+  newy = _mm512_set1_pd( newpoint[1] );
+  newz = _mm512_set1_pd( newpoint[2] );
+  ax = _mm512_sub_pd( _mm512_load_pd( batch->rightpoint[0] ), _mm512_load_pd( batch->leftpoint[0] ) );
+  ay = _mm512_sub_pd( _mm512_load_pd( batch->rightpoint[1] ), _mm512_load_pd( batch->leftpoint[1] ) );
+  az = _mm512_sub_pd( _mm512_load_pd( batch->rightpoint[2] ), _mm512_load_pd( batch->leftpoint[2] ) );
+  obx = _mm512_sub_pd( _mm512_load_pd( batch->oldpoint[0] ), _mm512_load_pd( batch->leftpoint[0] ) );
+  oby = _mm512_sub_pd( _mm512_load_pd( batch->oldpoint[1] ), _mm512_load_pd( batch->leftpoint[1] ) );
+  obz = _mm512_sub_pd( _mm512_load_pd( batch->oldpoint[2] ), _mm512_load_pd( batch->leftpoint[2] ) );
+  nbx = _mm512_sub_pd( newx, _mm512_load_pd( batch->leftpoint[0] ) );
+  nby = _mm512_sub_pd( newy, _mm512_load_pd( batch->leftpoint[1] ) );
+  nbz = _mm512_sub_pd( newz, _mm512_load_pd( batch->leftpoint[2] ) );
+  /* Normals of old and new triangles */
+  onx = _mm512_sub_pd( _mm512_mul_pd( ay, obz ), _mm512_mul_pd( az, oby ) );
+  ony = _mm512_sub_pd( _mm512_mul_pd( az, obx ), _mm512_mul_pd( ax, obz ) );
+  onz = _mm512_sub_pd( _mm512_mul_pd( ax, oby ), _mm512_mul_pd( ay, obx ) );
+  nnx = _mm512_sub_pd( _mm512_mul_pd( ay, nbz ), _mm512_mul_pd( az, nby ) );
+  nny = _mm512_sub_pd( _mm512_mul_pd( az, nbx ), _mm512_mul_pd( ax, nbz ) );
+  nnz = _mm512_sub_pd( _mm512_mul_pd( ax, nby ), _mm512_mul_pd( ay, nbx ) );
+  /* Detect normal inversion, or planar normal Z inversion */
+  if( meshflags & MD_FLAGS_PLANAR_MODE )
+    deny = _mm512_cmp_pd_mask( _mm512_mul_pd( onz, nnz ), _mm512_setzero_pd(), _CMP_LT_OQ );
+  else
+    deny = _mm512_cmp_pd_mask( _mm512_add_pd( _mm512_add_pd( _mm512_mul_pd( onx, nnx ), _mm512_mul_pd( ony, nny ) ), _mm512_mul_pd( onz, nnz ) ), _mm512_setzero_pd(), _CMP_LT_OQ );
+  /* Prevent near-zero area triangles */
+  oldmagnitude = _mm512_sqrt_pd( _mm512_add_pd( _mm512_add_pd( _mm512_mul_pd( onx, onx ), _mm512_mul_pd( ony, ony ) ), _mm512_mul_pd( onz, onz ) ) );
+  newmagnitude = _mm512_sqrt_pd( _mm512_add_pd( _mm512_add_pd( _mm512_mul_pd( nnx, nnx ), _mm512_mul_pd( nny, nny ) ), _mm512_mul_pd( nnz, nnz ) ) );
+  deny |= _mm512_cmp_pd_mask( newmagnitude, _mm512_mul_pd( oldmagnitude, _mm512_set1_pd( MD_COLINEAR_REJECTION ) ), _CMP_NGT_UQ );
+  if( deny )
+  {
+#if DEBUG_VERBOSE_COST >= 2
+    printf( "      !! Batch collapse denied, mask 0x%x\n", (int)deny );
+#endif
+    *denyflag = 1;
+    return;
+  }
+  /* Penalize long thin triangles */
+  ncx = _mm512_sub_pd( newx, _mm512_load_pd( batch->rightpoint[0] ) );
+  ncy = _mm512_sub_pd( newy, _mm512_load_pd( batch->rightpoint[1] ) );
+  ncz = _mm512_sub_pd( newz, _mm512_load_pd( batch->rightpoint[2] ) );
+  vecta2 = _mm512_add_pd( _mm512_add_pd( _mm512_mul_pd( ax, ax ), _mm512_mul_pd( ay, ay ) ), _mm512_mul_pd( az, az ) );
+  vectb2 = _mm512_add_pd( _mm512_add_pd( _mm512_mul_pd( nbx, nbx ), _mm512_mul_pd( nby, nby ) ), _mm512_mul_pd( nbz, nbz ) );
+  vectc2 = _mm512_add_pd( _mm512_add_pd( _mm512_mul_pd( ncx, ncx ), _mm512_mul_pd( ncy, ncy ) ), _mm512_mul_pd( ncz, ncz ) );
+  norm = _mm512_add_pd( vecta2, _mm512_add_pd( vectb2, vectc2 ) );
+  target = _mm512_set1_pd( compactnesstarget );
+  newcompactness = _mm512_mul_pd( _mm512_set1_pd( MD_COMPACTNESS_NORMALIZATION_FACTOR ), newmagnitude );
+  penalize = _mm512_cmp_pd_mask( newcompactness, _mm512_mul_pd( target, norm ), _CMP_LT_OQ );
+  if( !( penalize ) )
+  {
+    _mm512_store_pd( batch->penalty, _mm512_setzero_pd() );
+    return;
+  }
+  newcompactness = _mm512_div_pd( newcompactness, norm );
+  ocx = _mm512_sub_pd( _mm512_load_pd( batch->oldpoint[0] ), _mm512_load_pd( batch->rightpoint[0] ) );
+  ocy = _mm512_sub_pd( _mm512_load_pd( batch->oldpoint[1] ), _mm512_load_pd( batch->rightpoint[1] ) );
+  ocz = _mm512_sub_pd( _mm512_load_pd( batch->oldpoint[2] ), _mm512_load_pd( batch->rightpoint[2] ) );
+  vectb2 = _mm512_add_pd( _mm512_add_pd( _mm512_mul_pd( obx, obx ), _mm512_mul_pd( oby, oby ) ), _mm512_mul_pd( obz, obz ) );
+  vectc2 = _mm512_add_pd( _mm512_add_pd( _mm512_mul_pd( ocx, ocx ), _mm512_mul_pd( ocy, ocy ) ), _mm512_mul_pd( ocz, ocz ) );
+  norm = _mm512_add_pd( vecta2, _mm512_add_pd( vectb2, vectc2 ) );
+  oldcompactness = _mm512_div_pd( _mm512_mul_pd( _mm512_set1_pd( MD_COMPACTNESS_NORMALIZATION_FACTOR ), oldmagnitude ), norm );
+  /* Operand order picks the target if oldcompactness is NaN, and zero if the difference is, as fmin() and fmaxf() */
+  penalty = _mm512_sub_pd( _mm512_min_pd( oldcompactness, target ), newcompactness );
+  /* Round through single precision, as fmaxf() does for the other kernels */
+  penalty = _mm512_max_pd( _mm512_cvtps_pd( _mm512_cvtpd_ps( penalty ) ), _mm512_setzero_pd() );
+  _mm512_store_pd( batch->penalty, _mm512_maskz_mov_pd( penalize, penalty ) );
+  return;
+}
+
+ #endif
+
+#endif
+
+
+////
+
+
+static void mdEdgeCollapsePenaltyBatchFlush( mdMesh *mesh, mdPenaltyBatch *batch, mdf *collapsepoint, mdf *penaltysum, int *denyflag )
+{
+  int index, axis;
+
+  if( !( batch->count ) )
+    return;
+  /* Replicate the first triangle in the unused lanes */
+  for( index = batch->count ; index < mesh->penaltybatchwidth ; index++ )
+  {
+    for( axis = 0 ; axis < 3 ; axis++ )
+    {
+      batch->oldpoint[axis][index] = batch->oldpoint[axis][0];
+      batch->leftpoint[axis][index] = batch->leftpoint[axis][0];
+      batch->rightpoint[axis][index] = batch->rightpoint[axis][0];
+    }
+  }
+  mesh->collapsepenaltybatch( batch, collapsepoint, denyflag, mesh->compactnesstarget, mesh->operationflags );
+  if( !( *denyflag ) )
+  {
+    /* Accumulate in triangle order, for the same sums as the per-triangle path */
+    for( index = 0 ; index < batch->count ; index++ )
+    {
+#if DEBUG_VERBOSE_COST >= 2
+      printf( "      Penalty %f\n", batch->penalty[index] );
+#endif
+      penaltysum[ batch->group[index] ] += batch->penalty[index];
+    }
+  }
+  batch->count = 0;
+  return;
+}
+
+
+/* Accumulate the penalties of the triangles around pivotindex in penaltysum[group], or gather them in batch if not NULL */
+static void mdEdgeCollapsePenaltyTriRefs( mdMesh *mesh, mdThreadData *tdata, mdPenaltyBatch *batch, mdi *trireflist, mdi trirefcount, mdi pivotindex, mdi skipindex, mdf *collapsepoint, mdf *penaltysum, int group, int *denyflag )
+{
+  int index, axis, lane;
+  mdf tripenalty;
+  mdi triindex;
+  mdTriangle *tri;
+  mdf *oldpoint, *leftpoint, *rightpoint;
+
+  for( index = 0 ; index < trirefcount ; index++ )
+  {
+    if( *denyflag )
+      break;
+    triindex = trireflist[ index ];
+    tri = ADDRESS( mesh->trilist, triindex * mesh->trisize );
+    if( tri->v[0] == -1 )
+      continue;
+
+#if DEBUG_DEBUG_CHECK_SOMETHING
+    mdi triv[3];
+    triv[0] = tri->v[0];
+    triv[1] = tri->v[1];
+    triv[2] = tri->v[2];
+#endif
+
+#if DEBUG_VERBOSE_COST >= 2
+    printf( "    Penalty Tri %d,%d,%d ( Pivot %d ; Skip %d )\n", tri->v[0], tri->v[1], tri->v[2], pivotindex, skipindex );
+#endif
+    if( tri->v[0] == pivotindex )
+    {
+      if( ( tri->v[1] == skipindex ) || ( tri->v[2] == skipindex ) )
+        continue;
+      oldpoint = mesh->vertexlist[ tri->v[0] ].point;
+      leftpoint = mesh->vertexlist[ tri->v[2] ].point;
+      rightpoint = mesh->vertexlist[ tri->v[1] ].point;
+    }
+    else if( tri->v[1] == pivotindex )
+    {
+      if( ( tri->v[2] == skipindex ) || ( tri->v[0] == skipindex ) )
+        continue;
+      oldpoint = mesh->vertexlist[ tri->v[1] ].point;
+      leftpoint = mesh->vertexlist[ tri->v[0] ].point;
+      rightpoint = mesh->vertexlist[ tri->v[2] ].point;
+    }
+    else if( tri->v[2] == pivotindex )
+    {
+      if( ( tri->v[0] == skipindex ) || ( tri->v[1] == skipindex ) )
+        continue;
+      oldpoint = mesh->vertexlist[ tri->v[2] ].point;
+      leftpoint = mesh->vertexlist[ tri->v[1] ].point;
+      rightpoint = mesh->vertexlist[ tri->v[0] ].point;
+    }
+    else
+    {
+#if DEBUG_DEBUG_CHECK_SOMETHING
+      MD_ERROR( "SHOULD NOT HAPPEN %s:%d\n", 1, __FILE__, __LINE__ );
+      {
+        int32_t debugowner;
+        mdVertex *debugvertex;
+
+        printf( "Failure to locate pivot %d in triref %d / %d\n", pivotindex, index, trirefcount );
+
+        debugvertex = &mesh->vertexlist[ pivotindex ];
+        debugowner = mmAtomicRead32( &debugvertex->atomicowner );
+        printf( "  Pivot owner %d (self %d), redirect -> %d\n", debugowner, tdata->threadid, debugvertex->redirectindex );
+
+        debugvertex = &mesh->vertexlist[ tri->v[0] ];
         debugowner = mmAtomicRead32( &debugvertex->atomicowner );
         printf( "  tri->v[0] owner %d (self %d), redirect -> %d\n", debugowner, tdata->threadid, debugvertex->redirectindex );
 
@@ -2904,17 +4000,42 @@ static mdf mdEdgeCollapsePenaltyTriRefs( mdMesh *mesh, mdThreadData *tdata, mdi
       printf( "TriV  : %d %d %d (%d)\n", tri->v[0], tri->v[1], tri->v[2], pivotindex );
       printf( "\n" );
 #endif
+      continue;
+    }
+
+    if( batch )
+    {
+      lane = batch->count;
+      for( axis = 0 ; axis < 3 ; axis++ )
+      {
+        batch->oldpoint[axis][lane] = oldpoint[axis];
+        batch->leftpoint[axis][lane] = leftpoint[axis];
+        batch->rightpoint[axis][lane] = rightpoint[axis];
+      }
+      batch->group[lane] = group;
+      if( ++batch->count == mesh->penaltybatchwidth )
+        mdEdgeCollapsePenaltyBatchFlush( mesh, batch, collapsepoint, penaltysum, denyflag );
+    }
+    else
+    {
+      tripenalty = mesh->collapsepenalty( collapsepoint, oldpoint, leftpoint, rightpoint, denyflag, mesh->compactnesstarget, mesh->operationflags );
+#if DEBUG_VERBOSE_COST >= 2
+      printf( "      Penalty %f\n", tripenalty );
+#endif
+      penaltysum[group] += tripenalty;
     }
   }
 
-  return penalty;
+  return;
 }
 
 
 static mdf mdEdgeCollapsePenalty( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1, mdf *collapsepoint, int *denyflag )
 {
   mdf penalty, penaltyfactor;
+  mdf penaltysum[2];
   mdVertex *vertex0, *vertex1;
+  mdPenaltyBatch batch, *batchptr;
 
   vertex0 = &mesh->vertexlist[ v0 ];
   vertex1 = &mesh->vertexlist[ v1 ];
@@ -2924,8 +4045,20 @@ static mdf mdEdgeCollapsePenalty( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi
 #endif
 
   *denyflag = 0;
-  penalty  = mdEdgeCollapsePenaltyTriRefs( mesh, tdata, &mesh->trireflist[ vertex0->trirefbase ], vertex0->trirefcount, v0, v1, collapsepoint, denyflag );
-  penalty += mdEdgeCollapsePenaltyTriRefs( mesh, tdata, &mesh->trireflist[ vertex1->trirefbase ], vertex1->trirefcount, v1, v0, collapsepoint, denyflag );
+  penaltysum[0] = 0.0;
+  penaltysum[1] = 0.0;
+  /* Triangles of both vertices share the batches, usually filling one or two */
+  batchptr = 0;
+  if( mesh->collapsepenaltybatch )
+  {
+    batch.count = 0;
+    batchptr = &batch;
+  }
+  mdEdgeCollapsePenaltyTriRefs( mesh, tdata, batchptr, vertex0->trireflist, vertex0->trirefcount, v0, v1, collapsepoint, penaltysum, 0, denyflag );
+  mdEdgeCollapsePenaltyTriRefs( mesh, tdata, batchptr, vertex1->trireflist, vertex1->trirefcount, v1, v0, collapsepoint, penaltysum, 1, denyflag );
+  if( ( batchptr ) && !( *denyflag ) )
+    mdEdgeCollapsePenaltyBatchFlush( mesh, batchptr, collapsepoint, penaltysum, denyflag );
+  penalty = penaltysum[0] + penaltysum[1];
 
   if( penalty > 0.0 )
   {
@@ -2947,7 +4080,7 @@ static mdf mdEdgeCollapsePenalty( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi
     /* Apply global compactness penalty factor */
     penalty *= mesh->compactnesspenalty;
     /* Apply factor proportional to area compared to feature size, amplify/dampen with sqrt() */
-    penaltyfactor = sqrt( ( vertex0->quadric.area + vertex1->quadric.area ) * mesh->invfeaturesizearea );
+    penaltyfactor = sqrt( ( MD_VertexQuadric( mesh, vertex0 )->area + MD_VertexQuadric( mesh, vertex1 )->area ) * mesh->invfeaturesizearea );
     penalty *= penaltyfactor * mesh->maxcollapsecost;
 #if DEBUG_VERBOSE_COST
     printf( "    Penalty Total : %e (factor %f)\n", penalty, penaltyfactor );
@@ -2960,6 +4093,7 @@ static mdf mdEdgeCollapsePenalty( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi
 
 static inline int mdGetVertexLockFlag( mdMesh *mesh, mdi vertexindex )
 {
+  vertexindex = mdMeshVertexUserIndex( mesh, vertexindex );
   return ( mesh->lockmap[ vertexindex >> 5 ] & (((uint32_t)1)<<(vertexindex&(32-1))) ) != 0;
 }
 
@@ -2977,7 +4111,7 @@ static mdf mdVertexDistance( mdVertex *vertex0, mdVertex *vertex1 )
 
 
 /* Experimental: collapsemultiplier */
-static mdf mdSolveEdgeCollapse( mdMesh *mesh, mdi v0, mdi v1, mdf *point )
+static mdf mdSolveEdgeCollapse( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1, mdf *point )
 {
   int solveflags;
   mdf cost, costmultiplier;
@@ -3000,9 +4134,9 @@ static mdf mdSolveEdgeCollapse( mdMesh *mesh, mdi v0, mdi v1, mdf *point )
     return MD_OP_FAIL_VALUE;
 
   if( mesh->adjustcollapse )
-    cost = mdEdgeSolvePointAdjust( vertex0, vertex1, point, solveflags, mesh->adjustcollapse, mesh->adjustcontext );
+    cost = mdEdgeSolvePointAdjust( mesh, vertex0, vertex1, point, solveflags, mesh->adjustcollapse, mesh->adjustcontext );
   else
-    cost = mdEdgeSolvePoint( vertex0, vertex1, point, solveflags );
+    cost = mdEdgeSolvePoint( mesh, vertex0, vertex1, point, solveflags );
 
   if( mesh->collapsemultiplier )
   {
@@ -3010,12 +4144,12 @@ static mdf mdSolveEdgeCollapse( mdMesh *mesh, mdi v0, mdi v1, mdf *point )
     tridata0 = 0;
     edge.v[0] = v0;
     edge.v[1] = v1;
-    if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) == MM_HASH_SUCCESS )
+    if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) == MM_HASH_SUCCESS )
       tridata0 = ADDRESS( mesh->trilist, ( edge.triindex * mesh->trisize ) + sizeof(mdTriangle) );
     tridata1 = 0;
     edge.v[0] = v1;
     edge.v[1] = v0;
-    if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) == MM_HASH_SUCCESS )
+    if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) == MM_HASH_SUCCESS )
       tridata1 = ADDRESS( mesh->trilist, ( edge.triindex * mesh->trisize ) + sizeof(mdTriangle) );
 #if MD_CONF_DOUBLE_PRECISION
     costmultiplier = mesh->collapsemultiplier( mesh->collapsecontext, tridata0, tridata1, vertex0->point, vertex1->point );
@@ -3090,7 +4224,7 @@ static void mdMeshAddOp( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1 )
   op->updatebuffer = tdata->updatebuffer;
   op->v0 = v0;
   op->v1 = v1;
-  op->value = mdSolveEdgeCollapse( mesh, v0, v1, op->collapsepoint );
+  op->value = mdSolveEdgeCollapse( mesh, tdata, v0, v1, op->collapsepoint );
 #if CPU_SSE_SUPPORT
   op->collapsepoint[3] = 0.0;
 #endif
@@ -3102,10 +4236,16 @@ static void mdMeshAddOp( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1 )
     denyflag = 1;
   }
   op->collapsecost = op->value + op->penalty;
+  if( denyflag )
+    tdata->statusdenycount++;
   if( ( denyflag ) || ( op->collapsecost >= mesh->maxcollapseacceptcost ) )
     opflags |= MD_OP_FLAGS_DETACHED;
   else
+  {
+    mdThreadQueueLock( tdata );
     mmBinSortAdd( tdata->binsort, op, op->collapsecost );
+    mdThreadQueueUnlock( tdata );
+  }
 #if MD_CONFIG_ATOMIC_SUPPORT
   mmAtomicWrite32( &op->flags, opflags );
 #else
@@ -3115,7 +4255,7 @@ static void mdMeshAddOp( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1 )
 
   edge.v[0] = v0;
   edge.v[1] = v1;
-  if( mmHashLockCallEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, mdMeshEdgeSetOpCallback, op, 0 ) != MM_HASH_SUCCESS )
+  if( mmHashLockCallEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, mdMeshEdgeSetOpCallback, op, 0, &tdata->edgehashstat ) != MM_HASH_SUCCESS )
   {
 /*
     MD_ERROR( "SHOULD NOT HAPPEN %s:%d\n", 1, __FILE__, __LINE__ );
@@ -3129,19 +4269,19 @@ static void mdMeshAddOp( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1 )
   return;
 }
 
-static void mdMeshPopulateOpList( mdMesh *mesh, mdThreadData *tdata, mdi tribase, mdi tricount )
+/* Add ops for the triangles tribase to tribase+tricount, or for the triangles listed by these entries of trikeylist if not null */
+static void mdMeshPopulateOpList( mdMesh *mesh, mdThreadData *tdata, mdEdgeKey *trikeylist, mdi tribase, mdi tricount )
 {
-  mdTriangle *tri, *tristart, *triend;
+  mdi index;
+  mdTriangle *tri;
   long populatecount;
 
-  tristart = ADDRESS( mesh->trilist, tribase * mesh->trisize );
-  triend = ADDRESS( tristart, tricount * mesh->trisize );
-
   populatecount = 0;
-  for( tri = tristart ; tri < triend ; tri = ADDRESS( tri, mesh->trisize ) )
+  for( index = tribase ; index < tribase + tricount ; index++ )
   {
+    tri = ADDRESS( mesh->trilist, ( trikeylist ? trikeylist[index].triindex : index ) * mesh->trisize );
 #if DEBUG_VERBOSE_COLLAPSE
-    printf( "Triangle %d, edges %d,%d,%d ~ edgeflags 0x%02x\n", (int)( tri - tristart ), tri->v[0], tri->v[1], tri->v[2], tri->u.edgeflags );
+    printf( "Triangle %d, edges %d,%d,%d ~ edgeflags 0x%02x\n", (int)index, tri->v[0], tri->v[1], tri->v[2], tri->u.edgeflags );
 #endif
 #if 0
     if( ( ( tri->v[0] < tri->v[1] ) || ( tri->u.edgeflags & MD_EDGEFLAGS_BOUNDARY01 ) ) && !( tri->u.edgeflags & MD_EDGEFLAGS_DENYEDGE01 ) )
@@ -3188,8 +4328,8 @@ static inline void mdEdgeCollapseMergeVertexAttribs( mdMesh *mesh, mdThreadData
   vertex1 = &mesh->vertexlist[ v1 ];
   MD_VectorSubStore( dist, collapsepoint, vertex1->point );
   dist1 = MD_VectorMagnitude( dist );
-  weight0 = dist1 * vertex0->quadric.area;
-  weight1 = dist0 * vertex1->quadric.area;
+  weight0 = dist1 * MD_VertexQuadric( mesh, vertex0 )->area;
+  weight1 = dist0 * MD_VertexQuadric( mesh, vertex1 )->area;
   weightsum = weight0 + weight1;
   if( weightsum )
   {
@@ -3202,13 +4342,13 @@ static inline void mdEdgeCollapseMergeVertexAttribs( mdMesh *mesh, mdThreadData
     weight0 = 0.5;
     weight1 = 0.5;
   }
-  mesh->vertexmerge( mesh->mergecontext, v0, v1, weight0, weight1 );
+  mesh->vertexmerge( mesh->mergecontext, mdMeshVertexUserIndex( mesh, v0 ), mdMeshVertexUserIndex( mesh, v1 ), weight0, weight1 );
   return;
 }
 
 
 /* Delete triangle and return outer vertex */
-static mdi mdEdgeCollapseDeleteTriangle( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1, int *retdelflags )
+static mdi mdEdgeCollapseDeleteTriangle( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1, int *retdelflags, mdi *rettriindex )
 {
   int delflags;
   mdi outer;
@@ -3217,16 +4357,18 @@ static mdi mdEdgeCollapseDeleteTriangle( mdMesh *mesh, mdThreadData *tdata, mdi
   mdOp *op;
 
   *retdelflags = 0x0;
+  *rettriindex = -1;
 
   edge.v[0] = v0;
   edge.v[1] = v1;
-  if( mmHashLockDeleteEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1 ) != MM_HASH_SUCCESS )
+  if( mmHashLockDeleteEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1, &tdata->edgehashstat ) != MM_HASH_SUCCESS )
     return -1;
   op = edge.op;
   if( op )
     mdUpdateBufferAdd( &op->updatebuffer[ tdata->threadid >> mesh->updatebuffershift ], op, MD_OP_FLAGS_DELETION_PENDING );
 
   tri = ADDRESS( mesh->trilist, edge.triindex * mesh->trisize );
+  *rettriindex = edge.triindex;
 
 #if DEBUG_VERBOSE_COLLAPSE
   printf( "  Delete Triangle %d,%d,%d\n", tri->v[0], tri->v[1], tri->v[2] );
@@ -3236,7 +4378,7 @@ static mdi mdEdgeCollapseDeleteTriangle( mdMesh *mesh, mdThreadData *tdata, mdi
   {
     edge.v[0] = tri->v[0];
     edge.v[1] = tri->v[1];
-    if( mmHashLockDeleteEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1 ) == MM_HASH_SUCCESS )
+    if( mmHashLockDeleteEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1, &tdata->edgehashstat ) == MM_HASH_SUCCESS )
     {
       op = edge.op;
       if( op )
@@ -3254,7 +4396,7 @@ static mdi mdEdgeCollapseDeleteTriangle( mdMesh *mesh, mdThreadData *tdata, mdi
   {
     edge.v[0] = tri->v[1];
     edge.v[1] = tri->v[2];
-    if( mmHashLockDeleteEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1 ) == MM_HASH_SUCCESS )
+    if( mmHashLockDeleteEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1, &tdata->edgehashstat ) == MM_HASH_SUCCESS )
     {
       op = edge.op;
       if( op )
@@ -3272,7 +4414,7 @@ static mdi mdEdgeCollapseDeleteTriangle( mdMesh *mesh, mdThreadData *tdata, mdi
   {
     edge.v[0] = tri->v[2];
     edge.v[1] = tri->v[0];
-    if( mmHashLockDeleteEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1 ) == MM_HASH_SUCCESS )
+    if( mmHashLockDeleteEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1, &tdata->edgehashstat ) == MM_HASH_SUCCESS )
     {
       op = edge.op;
       if( op )
@@ -3344,7 +4486,7 @@ static void mdEdgeCollapseUpdateTriangle( mdMesh *mesh, mdThreadData *tdata, mdT
   edge.op = 0;
   if( edge.v[0] == newv )
   {
-    if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) != MM_HASH_SUCCESS )
+    if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) != MM_HASH_SUCCESS )
     {
 #if 0
       /* Shouldn't happen with a proper watertight mesh, but it can happen if edges are reused... */
@@ -3354,10 +4496,10 @@ static void mdEdgeCollapseUpdateTriangle( mdMesh *mesh, mdThreadData *tdata, mdT
   }
   else
   {
-    if( mmHashLockDeleteEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1 ) == MM_HASH_SUCCESS )
+    if( mmHashLockDeleteEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1, &tdata->edgehashstat ) == MM_HASH_SUCCESS )
     {
       edge.v[0] = newv;
-      if( mmHashLockAddEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1 ) != MM_HASH_SUCCESS )
+      if( mmHashLockAddEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1, &tdata->edgehashstat ) != MM_HASH_SUCCESS )
         MD_ERROR( "SHOULD NOT HAPPEN %s:%d\n", 1, __FILE__, __LINE__ );
     }
     else
@@ -3374,7 +4516,7 @@ static void mdEdgeCollapseUpdateTriangle( mdMesh *mesh, mdThreadData *tdata, mdT
 #if DEBUG_VERBOSE_COLLAPSE
     printf( "    Update Edge %d,%d Before ; Point %f %f %f ; Cost %.16f\n", op->v0, op->v1, op->collapsepoint[0], op->collapsepoint[1], op->collapsepoint[2], op->collapsecost );
 #endif
-    op->value = mdSolveEdgeCollapse( mesh, edge.v[0], edge.v[1], op->collapsepoint );
+    op->value = mdSolveEdgeCollapse( mesh, tdata, edge.v[0], edge.v[1], op->collapsepoint );
 #if CPU_SSE_SUPPORT
     op->collapsepoint[3] = 0.0;
 #endif
@@ -3391,7 +4533,7 @@ static void mdEdgeCollapseUpdateTriangle( mdMesh *mesh, mdThreadData *tdata, mdT
   edge.op = 0;
   if( edge.v[1] == newv )
   {
-    if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) != MM_HASH_SUCCESS )
+    if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) != MM_HASH_SUCCESS )
     {
 #if 0
       /* Shouldn't happen with a proper watertight mesh, but it can happen if edges are reused... */
@@ -3401,10 +4543,10 @@ static void mdEdgeCollapseUpdateTriangle( mdMesh *mesh, mdThreadData *tdata, mdT
   }
   else
   {
-    if( mmHashLockDeleteEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1 ) == MM_HASH_SUCCESS )
+    if( mmHashLockDeleteEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1, &tdata->edgehashstat ) == MM_HASH_SUCCESS )
     {
       edge.v[1] = newv;
-      if( mmHashLockAddEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1 ) != MM_HASH_SUCCESS )
+      if( mmHashLockAddEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1, &tdata->edgehashstat ) != MM_HASH_SUCCESS )
         MD_ERROR( "SHOULD NOT HAPPEN %s:%d\n", 1, __FILE__, __LINE__ );
     }
     else
@@ -3421,7 +4563,7 @@ static void mdEdgeCollapseUpdateTriangle( mdMesh *mesh, mdThreadData *tdata, mdT
 #if DEBUG_VERBOSE_COLLAPSE
     printf( "    Update Edge %d,%d Before ; Point %f %f %f ; Cost %f\n", op->v0, op->v1, op->collapsepoint[0], op->collapsepoint[1], op->collapsepoint[2], op->collapsecost );
 #endif
-    op->value = mdSolveEdgeCollapse( mesh, edge.v[0], edge.v[1], op->collapsepoint );
+    op->value = mdSolveEdgeCollapse( mesh, tdata, edge.v[0], edge.v[1], op->collapsepoint );
 #if CPU_SSE_SUPPORT
     op->collapsepoint[3] = 0.0;
 #endif
@@ -3445,15 +4587,15 @@ static void mdEdgeCollapseUpdateTriangle( mdMesh *mesh, mdThreadData *tdata, mdT
 #if DEBUG_VERBOSE_CHECKS
   edge.v[0] = tri->v[0];
   edge.v[1] = tri->v[1];
-  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) != MM_HASH_SUCCESS )
+  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) != MM_HASH_SUCCESS )
     printf( "      ERROR: Updated triangle %d,%d,%d has missing hash edge %d,%d\n", (int)tri->v[0], (int)tri->v[1], (int)tri->v[2], (int)edge.v[0], (int)edge.v[1] );
   edge.v[0] = tri->v[1];
   edge.v[1] = tri->v[2];
-  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) != MM_HASH_SUCCESS )
+  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) != MM_HASH_SUCCESS )
     printf( "      ERROR: Updated triangle %d,%d,%d has missing hash edge %d,%d\n", (int)tri->v[0], (int)tri->v[1], (int)tri->v[2], (int)edge.v[0], (int)edge.v[1] );
   edge.v[0] = tri->v[2];
   edge.v[1] = tri->v[0];
-  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) != MM_HASH_SUCCESS )
+  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) != MM_HASH_SUCCESS )
     printf( "      ERROR: Updated triangle %d,%d,%d has missing hash edge %d,%d\n", (int)tri->v[0], (int)tri->v[1], (int)tri->v[2], (int)edge.v[0], (int)edge.v[1] );
 #endif
 
@@ -3511,7 +4653,7 @@ static void mdVertexInvalidateTri( mdMesh *mesh, mdThreadData *tdata, mdi v0, md
 
   edge.v[0] = v0;
   edge.v[1] = v1;
-  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) == MM_HASH_SUCCESS )
+  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) == MM_HASH_SUCCESS )
   {
     op = edge.op;
     if( op )
@@ -3535,7 +4677,7 @@ static void mdVertexInvalidate( mdMesh *mesh, mdThreadData *tdata, mdi vertexind
 
   /* Vertices of the collapsed edge */
   vertex = &mesh->vertexlist[ vertexindex ];
-  trireflist = &mesh->trireflist[ vertex->trirefbase ];
+  trireflist = vertex->trireflist;
   trirefcount = vertex->trirefcount;
 
   for( index = 0 ; index < trirefcount ; index++ )
@@ -3614,7 +4756,7 @@ static void mdEdgeCollapseLinkOuter( mdMesh *mesh, mdThreadData *tdata, mdi newv
 
   edge.v[0] = newv;
   edge.v[1] = outer;
-  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) == MM_HASH_SUCCESS )
+  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) == MM_HASH_SUCCESS )
   {
     sideflags |= 0x1;
     op = edge.op;
@@ -3623,7 +4765,7 @@ static void mdEdgeCollapseLinkOuter( mdMesh *mesh, mdThreadData *tdata, mdi newv
   }
   edge.v[0] = outer;
   edge.v[1] = newv;
-  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) == MM_HASH_SUCCESS )
+  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) == MM_HASH_SUCCESS )
   {
     sideflags |= 0x2;
     op = edge.op;
@@ -3641,18 +4783,18 @@ static void mdEdgeCollapseLinkOuter( mdMesh *mesh, mdThreadData *tdata, mdi newv
 
 
 
-static void mdEdgeCollapsePropagateBoundary( mdMesh *mesh, mdi v0, mdi v1 )
+static void mdEdgeCollapsePropagateBoundary( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1 )
 {
   mdEdge edge;
   mdTriangle *tri;
 
   edge.v[0] = v1;
   edge.v[1] = v0;
-  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) == MM_HASH_SUCCESS )
+  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) == MM_HASH_SUCCESS )
     return;
   edge.v[0] = v0;
   edge.v[1] = v1;
-  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) != MM_HASH_SUCCESS )
+  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) != MM_HASH_SUCCESS )
     return;
 
   tri = ADDRESS( mesh->trilist, edge.triindex * mesh->trisize );
@@ -3733,7 +4875,7 @@ static inline void mdLockBufferEnd( mdLockBuffer *buffer )
   return;
 }
 
-void mdLockBufferUnlockAll( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *buffer )
+static void mdLockBufferUnlockAll( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *buffer )
 {
   int index;
   mdVertex *vertex;
@@ -3755,7 +4897,7 @@ void mdLockBufferUnlockAll( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *buf
 }
 
 /* If it fails, release all locks then return zero ~ return 1 when lock is already owned or acquired (and added to lockbuffer) */
-int mdLockBufferTryLock( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *buffer, mdi vertexindex )
+static int mdLockBufferTryLock( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *buffer, mdi vertexindex )
 {
   int32_t owner;
   mdVertex *vertex;
@@ -3767,6 +4909,8 @@ int mdLockBufferTryLock( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *buffer
     return 1;
   if( ( owner != -1 ) || !( mmAtomicCmpReplace32( &vertex->atomicowner, -1, tdata->threadid ) ) )
   {
+    if( tdata->profileflag )
+      tdata->profile.lockfailcount++;
     mdLockBufferUnlockAll( mesh, tdata, buffer );
     return 0;
   }
@@ -3781,6 +4925,8 @@ int mdLockBufferTryLock( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *buffer
   if( owner != -1 )
   {
     mtSpinUnlock( &vertex->ownerspinlock );
+    if( tdata->profileflag )
+      tdata->profile.lockfailcount++;
     mdLockBufferUnlockAll( mesh, tdata, buffer );
     return 0;
   }
@@ -3793,7 +4939,7 @@ int mdLockBufferTryLock( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *buffer
 }
 
 /* If it fails, release all locks then wait for the desired lock to become available */
-int mdLockBufferLock( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *buffer, mdi vertexindex )
+static int mdLockBufferLock( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *buffer, mdi vertexindex )
 {
   int32_t owner;
   mdVertex *vertex;
@@ -3810,6 +4956,8 @@ int mdLockBufferLock( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *buffer, m
     return 1;
   }
   /* Lock failed, release all locks and wait until we get the lock we got stuck on */
+  if( tdata->profileflag )
+    tdata->profile.lockfailcount++;
   mdLockBufferUnlockAll( mesh, tdata, buffer );
   mmAtomicSpinWaitEq32( &vertex->atomicowner, -1 );
 #else
@@ -3830,6 +4978,8 @@ int mdLockBufferLock( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *buffer, m
   }
   mtSpinUnlock( &vertex->ownerspinlock );
   /* Lock failed, release all locks */
+  if( tdata->profileflag )
+    tdata->profile.lockfailcount++;
   mdLockBufferUnlockAll( mesh, tdata, buffer );
 #endif
   return 0;
@@ -3845,7 +4995,7 @@ static int mdPivotLockRefs( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *buf
   mdVertex *vertex;
 
   vertex = &mesh->vertexlist[ vertexindex ];
-  trireflist = &mesh->trireflist[ vertex->trirefbase ];
+  trireflist = vertex->trireflist;
   trirefcount = vertex->trirefcount;
 
   for( index = 0 ; index < trirefcount ; index++ )
@@ -3887,10 +5037,12 @@ static int mdPivotLockRefs( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *buf
 static void mdOpResolveLockEdge( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *lockbuffer, mdOp *op )
 {
   int failcount, globalflag;
+  uint64_t cycles;
   mdVertex *vertex0, *vertex1;
 
   failcount = 0;
   globalflag = 0;
+  cycles = ( tdata->profileflag ? mmReadCycleCounter() : 0 );
   for( ; ; )
   {
     if( ( failcount > MD_GLOBAL_LOCK_THRESHOLD ) && !( globalflag ) )
@@ -3926,6 +5078,13 @@ static void mdOpResolveLockEdge( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer
     mtSpinUnlock( &mesh->globalvertexspinlock );
 #endif
 
+  if( tdata->profileflag )
+  {
+    tdata->profile.lockretrycount += failcount;
+    tdata->profile.globalvertexlockcount += globalflag;
+    tdata->profile.lockcycles += mmReadCycleCounter() - cycles;
+  }
+
   return;
 }
 
@@ -3953,10 +5112,12 @@ static int mdOpResolveLockEdgeTry( mdMesh *mesh, mdThreadData *tdata, mdLockBuff
 static void mdOpResolveLockFull( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *lockbuffer, mdOp *op )
 {
   int failcount, globalflag;
+  uint64_t cycles;
   mdVertex *vertex0, *vertex1;
 
   failcount = 0;
   globalflag = 0;
+  cycles = ( tdata->profileflag ? mmReadCycleCounter() : 0 );
   for( ; ; )
   {
     if( ( failcount > MD_GLOBAL_LOCK_THRESHOLD ) && !( globalflag ) )
@@ -4001,17 +5162,125 @@ static void mdOpResolveLockFull( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer
     mtSpinUnlock( &mesh->globalvertexspinlock );
 #endif
 
+  if( tdata->profileflag )
+  {
+    tdata->profile.lockretrycount += failcount;
+    tdata->profile.globalvertexlockcount += globalflag;
+    tdata->profile.lockcycles += mmReadCycleCounter() - cycles;
+  }
+
+  return;
+}
+
+
+/* Advance the logical clock of all locked vertices past their last collapse, all vertices of modified triangles are locked */
+static void mdEdgeCollapseAdvanceClock( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *lockbuffer )
+{
+  int index;
+  uint32_t clock;
+  clock = 0;
+  for( index = 0 ; index < lockbuffer->vertexcount ; index++ )
+  {
+    if( mesh->vertexclock[ lockbuffer->vertexlist[index] ] > clock )
+      clock = mesh->vertexclock[ lockbuffer->vertexlist[index] ];
+  }
+  clock++;
+  for( index = 0 ; index < lockbuffer->vertexcount ; index++ )
+    mesh->vertexclock[ lockbuffer->vertexlist[index] ] = clock;
+  tdata->collapseclock = clock;
   return;
 }
 
+/* Grow the collapse log of the thread for one more entry, before the collapse modifies anything */
+static int mdEdgeCollapseLogReserve( mdCollapseLog *log )
+{
+  size_t entryalloc;
+  mdCollapseEntry *entrylist;
+  if( log->entrycount < log->entryalloc )
+    return 1;
+  entryalloc = ( log->entryalloc ? log->entryalloc << 1 : MD_COLLAPSE_LOG_ALLOC_MIN );
+  entrylist = realloc( log->entrylist, entryalloc * sizeof(mdCollapseEntry) );
+  if( !( entrylist ) )
+    return 0;
+  log->entrylist = entrylist;
+  log->entryalloc = entryalloc;
+  return 1;
+}
+
+/* Append the edge collapse to the thread's own log, no other thread touches it */
+static void mdEdgeCollapseRecord( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1, mdi tri0, mdi tri1, mdf *collapsepoint )
+{
+  mdCollapseLog *log;
+  mdCollapseEntry *entry;
+  log = tdata->collapselog;
+  entry = &log->entrylist[ log->entrycount++ ];
+  entry->record.v0 = (int32_t)mdMeshVertexUserIndex( mesh, v0 );
+  entry->record.v1 = (int32_t)mdMeshVertexUserIndex( mesh, v1 );
+  entry->record.tri0 = (int32_t)( tri0 >= 0 ? mdMeshTriangleUserIndex( mesh, tri0 ) : tri0 );
+  entry->record.tri1 = (int32_t)( tri1 >= 0 ? mdMeshTriangleUserIndex( mesh, tri1 ) : tri1 );
+  entry->record.point[0] = (double)collapsepoint[0] / mesh->normalizationfactor;
+  entry->record.point[1] = (double)collapsepoint[1] / mesh->normalizationfactor;
+  entry->record.point[2] = (double)collapsepoint[2] / mesh->normalizationfactor;
+  entry->clock = tdata->collapseclock;
+  return;
+}
+
+
+/* Make room for trirefcount trirefs in the arena of a thread, no other thread allocates from it */
+static int mdTriRefArenaReserve( mdMesh *mesh, mdTriRefArena *arena, size_t trirefcount )
+{
+  size_t chunksize, arenacount;
+  mdTriRefChunk *chunk;
+
+  if( arena->trirefavail < trirefcount )
+  {
+    /* Start a new chunk, the remainder of the current one is left unused */
+    chunksize = MD_TRIREF_CHUNK_SIZE;
+    if( chunksize < trirefcount )
+      chunksize = trirefcount;
+    /* Count the chunk against the memory budget of all arenas */
+#if MD_CONFIG_ATOMIC_SUPPORT
+    arenacount = (size_t)mmAtomicAddReadL( &mesh->trirefarenacount, (long)chunksize );
+#else
+    mtSpinLock( &mesh->trirefarenaspinlock );
+    mesh->trirefarenacount += (long)chunksize;
+    arenacount = (size_t)mesh->trirefarenacount;
+    mtSpinUnlock( &mesh->trirefarenaspinlock );
+#endif
+    if( ( mesh->trirefarenalimit ) && ( arenacount > mesh->trirefarenalimit ) )
+      return 0;
+    chunk = malloc( sizeof(mdTriRefChunk) + ( chunksize * sizeof(mdi) ) );
+    if( !( chunk ) )
+      return 0;
+    chunk->next = arena->chunklist;
+    chunk->alloc = chunksize;
+    arena->chunklist = chunk;
+    arena->trireflist = ADDRESS( chunk, sizeof(mdTriRefChunk) );
+    arena->trirefavail = chunksize;
+  }
+
+  return 1;
+}
+
+/* Take storage for trirefcount trirefs from the arena, room must have been reserved by mdTriRefArenaReserve() */
+static mdi *mdTriRefArenaAlloc( mdTriRefArena *arena, size_t trirefcount )
+{
+  mdi *trireflist;
+  trireflist = arena->trireflist;
+  arena->trireflist += trirefcount;
+  arena->trirefavail -= trirefcount;
+  return trireflist;
+}
+
 
 #define MD_EDGE_COLLAPSE_TRIREF_STATIC (512)
 
-static void mdEdgeCollapse( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1, mdf *collapsepoint, int *growtriref )
+/* Returns zero without modifying the mesh if memory for the collapse can not be allocated */
+static int mdEdgeCollapse( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1, mdf *collapsepoint )
 {
   int index, delflags0, delflags1;
   long deletioncount;
-  mdi newv, trirefcount, trirefmax, outer0, outer1;
+  mdi newv, trirefcount, trirefmax, outer0, outer1, tri0, tri1;
   mdi *trireflist, *trirefstore;
   mdVertex *vertex0, *vertex1;
   mdi trirefstatic[MD_EDGE_COLLAPSE_TRIREF_STATIC];
@@ -4030,17 +5299,41 @@ static void mdEdgeCollapse( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1, m
   /* New vertex overwriting v0 */
   newv = v0;
 
-  /* Collapse other custom vertex attributes */
-  if( mesh->vertexmerge )
-    mdEdgeCollapseMergeVertexAttribs( mesh, tdata, v0, v1, collapsepoint );
-
   /* Vertices of the collapsed edge */
   vertex0 = &mesh->vertexlist[ v0 ];
   vertex1 = &mesh->vertexlist[ v1 ];
 
+  /* Maximum theoritical count of triangle references for our new vertex, we need a chunk of memory that big */
+  trirefmax = vertex0->trirefcount + vertex1->trirefcount;
+
+  /* Allocate all the memory we may need before touching anything, a failure leaves the mesh as it was */
+  if( ( trirefmax > vertex0->trirefcount ) && ( trirefmax > vertex1->trirefcount ) )
+  {
+    if( !( mdTriRefArenaReserve( mesh, tdata->trirefarena, trirefmax ) ) )
+      return 0;
+  }
+  if( ( tdata->collapselog ) && !( mdEdgeCollapseLogReserve( tdata->collapselog ) ) )
+    return 0;
+  /* Buffer to temporarily store our new trirefs */
+  trireflist = trirefstatic;
+  if( trirefmax > MD_EDGE_COLLAPSE_TRIREF_STATIC )
+  {
+    trireflist = malloc( trirefmax * sizeof(mdi) );
+    if( !( trireflist ) )
+      return 0;
+  }
+
+  /* Collapse other custom vertex attributes */
+  if( mesh->vertexmerge )
+    mdEdgeCollapseMergeVertexAttribs( mesh, tdata, v0, v1, collapsepoint );
+
   /* Delete the triangles on both sides of the edge and all associated edges */
-  outer0 = mdEdgeCollapseDeleteTriangle( mesh, tdata, v0, v1, &delflags0 );
-  outer1 = mdEdgeCollapseDeleteTriangle( mesh, tdata, v1, v0, &delflags1 );
+  outer0 = mdEdgeCollapseDeleteTriangle( mesh, tdata, v0, v1, &delflags0, &tri0 );
+  outer1 = mdEdgeCollapseDeleteTriangle( mesh, tdata, v1, v0, &delflags1, &tri1 );
+
+  /* Record the collapse for the progressive mesh stream */
+  if( tdata->collapselog )
+    mdEdgeCollapseRecord( mesh, tdata, v0, v1, tri0, tri1, collapsepoint );
 
   /* Track count of deletions */
   deletioncount = tdata->statusdeletioncount;
@@ -4064,13 +5357,13 @@ static void mdEdgeCollapse( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1, m
 
 #if MD_CONF_LOCAL_VERTEX_ORIGINS
   /* We must move both v0->q and v1->q to the frame of reference "collapsepoint" */
-  mathQuadricTranslate( &vertex0->quadric, collapsepoint[0] - vertex0->point[0], collapsepoint[1] - vertex0->point[1], collapsepoint[2] - vertex0->point[2] );
-  mathQuadricTranslate( &vertex1->quadric, collapsepoint[0] - vertex1->point[0], collapsepoint[1] - vertex1->point[1], collapsepoint[2] - vertex1->point[2] );
+  mathQuadricTranslate( MD_VertexQuadric( mesh, vertex0 ), collapsepoint[0] - vertex0->point[0], collapsepoint[1] - vertex0->point[1], collapsepoint[2] - vertex0->point[2] );
+  mathQuadricTranslate( MD_VertexQuadric( mesh, vertex1 ), collapsepoint[0] - vertex1->point[0], collapsepoint[1] - vertex1->point[1], collapsepoint[2] - vertex1->point[2] );
   /* Sum quadrics */
-  mathQuadricAddQuadric( &vertex0->quadric, &vertex1->quadric );
+  mathQuadricAddQuadric( MD_VertexQuadric( mesh, vertex0 ), MD_VertexQuadric( mesh, vertex1 ) );
 #else
   /* Sum quadrics */
-  mathQuadricAddQuadric( &vertex0->quadric, &vertex1->quadric );
+  mathQuadricAddQuadric( MD_VertexQuadric( mesh, vertex0 ), MD_VertexQuadric( mesh, vertex1 ) );
 #endif
 
   /* Set up new vertex over v0 */
@@ -4080,33 +5373,25 @@ static void mdEdgeCollapse( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1, m
   if( delflags0 )
   {
     if( delflags0 & 0x1 )
-      mdEdgeCollapsePropagateBoundary( mesh, newv, outer0 );
+      mdEdgeCollapsePropagateBoundary( mesh, tdata, newv, outer0 );
     if( delflags0 & 0x2 )
-      mdEdgeCollapsePropagateBoundary( mesh, outer0, newv );
+      mdEdgeCollapsePropagateBoundary( mesh, tdata, outer0, newv );
   }
   if( delflags1 )
   {
     if( delflags1 & 0x1 )
-      mdEdgeCollapsePropagateBoundary( mesh, newv, outer1 );
+      mdEdgeCollapsePropagateBoundary( mesh, tdata, newv, outer1 );
     if( delflags1 & 0x2 )
-      mdEdgeCollapsePropagateBoundary( mesh, outer1, newv );
+      mdEdgeCollapsePropagateBoundary( mesh, tdata, outer1, newv );
   }
 
   /* Redirect vertex1 to vertex0 */
   vertex1->redirectindex = newv;
 
-  /* Maximum theoritical count of triangle references for our new vertex, we need a chunk of memory that big */
-  trirefmax = vertex0->trirefcount + vertex1->trirefcount;
-
-  /* Buffer to temporarily store our new trirefs */
-  trireflist = trirefstatic;
-  if( trirefmax > MD_EDGE_COLLAPSE_TRIREF_STATIC )
-    trireflist = malloc( trirefmax * sizeof(mdi) );
-
   /* Update all triangles connected to vertex0 and vertex1 */
   trirefstore = trireflist;
-  trirefstore = mdEdgeCollapseUpdateAll( mesh, tdata, &mesh->trireflist[ vertex0->trirefbase ], vertex0->trirefcount, v0, newv, trirefstore );
-  trirefstore = mdEdgeCollapseUpdateAll( mesh, tdata, &mesh->trireflist[ vertex1->trirefbase ], vertex1->trirefcount, v1, newv, trirefstore );
+  trirefstore = mdEdgeCollapseUpdateAll( mesh, tdata, vertex0->trireflist, vertex0->trirefcount, v0, newv, trirefstore );
+  trirefstore = mdEdgeCollapseUpdateAll( mesh, tdata, vertex1->trireflist, vertex1->trirefcount, v1, newv, trirefstore );
 
   /* Find where to store the trirefs */
   trirefcount = (int)( trirefstore - trireflist );
@@ -4118,29 +5403,11 @@ static void mdEdgeCollapse( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1, m
   if( trirefcount > vertex0->trirefcount )
   {
     if( trirefcount <= vertex1->trirefcount )
-      vertex0->trirefbase = vertex1->trirefbase;
+      vertex0->trireflist = vertex1->trireflist;
     else
     {
-      /* Multithreading, acquire lock ~ we need to grow the trireflist buffer, we'll store our stuff at the end */
-#if MD_CONFIG_ATOMIC_SUPPORT
-      mmAtomicSpin32( &mesh->trireflock, 0x0, 0x1 );
-#else
-      mtSpinLock( &mesh->trirefspinlock );
-#endif
-      vertex0->trirefbase = mesh->trireflistcount;
-#if 0
-      printf( "Add %d trirefs, total %ld, alloc %ld\n", (int)trirefcount, (long)mesh->trireflistcount, (long)mesh->trireflistalloc );
-#endif
-      mesh->trireflistcount += trirefcount;
-      if( ( mesh->trireflistalloc - mesh->trireflistcount ) < ( mesh->threadcount * MD_TRIREF_AVAIL_MIN_COUNT ) )
-        *growtriref = 1;
-      if( mesh->trireflistcount >= mesh->trireflistalloc )
-        MD_ERROR( "SHOULD NOT HAPPEN %s:%d\n", 1, __FILE__, __LINE__ );
-#if MD_CONFIG_ATOMIC_SUPPORT
-      mmAtomicWrite32( &mesh->trireflock, 0x0 );
-#else
-      mtSpinUnlock( &mesh->trirefspinlock );
-#endif
+      /* Neither storage is large enough, take new storage from our own arena, room was reserved above */
+      vertex0->trireflist = mdTriRefArenaAlloc( tdata->trirefarena, trirefcount );
     }
   }
 
@@ -4149,7 +5416,7 @@ static void mdEdgeCollapse( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1, m
 
   /* Store trirefs */
   vertex0->trirefcount = trirefcount;
-  trirefstore = &mesh->trireflist[ vertex0->trirefbase ];
+  trirefstore = vertex0->trireflist;
   for( index = 0 ; index < trirefcount ; index++ )
   {
 #if DEBUG_VERBOSE_COLLAPSE
@@ -4176,7 +5443,7 @@ static void mdEdgeCollapse( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi v1, m
   fflush( stdout );
 #endif
 
-  return;
+  return 1;
 }
 
 
@@ -4226,14 +5493,14 @@ static int mdEdgeCollisionCheck( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi
   {
     vsrc = v0;
     vdst = v1;
-    trireflist = &mesh->trireflist[ vertex0->trirefbase ];
+    trireflist = vertex0->trireflist;
     trirefcount = vertex0->trirefcount;
   }
   else
   {
     vsrc = v1;
     vdst = v0;
-    trireflist = &mesh->trireflist[ vertex1->trirefbase ];
+    trireflist = vertex1->trireflist;
     trirefcount = vertex1->trirefcount;
   }
 
@@ -4247,12 +5514,12 @@ static int mdEdgeCollisionCheck( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi
   ecd.trileft = -1;
   edge.v[0] = v0;
   edge.v[1] = v1;
-  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) == MM_HASH_SUCCESS )
+  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) == MM_HASH_SUCCESS )
     ecd.trileft = edge.triindex;
   ecd.triright = -1;
   edge.v[0] = v1;
   edge.v[1] = v0;
-  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) == MM_HASH_SUCCESS )
+  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) == MM_HASH_SUCCESS )
     ecd.triright = edge.triindex;
 
   /* Check all trirefs for collision */
@@ -4292,12 +5559,12 @@ static int mdEdgeCollisionCheck( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi
 
     edge.v[0] = vdst;
     edge.v[1] = tri->v[right];
-    mmHashLockCallEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, mdEdgeCollisionCallback, &ecd, 0 );
+    mmHashLockCallEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, mdEdgeCollisionCallback, &ecd, 0, &tdata->edgehashstat );
     if( ecd.collisionflag )
       return 0;
     edge.v[0] = tri->v[left];
     edge.v[1] = vdst;
-    mmHashLockCallEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, mdEdgeCollisionCallback, &ecd, 0 );
+    mmHashLockCallEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, mdEdgeCollisionCallback, &ecd, 0, &tdata->edgehashstat );
     if( ecd.collisionflag )
       return 0;
   }
@@ -4311,39 +5578,290 @@ static int mdEdgeCollisionCheck( mdMesh *mesh, mdThreadData *tdata, mdi v0, mdi
 
 
 
-/* Mesh init step 0, allocate, NOT threaded */
+/* Mesh init step 0, allocate, NOT threaded */
+static void mdMeshFreeEdgeKeys( mdMesh *mesh )
+{
+  free( mesh->edgekeylist );
+  free( mesh->edgekeybuffer );
+  free( mesh->edgekeyhistogram );
+  mesh->edgekeylist = 0;
+  mesh->edgekeybuffer = 0;
+  mesh->edgekeyhistogram = 0;
+  return;
+}
+
+static void mdMeshFreeMortonKeys( mdMesh *mesh )
+{
+  free( mesh->mortonkeylist );
+  free( mesh->mortonkeybuffer );
+  free( mesh->mortonhistogram );
+  free( mesh->mortonbounds );
+  mesh->mortonkeylist = 0;
+  mesh->mortonkeybuffer = 0;
+  mesh->mortonhistogram = 0;
+  mesh->mortonbounds = 0;
+  return;
+}
+
+static void mdMeshFreeReorder( mdMesh *mesh )
+{
+  free( mesh->vertexmap );
+  free( mesh->vertexremap );
+  free( mesh->trimap );
+  mesh->vertexmap = 0;
+  mesh->vertexremap = 0;
+  mesh->trimap = 0;
+  return;
+}
+
+
 static int mdMeshInit( mdMesh *mesh, size_t maxmemoryusage )
 {
-  int retval;
+  int retval, threadindex;
+  size_t keycount, hashsize, memoryestimate;
+  uint64_t keymax;
   mdf hashsizefactor;
+  mdContext *context;
 
-  /* Allocate vertices, no extra room for vertices, we overwrite existing ones as we decimate */
-  mesh->vertexlist = mmAlignAlloc( mesh->vertexalloc * sizeof(mdVertex), 0x40 );
+  /* Allocate space for per-vertex lists of face references, trirefs outgrowing their storage go to per-thread arenas */
+  mesh->trireflistalloc = 3 * mesh->tricount;
+  mesh->trisize = ( sizeof(mdTriangle) + mesh->tridatasize + 0x7 ) & ~0x7;
 
-  /* Allocate space for per-vertex lists of face references, including future vertices */
-  mesh->trireflistcount = 0;
-  mesh->trireflistalloc = ( 2 * 6 * mesh->tricount ) + ( mesh->threadcount * MD_TRIREF_AVAIL_MIN_COUNT );
-  mesh->trireflist = malloc( mesh->trireflistalloc * sizeof(mdi) );
+  /* The memory limit is a hard one, don't even try if the smallest hash table wouldn't fit */
+  mesh->memorybuffers = mdMeshMemoryBuffers( mesh->operationflags, mesh->threadcount, ( mesh->normalbase != 0 ), ( mesh->collapsestream != 0 ), ( mesh->levelcount != 0 ) );
+  retval = 1;
+  hashsize = 0;
+  if( !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) )
+    hashsize = mdMeshHashSizeMin( mesh->tricount );
+  if( ( maxmemoryusage ) && ( mdMeshEstimateMemory( mesh->vertexalloc, mesh->tricount, mesh->trisize, hashsize, 7, mesh->memorybuffers ) > maxmemoryusage ) )
+    retval = 0;
 
-  /* Allocate triangles */
-  mesh->trisize = ( sizeof(mdTriangle) + mesh->tridatasize + 0x7 ) & ~0x7;
-  mesh->trilist = malloc( mesh->tricount * mesh->trisize );
+  mesh->vertexlist = 0;
+#if MD_CONF_SPLIT_VERTEX_QUADRICS
+  mesh->quadriclist = 0;
+#endif
+  mesh->trireflist = 0;
+  mesh->trilist = 0;
+  mesh->edgehashtable = 0;
+  context = mesh->context;
+  if( !( retval ) )
+  {
+    /* Leave the mesh storage and the context's buffers alone */
+  }
+  else if( !( context ) )
+  {
+    /* Allocate vertices, no extra room for vertices, we overwrite existing ones as we decimate */
+    mesh->vertexlist = mmAlignAlloc( mesh->vertexalloc * sizeof(mdVertex), 0x40 );
+#if MD_CONF_SPLIT_VERTEX_QUADRICS
+    mesh->quadriclist = mmAlignAlloc( mesh->vertexalloc * sizeof(mathQuadric), 0x40 );
+#endif
+    mesh->trireflist = malloc( mesh->trireflistalloc * sizeof(mdi) );
+    /* Allocate triangles */
+    mesh->trilist = malloc( mesh->tricount * mesh->trisize );
+  }
+  else
+  {
+    /* Grow the context's buffers if too small */
+    if( context->vertexalloc < mesh->vertexalloc )
+    {
+      if( context->vertexlist )
+        mmAlignFree( context->vertexlist );
+      context->vertexlist = mmAlignAlloc( mesh->vertexalloc * sizeof(mdVertex), 0x40 );
+#if MD_CONF_SPLIT_VERTEX_QUADRICS
+      if( context->quadriclist )
+        mmAlignFree( context->quadriclist );
+      context->quadriclist = mmAlignAlloc( mesh->vertexalloc * sizeof(mathQuadric), 0x40 );
+#endif
+      context->vertexalloc = ( context->vertexlist ? mesh->vertexalloc : 0 );
+    }
+    if( context->trireflistalloc < mesh->trireflistalloc )
+    {
+      free( context->trireflist );
+      context->trireflist = malloc( mesh->trireflistalloc * sizeof(mdi) );
+      context->trireflistalloc = ( context->trireflist ? mesh->trireflistalloc : 0 );
+    }
+    if( context->trilistsize < ( mesh->tricount * mesh->trisize ) )
+    {
+      free( context->trilist );
+      context->trilist = malloc( mesh->tricount * mesh->trisize );
+      context->trilistsize = ( context->trilist ? mesh->tricount * mesh->trisize : 0 );
+    }
+    mesh->vertexlist = context->vertexlist;
+#if MD_CONF_SPLIT_VERTEX_QUADRICS
+    mesh->quadriclist = context->quadriclist;
+#endif
+    mesh->trireflist = context->trireflist;
+    mesh->trireflistalloc = context->trireflistalloc;
+    mesh->trilist = context->trilist;
+  }
+  if( !( mesh->vertexlist ) || !( mesh->trireflist ) || !( mesh->trilist ) )
+    retval = 0;
+#if MD_CONF_SPLIT_VERTEX_QUADRICS
+  if( !( mesh->quadriclist ) )
+    retval = 0;
+#endif
 
   /* Allocate edge hash table */
-  retval = 1;
   hashsizefactor = 1.7;
-  if( !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) )
+  if( ( retval ) && !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) )
     retval = mdMeshHashInit( mesh, mesh->tricount, hashsizefactor, 7, maxmemoryusage );
 
+  /* Trirefs outgrowing their storage can take what the estimate counts for them, plus what the budget leaves over the estimate */
+  mesh->trirefarenalimit = 0;
+  if( ( retval ) && ( maxmemoryusage ) && !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) )
+  {
+    mmHashGetStatus( mesh->edgehashtable, &hashsize );
+    mesh->trirefarenalimit = 3 * mesh->tricount;
+    memoryestimate = mdMeshEstimateMemory( mesh->vertexalloc, mesh->tricount, mesh->trisize, hashsize, 7, mesh->memorybuffers );
+    if( memoryestimate < maxmemoryusage )
+      mesh->trirefarenalimit += ( maxmemoryusage - memoryestimate ) / sizeof(mdi);
+  }
+#if MD_CONFIG_ATOMIC_SUPPORT
+  mmAtomicWriteL( &mesh->trirefarenacount, 0 );
+#else
+  mesh->trirefarenacount = 0;
+  mtSpinInit( &mesh->trirefarenaspinlock );
+#endif
+
 #if MD_CONFIG_ATOMIC_SUPPORT
-  mmAtomicWrite32( &mesh->trireflock, 0x0 );
   mmAtomicWrite32( &mesh->globalvertexlock, 0x0 );
 #else
-  mtSpinInit( &mesh->trirefspinlock );
   mtSpinInit( &mesh->globalvertexspinlock );
   mtSpinInit( &mesh->trackspinlock );
 #endif
 
+  /* Per-thread op queues visible to other threads, for work stealing */
+  mesh->stealqueue = 0;
+  if( ( mesh->operationflags & MD_FLAGS_WORK_STEALING ) && !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) && ( mesh->threadcount > 1 ) )
+  {
+    mesh->stealqueue = mmAlignAlloc( mesh->threadcount * sizeof(mdStealQueue), 0x40 );
+    for( threadindex = 0 ; threadindex < mesh->threadcount ; threadindex++ )
+    {
+      mesh->stealqueue[threadindex].binsort = 0;
+#if MD_CONFIG_ATOMIC_SUPPORT
+      mmAtomicWrite32( &mesh->stealqueue[threadindex].atomlock, 0x0 );
+#else
+      mtSpinInit( &mesh->stealqueue[threadindex].spinlock );
+#endif
+    }
+  }
+
+  mesh->trirefthreadcount = malloc( mesh->threadcount * sizeof(size_t) );
+  mesh->trirefarena = mmAlignAlloc( mesh->threadcount * sizeof(mdTriRefArena), 0x40 );
+  for( threadindex = 0 ; threadindex < mesh->threadcount ; threadindex++ )
+  {
+    mesh->trirefarena[threadindex].chunklist = 0;
+    mesh->trirefarena[threadindex].trireflist = 0;
+    mesh->trirefarena[threadindex].trirefavail = 0;
+  }
+
+  /* Buffers to radix sort the directed edges of all triangles, fall back to the edge hash build if we can't get them */
+  mesh->edgekeylist = 0;
+  mesh->edgekeybuffer = 0;
+  mesh->edgekeyhistogram = 0;
+  if( ( mesh->operationflags & MD_FLAGS_SORTED_TOPOLOGY ) && ( (uint64_t)mesh->vertexcount <= 0xffffffff ) )
+  {
+    keycount = 3 * mesh->tricount;
+    mesh->edgekeylist = malloc( keycount * sizeof(mdEdgeKey) );
+    mesh->edgekeybuffer = malloc( keycount * sizeof(mdEdgeKey) );
+    mesh->edgekeyhistogram = malloc( mesh->threadcount * MD_EDGEKEY_RADIX_SIZE * sizeof(size_t) );
+    if( !( mesh->edgekeylist ) || !( mesh->edgekeybuffer ) || !( mesh->edgekeyhistogram ) )
+    {
+      mdMeshFreeEdgeKeys( mesh );
+      /* The edge hash build doesn't order trirefs, a deterministic decimation can't fall back to it */
+      if( mesh->operationflags & MD_FLAGS_DETERMINISTIC )
+        retval = 0;
+    }
+    else
+    {
+      /* Only sort the digits that keys may hold */
+      keymax = ( (uint64_t)mesh->vertexcount * (uint64_t)mesh->vertexcount ) - 1;
+      for( mesh->edgekeypasscount = 0 ; keymax ; keymax >>= MD_EDGEKEY_RADIX_BITS )
+        mesh->edgekeypasscount++;
+      mesh->edgekeysorted = mesh->edgekeylist;
+      mesh->edgekeydeny = (unsigned char *)mesh->edgekeybuffer;
+      if( mesh->edgekeypasscount & 0x1 )
+      {
+        mesh->edgekeysorted = mesh->edgekeybuffer;
+        mesh->edgekeydeny = (unsigned char *)mesh->edgekeylist;
+      }
+    }
+  }
+  /* Buffers to sort vertices or triangles along a Morton curve, fall back to the input order and index ranges if we can't get them */
+  mesh->mortonkeylist = 0;
+  mesh->mortonkeybuffer = 0;
+  mesh->mortonhistogram = 0;
+  mesh->mortonbounds = 0;
+  mesh->vertexmap = 0;
+  mesh->vertexremap = 0;
+  mesh->trimap = 0;
+  mesh->mapvertexcount = 0;
+  mesh->partitionflag = ( ( mesh->operationflags & MD_FLAGS_SPATIAL_PARTITION ) && !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) && ( mesh->threadcount > 1 ) );
+  if( ( mesh->partitionflag ) || ( mesh->operationflags & MD_FLAGS_REORDER_MESH ) )
+  {
+    keycount = ( mesh->vertexcount > mesh->tricount ? mesh->vertexcount : mesh->tricount );
+    mesh->mortonkeylist = malloc( keycount * sizeof(mdEdgeKey) );
+    mesh->mortonkeybuffer = malloc( keycount * sizeof(mdEdgeKey) );
+    mesh->mortonhistogram = malloc( mesh->threadcount * MD_EDGEKEY_RADIX_SIZE * sizeof(size_t) );
+    mesh->mortonbounds = malloc( mesh->threadcount * 6 * sizeof(mdf) );
+    if( !( mesh->mortonkeylist ) || !( mesh->mortonkeybuffer ) || !( mesh->mortonhistogram ) || !( mesh->mortonbounds ) )
+    {
+      mdMeshFreeMortonKeys( mesh );
+      mesh->partitionflag = 0;
+    }
+    else if( mesh->operationflags & MD_FLAGS_REORDER_MESH )
+    {
+      mesh->vertexmap = malloc( mesh->vertexcount * sizeof(mdi) );
+      mesh->vertexremap = malloc( mesh->vertexcount * sizeof(mdi) );
+      mesh->trimap = malloc( mesh->tricount * sizeof(mdi) );
+      if( !( mesh->vertexmap ) || !( mesh->vertexremap ) || !( mesh->trimap ) )
+        mdMeshFreeReorder( mesh );
+      else
+        mesh->mapvertexcount = mesh->vertexcount;
+    }
+  }
+  mesh->packcount = malloc( mesh->threadcount * sizeof(mdPackCount) );
+  mesh->trinormal = 0;
+  mesh->vertexnormal = 0;
+  mtMutexInit( &mesh->copymutex );
+
+  /* Per-thread sync steps, for asynchronous step progression */
+  mesh->threadstep = 0;
+  if( ( mesh->operationflags & MD_FLAGS_ASYNC_STEPS ) && !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) )
+  {
+    mesh->threadstep = mmAlignAlloc( mesh->threadcount * sizeof(mdThreadStep), 0x40 );
+    for( threadindex = 0 ; threadindex < mesh->threadcount ; threadindex++ )
+    {
+#if MD_CONFIG_ATOMIC_SUPPORT
+      mmAtomicWrite32( &mesh->threadstep[threadindex].stepindex, 0 );
+#else
+      mesh->threadstep[threadindex].stepindex = 0;
+#endif
+    }
+  }
+#if MD_CONFIG_ATOMIC_SUPPORT
+  mmAtomicWrite32( &mesh->stepwatermark, 0 );
+#else
+  mesh->stepwatermark = 0;
+  mtSpinInit( &mesh->stepspinlock );
+#endif
+  mesh->targetexitflag = 0;
+
+  /* Per-thread collapse logs and per-vertex logical clocks, for the progressive mesh stream */
+  mesh->collapselog = 0;
+  mesh->vertexclock = 0;
+  if( ( mesh->collapsestream ) && !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) )
+  {
+    mesh->collapselog = mmAlignAlloc( mesh->threadcount * sizeof(mdCollapseLog), 0x40 );
+    for( threadindex = 0 ; threadindex < mesh->threadcount ; threadindex++ )
+    {
+      mesh->collapselog[threadindex].entrylist = 0;
+      mesh->collapselog[threadindex].entrycount = 0;
+      mesh->collapselog[threadindex].entryalloc = 0;
+    }
+    mesh->vertexclock = calloc( mesh->vertexcount, sizeof(uint32_t) );
+  }
+
   return retval;
 }
 
@@ -4373,6 +5891,8 @@ static void mdMeshInitVertices( mdMesh *mesh, mdThreadData *tdata, int threadcou
     vertex->owner = -1;
     mtSpinInit( &vertex->ownerspinlock );
 #endif
+    if( mesh->vertexmap )
+      point = ADDRESS( mesh->point, mesh->vertexmap[ vertexindex ] * mesh->pointstride );
     mesh->vertexUserToNative( vertex->point, point, factor );
 #if CPU_SSE_SUPPORT && !MD_CONF_DOUBLE_PRECISION
     vertex->point[3] = 0.0;
@@ -4382,7 +5902,7 @@ static void mdMeshInitVertices( mdMesh *mesh, mdThreadData *tdata, int threadcou
 #if MD_CONFIG_DISTANCE_BIAS
     vertex->sumbias = 0.0;
 #endif
-    mathQuadricZero( &vertex->quadric );
+    mathQuadricZero( MD_VertexQuadric( mesh, vertex ) );
     point = ADDRESS( point, mesh->pointstride );
   }
 
@@ -4390,14 +5910,14 @@ static void mdMeshInitVertices( mdMesh *mesh, mdThreadData *tdata, int threadcou
 }
 
 
-static inline void mdMeshForbidEdge( mdMesh *mesh, int v0, int v1 )
+static inline void mdMeshForbidEdge( mdMesh *mesh, mdThreadData *tdata, int v0, int v1 )
 {
   int edgeflags;
   mdEdge edge;
   mdTriangle *tri;
   edge.v[0] = v0;
   edge.v[1] = v1;
-  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge ) == MM_HASH_SUCCESS )
+  if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) == MM_HASH_SUCCESS )
   {
     tri = ADDRESS( mesh->trilist, edge.triindex * mesh->trisize );
     edgeflags = 0;
@@ -4418,10 +5938,12 @@ static void mdMeshInitTriangles( mdMesh *mesh, mdThreadData *tdata, int threadco
 {
   int i, triperthread, triindex, triindexmax;
   long buildtricount;
+  uint64_t vertexcount;
   void *indices, *tridata;
   mdTriangle *tri;
   mdVertex *vertex;
   mdEdge edge;
+  mdEdgeKey *edgekey;
   mathQuadric q;
 
   triperthread = ( mesh->tricount / threadcount ) + 1;
@@ -4436,9 +5958,21 @@ static void mdMeshInitTriangles( mdMesh *mesh, mdThreadData *tdata, int threadco
   tridata = ADDRESS( mesh->tridata, triindex * mesh->tridatasize );
   tri = ADDRESS( mesh->trilist, triindex * mesh->trisize );
   edge.op = 0;
+  vertexcount = mesh->vertexcount;
   for( ; triindex < triindexmax ; triindex++, indices = ADDRESS( indices, mesh->indicesstride ), tri = ADDRESS( tri, mesh->trisize ), tridata = ADDRESS( tridata, mesh->tridatasize ) )
   {
+    if( mesh->trimap )
+    {
+      indices = ADDRESS( mesh->indices, mesh->trimap[ triindex ] * mesh->indicesstride );
+      tridata = ADDRESS( mesh->tridata, mesh->trimap[ triindex ] * mesh->tridatasize );
+    }
     mesh->indicesUserToNative( tri->v, indices );
+    if( mesh->vertexremap )
+    {
+      tri->v[0] = mdMeshVertexIndex( mesh, tri->v[0] );
+      tri->v[1] = mdMeshVertexIndex( mesh, tri->v[1] );
+      tri->v[2] = mdMeshVertexIndex( mesh, tri->v[2] );
+    }
 #if DEBUG_VERBOSE_QUADRIC
     printf( "Triangle %d ; %d,%d,%d\n", triindex, (int)tri->v[0], (int)tri->v[1], (int)tri->v[2] );
 #endif
@@ -4447,6 +5981,24 @@ static void mdMeshInitTriangles( mdMesh *mesh, mdThreadData *tdata, int threadco
       printf( "    ERROR: Repeated indices in triangle %d ; %d,%d,%d\n", triindex, (int)tri->v[0], (int)tri->v[1], (int)tri->v[2] );
 #endif
     tri->u.edgeflags = 0;
+    if( mesh->operationflags & MD_FLAGS_DETERMINISTIC )
+    {
+      /* Quadrics are accumulated later in a fixed order by mdMeshAccumVertexQuadrics(), only count the trirefs */
+      for( i = 0 ; i < 3 ; i++ )
+      {
+        vertex = &mesh->vertexlist[ tri->v[i] ];
+#if MD_CONFIG_ATOMIC_SUPPORT
+        mmAtomicSpin32( &vertex->atomicowner, -1, tdata->threadid );
+        vertex->trirefcount++;
+        mmAtomicWrite32( &vertex->atomicowner, -1 );
+#else
+        mtSpinLock( &vertex->ownerspinlock );
+        vertex->trirefcount++;
+        mtSpinUnlock( &vertex->ownerspinlock );
+#endif
+      }
+      goto quadricdone;
+    }
 #if MD_CONF_LOCAL_VERTEX_ORIGINS
     mdTriangleComputeLocalQuadric( mesh, tri, &q );
 #else
@@ -4460,92 +6012,556 @@ static void mdMeshInitTriangles( mdMesh *mesh, mdThreadData *tdata, int threadco
 #endif
 #if MD_CONFIG_ATOMIC_SUPPORT
       mmAtomicSpin32( &vertex->atomicowner, -1, tdata->threadid );
-      mathQuadricAddQuadric( &vertex->quadric, &q );
+      mathQuadricAddQuadric( MD_VertexQuadric( mesh, vertex ), &q );
       vertex->trirefcount++;
       mmAtomicWrite32( &vertex->atomicowner, -1 );
 #else
       mtSpinLock( &vertex->ownerspinlock );
-      mathQuadricAddQuadric( &vertex->quadric, &q );
+      mathQuadricAddQuadric( MD_VertexQuadric( mesh, vertex ), &q );
       vertex->trirefcount++;
       mtSpinUnlock( &vertex->ownerspinlock );
 #endif
     }
+    quadricdone:
     if( mesh->tridatasize )
       memcpy( ADDRESS(tri,sizeof(mdTriangle)), tridata, mesh->tridatasize );
 
-    if( !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) )
+    if( mesh->edgekeylist )
+    {
+      /* Emit the directed edges of the triangle, to be sorted */
+      edgekey = &mesh->edgekeylist[ triindex * 3 ];
+      edgekey[0].key = ( (uint64_t)tri->v[0] * vertexcount ) + (uint64_t)tri->v[1];
+      edgekey[0].triindex = triindex;
+      edgekey[1].key = ( (uint64_t)tri->v[1] * vertexcount ) + (uint64_t)tri->v[2];
+      edgekey[1].triindex = triindex;
+      edgekey[2].key = ( (uint64_t)tri->v[2] * vertexcount ) + (uint64_t)tri->v[0];
+      edgekey[2].triindex = triindex;
+    }
+    else if( !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) )
     {
       edge.triindex = triindex;
       edge.v[0] = tri->v[0];
       edge.v[1] = tri->v[1];
-      if( mmHashLockAddEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1 ) != MM_HASH_SUCCESS )
+      if( mmHashLockAddEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1, &tdata->edgehashstat ) != MM_HASH_SUCCESS )
       {
 #if DEBUG_VERBOSE_TOPOLOGY
         printf( "  WARNING: bad topology, collision on edge %d,%d\n", (int)edge.v[0], (int)edge.v[1] );
 #endif
         tri->u.edgeflags |= MD_EDGEFLAGS_DENYEDGE01;
-        mdMeshForbidEdge( mesh, edge.v[0], edge.v[1] );
-        mdMeshForbidEdge( mesh, edge.v[1], edge.v[0] );
+        mdMeshForbidEdge( mesh, tdata, edge.v[0], edge.v[1] );
+        mdMeshForbidEdge( mesh, tdata, edge.v[1], edge.v[0] );
         tdata->statuscollisioncount++;
       }
       edge.v[0] = tri->v[1];
       edge.v[1] = tri->v[2];
-      if( mmHashLockAddEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1 ) != MM_HASH_SUCCESS )
+      if( mmHashLockAddEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1, &tdata->edgehashstat ) != MM_HASH_SUCCESS )
       {
 #if DEBUG_VERBOSE_TOPOLOGY
         printf( "  WARNING: bad topology, collision on edge %d,%d\n", (int)edge.v[0], (int)edge.v[1] );
 #endif
         tri->u.edgeflags |= MD_EDGEFLAGS_DENYEDGE12;
-        mdMeshForbidEdge( mesh, edge.v[0], edge.v[1] );
-        mdMeshForbidEdge( mesh, edge.v[1], edge.v[0] );
+        mdMeshForbidEdge( mesh, tdata, edge.v[0], edge.v[1] );
+        mdMeshForbidEdge( mesh, tdata, edge.v[1], edge.v[0] );
         tdata->statuscollisioncount++;
       }
       edge.v[0] = tri->v[2];
       edge.v[1] = tri->v[0];
-      if( mmHashLockAddEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1 ) != MM_HASH_SUCCESS )
+      if( mmHashLockAddEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 1, &tdata->edgehashstat ) != MM_HASH_SUCCESS )
       {
 #if DEBUG_VERBOSE_TOPOLOGY
         printf( "  WARNING: bad topology, collision on edge %d,%d\n", (int)edge.v[0], (int)edge.v[1] );
 #endif
         tri->u.edgeflags |= MD_EDGEFLAGS_DENYEDGE20;
-        mdMeshForbidEdge( mesh, edge.v[0], edge.v[1] );
-        mdMeshForbidEdge( mesh, edge.v[1], edge.v[0] );
+        mdMeshForbidEdge( mesh, tdata, edge.v[0], edge.v[1] );
+        mdMeshForbidEdge( mesh, tdata, edge.v[1], edge.v[0] );
         tdata->statuscollisioncount++;
       }
     }
 
-    buildtricount++;
-    tdata->statusbuildtricount = buildtricount;
+    buildtricount++;
+    tdata->statusbuildtricount = buildtricount;
+  }
+
+  return;
+}
+
+
+/* Mesh init step 3, initialize vertex trirefbase, prefix sum in two passes over the vertex range of each thread */
+static void mdMeshInitTrirefs( mdMesh *mesh, mdThreadData *tdata, int threadcount )
+{
+  int threadindex, vertexindex, vertexindexbase, vertexindexmax, vertexperthread;
+  size_t trirefcount;
+  mdVertex *vertex;
+
+  vertexperthread = ( mesh->vertexcount / threadcount ) + 1;
+  vertexindexbase = tdata->threadid * vertexperthread;
+  vertexindexmax = vertexindexbase + vertexperthread;
+  if( vertexindexmax > mesh->vertexcount )
+    vertexindexmax = mesh->vertexcount;
+
+  /* Count the triangle references of our vertex range */
+  trirefcount = 0;
+  vertex = &mesh->vertexlist[vertexindexbase];
+  for( vertexindex = vertexindexbase ; vertexindex < vertexindexmax ; vertexindex++, vertex++ )
+    trirefcount += vertex->trirefcount;
+  mesh->trirefthreadcount[ tdata->threadid ] = trirefcount;
+  mdThreadBarrierSync( mesh, tdata );
+
+  /* Our range starts after the references of all previous ranges */
+  trirefcount = 0;
+  for( threadindex = 0 ; threadindex < tdata->threadid ; threadindex++ )
+    trirefcount += mesh->trirefthreadcount[threadindex];
+  vertex = &mesh->vertexlist[vertexindexbase];
+  for( vertexindex = vertexindexbase ; vertexindex < vertexindexmax ; vertexindex++, vertex++ )
+  {
+    vertex->trireflist = &mesh->trireflist[ trirefcount ];
+    trirefcount += vertex->trirefcount;
+    vertex->trirefcount = 0;
+  }
+
+  return;
+}
+
+
+/* Stable radix sort of keys by all threads, each thread handles a range of keys, returns the array holding the sorted keys */
+static mdEdgeKey *mdMeshRadixSortKeys( mdMesh *mesh, mdThreadData *tdata, int threadcount, mdEdgeKey *srckey, mdEdgeKey *dstkey, size_t keycount, size_t *threadhistogram, int passcount )
+{
+  int pass, shift, digit, threadindex;
+  size_t index, indexbase, indexmax, keyperthread, offset, digitcount;
+  size_t *histogram, digitoffset[MD_EDGEKEY_RADIX_SIZE];
+  mdEdgeKey *swapkey;
+
+  keyperthread = ( keycount / threadcount ) + 1;
+  indexbase = tdata->threadid * keyperthread;
+  indexmax = indexbase + keyperthread;
+  if( indexmax > keycount )
+    indexmax = keycount;
+
+  histogram = &threadhistogram[ tdata->threadid * MD_EDGEKEY_RADIX_SIZE ];
+  for( pass = 0, shift = 0 ; pass < passcount ; pass++, shift += MD_EDGEKEY_RADIX_BITS )
+  {
+    /* Count the digits of our key range */
+    memset( histogram, 0, MD_EDGEKEY_RADIX_SIZE * sizeof(size_t) );
+    for( index = indexbase ; index < indexmax ; index++ )
+      histogram[ ( srckey[index].key >> shift ) & ( MD_EDGEKEY_RADIX_SIZE - 1 ) ]++;
+    mdThreadBarrierSync( mesh, tdata );
+
+    /* Keys of a digit go after all lower digits and after the same digit of previous ranges */
+    offset = 0;
+    for( digit = 0 ; digit < MD_EDGEKEY_RADIX_SIZE ; digit++ )
+    {
+      for( threadindex = 0 ; threadindex < threadcount ; threadindex++ )
+      {
+        if( threadindex == tdata->threadid )
+          digitoffset[digit] = offset;
+        digitcount = threadhistogram[ ( threadindex * MD_EDGEKEY_RADIX_SIZE ) + digit ];
+        offset += digitcount;
+      }
+    }
+    for( index = indexbase ; index < indexmax ; index++ )
+      dstkey[ digitoffset[ ( srckey[index].key >> shift ) & ( MD_EDGEKEY_RADIX_SIZE - 1 ) ]++ ] = srckey[index];
+    mdThreadBarrierSync( mesh, tdata );
+
+    swapkey = srckey;
+    srckey = dstkey;
+    dstkey = swapkey;
+  }
+
+  return srckey;
+}
+
+
+/* Sorted topology step 1, stable radix sort of the directed edge keys of all triangles, threaded */
+static void mdMeshSortEdgeKeys( mdMesh *mesh, mdThreadData *tdata, int threadcount )
+{
+  mdMeshRadixSortKeys( mesh, tdata, threadcount, mesh->edgekeylist, mesh->edgekeybuffer, 3 * mesh->tricount, mesh->edgekeyhistogram, mesh->edgekeypasscount );
+  return;
+}
+
+
+static inline void mdTriangleCentroid( mdMesh *mesh, mdTriangle *tri, mdf *centroid )
+{
+  mdVertex *vertex0, *vertex1, *vertex2;
+  vertex0 = &mesh->vertexlist[ tri->v[0] ];
+  vertex1 = &mesh->vertexlist[ tri->v[1] ];
+  vertex2 = &mesh->vertexlist[ tri->v[2] ];
+  centroid[0] = ( vertex0->point[0] + vertex1->point[0] + vertex2->point[0] ) * (1.0/3.0);
+  centroid[1] = ( vertex0->point[1] + vertex1->point[1] + vertex2->point[1] ) * (1.0/3.0);
+  centroid[2] = ( vertex0->point[2] + vertex1->point[2] + vertex2->point[2] ) * (1.0/3.0);
+  return;
+}
+
+/* Point of a triangle for the spatial partition, its centroid */
+static void mdMortonPointTriangle( mdMesh *mesh, mdi triindex, mdf *point )
+{
+  mdTriangleCentroid( mesh, ADDRESS( mesh->trilist, triindex * mesh->trisize ), point );
+  return;
+}
+
+/* Point of a user vertex for the reordering, read from the user's arrays before the internal vertices are initialized */
+static void mdMortonPointUserVertex( mdMesh *mesh, mdi vertexindex, mdf *point )
+{
+  mesh->vertexUserToNative( point, ADDRESS( mesh->point, vertexindex * mesh->pointstride ), mesh->normalizationfactor );
+  return;
+}
+
+/* Point of a user triangle for the reordering, the centroid of its vertices once these have been reordered and initialized */
+static void mdMortonPointUserTriangle( mdMesh *mesh, mdi triindex, mdf *point )
+{
+  mdTriangle tri;
+  mesh->indicesUserToNative( tri.v, ADDRESS( mesh->indices, triindex * mesh->indicesstride ) );
+  tri.v[0] = mdMeshVertexIndex( mesh, tri.v[0] );
+  tri.v[1] = mdMeshVertexIndex( mesh, tri.v[1] );
+  tri.v[2] = mdMeshVertexIndex( mesh, tri.v[2] );
+  mdTriangleCentroid( mesh, &tri, point );
+  return;
+}
+
+/* Sort itemcount items by the Morton key of the point of each item, threaded */
+/* Returns the sorted keys, the triindex member of each key being the index of an item */
+static mdEdgeKey *mdMeshMortonSort( mdMesh *mesh, mdThreadData *tdata, int threadcount, mdi itemcount, void (*itempoint)( mdMesh *mesh, mdi itemindex, mdf *point ) )
+{
+  int axis, threadindex;
+  mdi itemindex, itemindexbase, itemindexmax, itemperthread;
+  uint32_t cell[3], cellmax;
+  mdf point[4], minimum[3], maximum[3], scale[3];
+  mdf *bounds;
+  mdEdgeKey *itemkey;
+
+  itemperthread = ( itemcount / threadcount ) + 1;
+  itemindexbase = tdata->threadid * itemperthread;
+  itemindexmax = itemindexbase + itemperthread;
+  if( itemindexmax > itemcount )
+    itemindexmax = itemcount;
+
+  /* Bounds of the points of our item range */
+  bounds = &mesh->mortonbounds[ tdata->threadid * 6 ];
+  for( axis = 0 ; axis < 3 ; axis++ )
+  {
+    bounds[axis+0] = FLT_MAX;
+    bounds[axis+3] = -FLT_MAX;
+  }
+  for( itemindex = itemindexbase ; itemindex < itemindexmax ; itemindex++ )
+  {
+    itempoint( mesh, itemindex, point );
+    for( axis = 0 ; axis < 3 ; axis++ )
+    {
+      bounds[axis+0] = mdfmin( bounds[axis+0], point[axis] );
+      bounds[axis+3] = mdfmax( bounds[axis+3], point[axis] );
+    }
+  }
+  mdThreadBarrierSync( mesh, tdata );
+
+  /* Bounds of all points, quantized to a grid of cells */
+  for( axis = 0 ; axis < 3 ; axis++ )
+  {
+    minimum[axis] = FLT_MAX;
+    maximum[axis] = -FLT_MAX;
+  }
+  for( threadindex = 0 ; threadindex < threadcount ; threadindex++ )
+  {
+    bounds = &mesh->mortonbounds[ threadindex * 6 ];
+    for( axis = 0 ; axis < 3 ; axis++ )
+    {
+      minimum[axis] = mdfmin( minimum[axis], bounds[axis+0] );
+      maximum[axis] = mdfmax( maximum[axis], bounds[axis+3] );
+    }
+  }
+  cellmax = ( 1 << MD_MORTON_CELL_BITS ) - 1;
+  for( axis = 0 ; axis < 3 ; axis++ )
+  {
+    scale[axis] = 0.0;
+    if( maximum[axis] > minimum[axis] )
+      scale[axis] = (mdf)cellmax / ( maximum[axis] - minimum[axis] );
+  }
+
+  /* Morton keys of our item range */
+  itemkey = &mesh->mortonkeylist[ itemindexbase ];
+  for( itemindex = itemindexbase ; itemindex < itemindexmax ; itemindex++, itemkey++ )
+  {
+    itempoint( mesh, itemindex, point );
+    for( axis = 0 ; axis < 3 ; axis++ )
+    {
+      cell[axis] = (uint32_t)( ( point[axis] - minimum[axis] ) * scale[axis] );
+      if( cell[axis] > cellmax )
+        cell[axis] = cellmax;
+    }
+    itemkey->key = ccMortonNumber3D64( cell[0], cell[1], cell[2] );
+    itemkey->triindex = itemindex;
+  }
+  mdThreadBarrierSync( mesh, tdata );
+
+  return mdMeshRadixSortKeys( mesh, tdata, threadcount, mesh->mortonkeylist, mesh->mortonkeybuffer, itemcount, mesh->mortonhistogram, MD_MORTON_PASS_COUNT );
+}
+
+
+/* Mesh reordering step 1, sort user vertices along a Morton curve and build the maps between user and internal vertex indices, threaded */
+static void mdMeshReorderVertices( mdMesh *mesh, mdThreadData *tdata, int threadcount )
+{
+  mdi vertexindex, vertexindexmax, vertexperthread, userindex;
+  mdEdgeKey *vertexkey;
+
+  vertexkey = mdMeshMortonSort( mesh, tdata, threadcount, mesh->vertexcount, mdMortonPointUserVertex );
+
+  vertexperthread = ( mesh->vertexcount / threadcount ) + 1;
+  vertexindex = tdata->threadid * vertexperthread;
+  vertexindexmax = vertexindex + vertexperthread;
+  if( vertexindexmax > mesh->vertexcount )
+    vertexindexmax = mesh->vertexcount;
+  for( ; vertexindex < vertexindexmax ; vertexindex++ )
+  {
+    userindex = vertexkey[ vertexindex ].triindex;
+    mesh->vertexmap[ vertexindex ] = userindex;
+    mesh->vertexremap[ userindex ] = vertexindex;
+  }
+  mdThreadBarrierSync( mesh, tdata );
+
+  return;
+}
+
+/* Mesh reordering step 2, sort user triangles along a Morton curve once vertices are initialized, threaded */
+static void mdMeshReorderTriangles( mdMesh *mesh, mdThreadData *tdata, int threadcount )
+{
+  mdi triindex, triindexmax, triperthread;
+  mdEdgeKey *trikey;
+
+  trikey = mdMeshMortonSort( mesh, tdata, threadcount, mesh->tricount, mdMortonPointUserTriangle );
+
+  triperthread = ( mesh->tricount / threadcount ) + 1;
+  triindex = tdata->threadid * triperthread;
+  triindexmax = triindex + triperthread;
+  if( triindexmax > mesh->tricount )
+    triindexmax = mesh->tricount;
+  for( ; triindex < triindexmax ; triindex++ )
+    mesh->trimap[ triindex ] = trikey[ triindex ].triindex;
+  mdThreadBarrierSync( mesh, tdata );
+
+  return;
+}
+
+
+/* Mark the corners of all triangles sharing the directed edge v0,v1, marks are only ever set so threads may mark the same corners */
+static void mdMeshDenyEdgeKeys( mdMesh *mesh, mdEdgeKey *keylist, size_t keycount, mdi v0, mdi v1 )
+{
+  size_t index, indexmin, indexmax;
+  uint64_t key;
+  mdTriangle *tri;
+
+  key = ( (uint64_t)v0 * (uint64_t)mesh->vertexcount ) + (uint64_t)v1;
+
+  indexmin = 0;
+  indexmax = keycount;
+  while( indexmin < indexmax )
+  {
+    index = ( indexmin + indexmax ) >> 1;
+    if( keylist[index].key < key )
+      indexmin = index + 1;
+    else
+      indexmax = index;
+  }
+  for( index = indexmin ; ( index < keycount ) && ( keylist[index].key == key ) ; index++ )
+  {
+    tri = ADDRESS( mesh->trilist, keylist[index].triindex * mesh->trisize );
+    if( ( tri->v[0] == v0 ) && ( tri->v[1] == v1 ) )
+      mesh->edgekeydeny[ ( keylist[index].triindex * 3 ) + 0 ] = 1;
+    else if( ( tri->v[1] == v0 ) && ( tri->v[2] == v1 ) )
+      mesh->edgekeydeny[ ( keylist[index].triindex * 3 ) + 1 ] = 1;
+    else
+      mesh->edgekeydeny[ ( keylist[index].triindex * 3 ) + 2 ] = 1;
+  }
+
+  return;
+}
+
+
+/* Thread filling the range of the edge hash holding hashindex, ranges are split evenly between threads */
+static inline int mdEdgeHashRangeThread( size_t hashindex, size_t hashsize, int threadcount )
+{
+  return (int)( ( (uint64_t)hashindex * (uint64_t)threadcount ) / (uint64_t)hashsize );
+}
+
+/* Sorted topology step 3, insert the edges of the sorted run heads in the edge hash, threaded */
+/* Each thread adds the run heads whose search starts in its range of the hash without locking, the few reaching the next range */
+/* are added with locks once all ranges are filled ; run heads were counted per range thread by mdMeshMergeEdgeKeys() */
+static void mdMeshFillEdgeHash( mdMesh *mesh, mdThreadData *tdata, int threadcount, size_t indexbase, size_t indexmax, size_t hashsize )
+{
+  int threadindex, rangethread;
+  size_t index, offset, headbase, headmax, deferindex;
+  size_t *hashcount, *hashoffset, *headlist;
+  uint64_t key, vertexcount;
+  mmHashIndex indexlimit;
+  mdEdgeKey *keylist;
+  mdEdge edge;
+
+  keylist = mesh->edgekeysorted;
+  vertexcount = mesh->vertexcount;
+  headlist = ADDRESS( mesh->edgekeydeny, ( ( 3 * mesh->tricount ) + 0x7 ) & ~(size_t)0x7 );
+  hashcount = mesh->edgekeyhistogram;
+  hashoffset = &mesh->edgekeyhistogram[ ( threadcount + tdata->threadid ) * threadcount ];
+  mdThreadBarrierSync( mesh, tdata );
+
+  /* Offsets of our run heads in headlist, grouped by range thread then by thread walking them */
+  offset = 0;
+  headbase = 0;
+  headmax = 0;
+  for( rangethread = 0 ; rangethread < threadcount ; rangethread++ )
+  {
+    if( rangethread == tdata->threadid )
+      headbase = offset;
+    for( threadindex = 0 ; threadindex < threadcount ; threadindex++ )
+    {
+      if( threadindex == tdata->threadid )
+        hashoffset[rangethread] = offset;
+      offset += hashcount[ ( threadindex * threadcount ) + rangethread ];
+    }
+    if( rangethread == tdata->threadid )
+      headmax = offset;
+  }
+  for( index = indexbase ; index < indexmax ; index++ )
+  {
+    key = keylist[index].key;
+    if( ( index ) && ( keylist[index-1].key == key ) )
+      continue;
+    edge.v[0] = (mdi)( key / vertexcount );
+    edge.v[1] = (mdi)( key % vertexcount );
+    rangethread = mdEdgeHashRangeThread( mmHashGetEntryIndex( mesh->edgehashtable, &mdEdgeHashAccess, &edge ), hashsize, threadcount );
+    headlist[ hashoffset[rangethread]++ ] = index;
+  }
+  mdThreadBarrierSync( mesh, tdata );
+
+  /* Fill our range of the hash, keep the run heads whose search reached the next range */
+  indexlimit = (mmHashIndex)( ( ( (uint64_t)( tdata->threadid + 1 ) * (uint64_t)hashsize ) + threadcount - 1 ) / threadcount );
+  deferindex = headbase;
+  for( index = headbase ; index < headmax ; index++ )
+  {
+    key = keylist[ headlist[index] ].key;
+    edge.v[0] = (mdi)( key / vertexcount );
+    edge.v[1] = (mdi)( key % vertexcount );
+    edge.triindex = keylist[ headlist[index] ].triindex;
+    edge.op = 0;
+    if( mmHashDirectAddEntryRange( mesh->edgehashtable, &mdEdgeHashAccess, &edge, indexlimit ) != MM_HASH_SUCCESS )
+      headlist[ deferindex++ ] = headlist[index];
+  }
+  mdThreadBarrierSync( mesh, tdata );
+
+  for( index = headbase ; index < deferindex ; index++ )
+  {
+    key = keylist[ headlist[index] ].key;
+    edge.v[0] = (mdi)( key / vertexcount );
+    edge.v[1] = (mdi)( key % vertexcount );
+    edge.triindex = keylist[ headlist[index] ].triindex;
+    edge.op = 0;
+    mmHashLockAddEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, 0, &tdata->edgehashstat );
+  }
+
+  return;
+}
+
+
+/* Sorted topology step 2, walk the runs of equal keys starting in our range of sorted keys, threaded */
+/* Set vertex trirefbase and store trirefs, mark the corners of colliding edges, then insert the edges in the hash table */
+static void mdMeshMergeEdgeKeys( mdMesh *mesh, mdThreadData *tdata, int threadcount )
+{
+  int lastflag, rangethread;
+  mdi v0, v1, vertexindex, prevv0;
+  size_t index, indexbase, indexmax, runindex, runend, keyperthread, keycount, collisioncount, hashsize;
+  size_t *hashcount;
+  uint64_t key, vertexcount;
+  mdEdgeKey *keylist;
+  mdEdge edge;
+
+  keycount = 3 * mesh->tricount;
+  keyperthread = ( keycount / threadcount ) + 1;
+  indexbase = tdata->threadid * keyperthread;
+  indexmax = indexbase + keyperthread;
+  if( indexmax > keycount )
+    indexmax = keycount;
+  if( indexbase > indexmax )
+    indexbase = indexmax;
+
+  /* Clear the deny marks of the corners of our range */
+  for( index = indexbase ; index < indexmax ; index++ )
+    mesh->edgekeydeny[index] = 0;
+  mdThreadBarrierSync( mesh, tdata );
+
+  /* Runs are walked by the thread of the range they start in */
+  keylist = mesh->edgekeysorted;
+  index = indexbase;
+  if( index )
+  {
+    for( ; ( index < keycount ) && ( keylist[index].key == keylist[index-1].key ) ; index++ );
+  }
+
+  /* Count our run heads per thread filling the range of the hash they belong to */
+  hashsize = 0;
+  hashcount = &mesh->edgekeyhistogram[ tdata->threadid * threadcount ];
+  if( !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) )
+  {
+    mmHashGetStatus( mesh->edgehashtable, &hashsize );
+    for( rangethread = 0 ; rangethread < threadcount ; rangethread++ )
+      hashcount[rangethread] = 0;
   }
 
-  return;
-}
+  vertexcount = mesh->vertexcount;
+  prevv0 = ( index ? (mdi)( keylist[index-1].key / vertexcount ) : -1 );
+  collisioncount = 0;
+  lastflag = ( !( keycount ) && !( tdata->threadid ) );
+  for( ; index < indexmax ; index = runend )
+  {
+    key = keylist[index].key;
+    for( runend = index + 1 ; ( runend < keycount ) && ( keylist[runend].key == key ) ; runend++ );
+    if( runend == keycount )
+      lastflag = 1;
+    v0 = (mdi)( key / vertexcount );
+    v1 = (mdi)( key % vertexcount );
 
+    /* First run of v0, the trirefs of v0 start here, and so do the empty trirefs of unreferenced vertices before it */
+    if( v0 != prevv0 )
+    {
+      for( vertexindex = prevv0 + 1 ; vertexindex <= v0 ; vertexindex++ )
+        mesh->vertexlist[vertexindex].trireflist = &mesh->trireflist[index];
+      prevv0 = v0;
+    }
+    for( runindex = index ; runindex < runend ; runindex++ )
+      mesh->trireflist[runindex] = keylist[runindex].triindex;
 
-/* Mesh init step 3, initialize vertex trirefbase, NOT threaded */
-static void mdMeshInitTrirefs( mdMesh *mesh )
-{
-  mdi vertexindex;
-  size_t trirefcount;
-  mdVertex *vertex;
+    if( mesh->operationflags & MD_FLAGS_NO_DECIMATION )
+      continue;
 
-  /* Compute base of vertex triangle references */
-  trirefcount = 0;
-  vertex = mesh->vertexlist;
-  for( vertexindex = 0 ; vertexindex < mesh->vertexcount ; vertexindex++, vertex++ )
+    /* The edge belongs to the first triangle, the lowest triangle index, inserted by mdMeshFillEdgeHash() */
+    edge.v[0] = v0;
+    edge.v[1] = v1;
+    hashcount[ mdEdgeHashRangeThread( mmHashGetEntryIndex( mesh->edgehashtable, &mdEdgeHashAccess, &edge ), hashsize, threadcount ) ]++;
+
+    /* Edge shared by more than one triangle in the same direction, deny its collapse in both directions */
+    if( runend - index > 1 )
+    {
+#if DEBUG_VERBOSE_TOPOLOGY
+      printf( "  WARNING: bad topology, collision on edge %d,%d\n", (int)v0, (int)v1 );
+#endif
+      collisioncount += ( runend - index ) - 1;
+      mdMeshDenyEdgeKeys( mesh, keylist, keycount, v0, v1 );
+      mdMeshDenyEdgeKeys( mesh, keylist, keycount, v1, v0 );
+    }
+  }
+  tdata->statuscollisioncount += collisioncount;
+
+  /* The thread walking the last run sets trirefbase of the unreferenced vertices at the end */
+  if( lastflag )
   {
-    vertex->trirefbase = trirefcount;
-    trirefcount += vertex->trirefcount;
-    vertex->trirefcount = 0;
+    for( vertexindex = prevv0 + 1 ; vertexindex < mesh->vertexcount ; vertexindex++ )
+      mesh->vertexlist[vertexindex].trireflist = &mesh->trireflist[keycount];
   }
-  mesh->trireflistcount = trirefcount;
+
+  if( !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) )
+    mdMeshFillEdgeHash( mesh, tdata, threadcount, indexbase, indexmax, hashsize );
 
   return;
 }
 
 
 /* Accumulate quadrics from boundaries or weighted edges as returned by user callback */
-static inline void mdMeshAccumBoundaryEdges( mdMesh *mesh, mdTriangle *tri, mdVertex **trivertex )
+static inline void mdMeshAccumBoundaryEdges( mdMesh *mesh, mdThreadData *tdata, mdTriangle *tri, mdVertex **trivertex )
 {
   int hashread;
   mdf edgeweight, boundaryedgeexpand;
@@ -4556,7 +6572,7 @@ static inline void mdMeshAccumBoundaryEdges( mdMesh *mesh, mdTriangle *tri, mdVe
 
   edge.v[0] = tri->v[1];
   edge.v[1] = tri->v[0];
-  hashread = mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge );
+  hashread = mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat );
   edgeweight = mesh->boundaryareafactor;
   if( !( tri->u.edgeflags & MD_EDGEFLAGS_DENYEDGE01 ) && ( hashread != MM_HASH_SUCCESS ) )
   {
@@ -4577,12 +6593,12 @@ static inline void mdMeshAccumBoundaryEdges( mdMesh *mesh, mdTriangle *tri, mdVe
   }
   else
     goto skip01;
-  mdMeshAccumulateBoundary( trivertex[0], trivertex[1], trivertex[2], edgeweight, boundaryedgeexpand );
+  mdMeshAccumulateBoundary( mesh, trivertex[0], trivertex[1], trivertex[2], edgeweight, boundaryedgeexpand );
   skip01:
 
   edge.v[0] = tri->v[2];
   edge.v[1] = tri->v[1];
-  hashread = mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge );
+  hashread = mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat );
   edgeweight = mesh->boundaryareafactor;
   if( !( tri->u.edgeflags & MD_EDGEFLAGS_DENYEDGE12 ) && ( hashread != MM_HASH_SUCCESS ) )
   {
@@ -4603,12 +6619,12 @@ static inline void mdMeshAccumBoundaryEdges( mdMesh *mesh, mdTriangle *tri, mdVe
   }
   else
     goto skip12;
-  mdMeshAccumulateBoundary( trivertex[1], trivertex[2], trivertex[0], edgeweight, boundaryedgeexpand );
+  mdMeshAccumulateBoundary( mesh, trivertex[1], trivertex[2], trivertex[0], edgeweight, boundaryedgeexpand );
   skip12:
 
   edge.v[0] = tri->v[0];
   edge.v[1] = tri->v[2];
-  hashread = mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge );
+  hashread = mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat );
   edgeweight = mesh->boundaryareafactor;
   if( !( tri->u.edgeflags & MD_EDGEFLAGS_DENYEDGE20 ) && ( hashread != MM_HASH_SUCCESS ) )
   {
@@ -4617,139 +6633,473 @@ static inline void mdMeshAccumBoundaryEdges( mdMesh *mesh, mdTriangle *tri, mdVe
 #endif
     tri->u.edgeflags |= MD_EDGEFLAGS_BOUNDARY20;
   }
-  else if( ( mesh->edgeweight ) && ( hashread == MM_HASH_SUCCESS ) )
-  {
-    trilink = ADDRESS( mesh->trilist, edge.triindex * mesh->trisize );
-    edgeweight *= mesh->edgeweight( ADDRESS( tri, sizeof(mdTriangle) ), ADDRESS( trilink, sizeof(mdTriangle) ) );
-    if( edgeweight <= 0.0 )
-      goto skip20;
-#if DEBUG_VERBOSE_BOUNDARY
-    printf( "Edge weight %d,%d (%d) ; %f\n", tri->v[0], tri->v[2], tri->v[1], edgeweight );
+  else if( ( mesh->edgeweight ) && ( hashread == MM_HASH_SUCCESS ) )
+  {
+    trilink = ADDRESS( mesh->trilist, edge.triindex * mesh->trisize );
+    edgeweight *= mesh->edgeweight( ADDRESS( tri, sizeof(mdTriangle) ), ADDRESS( trilink, sizeof(mdTriangle) ) );
+    if( edgeweight <= 0.0 )
+      goto skip20;
+#if DEBUG_VERBOSE_BOUNDARY
+    printf( "Edge weight %d,%d (%d) ; %f\n", tri->v[0], tri->v[2], tri->v[1], edgeweight );
+#endif
+  }
+  else
+    goto skip20;
+  mdMeshAccumulateBoundary( mesh, trivertex[2], trivertex[0], trivertex[1], edgeweight, boundaryedgeexpand );
+  skip20:
+
+  return;
+}
+
+
+/* Deterministic build, flag the boundary edges of a triangle, boundary quadrics are accumulated by mdMeshAccumVertexQuadrics() */
+static inline void mdMeshMarkBoundaryEdges( mdMesh *mesh, mdThreadData *tdata, mdTriangle *tri )
+{
+  mdEdge edge;
+
+  edge.v[0] = tri->v[1];
+  edge.v[1] = tri->v[0];
+  if( !( tri->u.edgeflags & MD_EDGEFLAGS_DENYEDGE01 ) && ( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) != MM_HASH_SUCCESS ) )
+    tri->u.edgeflags |= MD_EDGEFLAGS_BOUNDARY01;
+  edge.v[0] = tri->v[2];
+  edge.v[1] = tri->v[1];
+  if( !( tri->u.edgeflags & MD_EDGEFLAGS_DENYEDGE12 ) && ( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) != MM_HASH_SUCCESS ) )
+    tri->u.edgeflags |= MD_EDGEFLAGS_BOUNDARY12;
+  edge.v[0] = tri->v[0];
+  edge.v[1] = tri->v[2];
+  if( !( tri->u.edgeflags & MD_EDGEFLAGS_DENYEDGE20 ) && ( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) != MM_HASH_SUCCESS ) )
+    tri->u.edgeflags |= MD_EDGEFLAGS_BOUNDARY20;
+
+  return;
+}
+
+/* Weight of the boundary quadric of edge edgeindex of a triangle, as mdMeshAccumBoundaryEdges() would accumulate it ; return zero if none */
+static int mdMeshBoundaryEdgeWeight( mdMesh *mesh, mdThreadData *tdata, mdTriangle *tri, int edgeindex, mdf *retweight )
+{
+  static const int boundaryflags[3] = { MD_EDGEFLAGS_BOUNDARY01, MD_EDGEFLAGS_BOUNDARY12, MD_EDGEFLAGS_BOUNDARY20 };
+  mdf edgeweight;
+  mdEdge edge;
+  mdTriangle *trilink;
+
+  edgeweight = mesh->boundaryareafactor;
+  if( !( tri->u.edgeflags & boundaryflags[edgeindex] ) )
+  {
+    if( !( mesh->edgeweight ) )
+      return 0;
+    edge.v[0] = tri->v[ edgeindex < 2 ? edgeindex + 1 : 0 ];
+    edge.v[1] = tri->v[ edgeindex ];
+    if( mmHashLockReadEntry( mesh->edgehashtable, &mdEdgeHashAccess, &edge, &tdata->edgehashstat ) != MM_HASH_SUCCESS )
+      return 0;
+    trilink = ADDRESS( mesh->trilist, edge.triindex * mesh->trisize );
+    edgeweight *= mesh->edgeweight( ADDRESS( tri, sizeof(mdTriangle) ), ADDRESS( trilink, sizeof(mdTriangle) ) );
+    if( edgeweight <= 0.0 )
+      return 0;
+  }
+  *retweight = edgeweight;
+  return 1;
+}
+
+
+/* Mesh init step 4, store vertex trirefs and accumulate boundary quadrics, threaded */
+static void mdMeshBuildTrirefs( mdMesh *mesh, mdThreadData *tdata, int threadcount )
+{
+  int i, triperthread, triindex, triindexmax;
+  long buildrefcount;
+  unsigned char *denymark;
+  mdTriangle *tri;
+  mdVertex *vertex, *trivertex[3];
+
+  triperthread = ( mesh->tricount / threadcount ) + 1;
+  triindex = tdata->threadid * triperthread;
+  triindexmax = triindex + triperthread;
+  if( triindexmax > mesh->tricount )
+    triindexmax = mesh->tricount;
+
+  /* Store vertex triangle references and accumulate boundary quadrics */
+  buildrefcount = 0;
+  tri = ADDRESS( mesh->trilist, triindex * mesh->trisize );
+  for( ; triindex < triindexmax ; triindex++, tri = ADDRESS( tri, mesh->trisize ) )
+  {
+    if( mesh->edgekeylist )
+    {
+      /* Trirefs were stored from the sorted edge keys, apply the deny marks of colliding edges */
+      denymark = &mesh->edgekeydeny[ triindex * 3 ];
+      if( denymark[0] )
+        tri->u.edgeflags |= MD_EDGEFLAGS_DENYEDGE01;
+      if( denymark[1] )
+        tri->u.edgeflags |= MD_EDGEFLAGS_DENYEDGE12;
+      if( denymark[2] )
+        tri->u.edgeflags |= MD_EDGEFLAGS_DENYEDGE20;
+      for( i = 0 ; i < 3 ; i++ )
+        trivertex[i] = &mesh->vertexlist[ tri->v[i] ];
+      goto boundary;
+    }
+    for( i = 0 ; i < 3 ; i++ )
+    {
+      vertex = &mesh->vertexlist[ tri->v[i] ];
+#if MD_CONFIG_ATOMIC_SUPPORT
+      mmAtomicSpin32( &vertex->atomicowner, -1, tdata->threadid );
+      vertex->trireflist[ vertex->trirefcount++ ] = triindex;
+      mmAtomicWrite32( &vertex->atomicowner, -1 );
+#else
+      mtSpinLock( &vertex->ownerspinlock );
+      vertex->trireflist[ vertex->trirefcount++ ] = triindex;
+      mtSpinUnlock( &vertex->ownerspinlock );
+#endif
+      trivertex[i] = vertex;
+    }
+
+    boundary:
+    if( mesh->operationflags & MD_FLAGS_NO_DECIMATION )
+      ;
+    else if( mesh->operationflags & MD_FLAGS_DETERMINISTIC )
+      mdMeshMarkBoundaryEdges( mesh, tdata, tri );
+    else
+      mdMeshAccumBoundaryEdges( mesh, tdata, tri, trivertex );
+
+    buildrefcount++;
+    tdata->statusbuildrefcount = buildrefcount;
+  }
+
+  return;
+}
+
+
+/* Deterministic build step 5, accumulate the quadrics of the vertices of our range, threaded */
+/* Each vertex sums its triangles in the order of its sorted trirefs, the sums don't depend on the count of threads or their timing */
+static void mdMeshAccumVertexQuadrics( mdMesh *mesh, mdThreadData *tdata, int threadcount )
+{
+  int i, edgeindex, vertexindex, vertexindexmax, vertexperthread;
+  mdf edgeweight;
+  mdTriangle *tri;
+  mdVertex *vertex, *trivertex[3];
+  mathQuadric q;
+
+  vertexperthread = ( mesh->vertexcount / threadcount ) + 1;
+  vertexindex = tdata->threadid * vertexperthread;
+  vertexindexmax = vertexindex + vertexperthread;
+  if( vertexindexmax > mesh->vertexcount )
+    vertexindexmax = mesh->vertexcount;
+
+  vertex = &mesh->vertexlist[vertexindex];
+  for( ; vertexindex < vertexindexmax ; vertexindex++, vertex++ )
+  {
+    for( i = 0 ; i < vertex->trirefcount ; i++ )
+    {
+      tri = ADDRESS( mesh->trilist, vertex->trireflist[i] * mesh->trisize );
+#if MD_CONF_LOCAL_VERTEX_ORIGINS
+      mdTriangleComputeLocalQuadric( mesh, tri, &q );
+#else
+      mdTriangleComputeQuadric( mesh, tri, &q );
+#endif
+      mathQuadricAddQuadric( MD_VertexQuadric( mesh, vertex ), &q );
+    }
+    /* Boundary quadrics go to both vertices of the edge */
+    for( i = 0 ; i < vertex->trirefcount ; i++ )
+    {
+      tri = ADDRESS( mesh->trilist, vertex->trireflist[i] * mesh->trisize );
+      trivertex[0] = &mesh->vertexlist[ tri->v[0] ];
+      trivertex[1] = &mesh->vertexlist[ tri->v[1] ];
+      trivertex[2] = &mesh->vertexlist[ tri->v[2] ];
+      for( edgeindex = 0 ; edgeindex < 3 ; edgeindex++ )
+      {
+        if( ( trivertex[ edgeindex ] != vertex ) && ( trivertex[ ( edgeindex + 1 ) % 3 ] != vertex ) )
+          continue;
+        if( !( mdMeshBoundaryEdgeWeight( mesh, tdata, tri, edgeindex, &edgeweight ) ) )
+          continue;
+        if( mdMeshBoundaryQuadric( trivertex[ edgeindex ], trivertex[ ( edgeindex + 1 ) % 3 ], trivertex[ ( edgeindex + 2 ) % 3 ], edgeweight, mesh->boundaryedgeexpand, &q ) )
+          mathQuadricAddQuadric( MD_VertexQuadric( mesh, vertex ), &q );
+      }
+    }
+  }
+
+  return;
+}
+
+
+/* Mesh clean up */
+static void mdMeshEnd( mdMesh *mesh )
+{
+  int threadindex;
+  mdTriRefChunk *chunk, *chunknext;
+#ifndef MD_CONFIG_ATOMIC_SUPPORT
+  mdi index;
+  mdVertex *vertex;
+  vertex = mesh->vertexlist;
+  for( index = 0 ; index < mesh->vertexcount ; index++, vertex++ )
+    mtSpinDestroy( &vertex->ownerspinlock );
+  mtSpinDestroy( &mesh->globalvertexspinlock );
+  mtSpinDestroy( &mesh->trackspinlock );
+  mtSpinDestroy( &mesh->stepspinlock );
+#endif
+  if( mesh->threadstep )
+    mmAlignFree( mesh->threadstep );
+  for( threadindex = 0 ; threadindex < mesh->threadcount ; threadindex++ )
+  {
+    for( chunk = mesh->trirefarena[threadindex].chunklist ; chunk ; chunk = chunknext )
+    {
+      chunknext = chunk->next;
+      free( chunk );
+    }
+  }
+  mmAlignFree( mesh->trirefarena );
+  free( mesh->trirefthreadcount );
+  mdMeshFreeEdgeKeys( mesh );
+  mdMeshFreeMortonKeys( mesh );
+  mdMeshFreeReorder( mesh );
+  free( mesh->packcount );
+  mtMutexDestroy( &mesh->copymutex );
+  if( mesh->stealqueue )
+  {
+#ifndef MD_CONFIG_ATOMIC_SUPPORT
+    for( index = 0 ; index < mesh->threadcount ; index++ )
+      mtSpinDestroy( &mesh->stealqueue[index].spinlock );
+#endif
+    mmAlignFree( mesh->stealqueue );
+  }
+  if( mesh->collapselog )
+  {
+    for( threadindex = 0 ; threadindex < mesh->threadcount ; threadindex++ )
+      free( mesh->collapselog[threadindex].entrylist );
+    mmAlignFree( mesh->collapselog );
+  }
+  free( mesh->vertexclock );
+  if( mesh->context )
+    return;
+  mmAlignFree( mesh->vertexlist );
+#if MD_CONF_SPLIT_VERTEX_QUADRICS
+  mmAlignFree( mesh->quadriclist );
+#endif
+  free( mesh->trireflist );
+  free( mesh->trilist );
+  return;
+}
+
+
+
+////
+
+
+
+/* In some rare circumstances, a vertex can be unused even with redirectindex == -1 and trirefs leading to deleted triangles */
+static int mdMeshVertexCheckUse( mdMesh *mesh, mdi *trireflist, int trirefcount )
+{
+  int index;
+  mdi triindex;
+  mdTriangle *tri;
+  for( index = 0 ; index < trirefcount ; index++ )
+  {
+    triindex = trireflist[ index ];
+    if( triindex == -1 )
+      continue;
+    tri = ADDRESS( mesh->trilist, triindex * mesh->trisize );
+    if( tri->v[0] == -1 )
+      continue;
+    return 1;
+  }
+  return 0;
+}
+
+
+/* Set the vertex count and cost ceiling of the next level of detail pending */
+static void mdMeshSetPendingLevel( mdMesh *mesh )
+{
+  mdLevel *level;
+
+  mesh->levelvertexcount = 0;
+  mesh->levelmaxcost = MD_OP_FAIL_VALUE;
+  if( mesh->levelindex >= mesh->levelcount )
+    return;
+  level = &mesh->levellist[ mesh->levelindex ];
+  mesh->levelvertexcount = level->targetvertexcount;
+  if( level->featuresize > 0.0 )
+    mesh->levelmaxcost = pow( 0.25 * level->featuresize * mesh->normalizationfactor, 6.0 );
+  return;
+}
+
+
+/* Write a snapshot of the current mesh to a level of detail, all threads must be stopped */
+/* Vertices are written in user order like mdMeshStoreVertices(), vertexmap is indexed by internal vertex index */
+static void mdMeshWriteLevel( mdMesh *mesh, mdLevel *level )
+{
+  mdi vertexindex, nativeindex, writeindex, tricount, v[3];
+  mdf factor;
+  mdi *vertexmap;
+  uint32_t *vertexsource;
+  mdVertex *vertex;
+  mdTriangle *tri, *triend;
+  void *point, *indices, *tridata;
+
+  vertexmap = malloc( mesh->vertexcount * sizeof(mdi) );
+  writeindex = 0;
+  for( vertexindex = 0 ; vertexindex < mesh->vertexcount ; vertexindex++ )
+  {
+    nativeindex = mdMeshVertexIndex( mesh, vertexindex );
+    vertex = &mesh->vertexlist[ nativeindex ];
+    vertexmap[nativeindex] = -1;
+    if( !( mesh->operationflags & MD_FLAGS_NO_VERTEX_PACKING ) )
+    {
+      if( vertex->redirectindex != -1 )
+        continue;
+      if( !( vertex->trirefcount ) )
+        continue;
+      if( ( vertex->trirefcount != -1 ) && !( mdMeshVertexCheckUse( mesh, vertex->trireflist, vertex->trirefcount ) ) )
+        continue;
+    }
+    vertexmap[nativeindex] = writeindex++;
+  }
+  tricount = 0;
+  tri = mesh->trilist;
+  triend = ADDRESS( tri, mesh->tricount * mesh->trisize );
+  for( ; tri < triend ; tri = ADDRESS( tri, mesh->trisize ) )
+  {
+    if( tri->v[0] != -1 )
+      tricount++;
+  }
+
+  level->vertexcount = writeindex;
+  level->tricount = tricount;
+  if( ( level->vertexcount <= level->vertexalloc ) && ( level->tricount <= level->trialloc ) )
+  {
+    factor = 1.0 / mesh->normalizationfactor;
+    point = level->vertex;
+    vertexsource = level->vertexsource;
+    for( vertexindex = 0 ; vertexindex < mesh->vertexcount ; vertexindex++ )
+    {
+      nativeindex = mdMeshVertexIndex( mesh, vertexindex );
+      if( vertexmap[nativeindex] == -1 )
+        continue;
+      mesh->vertexNativeToUser( point, mesh->vertexlist[ nativeindex ].point, factor );
+      point = ADDRESS( point, level->vertexstride );
+      if( vertexsource )
+        *vertexsource++ = (uint32_t)vertexindex;
+    }
+    indices = level->indices;
+    tridata = level->tridata;
+    for( tri = mesh->trilist ; tri < triend ; tri = ADDRESS( tri, mesh->trisize ) )
+    {
+      if( tri->v[0] == -1 )
+        continue;
+      v[0] = vertexmap[ tri->v[0] ];
+      v[1] = vertexmap[ tri->v[1] ];
+      v[2] = vertexmap[ tri->v[2] ];
+      mesh->indicesNativeToUser( indices, v );
+      indices = ADDRESS( indices, level->indicesstride );
+      if( ( mesh->tridatasize ) && ( tridata ) )
+      {
+        memcpy( tridata, ADDRESS(tri,sizeof(mdTriangle)), mesh->tridatasize );
+        tridata = ADDRESS( tridata, mesh->tridatasize );
+      }
+    }
+  }
+
+#if DEBUG_VERBOSE_OUTPUT
+  printf( "Level %d : %d vertices, %d triangles\n", mesh->levelindex, (int)writeindex, (int)tricount );
 #endif
-  }
-  else
-    goto skip20;
-  mdMeshAccumulateBoundary( trivertex[2], trivertex[0], trivertex[1], edgeweight, boundaryedgeexpand );
-  skip20:
 
+  free( vertexmap );
   return;
 }
 
 
-/* Mesh init step 4, store vertex trirefs and accumulate boundary quadrics, threaded */
-static void mdMeshBuildTrirefs( mdMesh *mesh, mdThreadData *tdata, int threadcount )
+/* Snapshot all pending levels reached by the vertex count, or by the cost ceiling maxcost completed by all threads */
+static void mdMeshSnapshotLevels( mdMesh *mesh, mdf maxcost )
 {
-  int i, triperthread, triindex, triindexmax;
-  long buildrefcount;
-  mdTriangle *tri;
-  mdi *trireflist;
-  mdVertex *vertex, *trivertex[3];
-
-  triperthread = ( mesh->tricount / threadcount ) + 1;
-  triindex = tdata->threadid * triperthread;
-  triindexmax = triindex + triperthread;
-  if( triindexmax > mesh->tricount )
-    triindexmax = mesh->tricount;
+  long trackvertexcount;
 
-  /* Store vertex triangle references and accumulate boundary quadrics */
-  buildrefcount = 0;
-  tri = ADDRESS( mesh->trilist, triindex * mesh->trisize );
-  trireflist = mesh->trireflist;
-  for( ; triindex < triindexmax ; triindex++, tri = ADDRESS( tri, mesh->trisize ) )
+  while( mesh->levelindex < mesh->levelcount )
   {
-    for( i = 0 ; i < 3 ; i++ )
-    {
-      vertex = &mesh->vertexlist[ tri->v[i] ];
 #if MD_CONFIG_ATOMIC_SUPPORT
-      mmAtomicSpin32( &vertex->atomicowner, -1, tdata->threadid );
-      trireflist[ vertex->trirefbase + vertex->trirefcount++ ] = triindex;
-      mmAtomicWrite32( &vertex->atomicowner, -1 );
+    trackvertexcount = mmAtomicReadL( &mesh->trackvertexcount );
 #else
-      mtSpinLock( &vertex->ownerspinlock );
-      trireflist[ vertex->trirefbase + vertex->trirefcount++ ] = triindex;
-      mtSpinUnlock( &vertex->ownerspinlock );
+    mtSpinLock( &mesh->trackspinlock );
+    trackvertexcount = mesh->trackvertexcount;
+    mtSpinUnlock( &mesh->trackspinlock );
 #endif
-      trivertex[i] = vertex;
-    }
-
-    if( !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) )
-      mdMeshAccumBoundaryEdges( mesh, tri, trivertex );
-
-    buildrefcount++;
-    tdata->statusbuildrefcount = buildrefcount;
+    if( !( ( mesh->levelvertexcount ) && ( trackvertexcount <= mesh->levelvertexcount ) ) && ( maxcost < mesh->levelmaxcost ) )
+      break;
+    mdMeshWriteLevel( mesh, &mesh->levellist[ mesh->levelindex ] );
+    mesh->levelindex++;
+    mdMeshSetPendingLevel( mesh );
   }
-
   return;
 }
 
 
-/* Mesh clean up */
-static void mdMeshEnd( mdMesh *mesh )
-{
-#ifndef MD_CONFIG_ATOMIC_SUPPORT
-  mdi index;
-  mdVertex *vertex;
-  vertex = mesh->vertexlist;
-  for( index = 0 ; index < mesh->vertexcount ; index++, vertex++ )
-    mtSpinDestroy( &vertex->ownerspinlock );
-  mtSpinDestroy( &mesh->trirefspinlock );
-  mtSpinDestroy( &mesh->globalvertexspinlock );
-  mtSpinDestroy( &mesh->trackspinlock );
-#endif
-  mmAlignFree( mesh->vertexlist );
-  free( mesh->trireflist );
-  free( mesh->trilist );
-  return;
-}
 
+////
 
 
-////
 
+static int mdCollapseEntryCompare( const void *p0, const void *p1 )
+{
+  const mdCollapseEntry *entry0, *entry1;
+  entry0 = p0;
+  entry1 = p1;
+  if( entry0->clock != entry1->clock )
+    return ( entry0->clock < entry1->clock ? -1 : 1 );
+  if( entry0->order != entry1->order )
+    return ( entry0->order < entry1->order ? -1 : 1 );
+  return 0;
+}
 
+#define MD_COLLAPSE_STREAM_CHUNK (1024)
 
-static void mdMeshGrowTriRefBuffer( mdMesh *mesh, size_t trirefavailneed )
+/* Sort the records of all threads by logical clock, ties broken by thread then by order within thread */
+static void mdMeshWriteCollapseStream( mdMesh *mesh )
 {
-  size_t trirefalloc;
-  mdBarrierLockGlobal( &mesh->workbarrier );
-  trirefalloc = mesh->trireflistcount + trirefavailneed;
-  if( trirefalloc > mesh->trireflistalloc )
+  int threadindex;
+  size_t index, entrycount, chunkcount;
+  mdCollapseLog *log;
+  mdCollapseEntry *entrylist;
+  mdCollapseHeader header;
+  mdCollapseRecord chunk[MD_COLLAPSE_STREAM_CHUNK];
+
+  entrycount = 0;
+  if( mesh->collapselog )
+  {
+    for( threadindex = 0 ; threadindex < mesh->threadcount ; threadindex++ )
+      entrycount += mesh->collapselog[threadindex].entrycount;
+  }
+
+  header.magic = MD_COLLAPSE_STREAM_MAGIC;
+  header.version = MD_COLLAPSE_STREAM_VERSION;
+  header.vertexcount = mesh->vertexcount;
+  header.tricount = mesh->tricount;
+  header.recordcount = entrycount;
+  mesh->collapsestream( mesh->streamcontext, &header, sizeof(mdCollapseHeader) );
+  if( !( entrycount ) )
+    return;
+
+  /* Merge all logs in thread order, then sort by clock */
+  entrylist = malloc( entrycount * sizeof(mdCollapseEntry) );
+  entrycount = 0;
+  for( threadindex = 0 ; threadindex < mesh->threadcount ; threadindex++ )
   {
-    trirefalloc += 4096;
-    mesh->trireflistalloc = trirefalloc;
-    mesh->trireflist = realloc( mesh->trireflist, mesh->trireflistalloc * sizeof(mdi) );
+    log = &mesh->collapselog[threadindex];
+    for( index = 0 ; index < log->entrycount ; index++, entrycount++ )
+    {
+      entrylist[entrycount] = log->entrylist[index];
+      entrylist[entrycount].order = entrycount;
+    }
   }
-  mdBarrierUnlockGlobal( &mesh->workbarrier );
-  return;
-}
+  qsort( entrylist, entrycount, sizeof(mdCollapseEntry), mdCollapseEntryCompare );
 
-/* Maximum count of trirefs required by op */
-static int mdMeshCountOpTriRefNeed( mdMesh *mesh, mdOp *op )
-{
-  mdi trirefmax;
-  mdVertex *vertex0, *vertex1;
-  vertex0 = &mesh->vertexlist[op->v0];
-  vertex1 = &mesh->vertexlist[op->v1];
-  trirefmax = vertex0->trirefcount + vertex1->trirefcount;
-  return trirefmax;
-}
+  chunkcount = 0;
+  for( index = 0 ; index < entrycount ; index++ )
+  {
+    chunk[chunkcount++] = entrylist[index].record;
+    if( chunkcount == MD_COLLAPSE_STREAM_CHUNK )
+    {
+      mesh->collapsestream( mesh->streamcontext, chunk, chunkcount * sizeof(mdCollapseRecord) );
+      chunkcount = 0;
+    }
+  }
+  if( chunkcount )
+    mesh->collapsestream( mesh->streamcontext, chunk, chunkcount * sizeof(mdCollapseRecord) );
 
-/* Count of available trirefs */
-static size_t mdMeshTriRefAvail( mdMesh *mesh )
-{
-  size_t trirefavail;
-#if MD_CONFIG_ATOMIC_SUPPORT
-  mmAtomicSpin32( &mesh->trireflock, 0x0, 0x1 );
-#else
-  mtSpinLock( &mesh->trirefspinlock );
-#endif
-  trirefavail = mesh->trireflistalloc - mesh->trireflistcount;
-#if MD_CONFIG_ATOMIC_SUPPORT
-  mmAtomicWrite32( &mesh->trireflock, 0x0 );
-#else
-  mtSpinUnlock( &mesh->trirefspinlock );
-#endif
-  return trirefavail;
+  free( entrylist );
+  return;
 }
 
 
@@ -4762,6 +7112,9 @@ static void mdSortOp( mdMesh *mesh, mdThreadData *tdata, mdOp *op, int denyflag
 {
   mdf collapsecost;
   collapsecost = op->value + op->penalty;
+  if( denyflag )
+    tdata->statusdenycount++;
+  mdThreadQueueLock( tdata );
   if( ( denyflag ) || ( collapsecost >= mesh->maxcollapseacceptcost ) )
   {
 #if MD_CONFIG_ATOMIC_SUPPORT
@@ -4803,6 +7156,7 @@ static void mdSortOp( mdMesh *mesh, mdThreadData *tdata, mdOp *op, int denyflag
 #endif
   }
   op->collapsecost = collapsecost;
+  mdThreadQueueUnlock( tdata );
   return;
 }
 
@@ -4831,7 +7185,11 @@ static void mdUpdateOp( mdMesh *mesh, mdThreadData *tdata, mdOp *op, int32_t opf
   if( flags & MD_OP_FLAGS_DELETION_PENDING )
   {
     if( !( flags & MD_OP_FLAGS_DETACHED ) )
+    {
+      mdThreadQueueLock( tdata );
       mmBinSortRemove( tdata->binsort, op, op->collapsecost );
+      mdThreadQueueUnlock( tdata );
+    }
     /* Race condition, flag the op as deleted but don't free it ~ Free them all at the end with FreeAll(). */
     /*    mmBlockFree( &tdata->opblock, op );  */
 #if MD_CONFIG_ATOMIC_SUPPORT
@@ -4844,6 +7202,7 @@ static void mdUpdateOp( mdMesh *mesh, mdThreadData *tdata, mdOp *op, int32_t opf
   }
   else
   {
+    tdata->statusupdatecount++;
     if( op->value < MD_OP_FAIL_VALUE )
       op->penalty = mdEdgeCollapsePenalty( mesh, tdata, op->v0, op->v1, op->collapsepoint, &denyflag );
     else
@@ -4916,21 +7275,152 @@ static inline mdf mdfMeshProcessGetStepMaxCost( mdMesh *mesh, int stepindex )
 }
 
 
+/* Asynchronous step progression, our queue ran dry for *stepindex ; return zero when the thread is done */
+/* Adopt the shared step watermark if it moved ahead, or raise it unless it would move more than MD_ASYNC_STEP_LAG steps ahead of the slowest thread */
+static int mdMeshAsyncStep( mdMesh *mesh, mdThreadData *tdata, int *stepindex )
+{
+  int index, watermark, minstep, threadstep, newstep, doneflag;
+  long trackvertexcount;
+
+  newstep = *stepindex;
+  doneflag = 0;
+#if MD_CONFIG_ATOMIC_SUPPORT
+  watermark = mmAtomicRead32( &mesh->stepwatermark );
+#else
+  mtSpinLock( &mesh->stepspinlock );
+  watermark = mesh->stepwatermark;
+#endif
+  if( watermark > newstep )
+    newstep = watermark;
+  else
+  {
+    if( mesh->targetvertexcountmax )
+    {
+#if MD_CONFIG_ATOMIC_SUPPORT
+      trackvertexcount = mmAtomicReadL( &mesh->trackvertexcount );
+#else
+      trackvertexcount = mesh->trackvertexcount;
+#endif
+      if( ( newstep >= mesh->syncstepcount ) && ( trackvertexcount < mesh->targetvertexcountmax ) )
+        doneflag = 1;
+      if( ( newstep + 1 ) >= mesh->syncstepabort )
+        doneflag = 1;
+    }
+    else if( newstep >= mesh->syncstepcount )
+      doneflag = 1;
+    if( !( doneflag ) )
+    {
+      minstep = watermark;
+      for( index = 0 ; index < mesh->threadcount ; index++ )
+      {
+#if MD_CONFIG_ATOMIC_SUPPORT
+        threadstep = mmAtomicRead32( &mesh->threadstep[index].stepindex );
+#else
+        threadstep = mesh->threadstep[index].stepindex;
+#endif
+        if( threadstep < minstep )
+          minstep = threadstep;
+      }
+      if( ( ( watermark + 1 ) - minstep ) <= MD_ASYNC_STEP_LAG )
+      {
+#if MD_CONFIG_ATOMIC_SUPPORT
+        if( mmAtomicCmpReplace32( &mesh->stepwatermark, watermark, watermark + 1 ) )
+          newstep = watermark + 1;
+#else
+        mesh->stepwatermark = watermark + 1;
+        newstep = watermark + 1;
+#endif
+      }
+    }
+  }
+#if MD_CONFIG_ATOMIC_SUPPORT
+  mmAtomicWrite32( &mesh->threadstep[ tdata->threadid ].stepindex, ( doneflag ? MD_THREAD_STEP_DONE : newstep ) );
+#else
+  mesh->threadstep[ tdata->threadid ].stepindex = ( doneflag ? MD_THREAD_STEP_DONE : newstep );
+  mtSpinUnlock( &mesh->stepspinlock );
+#endif
+
+  if( doneflag )
+    return 0;
+  if( newstep == *stepindex )
+  {
+    /* Slower threads are too far behind, wait for them */
+    mdThreadBarrierCheckGlobal( mesh, tdata );
+    mtYield();
+  }
+  *stepindex = newstep;
+  return 1;
+}
+
+
+/* Steal an op below maxcost from the queue of another thread, return with all locks for the op acquired */
+static mdOp *mdMeshStealOp( mdMesh *mesh, mdThreadData *tdata, mdLockBuffer *lockbuffer, mdf maxcost, mdStealQueue **retqueue )
+{
+  int index, victimindex;
+  int32_t opflags;
+  mdOp *op;
+  mdStealQueue *queue;
+
+  for( index = 1 ; index < mesh->threadcount ; index++ )
+  {
+    victimindex = tdata->threadid + index;
+    if( victimindex >= mesh->threadcount )
+      victimindex -= mesh->threadcount;
+    queue = &mesh->stealqueue[ victimindex ];
+
+    op = 0;
+    mdStealQueueLock( queue );
+    if( queue->binsort )
+      op = mmBinSortGetFirst( queue->binsort, maxcost );
+    mdStealQueueUnlock( queue );
+    if( !op )
+      continue;
+
+    /* Check if a thread requested a global lock, we must not hold any vertex lock when doing so */
+    mdThreadBarrierCheckGlobal( mesh, tdata );
+
+    /* Acquire lock for op edge and all trirefs vertices */
+    mdOpResolveLockFull( mesh, tdata, lockbuffer, op );
+
+    /* The owner or another thread may have updated, detached or collapsed the op before we acquired the locks */
+#if MD_CONFIG_ATOMIC_SUPPORT
+    opflags = mmAtomicRead32( &op->flags );
+#else
+    mtSpinLock( &op->spinlock );
+    opflags = op->flags;
+    mtSpinUnlock( &op->spinlock );
+#endif
+    if( ( opflags & ( MD_OP_FLAGS_DETACHED | MD_OP_FLAGS_DELETION_PENDING | MD_OP_FLAGS_UPDATE_NEEDED | MD_OP_FLAGS_DELETED ) ) || ( op->collapsecost > maxcost ) )
+    {
+      mdLockBufferUnlockAll( mesh, tdata, lockbuffer );
+      continue;
+    }
+
+    *retqueue = queue;
+    return op;
+  }
+
+  return 0;
+}
+
+
 /* The actual mesh decimation loop, per thread */
 static int mdMeshProcessQueue( mdMesh *mesh, mdThreadData *tdata )
 {
-  int index, decimationcount, stepindex, growtriref;
-  size_t trirefneed, trirefavail;
+  int index, decimationcount, stepindex, levelstep, levelsnapshot;
   long targetvertexcountmin, targetvertexcountmax, trackvertexcount;
   int32_t opflags;
+  uint64_t idletime;
   mdf maxcost;
   mdOp *op;
+  mdStealQueue *stealqueue;
   mdLockBuffer lockbuffer;
 
   mdLockBufferInit( &lockbuffer, 2 );
 
   stepindex = 0;
   maxcost = 0.0;
+  levelstep = 0;
 
 #if DEBUG_VERBOSE_WORK >= 2
   printf( "Thread %d work, begin decimation, maxcollapsecost %f\n", mesh->maxcollapsecost );
@@ -4951,20 +7441,49 @@ static int mdMeshProcessQueue( mdMesh *mesh, mdThreadData *tdata )
         mdUpdateBufferOps( mesh, tdata, &tdata->updatebuffer[index], &lockbuffer );
     }
 
-    /* Acquire first op from thread's "queue" */
-    op = mmBinSortGetFirst( tdata->binsort, maxcost );
+    /* Acquire first op from thread's "queue", unless a target vertex count was reached */
+    op = 0;
+    stealqueue = 0;
+    if( !( mesh->targetexitflag ) )
+    {
+      mdThreadQueueLock( tdata );
+      op = mmBinSortGetFirst( tdata->binsort, maxcost );
+      mdThreadQueueUnlock( tdata );
+      /* Our queue is empty for this step, steal an op from another thread's queue rather than idling until the next step */
+      if( !( op ) && ( mesh->stealqueue ) )
+        op = mdMeshStealOp( mesh, tdata, &lockbuffer, maxcost, &stealqueue );
+    }
     if( !op )
     {
-      /* TODO: Consider stealing an op from another queue? Many threads become idle, waiting for the next step */
-      if( targetvertexcountmax )
+      idletime = mmGetMicrosecondsTime();
+      /* Threads leave together, the exit flag is read between two barriers where nobody can set it */
+      if( levelstep )
+      {
+        /* All threads are done with ops below the cost ceiling of the pending level, snapshot it then resume the same step */
+        mdThreadBarrierSync( mesh, tdata );
+        if( mesh->targetexitflag )
+          break;
+        if( !( tdata->threadid ) )
+          mdMeshSnapshotLevels( mesh, maxcost );
+        mdThreadBarrierSync( mesh, tdata );
+      }
+      else if( mesh->threadstep )
+      {
+        /* Asynchronous steps, no barrier, follow or raise the shared step watermark */
+        if( ( mesh->targetexitflag ) || !( mdMeshAsyncStep( mesh, tdata, &stepindex ) ) )
+          break;
+      }
+      else if( targetvertexcountmax )
       {
-        mdBarrierSync( &mesh->workbarrier );
+        mdThreadBarrierSync( mesh, tdata );
 #if MD_CONFIG_ATOMIC_SUPPORT
         trackvertexcount = mmAtomicReadL( &mesh->trackvertexcount );
 #else
         trackvertexcount = mesh->trackvertexcount;
 #endif
         stepindex++;
+        if( mesh->targetexitflag )
+          break;
         if( ( stepindex > mesh->syncstepcount ) && ( trackvertexcount < targetvertexcountmax ) )
           break;
         if( stepindex >= mesh->syncstepabort )
@@ -4972,7 +7491,7 @@ static int mdMeshProcessQueue( mdMesh *mesh, mdThreadData *tdata )
 #if DEBUG_VERBOSE_WORK >= 2
         printf( "Thread %d work, wait to begin step %d\n", tdata->threadid, stepindex );
 #endif
-        mdBarrierSync( &mesh->workbarrier );
+        mdThreadBarrierSync( mesh, tdata );
       }
       else
       {
@@ -4981,9 +7500,23 @@ static int mdMeshProcessQueue( mdMesh *mesh, mdThreadData *tdata )
 #if DEBUG_VERBOSE_WORK >= 2
         printf( "Thread %d work, wait to begin step %d\n", tdata->threadid, stepindex );
 #endif
-        mdBarrierSync( &mesh->workbarrier );
+        mdThreadBarrierSync( mesh, tdata );
+        if( targetvertexcountmin )
+        {
+          if( mesh->targetexitflag )
+            break;
+          mdThreadBarrierSync( mesh, tdata );
+        }
       }
+      tdata->statusidleusecs += mmGetMicrosecondsTime() - idletime;
       maxcost = mdfMeshProcessGetStepMaxCost( mesh, stepindex );
+      /* Don't go past the cost ceiling of the pending level of detail */
+      levelstep = 0;
+      if( maxcost >= mesh->levelmaxcost )
+      {
+        maxcost = mesh->levelmaxcost;
+        levelstep = 1;
+      }
 #if DEBUG_VERBOSE_WORK >= 2
       printf( "Thread %d work, begin step %d, maxcost %e\n", tdata->threadid, stepindex, maxcost );
 #elif DEBUG_VERBOSE_WORK > 0
@@ -5007,24 +7540,14 @@ static int mdMeshProcessQueue( mdMesh *mesh, mdThreadData *tdata )
  #endif
 #endif
 
-    /* Check if a thread requested a global lock */
-    mdBarrierCheckGlobal( &mesh->workbarrier );
-
-    for( ; ; )
+    /* A stolen op is returned by mdMeshStealOp() with all locks already acquired */
+    if( !( stealqueue ) )
     {
+      /* Check if a thread requested a global lock */
+      mdThreadBarrierCheckGlobal( mesh, tdata );
+
       /* Acquire lock for op edge and all trirefs vertices */
       mdOpResolveLockFull( mesh, tdata, &lockbuffer, op );
-      /* If the op may require many trirefs, make sure we have enough buffer for them */
-      trirefneed = mdMeshCountOpTriRefNeed( mesh, op );
-      if( trirefneed < MD_TRIREF_AVAIL_MIN_COUNT )
-        break;
-      trirefavail = mdMeshTriRefAvail( mesh );
-      if( trirefavail >= ( trirefneed * mesh->threadcount ) )
-        break;
-      /* Release all locks for op */
-      mdLockBufferUnlockAll( mesh, tdata, &lockbuffer );
-      /* Grow triref buffer and try again */
-      mdMeshGrowTriRefBuffer( mesh, trirefneed * mesh->threadcount );
     }
 
     /* If our op was flagged for update between mdUpdateBufferOps() and before we acquired lock, no big deal, catch the update */
@@ -5041,29 +7564,48 @@ static int mdMeshProcessQueue( mdMesh *mesh, mdThreadData *tdata )
       mdLockBufferUnlockAll( mesh, tdata, &lockbuffer );
       continue;
     }
+    /* Another thread stole the op and removed it from our queue before we acquired lock */
+    if( opflags & MD_OP_FLAGS_DETACHED )
+    {
+      mdLockBufferUnlockAll( mesh, tdata, &lockbuffer );
+      continue;
+    }
 
-    growtriref = 0;
+    levelsnapshot = 0;
 
     /* Prevent 2D collapses */
     if( !( mdEdgeCollisionCheck( mesh, tdata, op->v0, op->v1 ) ) )
     {
+      tdata->statusedgecollisioncount++;
 #if MD_CONFIG_ATOMIC_SUPPORT
       if( mmAtomicRead32( &op->flags ) & MD_OP_FLAGS_DETACHED )
         MD_ERROR( "SHOULD NOT HAPPEN %s:%d\n", 1, __FILE__, __LINE__ );
       mmAtomicOr32( &op->flags, MD_OP_FLAGS_DETACHED );
-      mmBinSortRemove( tdata->binsort, op, op->collapsecost );
 #else
       mtSpinLock( &op->spinlock );
       if( op->flags & MD_OP_FLAGS_DETACHED )
         MD_ERROR( "SHOULD NOT HAPPEN %s:%d\n", 1, __FILE__, __LINE__ );
       op->flags |= MD_OP_FLAGS_DETACHED;
       mtSpinUnlock( &op->spinlock );
-      mmBinSortRemove( tdata->binsort, op, op->collapsecost );
 #endif
+      if( stealqueue )
+      {
+        /* The op belongs to the queue of another thread, which may have already exited */
+        mdStealQueueLock( stealqueue );
+        if( stealqueue->binsort )
+          mmBinSortRemove( stealqueue->binsort, op, op->collapsecost );
+        mdStealQueueUnlock( stealqueue );
+      }
+      else
+      {
+        mdThreadQueueLock( tdata );
+        mmBinSortRemove( tdata->binsort, op, op->collapsecost );
+        mdThreadQueueUnlock( tdata );
+      }
       goto opdone;
     }
 
-    if( ( targetvertexcountmin | targetvertexcountmax ) )
+    if( ( targetvertexcountmin | targetvertexcountmax ) || ( mesh->levelcount ) )
     {
       /* Only track vertex count if we need it */
 #if MD_CONFIG_ATOMIC_SUPPORT
@@ -5074,13 +7616,17 @@ static int mdMeshProcessQueue( mdMesh *mesh, mdThreadData *tdata )
       trackvertexcount = mesh->trackvertexcount;
       mtSpinUnlock( &mesh->trackspinlock );
 #endif
+      /* Snapshot the pending level of detail once this collapse is done */
+      if( ( mesh->levelvertexcount ) && ( trackvertexcount <= mesh->levelvertexcount ) )
+        levelsnapshot = 1;
       /* Exit if we have reached our minimum count of vertices */
       if( targetvertexcountmin )
       {
         if( trackvertexcount <= targetvertexcountmin )
         {
+          mesh->targetexitflag = 1;
           mdLockBufferUnlockAll( mesh, tdata, &lockbuffer );
-          break;
+          continue;
         }
       }
       /* When targetvertexcountmax is enabled, _all_ ops are added to binsort queue */
@@ -5090,33 +7636,56 @@ static int mdMeshProcessQueue( mdMesh *mesh, mdThreadData *tdata )
         /* Continue while count>max */
         if( ( trackvertexcount < targetvertexcountmax ) && ( op->collapsecost > mesh->maxcollapsecost ) )
         {
+          mesh->targetexitflag = 1;
           mdLockBufferUnlockAll( mesh, tdata, &lockbuffer );
-          break;
+          continue;
         }
       }
     }
 
-    /* Perform the edge collapse */
-    mdEdgeCollapse( mesh, tdata, op->v0, op->v1, op->collapsepoint, &growtriref );
+    /* Order the collapse after all previous collapses touching the same vertices */
+    if( tdata->collapselog )
+      mdEdgeCollapseAdvanceClock( mesh, tdata, &lockbuffer );
+
+    /* Perform the edge collapse, out of memory leaves the mesh untouched and all threads stop decimating */
+    if( !( mdEdgeCollapse( mesh, tdata, op->v0, op->v1, op->collapsepoint ) ) )
+    {
+      mesh->allocfailflag = 1;
+      mesh->targetexitflag = 1;
+      mdLockBufferUnlockAll( mesh, tdata, &lockbuffer );
+      continue;
+    }
     decimationcount++;
+    if( stealqueue )
+      tdata->statusstealcount++;
 
     opdone:
     /* Release all locks for op */
     mdLockBufferUnlockAll( mesh, tdata, &lockbuffer );
 
-    /* Grow triref buffer if flagged as too small, we need MD_TRIREF_AVAIL_MIN_COUNT per thread */
-    if( growtriref )
+    /* Stop all threads to snapshot the level of detail we reached */
+    if( levelsnapshot )
     {
-      /* Check if a thread requested a global lock */
-      mdBarrierCheckGlobal( &mesh->workbarrier );
-      /* Grow triref buffer if still required */
-      if( mdMeshTriRefAvail( mesh ) < ( mesh->threadcount * MD_TRIREF_AVAIL_MIN_COUNT ) )
-        mdMeshGrowTriRefBuffer( mesh, mesh->threadcount * MD_TRIREF_AVAIL_MIN_COUNT );
+      mdThreadBarrierLockGlobal( mesh, tdata );
+      mdMeshSnapshotLevels( mesh, 0.0 );
+      mdBarrierUnlockGlobal( &mesh->workbarrier );
     }
   }
 
   mdLockBufferEnd( &lockbuffer );
 
+  /* Don't hold back the step watermark for other threads */
+  if( mesh->threadstep )
+  {
+#if MD_CONFIG_ATOMIC_SUPPORT
+    mmAtomicWrite32( &mesh->threadstep[ tdata->threadid ].stepindex, MD_THREAD_STEP_DONE );
+#else
+    mtSpinLock( &mesh->stepspinlock );
+    mesh->threadstep[ tdata->threadid ].stepindex = MD_THREAD_STEP_DONE;
+    mtSpinUnlock( &mesh->stepspinlock );
+#endif
+  }
+
 #if DEBUG_VERBOSE_WORK >= 2
   printf( "Thread %d work, end decimation, %d collapses\n", tdata->threadid, decimationcount );
 #endif
@@ -5134,33 +7703,6 @@ static int mdMeshProcessQueue( mdMesh *mesh, mdThreadData *tdata )
 
 
 
-typedef struct
-{
-  mdf normal[3];
-  mdf factor[3];
-} mdTriNormal;
-
-
-static mdi mdMeshPackCountTriangles( mdMesh *mesh )
-{
-  mdi tricount;
-  mdTriangle *tri, *triend;
-
-  tricount = 0;
-  tri = mesh->trilist;
-  triend = ADDRESS( tri, mesh->tricount * mesh->trisize );
-  for( ; tri < triend ; tri = ADDRESS( tri, mesh->trisize ) )
-  {
-    if( tri->v[0] == -1 )
-      continue;
-    tri->u.redirectindex = tricount;
-    tricount++;
-  }
-
-  mesh->tripackcount = tricount;
-  return tricount;
-}
-
 static mdf mdMeshAngleFactor( mdf dotangle )
 {
   mdf factor;
@@ -5171,60 +7713,42 @@ static mdf mdMeshAngleFactor( mdf dotangle )
   else
   {
     factor = mdfacos( dotangle );
-    if( isnan( factor ) )
-      factor = 0.0;
-  }
-  return factor;
-}
-
-static void mdMeshBuildTriangleNormals( mdMesh *mesh )
-{
-  mdTriangle *tri, *triend;
-  mdVertex *vertex0, *vertex1, *vertex2;
-  mdf vecta[3], vectb[3], vectc[3], normalfactor, magna, magnb, magnc, norm, norminv;
-  mdTriNormal *trinormal;
-
-  trinormal = mesh->trinormal;
-
-  normalfactor = 1.0;
-  if( mesh->operationflags & MD_FLAGS_TRIANGLE_WINDING_CCW )
-    normalfactor = -1.0;
-
-  tri = mesh->trilist;
-  triend = ADDRESS( tri, mesh->tricount * mesh->trisize );
-  for( ; tri < triend ; tri = ADDRESS( tri, mesh->trisize ) )
-  {
-    if( tri->v[0] == -1 )
-      continue;
-
-    /* Compute triangle normal */
-    vertex0 = &mesh->vertexlist[ tri->v[0] ];
-    vertex1 = &mesh->vertexlist[ tri->v[1] ];
-    vertex2 = &mesh->vertexlist[ tri->v[2] ];
-    MD_VectorSubStore( vecta, vertex1->point, vertex0->point );
-    MD_VectorSubStore( vectb, vertex2->point, vertex0->point );
-    MD_VectorCrossProduct( trinormal->normal, vectb, vecta );
+    if( isnan( factor ) )
+      factor = 0.0;
+  }
+  return factor;
+}
 
-    norm = mdfsqrt( MD_VectorDotProduct( trinormal->normal, trinormal->normal ) );
-    if( norm )
-    {
-      norminv = normalfactor / norm;
-      trinormal->normal[0] *= norminv;
-      trinormal->normal[1] *= norminv;
-      trinormal->normal[2] *= norminv;
-    }
+static void mdMeshBuildTriangleNormal( mdMesh *mesh, mdTriangle *tri, mdTriNormal *trinormal, mdf normalfactor )
+{
+  mdVertex *vertex0, *vertex1, *vertex2;
+  mdf vecta[3], vectb[3], vectc[3], magna, magnb, magnc, norm, norminv;
 
-    MD_VectorSubStore( vectc, vertex2->point, vertex1->point );
-    magna = MD_VectorMagnitude( vecta );
-    magnb = MD_VectorMagnitude( vectb );
-    magnc = MD_VectorMagnitude( vectc );
-    trinormal->factor[0] = norm * mdMeshAngleFactor(  MD_VectorDotProduct( vecta, vectb ) / ( magna * magnb ) );
-    trinormal->factor[1] = norm * mdMeshAngleFactor( -MD_VectorDotProduct( vecta, vectc ) / ( magna * magnc ) );
-    trinormal->factor[2] = norm * mdMeshAngleFactor(  MD_VectorDotProduct( vectb, vectc ) / ( magnb * magnc ) );
+  /* Compute triangle normal */
+  vertex0 = &mesh->vertexlist[ tri->v[0] ];
+  vertex1 = &mesh->vertexlist[ tri->v[1] ];
+  vertex2 = &mesh->vertexlist[ tri->v[2] ];
+  MD_VectorSubStore( vecta, vertex1->point, vertex0->point );
+  MD_VectorSubStore( vectb, vertex2->point, vertex0->point );
+  MD_VectorCrossProduct( trinormal->normal, vectb, vecta );
 
-    trinormal++;
+  norm = mdfsqrt( MD_VectorDotProduct( trinormal->normal, trinormal->normal ) );
+  if( norm )
+  {
+    norminv = normalfactor / norm;
+    trinormal->normal[0] *= norminv;
+    trinormal->normal[1] *= norminv;
+    trinormal->normal[2] *= norminv;
   }
 
+  MD_VectorSubStore( vectc, vertex2->point, vertex1->point );
+  magna = MD_VectorMagnitude( vecta );
+  magnb = MD_VectorMagnitude( vectb );
+  magnc = MD_VectorMagnitude( vectc );
+  trinormal->factor[0] = norm * mdMeshAngleFactor(  MD_VectorDotProduct( vecta, vectb ) / ( magna * magnb ) );
+  trinormal->factor[1] = norm * mdMeshAngleFactor( -MD_VectorDotProduct( vecta, vectc ) / ( magna * magnc ) );
+  trinormal->factor[2] = norm * mdMeshAngleFactor(  MD_VectorDotProduct( vectb, vectc ) / ( magnb * magnc ) );
+
   return;
 }
 
@@ -5284,31 +7808,44 @@ static int mdMeshVertexComputeNormal( mdMesh *mesh, mdi vertexindex, mdi *triref
 }
 
 
-static mdi mdMeshCloneVertex( mdMesh *mesh, mdi cloneindex, mdf *point )
+/* Reuse an unused vertex of the thread's range, or append one to its reserved range past the vertex count */
+static mdi mdMeshCloneVertex( mdMesh *mesh, mdCloneRange *clonerange, mdi cloneindex, mdf *point )
 {
-  mdi vertexindex, retindex;
+  mdi vertexindex;
   mdVertex *vertex;
 
-  retindex = -1;
-  vertex = &mesh->vertexlist[ mesh->clonesearchindex ];
-  for( vertexindex = mesh->clonesearchindex ; vertexindex < mesh->vertexalloc ; vertexindex++, vertex++ )
+  vertex = &mesh->vertexlist[ clonerange->searchindex ];
+  for( vertexindex = clonerange->searchindex ; vertexindex < clonerange->searchmax ; vertexindex++, vertex++ )
   {
-    if( ( vertexindex < mesh->vertexcount ) && ( vertex->trirefcount ) )
-      continue;
-    vertex->trirefcount = -1;
-    vertex->redirectindex = -1;
-    /* Copy the point from the cloned vertex */
-    MD_VectorCopy( vertex->point, point );
-    /* Copy custom vertex attributes, if any */
-    if( mesh->vertexcopy )
-      mesh->vertexcopy( mesh->copycontext, vertexindex, cloneindex );
-    retindex = vertexindex;
-    if( vertexindex >= mesh->vertexcount )
-      mesh->vertexcount = vertexindex+1;
-    break;
+    if( !( vertex->trirefcount ) )
+      break;
+  }
+  clonerange->searchindex = vertexindex;
+  if( vertexindex == clonerange->searchmax )
+  {
+    if( clonerange->appendindex >= clonerange->appendmax )
+      return -1;
+    vertexindex = clonerange->appendindex++;
+    vertex = &mesh->vertexlist[ vertexindex ];
+  }
+
+  vertex->trirefcount = -1;
+  vertex->redirectindex = -1;
+  /* Copy the point from the cloned vertex */
+  MD_VectorCopy( vertex->point, point );
+  /* Copy custom vertex attributes, if any, the user's slot of an unused vertex we reuse is free as well */
+  if( mesh->vertexcopy )
+  {
+    if( mesh->operationflags & MD_FLAGS_CONCURRENT_VERTEXCOPY )
+      mesh->vertexcopy( mesh->copycontext, mdMeshVertexUserIndex( mesh, vertexindex ), mdMeshVertexUserIndex( mesh, cloneindex ) );
+    else
+    {
+      mtMutexLock( &mesh->copymutex );
+      mesh->vertexcopy( mesh->copycontext, mdMeshVertexUserIndex( mesh, vertexindex ), mdMeshVertexUserIndex( mesh, cloneindex ) );
+      mtMutexUnlock( &mesh->copymutex );
+    }
   }
-  mesh->clonesearchindex = vertexindex;
-  return retindex;
+  return vertexindex;
 }
 
 
@@ -5389,7 +7926,7 @@ static int mdMeshVertexFindTarget( mdMesh *mesh, mdi *trireflist, int trirefcoun
 
 #define MD_MESH_TRIREF_MAX (256)
 
-static int mdMeshVertexBuildNormal( mdMesh *mesh, mdi vertexindex, mdi *trireflist, int trirefcount, mdf *point, mdf *normal )
+static int mdMeshVertexBuildNormal( mdMesh *mesh, mdCloneRange *clonerange, mdi vertexindex, mdi *trireflist, int trirefcount, mdf *point, mdf *normal )
 {
   int index, trirefbuffercount;
   mdi triindex, newvertexindex;
@@ -5442,7 +7979,7 @@ static int mdMeshVertexBuildNormal( mdMesh *mesh, mdi vertexindex, mdi *trirefli
       break;
 
     /* Find an unused vertex, bail out if none can be found */
-    newvertexindex = mdMeshCloneVertex( mesh, vertexindex, point );
+    newvertexindex = mdMeshCloneVertex( mesh, clonerange, vertexindex, point );
     if( newvertexindex == -1 )
       break;
 
@@ -5451,109 +7988,327 @@ static int mdMeshVertexBuildNormal( mdMesh *mesh, mdi vertexindex, mdi *trirefli
 
     /* Spawn a new vertex */
     newnormal = ADDRESS( mesh->vertexnormal, newvertexindex * 3 * sizeof(mdf) );
-    mdMeshVertexBuildNormal( mesh, newvertexindex, trirefbuffer, trirefbuffercount, point, newnormal );
+    mdMeshVertexBuildNormal( mesh, clonerange, newvertexindex, trirefbuffer, trirefbuffercount, point, newnormal );
   }
 
   return 1;
 }
 
 
-/* In some rare circumstances, a vertex can be unused even with redirectindex == -1 and trirefs leading to deleted triangles */
-static int mdMeshVertexCheckUse( mdMesh *mesh, mdi *trireflist, int trirefcount )
+/* Normals step 1, number the remaining triangles of our range and compute their normals */
+static void mdMeshStoreTriangleNormals( mdMesh *mesh, mdThreadData *tdata, int threadcount )
 {
-  int index;
-  mdi triindex;
+  int threadindex;
+  mdi triindex, triindexbase, triindexmax, triperthread, packcount;
+  mdf normalfactor;
   mdTriangle *tri;
-  for( index = 0 ; index < trirefcount ; index++ )
+  mdTriNormal *trinormal;
+
+  triperthread = ( mesh->tricount / threadcount ) + 1;
+  triindexbase = tdata->threadid * triperthread;
+  triindexmax = triindexbase + triperthread;
+  if( triindexmax > mesh->tricount )
+    triindexmax = mesh->tricount;
+
+  packcount = 0;
+  tri = ADDRESS( mesh->trilist, triindexbase * mesh->trisize );
+  for( triindex = triindexbase ; triindex < triindexmax ; triindex++, tri = ADDRESS( tri, mesh->trisize ) )
   {
-    triindex = trireflist[ index ];
-    if( triindex == -1 )
+    if( tri->v[0] != -1 )
+      packcount++;
+  }
+  mesh->packcount[ tdata->threadid ].tricount = packcount;
+  if( !( tdata->threadid ) )
+  {
+    mesh->trinormal = malloc( mesh->tricount * sizeof(mdTriNormal) );
+    mesh->vertexnormal = malloc( mesh->vertexalloc * 3 * sizeof(mdf) );
+  }
+  mdThreadBarrierSync( mesh, tdata );
+
+  normalfactor = 1.0;
+  if( mesh->operationflags & MD_FLAGS_TRIANGLE_WINDING_CCW )
+    normalfactor = -1.0;
+
+  packcount = 0;
+  for( threadindex = 0 ; threadindex < tdata->threadid ; threadindex++ )
+    packcount += mesh->packcount[threadindex].tricount;
+  trinormal = mesh->trinormal;
+  tri = ADDRESS( mesh->trilist, triindexbase * mesh->trisize );
+  for( triindex = triindexbase ; triindex < triindexmax ; triindex++, tri = ADDRESS( tri, mesh->trisize ) )
+  {
+    if( tri->v[0] == -1 )
       continue;
-    tri = ADDRESS( mesh->trilist, triindex * mesh->trisize );
+    tri->u.redirectindex = packcount;
+    mdMeshBuildTriangleNormal( mesh, tri, &trinormal[ packcount ], normalfactor );
+    packcount++;
+  }
+
+  return;
+}
+
+
+/* Packed index of a vertex clone appended in the reserved range of a thread, past the clones of all previous threads */
+static mdi mdMeshClonePackIndex( mdMesh *mesh, mdi vertexcount, mdi appendperthread, mdi cloneindex )
+{
+  int threadindex, clonethread;
+  mdi packindex;
+
+  clonethread = ( cloneindex - vertexcount ) / appendperthread;
+  packindex = cloneindex - ( clonethread * appendperthread );
+  for( threadindex = 0 ; threadindex < clonethread ; threadindex++ )
+    packindex += mesh->packcount[threadindex].clonecount;
+  return packindex;
+}
+
+
+/* Move the vertex clones appended by all threads to their packed index, in increasing order as packing only moves them down */
+static void mdMeshPackCloneVertices( mdMesh *mesh, int threadcount, mdi vertexcount, mdi appendperthread )
+{
+  int threadindex;
+  mdi cloneindex, cloneindexmax, packindex;
+
+  packindex = vertexcount;
+  for( threadindex = 0 ; threadindex < threadcount ; threadindex++ )
+  {
+    cloneindex = vertexcount + ( threadindex * appendperthread );
+    cloneindexmax = cloneindex + mesh->packcount[threadindex].clonecount;
+    if( cloneindex == packindex )
+    {
+      packindex = cloneindexmax;
+      continue;
+    }
+    for( ; cloneindex < cloneindexmax ; cloneindex++, packindex++ )
+    {
+      mesh->vertexlist[ packindex ] = mesh->vertexlist[ cloneindex ];
+      memcpy( ADDRESS( mesh->vertexnormal, packindex * 3 * sizeof(mdf) ), ADDRESS( mesh->vertexnormal, cloneindex * 3 * sizeof(mdf) ), 3 * sizeof(mdf) );
+      if( mesh->vertexcopy )
+        mesh->vertexcopy( mesh->copycontext, mdMeshVertexUserIndex( mesh, packindex ), mdMeshVertexUserIndex( mesh, cloneindex ) );
+    }
+  }
+
+  return;
+}
+
+
+/* Redirect the triangles of our range to the packed indices of vertex clones */
+static void mdMeshPackCloneIndices( mdMesh *mesh, mdThreadData *tdata, int threadcount, mdi vertexcount, mdi appendperthread )
+{
+  int index;
+  mdi triindex, triindexmax, triperthread;
+  mdTriangle *tri;
+
+  triperthread = ( mesh->tricount / threadcount ) + 1;
+  triindex = tdata->threadid * triperthread;
+  triindexmax = triindex + triperthread;
+  if( triindexmax > mesh->tricount )
+    triindexmax = mesh->tricount;
+
+  tri = ADDRESS( mesh->trilist, triindex * mesh->trisize );
+  for( ; triindex < triindexmax ; triindex++, tri = ADDRESS( tri, mesh->trisize ) )
+  {
     if( tri->v[0] == -1 )
       continue;
-    return 1;
+    for( index = 0 ; index < 3 ; index++ )
+    {
+      if( tri->v[index] >= vertexcount )
+        tri->v[index] = mdMeshClonePackIndex( mesh, vertexcount, appendperthread, tri->v[index] );
+    }
   }
-  return 0;
+
+  return;
 }
 
 
-static void mdMeshWriteVertices( mdMesh *mesh )
+/* Normals step 2, build the normals of the vertices of our range, return the vertex count including clones of all threads */
+/* Splitting a vertex rewrites its own indices in triangles shared with other ranges, other threads never look for these indices */
+/* Clones are appended to a range reserved for each thread, then packed right after the vertex count in the order of threads */
+static mdi mdMeshStoreVertexNormals( mdMesh *mesh, mdThreadData *tdata, int threadcount, mdi vertexcount )
 {
-  mdi vertexindex, writeindex;
-  mdf factor;
-  mdf *point;
-  mdi *trireflist;
+  int threadindex;
+  mdi vertexindex, vertexindexmax, vertexperthread, appendperthread, appendbase, clonecount;
+  mdf *normal;
   mdVertex *vertex;
+  mdCloneRange clonerange;
 
-  factor = 1.0 / mesh->normalizationfactor;
-  point = mesh->point;
-  writeindex = 0;
-  vertex = mesh->vertexlist;
-  trireflist = mesh->trireflist;
-  for( vertexindex = 0 ; vertexindex < mesh->vertexcount ; vertexindex++, vertex++ )
+  vertexperthread = ( vertexcount / threadcount ) + 1;
+  vertexindex = tdata->threadid * vertexperthread;
+  vertexindexmax = vertexindex + vertexperthread;
+  if( vertexindexmax > vertexcount )
+    vertexindexmax = vertexcount;
+
+  /* Clones reuse unused vertices of our range, then the range of vertexalloc reserved for the thread */
+  appendperthread = ( ( mesh->vertexalloc - vertexcount ) + threadcount - 1 ) / threadcount;
+  clonerange.searchindex = vertexindex;
+  clonerange.searchmax = vertexindexmax;
+  clonerange.appendindex = vertexcount + ( tdata->threadid * appendperthread );
+  clonerange.appendmax = clonerange.appendindex + appendperthread;
+  if( clonerange.appendmax > mesh->vertexalloc )
+    clonerange.appendmax = mesh->vertexalloc;
+  if( clonerange.appendindex > clonerange.appendmax )
+    clonerange.appendindex = clonerange.appendmax;
+  appendbase = clonerange.appendindex;
+
+  vertex = &mesh->vertexlist[vertexindex];
+  for( ; vertexindex < vertexindexmax ; vertexindex++, vertex++ )
+  {
+    if( !( vertex->trirefcount ) || ( vertex->trirefcount == -1 ) )
+      continue;
+    normal = ADDRESS( mesh->vertexnormal, vertexindex * 3 * sizeof(mdf) );
+    if( !( mdMeshVertexBuildNormal( mesh, &clonerange, vertexindex, vertex->trireflist, vertex->trirefcount, vertex->point, normal ) ) )
+      vertex->trirefcount = 0;
+  }
+  mesh->packcount[ tdata->threadid ].clonecount = clonerange.appendindex - appendbase;
+  mdThreadBarrierSync( mesh, tdata );
+
+  /* Pack the clones of all threads without gaps, the caller syncs all threads before the vertices are stored */
+  clonecount = 0;
+  for( threadindex = 0 ; threadindex < threadcount ; threadindex++ )
+    clonecount += mesh->packcount[threadindex].clonecount;
+  if( ( clonecount ) && ( threadcount > 1 ) )
+  {
+    if( !( tdata->threadid ) )
+      mdMeshPackCloneVertices( mesh, threadcount, vertexcount, appendperthread );
+    mdMeshPackCloneIndices( mesh, tdata, threadcount, vertexcount, appendperthread );
+  }
+
+  return vertexcount + clonecount;
+}
+
+
+/* Threaded store step 1, flag the vertices to keep in our range and count them, along with the triangles of our range */
+/* Vertex ranges are in user order, vertices of a reordered mesh are written back in the relative order of the user's vertices */
+static void mdMeshStoreCount( mdMesh *mesh, mdThreadData *tdata, int threadcount, mdi vertexcount )
+{
+  mdi vertexindex, vertexindexmax, vertexperthread, packcount;
+  mdi triindex, triindexmax, triperthread;
+  mdVertex *vertex;
+  mdTriangle *tri;
+
+  vertexperthread = ( vertexcount / threadcount ) + 1;
+  vertexindex = tdata->threadid * vertexperthread;
+  vertexindexmax = vertexindex + vertexperthread;
+  if( vertexindexmax > vertexcount )
+    vertexindexmax = vertexcount;
+
+  packcount = 0;
+  for( ; vertexindex < vertexindexmax ; vertexindex++ )
   {
+    vertex = &mesh->vertexlist[ mdMeshVertexIndex( mesh, vertexindex ) ];
     if( !( mesh->operationflags & MD_FLAGS_NO_VERTEX_PACKING ) )
     {
-      if( vertex->redirectindex != -1 )
-        continue;
-      if( !( vertex->trirefcount ) )
-        continue;
-      if( ( vertex->trirefcount != -1 ) && !( mdMeshVertexCheckUse( mesh, &trireflist[ vertex->trirefbase ], vertex->trirefcount ) ) )
+      /* Vertices not kept are no longer referenced by any triangle, their redirection isn't needed anymore */
+      if( ( vertex->redirectindex != -1 ) || !( vertex->trirefcount ) || ( ( vertex->trirefcount != -1 ) && !( mdMeshVertexCheckUse( mesh, vertex->trireflist, vertex->trirefcount ) ) ) )
+      {
+        vertex->redirectindex = -1;
         continue;
+      }
     }
+    vertex->redirectindex = MD_VERTEX_STORE_KEEP;
+    packcount++;
+  }
+  mesh->packcount[ tdata->threadid ].vertexcount = packcount;
+
+  triperthread = ( mesh->tricount / threadcount ) + 1;
+  triindex = tdata->threadid * triperthread;
+  triindexmax = triindex + triperthread;
+  if( triindexmax > mesh->tricount )
+    triindexmax = mesh->tricount;
+
+  packcount = 0;
+  tri = ADDRESS( mesh->trilist, triindex * mesh->trisize );
+  for( ; triindex < triindexmax ; triindex++, tri = ADDRESS( tri, mesh->trisize ) )
+  {
+    if( tri->v[0] != -1 )
+      packcount++;
+  }
+  mesh->packcount[ tdata->threadid ].tricount = packcount;
+
+  return;
+}
+
+
+/* Threaded store step 2, write the kept vertices of our range after those of all previous ranges */
+static void mdMeshStoreVertices( mdMesh *mesh, mdThreadData *tdata, int threadcount, mdi vertexcount )
+{
+  int threadindex;
+  mdi vertexindex, vertexindexmax, vertexperthread, writeindex, nativeindex;
+  mdf factor;
+  void *point;
+  mdVertex *vertex;
+
+  writeindex = 0;
+  for( threadindex = 0 ; threadindex < tdata->threadid ; threadindex++ )
+    writeindex += mesh->packcount[threadindex].vertexcount;
+
+  vertexperthread = ( vertexcount / threadcount ) + 1;
+  vertexindex = tdata->threadid * vertexperthread;
+  vertexindexmax = vertexindex + vertexperthread;
+  if( vertexindexmax > vertexcount )
+    vertexindexmax = vertexcount;
+
+  factor = 1.0 / mesh->normalizationfactor;
+  point = ADDRESS( mesh->point, writeindex * mesh->pointstride );
+  for( ; vertexindex < vertexindexmax ; vertexindex++ )
+  {
+    nativeindex = mdMeshVertexIndex( mesh, vertexindex );
+    vertex = &mesh->vertexlist[ nativeindex ];
+    if( vertex->redirectindex != MD_VERTEX_STORE_KEEP )
+      continue;
     vertex->redirectindex = writeindex;
     mesh->vertexNativeToUser( point, vertex->point, factor );
-    if( ( mesh->vertexcopy ) && ( writeindex != vertexindex  ) )
+    if( mesh->vertexnormal )
+      mesh->writenormal( ADDRESS( mesh->normalbase, writeindex * mesh->normalstride ), ADDRESS( mesh->vertexnormal, nativeindex * 3 * sizeof(mdf) ) );
+    if( ( mesh->vertexcopy ) && ( mesh->operationflags & MD_FLAGS_CONCURRENT_VERTEXCOPY ) && ( writeindex != vertexindex ) )
       mesh->vertexcopy( mesh->copycontext, writeindex, vertexindex );
     point = ADDRESS( point, mesh->pointstride );
     writeindex++;
   }
-  mesh->vertexpackcount = writeindex;
-  if( mesh->operationflags & MD_FLAGS_NO_VERTEX_PACKING )
-    mesh->vertexpackcount = mesh->vertexcount;
-#if DEBUG_VERBOSE_OUTPUT
-  printf( "Final vertex count: %d\n", (int)mesh->vertexpackcount );
-#endif
+
+  if( tdata->threadid == threadcount - 1 )
+  {
+    mesh->vertexpackcount = writeindex;
+    if( mesh->operationflags & MD_FLAGS_NO_VERTEX_PACKING )
+      mesh->vertexpackcount = vertexcount;
+  }
+
   return;
 }
 
 
-static void mdMeshWriteIndices( mdMesh *mesh )
+/* Threaded store step 3, write the remaining triangles of our range after those of all previous ranges */
+static void mdMeshStoreIndices( mdMesh *mesh, mdThreadData *tdata, int threadcount )
 {
-  mdi finaltricount, v[3];
-  mdTriangle *tri, *triend;
-  mdVertex *vertex0, *vertex1, *vertex2;
+  int threadindex;
+  mdi triindex, triindexmax, triperthread, writeindex, v[3];
+  mdTriangle *tri;
   void *indices, *tridata;
 
-  indices = mesh->indices;
-  finaltricount = 0;
-  tri = mesh->trilist;
-  triend = ADDRESS( tri, mesh->tricount * mesh->trisize );
-  tridata = mesh->tridata;
-#if DEBUG_VERBOSE_OUTPUT
-  printf( "Final triangle list\n" );
-#endif
-  for( ; tri < triend ; tri = ADDRESS( tri, mesh->trisize ) )
+  writeindex = 0;
+  for( threadindex = 0 ; threadindex < tdata->threadid ; threadindex++ )
+    writeindex += mesh->packcount[threadindex].tricount;
+
+  triperthread = ( mesh->tricount / threadcount ) + 1;
+  triindex = tdata->threadid * triperthread;
+  triindexmax = triindex + triperthread;
+  if( triindexmax > mesh->tricount )
+    triindexmax = mesh->tricount;
+
+  indices = ADDRESS( mesh->indices, writeindex * mesh->indicesstride );
+  tridata = ADDRESS( mesh->tridata, writeindex * mesh->tridatasize );
+  tri = ADDRESS( mesh->trilist, triindex * mesh->trisize );
+  for( ; triindex < triindexmax ; triindex++, tri = ADDRESS( tri, mesh->trisize ) )
   {
     if( tri->v[0] == -1 )
       continue;
-    vertex0 = &mesh->vertexlist[ tri->v[0] ];
-    v[0] = vertex0->redirectindex;
-    vertex1 = &mesh->vertexlist[ tri->v[1] ];
-    v[1] = vertex1->redirectindex;
-    vertex2 = &mesh->vertexlist[ tri->v[2] ];
-    v[2] = vertex2->redirectindex;
-#if DEBUG_VERBOSE_OUTPUT
-    printf( "  Tri %d ; %d,%d,%d -> %d,%d,%d\n", (int)finaltricount, (int)tri->v[0], (int)tri->v[1], (int)tri->v[2], (int)v[0], (int)v[1], (int)v[2] );
-#endif
+    v[0] = mesh->vertexlist[ tri->v[0] ].redirectindex;
+    v[1] = mesh->vertexlist[ tri->v[1] ].redirectindex;
+    v[2] = mesh->vertexlist[ tri->v[2] ].redirectindex;
 #if DEBUG_VERBOSE_OUTPUT || DEBUG_VERBOSE_CHECKS
     if( ( v[0] == v[1] ) || ( v[1] == v[2] ) ||( v[0] == v[2] ) )
-      printf( "    ERROR: Repeated indices in triangle %d ; %d,%d,%d\n", (int)finaltricount, (int)v[0], (int)v[1], (int)v[2] );
+      printf( "    ERROR: Repeated indices in triangle %d ; %d,%d,%d\n", (int)writeindex, (int)v[0], (int)v[1], (int)v[2] );
     if( ( v[0] >= mesh->vertexpackcount ) || ( v[1] >= mesh->vertexpackcount ) ||( v[2] >= mesh->vertexpackcount ) )
-      printf( "    ERROR: Out of range vertex in triangle %d ; %d,%d,%d >= %d\n", (int)finaltricount, (int)v[0], (int)v[1], (int)v[2], (int)mesh->vertexpackcount );
+      printf( "    ERROR: Out of range vertex in triangle %d ; %d,%d,%d >= %d\n", (int)writeindex, (int)v[0], (int)v[1], (int)v[2], (int)mesh->vertexpackcount );
 #endif
-
     mesh->indicesNativeToUser( indices, v );
     if( mesh->tridatasize )
     {
@@ -5561,86 +8316,65 @@ static void mdMeshWriteIndices( mdMesh *mesh )
       tridata = ADDRESS( tridata, mesh->tridatasize );
     }
     indices = ADDRESS( indices, mesh->indicesstride );
-    finaltricount++;
+    writeindex++;
   }
-#if DEBUG_VERBOSE_OUTPUT
-  printf( "Final triangle count: %d\n", (int)finaltricount );
-#endif
 
-  mesh->tripackcount = finaltricount;
+  if( tdata->threadid == threadcount - 1 )
+    mesh->tripackcount = writeindex;
+
   return;
 }
 
 
-/* Write vertices and indices, recompute normals, store them along with vertices and indices at once */
-static void mdMeshWriteVerticesAndNormals( mdMesh *mesh )
+/* Copy vertex attributes in increasing vertex order, as the user callback may copy them in place */
+static void mdMeshStoreVertexCopy( mdMesh *mesh, mdi vertexcount )
 {
-  mdi vertexindex, writeindex;
-  mdf factor;
-  mdf *point, *normal;
+  mdi vertexindex;
   mdVertex *vertex;
-  mdi *trireflist;
-  void (*writenormal)( void *dst, mdf *src );
-  void *normaldst;
 
-  /* Start search for free vertices to clone at 0 */
-  mesh->clonesearchindex = 0;
-  mesh->trinormal = malloc( mesh->tripackcount * sizeof(mdTriNormal) );
-  mesh->vertexnormal = malloc( mesh->vertexalloc * 3 * sizeof(normal) );
+  for( vertexindex = 0 ; vertexindex < vertexcount ; vertexindex++ )
+  {
+    vertex = &mesh->vertexlist[ mdMeshVertexIndex( mesh, vertexindex ) ];
+    if( ( vertex->redirectindex != -1 ) && ( vertex->redirectindex != vertexindex ) )
+      mesh->vertexcopy( mesh->copycontext, vertex->redirectindex, vertexindex );
+  }
+
+  return;
+}
 
-  /* Count triangles and assign redirectindex to each in sequence */
-  mdMeshPackCountTriangles( mesh );
 
-  /* Build up mesh->trinormal, store normals, area and vertex angles of each triangle */
-  mdMeshBuildTriangleNormals( mesh );
+/* Write out the final mesh from all worker threads, with a prefix sum of packed vertices and triangles per thread range */
+static void mdMeshStore( mdMesh *mesh, mdThreadData *tdata, int threadcount )
+{
+  mdi vertexcount;
 
-  /* Build each vertex normal */
-  vertex = mesh->vertexlist;
-  trireflist = mesh->trireflist;
-  for( vertexindex = 0 ; vertexindex < mesh->vertexcount ; vertexindex++, vertex++ )
+  /* Recompute normals, vertex clones may be appended past the vertex count */
+  vertexcount = mesh->vertexcount;
+  if( mesh->normalbase )
   {
-    if( !( vertex->trirefcount ) || ( vertex->trirefcount == -1 ) )
-      continue;
-    normal = ADDRESS( mesh->vertexnormal, vertexindex * 3 * sizeof(mdf) );
-    if( !( mdMeshVertexBuildNormal( mesh, vertexindex, &trireflist[ vertex->trirefbase ], vertex->trirefcount, vertex->point, normal ) ) )
-      vertex->trirefcount = 0;
+    mdMeshStoreTriangleNormals( mesh, tdata, threadcount );
+    mdThreadBarrierSync( mesh, tdata );
+    vertexcount = mdMeshStoreVertexNormals( mesh, tdata, threadcount, vertexcount );
   }
+  mdThreadBarrierSync( mesh, tdata );
 
-  /* Write vertices along with normals and other attributes */
-  factor = 1.0 / mesh->normalizationfactor;
-  writenormal = mesh->writenormal;
-  point = mesh->point;
-  writeindex = 0;
-  vertex = mesh->vertexlist;
-  for( vertexindex = 0 ; vertexindex < mesh->vertexcount ; vertexindex++, vertex++ )
+  mdMeshStoreCount( mesh, tdata, threadcount, vertexcount );
+  mdThreadBarrierSync( mesh, tdata );
+  mdMeshStoreVertices( mesh, tdata, threadcount, vertexcount );
+  mdThreadBarrierSync( mesh, tdata );
+  mdMeshStoreIndices( mesh, tdata, threadcount );
+  if( !( tdata->threadid ) )
   {
-    if( !( mesh->operationflags & MD_FLAGS_NO_VERTEX_PACKING ) )
+    /* Unless the user allows concurrent calls, thread zero copies vertex attributes while other threads write indices */
+    if( ( mesh->vertexcopy ) && !( mesh->operationflags & MD_FLAGS_CONCURRENT_VERTEXCOPY ) )
+      mdMeshStoreVertexCopy( mesh, vertexcount );
+    if( mesh->vertexnormal )
     {
-      if( vertex->redirectindex != -1 )
-        continue;
-      if( !( vertex->trirefcount ) )
-        continue;
+      free( mesh->vertexnormal );
+      free( mesh->trinormal );
     }
-    vertex->redirectindex = writeindex;
-    mesh->vertexNativeToUser( point, vertex->point, factor );
-    normal = ADDRESS( mesh->vertexnormal, vertexindex * 3 * sizeof(mdf) );
-    normaldst = ADDRESS( mesh->normalbase, writeindex * mesh->normalstride );
-    writenormal( normaldst, normal );
-    if( ( mesh->vertexcopy ) && ( writeindex != vertexindex  ) )
-      mesh->vertexcopy( mesh->copycontext, writeindex, vertexindex );
-    point = ADDRESS( point, mesh->pointstride );
-    writeindex++;
+    mesh->vertexcount = vertexcount;
   }
-
-  mesh->vertexpackcount = writeindex;
-  if( mesh->operationflags & MD_FLAGS_NO_VERTEX_PACKING )
-    mesh->vertexpackcount = mesh->vertexcount;
-#if DEBUG_VERBOSE_OUTPUT
-  printf( "Final vertex count: %d\n", (int)mesh->vertexpackcount );
-#endif
-  free( mesh->vertexnormal );
-  free( mesh->trinormal );
-
   return;
 }
 
@@ -5657,41 +8391,104 @@ typedef struct
   long deletioncount;
   long collisioncount;
   long decimationcount;
+  long stealcount;
+  long idlemsecs;
+  long updatecount;
+  long denycount;
+  long edgecollisioncount;
+  mdThreadProfile profile;
+  mmHashStatistics edgehashstat;
   mdThreadData *tdata;
   int stage;
 } mdThreadInit;
 
-#ifndef MD_CONFIG_ATOMIC_SUPPORT
-int mdFreeOpCallback( void *chunk, void *userpointer )
+/* Called by the first thread only, as the stage progresses */
+static void mdMeshSetStage( mdMesh *mesh, mdThreadInit *tinit, int stage )
+{
+  tinit->stage = stage;
+  mesh->stageusecs[stage] = mmGetMicrosecondsTime();
+  return;
+}
+
+#ifndef MD_CONFIG_ATOMIC_SUPPORT
+static int mdFreeOpCallback( void *chunk, void *userpointer )
+{
+  mdOp *op;
+  op = chunk;
+  mtSpinDestroy( &op->spinlock );
+  return 0;
+}
+#endif
+
+
+static void mdThreadDataFreePools( mdThreadData *tdata )
+{
+  int index;
+  if( !( tdata->poolready ) )
+    return;
+  mmBlockFreeAll( &tdata->opblock );
+  for( index = 0 ; index < tdata->poolupdatebuffercount ; index++ )
+    mdUpdateBufferEnd( &tdata->updatebuffer[index] );
+  if( tdata->binsort )
+    mmBinSortFree( tdata->binsort );
+  tdata->binsort = 0;
+  tdata->poolupdatebuffercount = 0;
+  tdata->poolready = 0;
+  return;
+}
+
+static mdThreadData *mdContextThreadData( mdContext *context, int threadid )
 {
-  mdOp *op;
-  op = chunk;
-  mtSpinDestroy( &op->spinlock );
-  return 0;
+  mdThreadData *tdata;
+  tdata = context->threaddata[threadid];
+  if( !( tdata ) )
+  {
+    tdata = mmAlignAlloc( sizeof(mdThreadData), 0x40 );
+    memset( tdata, 0, sizeof(mdThreadData) );
+    context->threaddata[threadid] = tdata;
+  }
+  return tdata;
 }
-#endif
 
 
 static void *mdThreadMain( void *value )
 {
-  int index, tribase, trimax, triperthread, nodeindex;
+  int index, tribase, trimax, triperthread, nodeindex, binsortmode;
   int groupthreshold;
+  mdEdgeKey *trikeylist;
   mdThreadInit *tinit;
-  mdThreadData tdata;
+  mdThreadData *tdata, tdatalocal;
   mdMesh *mesh;
 
   tinit = value;
   mesh = tinit->mesh;
-  tinit->tdata = &tdata;
-
-  /* Thread memory initialization */
-  memset( &tdata, 0, sizeof(mdThreadData) );
-  tdata.threadid = tinit->threadid;
-  tdata.statusbuildtricount = 0;
-  tdata.statusbuildrefcount = 0;
-  tdata.statuspopulatecount = 0;
-  tdata.statusdeletioncount = 0;
-  tdata.statuscollisioncount = 0;
+
+  /* Thread memory initialization, keep the pools of the context's thread data */
+  if( mesh->context )
+    tdata = mdContextThreadData( mesh->context, tinit->threadid );
+  else
+  {
+    tdata = &tdatalocal;
+    memset( tdata, 0, sizeof(mdThreadData) );
+  }
+  tinit->tdata = tdata;
+  tdata->threadid = tinit->threadid;
+  tdata->stealqueue = 0;
+  tdata->collapselog = 0;
+  tdata->collapseclock = 0;
+  tdata->statusbuildtricount = 0;
+  tdata->statusbuildrefcount = 0;
+  tdata->statuspopulatecount = 0;
+  tdata->statusdeletioncount = 0;
+  tdata->statuscollisioncount = 0;
+  tdata->statusstealcount = 0;
+  tdata->statusidleusecs = 0;
+  tdata->statusupdatecount = 0;
+  tdata->statusdenycount = 0;
+  tdata->statusedgecollisioncount = 0;
+  tdata->profileflag = ( ( mesh->operationflags & MD_FLAGS_PROFILE_CONTENTION ) != 0 );
+  memset( &tdata->profile, 0, sizeof(mdThreadProfile) );
+  mmHashResetStatistics( &tdata->edgehashstat );
   groupthreshold = mesh->tricount >> 10;
   if( groupthreshold < 256 )
     groupthreshold = 256;
@@ -5701,97 +8498,203 @@ static void *mdThreadMain( void *value )
   nodeindex = -1;
   if( ( mmcore.numa.capable ) && !( mesh->operationflags & MD_FLAGS_DISABLE_NUMA ) )
   {
-    mmBindThreadToCpu( tdata.threadid );
-    nodeindex = mmGetNodeForCpu( tdata.threadid );
-    mmBlockNumaInit( &tdata.opblock, nodeindex, sizeof(mdOp), 16384, 16384, MD_CONF_OP_ALIGNMENT );
+    mmBindThreadToCpu( tdata->threadid );
+    nodeindex = mmGetNodeForCpu( tdata->threadid );
+  }
+
+  /* Pools kept from a previous decimation must come from the same NUMA node */
+  if( ( tdata->poolready ) && ( tdata->poolnodeindex != nodeindex ) )
+    mdThreadDataFreePools( tdata );
+  if( !( tdata->poolready ) )
+  {
+    if( nodeindex >= 0 )
+      mmBlockNumaInit( &tdata->opblock, nodeindex, sizeof(mdOp), 16384, 16384, MD_CONF_OP_ALIGNMENT );
+    else
+      mmBlockInit( &tdata->opblock, sizeof(mdOp), 16384, 16384, MD_CONF_OP_ALIGNMENT );
+    tdata->binsort = 0;
+    tdata->poolupdatebuffercount = 0;
+    tdata->poolnodeindex = nodeindex;
+    tdata->poolready = 1;
   }
-  else
-    mmBlockInit( &tdata.opblock, sizeof(mdOp), 16384, 16384, MD_CONF_OP_ALIGNMENT );
 
+  /* Reuse the binsort if it has the same bucket layout */
+  binsortmode = ( mesh->targetvertexcountmax != 0 );
+  if( ( tdata->binsort ) && ( tdata->poolbinsortmode != binsortmode ) )
+  {
+    mmBinSortFree( tdata->binsort );
+    tdata->binsort = 0;
+  }
   if( !mesh->targetvertexcountmax )
-    tdata.binsort = mmBinSortInit( offsetof(mdOp,list), 64, 32, -0.2 * mesh->maxcollapsecost, 1.2 * mesh->maxcollapsecost, groupthreshold, mdMeshOpValueCallback, 6, nodeindex );
+  {
+    if( tdata->binsort )
+      mmBinSortReset( tdata->binsort, -0.2 * mesh->maxcollapsecost, 1.2 * mesh->maxcollapsecost, groupthreshold );
+    else
+      tdata->binsort = mmBinSortInit( offsetof(mdOp,list), 64, 32, -0.2 * mesh->maxcollapsecost, 1.2 * mesh->maxcollapsecost, groupthreshold, mdMeshOpValueCallback, 6, nodeindex );
+  }
   else
   {
     int rootbucketcount;
     double maxcostrange;
     rootbucketcount = 4096;
     maxcostrange = 64.0 * mesh->maxcollapsecost;
-    tdata.binsort = mmBinSortInit( offsetof(mdOp,list), rootbucketcount, 16, -0.2 * mesh->maxcollapsecost, maxcostrange, groupthreshold, mdMeshOpValueCallback, 6, nodeindex );
+    if( tdata->binsort )
+      mmBinSortReset( tdata->binsort, -0.2 * mesh->maxcollapsecost, maxcostrange, groupthreshold );
+    else
+      tdata->binsort = mmBinSortInit( offsetof(mdOp,list), rootbucketcount, 16, -0.2 * mesh->maxcollapsecost, maxcostrange, groupthreshold, mdMeshOpValueCallback, 6, nodeindex );
+  }
+  tdata->poolbinsortmode = binsortmode;
+
+  for( index = 0 ; index < tdata->poolupdatebuffercount ; index++ )
+    tdata->updatebuffer[index].opcount = 0;
+  for( ; index < mesh->updatebuffercount ; index++ )
+    mdUpdateBufferInit( &tdata->updatebuffer[index], 4096 );
+  if( tdata->poolupdatebuffercount < mesh->updatebuffercount )
+    tdata->poolupdatebuffercount = mesh->updatebuffercount;
+
+  /* Expose our op queue to other threads for work stealing */
+  if( mesh->stealqueue )
+  {
+    tdata->stealqueue = &mesh->stealqueue[ tdata->threadid ];
+    tdata->stealqueue->binsort = tdata->binsort;
   }
 
-  for( index = 0 ; index < mesh->updatebuffercount ; index++ )
-    mdUpdateBufferInit( &tdata.updatebuffer[index], 4096 );
+  /* Our own log of edge collapses for the progressive mesh stream */
+  if( mesh->collapselog )
+    tdata->collapselog = &mesh->collapselog[ tdata->threadid ];
+
+  /* Our own arena for trirefs */
+  tdata->trirefarena = &mesh->trirefarena[ tdata->threadid ];
 
   /* Wait until all threads have properly initialized */
   if( mesh->updatestatusflag )
-    mdBarrierSync( &mesh->workbarrier );
+    mdThreadBarrierSync( mesh, tdata );
 
   /* Build mesh step 1 */
-  if( !( tdata.threadid ) )
-    tinit->stage = MD_STATUS_STAGE_BUILDVERTICES;
-  mdMeshInitVertices( mesh, &tdata, mesh->threadcount );
-  mdBarrierSync( &mesh->workbarrier );
+  if( !( tdata->threadid ) )
+    mdMeshSetStage( mesh, tinit, MD_STATUS_STAGE_BUILDVERTICES );
+  if( mesh->vertexmap )
+    mdMeshReorderVertices( mesh, tdata, mesh->threadcount );
+  mdMeshInitVertices( mesh, tdata, mesh->threadcount );
+  mdThreadBarrierSync( mesh, tdata );
 
   /* Build mesh step 2 */
-  if( !( tdata.threadid ) )
-    tinit->stage = MD_STATUS_STAGE_BUILDTRIANGLES;
-  mdMeshInitTriangles( mesh, &tdata, mesh->threadcount );
-  mdBarrierSync( &mesh->workbarrier );
+  if( !( tdata->threadid ) )
+    mdMeshSetStage( mesh, tinit, MD_STATUS_STAGE_BUILDTRIANGLES );
+  if( mesh->trimap )
+  {
+    mdMeshReorderTriangles( mesh, tdata, mesh->threadcount );
+    if( !( tdata->threadid ) && !( mesh->partitionflag ) )
+      mdMeshFreeMortonKeys( mesh );
+  }
+  mdMeshInitTriangles( mesh, tdata, mesh->threadcount );
+  mdThreadBarrierSync( mesh, tdata );
 
-  /* Build mesh step 3 is not parallel, have the thread zero run it */
-  if( !( tdata.threadid ) )
+  /* Build mesh step 3 */
+  if( !( tdata->threadid ) )
+    mdMeshSetStage( mesh, tinit, MD_STATUS_STAGE_BUILDTRIREFS );
+  if( mesh->edgekeylist )
   {
-    tinit->stage = MD_STATUS_STAGE_BUILDTRIREFS;
-    /* Build mesh step 3 is not parallel, have the thread zero run it */
-    mdMeshInitTrirefs( mesh );
+    mdMeshSortEdgeKeys( mesh, tdata, mesh->threadcount );
+    mdMeshMergeEdgeKeys( mesh, tdata, mesh->threadcount );
   }
-  mdBarrierSync( &mesh->workbarrier );
+  else
+    mdMeshInitTrirefs( mesh, tdata, mesh->threadcount );
+  mdThreadBarrierSync( mesh, tdata );
 
   /* Build mesh step 4 */
-  mdMeshBuildTrirefs( mesh, &tdata, mesh->threadcount );
-  mdBarrierSync( &mesh->workbarrier );
+  mdMeshBuildTrirefs( mesh, tdata, mesh->threadcount );
+  mdThreadBarrierSync( mesh, tdata );
+  if( !( tdata->threadid ) )
+    mdMeshFreeEdgeKeys( mesh );
+
+  /* Build mesh step 5, deterministic vertex quadrics */
+  if( ( mesh->operationflags & MD_FLAGS_DETERMINISTIC ) && !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) )
+  {
+    mdMeshAccumVertexQuadrics( mesh, tdata, mesh->threadcount );
+    mdThreadBarrierSync( mesh, tdata );
+  }
 
   if( !( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) )
   {
     /* Initialize the thread's op queue */
-    if( !( tdata.threadid ) )
-      tinit->stage = MD_STATUS_STAGE_BUILDQUEUE;
+    if( !( tdata->threadid ) )
+      mdMeshSetStage( mesh, tinit, MD_STATUS_STAGE_BUILDQUEUE );
+
+    trikeylist = 0;
+    if( mesh->partitionflag )
+      trikeylist = mdMeshMortonSort( mesh, tdata, mesh->threadcount, mesh->tricount, mdMortonPointTriangle );
 
     triperthread = ( mesh->tricount / mesh->threadcount ) + 1;
-    tribase = tdata.threadid * triperthread;
+    tribase = tdata->threadid * triperthread;
     trimax = tribase + triperthread;
     if( trimax > mesh->tricount )
       trimax = mesh->tricount;
+    if( mesh->operationflags & MD_FLAGS_DETERMINISTIC )
+    {
+      /* Thread zero owns a single op queue, filled and processed in a fixed order */
+      tribase = 0;
+      trimax = ( tdata->threadid ? 0 : mesh->tricount );
+    }
 
     /* Initialize a list of ops for all edges */
-    mdMeshPopulateOpList( mesh, &tdata, tribase, trimax - tribase );
+    mdMeshPopulateOpList( mesh, tdata, trikeylist, tribase, trimax - tribase );
 
     /* Wait for all threads to reach this point */
-    mdBarrierSync( &mesh->workbarrier );
+    mdThreadBarrierSync( mesh, tdata );
+    if( !( tdata->threadid ) )
+      mdMeshFreeMortonKeys( mesh );
 
     /* Process the thread's op queue */
-    if( !( tdata.threadid ) )
-      tinit->stage = MD_STATUS_STAGE_DECIMATION;
-    tinit->decimationcount = mdMeshProcessQueue( mesh, &tdata );
+    if( !( tdata->threadid ) )
+      mdMeshSetStage( mesh, tinit, MD_STATUS_STAGE_DECIMATION );
+    tinit->decimationcount = mdMeshProcessQueue( mesh, tdata );
+
+    /* Withdraw our op queue, other threads may still be stealing ops */
+    if( tdata->stealqueue )
+    {
+      mdStealQueueLock( tdata->stealqueue );
+      tdata->stealqueue->binsort = 0;
+      mdStealQueueUnlock( tdata->stealqueue );
+    }
   }
 
   /* We need to synchronize the work barrier first, in case we had a request for a global lock on it */
-  mdBarrierSync( &mesh->workbarrier );
+  mdThreadBarrierSync( mesh, tdata );
+
+  /* Write out the final mesh */
+  if( !( tdata->threadid ) )
+  {
+    mdMeshSetStage( mesh, tinit, MD_STATUS_STAGE_STORE );
+    /* Levels of detail not reached receive the final mesh */
+    mdMeshSnapshotLevels( mesh, FLT_MAX );
+    /* Merge the collapse logs of all threads into the progressive mesh stream */
+    if( mesh->collapsestream )
+      mdMeshWriteCollapseStream( mesh );
+  }
+  mdThreadBarrierSync( mesh, tdata );
+  mdMeshStore( mesh, tdata, mesh->threadcount );
 
   /* Wait for all threads to reach this point */
-  tinit->deletioncount = tdata.statusdeletioncount;
-  tinit->collisioncount = tdata.statuscollisioncount;
+  tinit->deletioncount = tdata->statusdeletioncount;
+  tinit->collisioncount = tdata->statuscollisioncount;
+  tinit->stealcount = tdata->statusstealcount;
+  tinit->idlemsecs = tdata->statusidleusecs / 1000;
+  tinit->updatecount = tdata->statusupdatecount;
+  tinit->denycount = tdata->statusdenycount;
+  tinit->edgecollisioncount = tdata->statusedgecollisioncount;
+  tinit->profile = tdata->profile;
+  tinit->edgehashstat = tdata->edgehashstat;
 
   /* If we didn't use atomic operations, we have spinlocks to destroy in each op */
 #ifndef MD_CONFIG_ATOMIC_SUPPORT
-  mmBlockProcessList( &tdata.opblock, 0, mdFreeOpCallback );
+  mmBlockProcessList( &tdata->opblock, 0, mdFreeOpCallback );
 #endif
 
-  /* Free thread memory allocations */
-  mmBlockFreeAll( &tdata.opblock );
-  for( index = 0 ; index < mesh->updatebuffercount ; index++ )
-    mdUpdateBufferEnd( &tdata.updatebuffer[index] );
-  mmBinSortFree( tdata.binsort );
+  /* Free thread memory allocations, or keep them for the next decimation using the context */
+  if( mesh->context )
+    mmBlockReleaseAll( &tdata->opblock );
+  else
+    mdThreadDataFreePools( tdata );
 
   /* Send finish signal */
   mtMutexLock( &mesh->finishmutex );
@@ -5891,6 +8794,7 @@ static void mdUpdateStatus( mdMesh *mesh, mdThreadInit *threadinit, mdStatus *st
 //////////
 
 
+#if !MD_CONF_FLOAT_VARIANT
 
 void mdOperationInit( mdOperation *op )
 {
@@ -5936,6 +8840,12 @@ void mdOperationStrength( mdOperation *op, double featuresize )
   return;
 }
 
+void mdOperationPrecision( mdOperation *op, int precision )
+{
+  op->precision = precision;
+  return;
+}
+
 void mdOperationBoundaryWeight( mdOperation *op, double boundaryweight )
 {
   op->boundaryweight = boundaryweight;
@@ -6013,6 +8923,28 @@ void mdOperationFreeLocks( mdOperation *op )
   return;
 }
 
+void mdOperationLevels( mdOperation *op, mdLevel *levellist, int levelcount )
+{
+  op->levellist = levellist;
+  op->levelcount = levelcount;
+  return;
+}
+
+void mdOperationCollapseStream( mdOperation *op, void (*collapsestream)( void *streamcontext, const void *data, size_t size ), void *streamcontext )
+{
+  op->collapsestream = collapsestream;
+  op->streamcontext = streamcontext;
+  return;
+}
+
+void mdOperationStatistics( mdOperation *op, mdStatistics *statistics )
+{
+  op->statistics = statistics;
+  return;
+}
+
+#endif
+
 
 
 //////
@@ -6020,6 +8952,8 @@ void mdOperationFreeLocks( mdOperation *op )
 
 struct mdState
 {
+  /* Must be first, identifies the variant owning the state */
+  int precision;
   mdOperation *operation;
   mdMesh mesh;
   mdThreadInit threadinit[MD_THREAD_COUNT_MAX];
@@ -6036,12 +8970,13 @@ static void mdMeshDecimationFree( mdState *state )
   mdBarrierDestroy( &mesh->workbarrier );
   mtMutexDestroy( &mesh->finishmutex );
   mtSignalDestroy( &mesh->finishsignal );
-  free( state );
+  if( !( mesh->context ) )
+    free( state );
   return;
 }
 
-/* Initialize state to decimate the mesh specified by the mdOperation struct */
-mdState *mdMeshDecimationInit( mdOperation *operation, int threadcount, int flags )
+/* Initialize state to decimate the mesh specified by the mdOperation struct, using the memory pools of the context if not null */
+static mdState *mdMeshDecimationSetup( mdContext *context, mdOperation *operation, int threadcount, int flags )
 {
   int threadindex;
   double featuresize, normalizationfactor;
@@ -6049,19 +8984,36 @@ mdState *mdMeshDecimationInit( mdOperation *operation, int threadcount, int flag
   mdMesh *mesh;
   mdThreadInit *tinit;
   mdStatus *status;
+#if CPU_DISPATCH_SUPPORT
+  uint32_t isaflags;
+#endif
 
+  /* Cleared once the setup succeeded */
+  operation->failureflag = 1;
   if( threadcount <= 0 )
     return 0;
   if( threadcount > MD_THREAD_COUNT_MAX )
     threadcount = MD_THREAD_COUNT_MAX;
 
-  state = malloc( sizeof(mdState) );
+  if( context )
+  {
+    if( !( context->state ) )
+      context->state = malloc( sizeof(mdState) );
+    state = context->state;
+  }
+  else
+    state = malloc( sizeof(mdState) );
   memset( state, 0, sizeof(mdState) );
+  state->precision = ( MD_CONF_DOUBLE_PRECISION ? MD_PRECISION_DOUBLE : MD_PRECISION_FLOAT );
   state->operation = operation;
   mesh = &state->mesh;
+  mesh->context = context;
   status = &state->status;
 
   operation->decimationcount = 0;
+  operation->stealcount = 0;
+  operation->idlemsecs = 0;
+  operation->globallockcount = 0;
   operation->msecs = 0;
 
   /* Get operation general settings */
@@ -6200,9 +9152,16 @@ mdState *mdMeshDecimationInit( mdOperation *operation, int threadcount, int flag
 
   /* Record start time */
   operation->msecs = mmGetMillisecondsTime();
+  mesh->stageusecs[MD_STATUS_STAGE_INIT] = mmGetMicrosecondsTime();
 
   mesh->threadcount = threadcount;
   mesh->operationflags = flags;
+  /* A deterministic decimation needs the sorted topology build, and no op may move between threads */
+  if( mesh->operationflags & MD_FLAGS_DETERMINISTIC )
+  {
+    mesh->operationflags |= MD_FLAGS_SORTED_TOPOLOGY;
+    mesh->operationflags &= ~( MD_FLAGS_WORK_STEALING | MD_FLAGS_ASYNC_STEPS | MD_FLAGS_SPATIAL_PARTITION );
+  }
 
   /* To compute vertex normals */
   mesh->normalbase = operation->normalbase;
@@ -6241,6 +9200,18 @@ mdState *mdMeshDecimationInit( mdOperation *operation, int threadcount, int flag
   /* Vertex lock map */
   mesh->lockmap = operation->lockmap;
 
+  /* Progressive mesh stream */
+  mesh->collapsestream = operation->collapsestream;
+  mesh->streamcontext = operation->streamcontext;
+
+  /* Levels of detail to snapshot */
+  mesh->levellist = operation->levellist;
+  mesh->levelcount = ( operation->levellist ? operation->levelcount : 0 );
+  mesh->levelindex = 0;
+  mdMeshSetPendingLevel( mesh );
+  if( mesh->levelcount )
+    mesh->operationflags &= ~MD_FLAGS_ASYNC_STEPS;
+
   /* Advanced configuration options */
   mesh->compactnesstarget = operation->compactnesstarget;
   mesh->compactnesspenalty = operation->compactnesspenalty;
@@ -6266,6 +9237,8 @@ mdState *mdMeshDecimationInit( mdOperation *operation, int threadcount, int flag
 
   /* Runtime picking of collapse penalty computation path */
   mesh->collapsepenalty = mdEdgeCollapsePenaltyTriangle;
+  mesh->collapsepenaltybatch = 0;
+  mesh->penaltybatchwidth = 1;
 #if CPU_SSE_SUPPORT && 1
  #if !MD_CONF_DOUBLE_PRECISION
   #if CPU_SSE4_1_SUPPORT
@@ -6285,6 +9258,34 @@ mdState *mdMeshDecimationInit( mdOperation *operation, int threadcount, int flag
   #endif
  #endif
 #endif
+#if CPU_DISPATCH_SUPPORT
+  /* Prefer the AVX2 and AVX-512 kernels when supported by the CPU and enabled by the OS */
+  isaflags = mmcore.cpuid.isaflags;
+  /* Deterministic output stays on the reference kernels, whatever CPU runs the build */
+  if( mesh->operationflags & MD_FLAGS_DETERMINISTIC )
+    isaflags = 0;
+ #if !MD_CONF_DOUBLE_PRECISION
+  if( isaflags & MM_CPUID_ISA_AVX2 )
+  {
+    mesh->collapsepenalty = mdEdgeCollapsePenaltyTriangleAVX2f;
+    mesh->collapsepenaltybatch = mdEdgeCollapsePenaltyBatchAVX2f;
+    mesh->penaltybatchwidth = 8;
+  }
+ #else
+  if( ( isaflags & ( MM_CPUID_ISA_AVX512F | MM_CPUID_ISA_AVX512VL ) ) == ( MM_CPUID_ISA_AVX512F | MM_CPUID_ISA_AVX512VL ) )
+  {
+    mesh->collapsepenalty = mdEdgeCollapsePenaltyTriangleAVX512d;
+    mesh->collapsepenaltybatch = mdEdgeCollapsePenaltyBatchAVX512d;
+    mesh->penaltybatchwidth = 8;
+  }
+  else if( isaflags & MM_CPUID_ISA_AVX2 )
+  {
+    mesh->collapsepenalty = mdEdgeCollapsePenaltyTriangleAVX2d;
+    mesh->collapsepenaltybatch = mdEdgeCollapsePenaltyBatchAVX2d;
+    mesh->penaltybatchwidth = 4;
+  }
+ #endif
+#endif
 
   /* Finish status tracking */
   mesh->finishcount = threadcount;
@@ -6323,19 +9324,37 @@ mdState *mdMeshDecimationInit( mdOperation *operation, int threadcount, int flag
     operation->statuscallback( operation->statuscontext, status );
   }
 
+  operation->failureflag = 0;
   return state;
 
   /* Free all global data */
   error:
-  free( state );
+  if( !( context ) )
+    free( state );
   return 0;
 }
 
+mdState *mdMeshDecimationInit( mdOperation *operation, int threadcount, int flags )
+{
+#if !MD_CONF_FLOAT_VARIANT
+  if( operation->precision == MD_PRECISION_FLOAT )
+    return mdfMeshDecimationInit( operation, threadcount, flags );
+#endif
+  return mdMeshDecimationSetup( 0, operation, threadcount, flags );
+}
+
 /* Perform the work for specified thread, must be called synchronously for all threadcount */
 void mdMeshDecimationThread( mdState *state, int threadindex )
 {
   mdMesh *mesh;
   mdThreadInit *tinit;
+#if !MD_CONF_FLOAT_VARIANT
+  if( state->precision == MD_PRECISION_FLOAT )
+  {
+    mdfMeshDecimationThread( state, threadindex );
+    return;
+  }
+#endif
   mesh = &state->mesh;
   if( threadindex < mesh->threadcount )
   {
@@ -6349,17 +9368,79 @@ void mdMeshDecimationThread( mdState *state, int threadindex )
   return;
 }
 
+/* Stage timings and counters summed over threads, the time of MD_STATUS_STAGE_DONE is only known once the state is freed */
+static void mdMeshStatistics( mdMesh *mesh, mdThreadInit *threadinit, mdStatistics *statistics )
+{
+  int stage, nextstage, threadid;
+  mdThreadInit *tinit;
+  mmHashStatistics edgehashstat;
+  mdHashStatistics *edgehash;
+
+  memset( statistics, 0, sizeof(mdStatistics) );
+  /* A stage lasts until the start of the next stage reached, stages skipped take no time */
+  for( stage = 0 ; stage < MD_STATUS_STAGE_DONE ; stage++ )
+  {
+    if( !( mesh->stageusecs[stage] ) )
+      continue;
+    for( nextstage = stage + 1 ; !( mesh->stageusecs[nextstage] ) ; nextstage++ );
+    statistics->stagemsecs[stage] = (double)( mesh->stageusecs[nextstage] - mesh->stageusecs[stage] ) / 1000.0;
+  }
+  statistics->threadcount = mesh->threadcount;
+  statistics->profileflag = ( ( mesh->operationflags & MD_FLAGS_PROFILE_CONTENTION ) != 0 );
+  tinit = threadinit;
+  for( threadid = 0 ; threadid < mesh->threadcount ; threadid++, tinit++ )
+  {
+    if( threadid < MD_STATISTICS_THREAD_MAX )
+    {
+      statistics->threadcollapsecount[threadid] = tinit->decimationcount;
+      statistics->threadprofile[threadid] = tinit->profile;
+    }
+    statistics->opupdatecount += tinit->updatecount;
+    statistics->denycount += tinit->denycount;
+    statistics->edgecollisioncount += tinit->edgecollisioncount;
+  }
+
+  /* Edge hash table layout, and accesses of all threads */
+  if( ( mesh->operationflags & MD_FLAGS_NO_DECIMATION ) || !( mesh->edgehashtable ) )
+    return;
+  mmHashResetStatistics( &edgehashstat );
+  tinit = threadinit;
+  for( threadid = 0 ; threadid < mesh->threadcount ; threadid++, tinit++ )
+    mmHashAddStatistics( &edgehashstat, &tinit->edgehashstat );
+  edgehash = &statistics->edgehash;
+  mmHashGetStatus( mesh->edgehashtable, &edgehash->hashsize );
+  mmHashGetPages( mesh->edgehashtable, &edgehash->lockpagesize, &edgehash->lockpagecount );
+  edgehash->accesscount = edgehashstat.accesscount;
+  edgehash->probecount = edgehashstat.probecount;
+  edgehash->probemax = edgehashstat.probemax;
+  edgehash->deletecount = edgehashstat.deletecount;
+  edgehash->delrewindcount = edgehashstat.delrewindcount;
+  edgehash->relocationcount = edgehashstat.relocationcount;
+  edgehash->pagelockfailcount = edgehashstat.pagelockfailcount;
+  edgehash->globallockcount = edgehashstat.globallockcount;
+  return;
+}
+
 /* Wait until the work has completed */
 void mdMeshDecimationEnd( mdState *state )
 {
   int threadid, threadcount;
   long statuswait;
+  uint64_t doneusecs;
   mdOperation *operation;
+  mdStatistics *statistics;
   mdMesh *mesh;
   mdThreadInit *threadinit;
   mdStatus *status;
   mdThreadInit *tinit;
 
+#if !MD_CONF_FLOAT_VARIANT
+  if( state->precision == MD_PRECISION_FLOAT )
+  {
+    mdfMeshDecimationEnd( state );
+    return;
+  }
+#endif
   operation = state->operation;
   mesh = &state->mesh;
   threadinit = state->threadinit;
@@ -6395,29 +9476,31 @@ void mdMeshDecimationEnd( mdState *state )
   mtMutexUnlock( &mesh->finishmutex );
 #endif
 
+  doneusecs = mmGetMicrosecondsTime();
+  mesh->stageusecs[MD_STATUS_STAGE_DONE] = doneusecs;
+  statistics = operation->statistics;
+  if( statistics )
+    mdMeshStatistics( mesh, threadinit, statistics );
+
   /* Count sums of all threads */
+  operation->failureflag = mesh->allocfailflag;
   operation->decimationcount = 0;
   operation->collisioncount = 0;
+  operation->stealcount = 0;
+  operation->idlemsecs = 0;
   tinit = threadinit;
   for( threadid = 0 ; threadid < threadcount ; threadid++, tinit++ )
   {
     operation->decimationcount += tinit->decimationcount;
     operation->collisioncount += tinit->collisioncount;
+    operation->stealcount += tinit->stealcount;
+    operation->idlemsecs += tinit->idlemsecs;
+#if DEBUG_VERBOSE_WORK
+    printf( "Thread %d : %ld collapses, %ld stolen, %ld msecs idle\n", threadid, tinit->decimationcount, tinit->stealcount, tinit->idlemsecs );
+#endif
   }
+  operation->globallockcount = mesh->workbarrier.globallockcount;
 
-  if( mesh->updatestatusflag )
-  {
-    threadinit->stage = MD_STATUS_STAGE_STORE;
-    mdUpdateStatus( mesh, threadinit, status );
-    operation->statuscallback( operation->statuscontext, status );
-  }
-
-  /* Write out the final mesh */
-  if( ( mesh->normalbase ) && ( mesh->writenormal ) )
-    mdMeshWriteVerticesAndNormals( mesh );
-  else
-    mdMeshWriteVertices( mesh );
-  mdMeshWriteIndices( mesh );
   operation->vertexcount = mesh->vertexpackcount;
   operation->tricount = mesh->tripackcount;
 
@@ -6428,14 +9511,11 @@ void mdMeshDecimationEnd( mdState *state )
     operation->statuscallback( operation->statuscontext, status );
   }
 
-  /* Requires mmhash.c compiled with MM_HASH_DEBUG_STATISTICS */
-#if MM_HASH_DEBUG_STATISTICS
-  mmHashPrintStatistics( mesh->edgehashtable );
-#endif
-
   mdMeshDecimationFree( state );
   /* Store total processing time */
   operation->msecs = mmGetMillisecondsTime() - operation->msecs;
+  if( statistics )
+    statistics->stagemsecs[MD_STATUS_STAGE_DONE] = (double)( mmGetMicrosecondsTime() - doneusecs ) / 1000.0;
 
   return;
 }
@@ -6458,7 +9538,7 @@ static void *mdMeshDecimationThreadMain( void *value )
   return 0;
 }
 
-int mdMeshDecimation( mdOperation *operation, int threadcount, int flags )
+static int mdMeshDecimationLaunch( mdContext *context, mdOperation *operation, int threadcount, int flags )
 {
   int threadindex, maxthreadcount;
   mdState *state;
@@ -6479,7 +9559,7 @@ int mdMeshDecimation( mdOperation *operation, int threadcount, int flags )
   if( threadcount > maxthreadcount )
     threadcount = maxthreadcount;
 
-  state = mdMeshDecimationInit( operation, threadcount, flags );
+  state = mdMeshDecimationSetup( context, operation, threadcount, flags );
   if( !state )
     return 0;
   for( threadindex = 0 ; threadindex < threadcount ; threadindex++ )
@@ -6492,7 +9572,326 @@ int mdMeshDecimation( mdOperation *operation, int threadcount, int flags )
   for( threadindex = 0 ; threadindex < threadcount ; threadindex++ )
     mtThreadJoin( &thread[threadindex] );
 
-  return 1;
+  return !( operation->failureflag );
+}
+
+int mdMeshDecimation( mdOperation *operation, int threadcount, int flags )
+{
+#if !MD_CONF_FLOAT_VARIANT
+  if( operation->precision == MD_PRECISION_FLOAT )
+    return mdfMeshDecimation( operation, threadcount, flags );
+#endif
+  return mdMeshDecimationLaunch( 0, operation, threadcount, flags );
+}
+
+size_t mdMeshDecimationMemoryUsage( mdOperation *operation, int flags )
+{
+  int buffers;
+  size_t vertexalloc, trisize, hashsize;
+#if !MD_CONF_FLOAT_VARIANT
+  if( operation->precision == MD_PRECISION_FLOAT )
+    return mdfMeshDecimationMemoryUsage( operation, flags );
+#endif
+  vertexalloc = operation->vertexalloc;
+  if( vertexalloc < operation->vertexcount )
+    vertexalloc = operation->vertexcount;
+  trisize = ( sizeof(mdTriangle) + operation->tridatasize + 0x7 ) & ~0x7;
+  hashsize = 0;
+  if( !( flags & MD_FLAGS_NO_DECIMATION ) )
+    hashsize = mdMeshHashSizeMin( operation->tricount );
+  /* Same flags as mdMeshDecimationSetup(), the thread count isn't known yet, count the buffers of a multithreaded decimation */
+  if( flags & MD_FLAGS_DETERMINISTIC )
+  {
+    flags |= MD_FLAGS_SORTED_TOPOLOGY;
+    flags &= ~( MD_FLAGS_WORK_STEALING | MD_FLAGS_ASYNC_STEPS | MD_FLAGS_SPATIAL_PARTITION );
+  }
+  buffers = mdMeshMemoryBuffers( flags, MD_THREAD_COUNT_MAX, ( operation->normalbase != 0 ), ( operation->collapsestream != 0 ), ( ( operation->levellist ) && ( operation->levelcount ) ) );
+  return mdMeshEstimateMemory( vertexalloc, operation->tricount, trisize, hashsize, 7, buffers );
+}
+
+
+////
+
+
+mdContext *mdContextCreate( void )
+{
+  mdContext *context;
+  context = malloc( sizeof(mdContext) );
+  memset( context, 0, sizeof(mdContext) );
+  return context;
+}
+
+#if !MD_CONF_FLOAT_VARIANT
+/* Memory pools for single precision operations are kept in a separate context of the float variant */
+static mdContext *mdContextFloat( mdContext *context )
+{
+  if( !( context ) )
+    return 0;
+  if( !( context->floatcontext ) )
+    context->floatcontext = mdfContextCreate();
+  return context->floatcontext;
+}
+#endif
+
+/* Release all memory pools, the context remains usable */
+void mdContextTrim( mdContext *context )
+{
+  int threadindex;
+  mdThreadData *tdata;
+#if !MD_CONF_FLOAT_VARIANT
+  if( context->floatcontext )
+    mdfContextTrim( context->floatcontext );
+#endif
+  if( context->vertexlist )
+    mmAlignFree( context->vertexlist );
+  context->vertexlist = 0;
+  context->vertexalloc = 0;
+#if MD_CONF_SPLIT_VERTEX_QUADRICS
+  if( context->quadriclist )
+    mmAlignFree( context->quadriclist );
+  context->quadriclist = 0;
+#endif
+  free( context->trireflist );
+  context->trireflist = 0;
+  context->trireflistalloc = 0;
+  free( context->trilist );
+  context->trilist = 0;
+  context->trilistsize = 0;
+  free( context->edgehashtable );
+  context->edgehashtable = 0;
+  context->edgehashsize = 0;
+  for( threadindex = 0 ; threadindex < MD_THREAD_COUNT_MAX ; threadindex++ )
+  {
+    tdata = context->threaddata[threadindex];
+    if( !( tdata ) )
+      continue;
+    mdThreadDataFreePools( tdata );
+    mmAlignFree( tdata );
+    context->threaddata[threadindex] = 0;
+  }
+  free( context->state );
+  context->state = 0;
+  return;
+}
+
+void mdContextDestroy( mdContext *context )
+{
+  mdContextTrim( context );
+#if !MD_CONF_FLOAT_VARIANT
+  if( context->floatcontext )
+    mdfContextDestroy( context->floatcontext );
+#endif
+  free( context );
+  return;
+}
+
+int mdMeshDecimationRun( mdContext *context, mdOperation *operation, int threadcount, int flags )
+{
+#if !MD_CONF_FLOAT_VARIANT
+  if( operation->precision == MD_PRECISION_FLOAT )
+    return mdfMeshDecimationRun( mdContextFloat( context ), operation, threadcount, flags );
+#endif
+  return mdMeshDecimationLaunch( context, operation, threadcount, flags );
+}
+
+/* Decimate a mesh with a single thread, the calling one, for the batch workers */
+/* Not part of the public API : static in the double variant, exported as mdfMeshDecimationInline() by the float variant for the dispatch */
+#if !MD_CONF_FLOAT_VARIANT
+static
+#endif
+int mdMeshDecimationInline( mdContext *context, mdOperation *operation, int flags )
+{
+  mdState *state;
+#if !MD_CONF_FLOAT_VARIANT
+  if( operation->precision == MD_PRECISION_FLOAT )
+    return mdfMeshDecimationInline( mdContextFloat( context ), operation, flags );
+#endif
+  state = mdMeshDecimationSetup( context, operation, 1, flags );
+  if( !state )
+    return 0;
+  mdMeshDecimationThread( state, 0 );
+  mdMeshDecimationEnd( state );
+  return !( operation->failureflag );
+}
+
+
+
+////
+
+
+
+#if !MD_CONF_FLOAT_VARIANT
+
+/* Meshes with at least that many triangles per thread of the pool are decimated by all threads together */
+#define MD_BATCH_PARALLEL_TRIPERTHREAD (16384)
+
+typedef struct
+{
+  size_t tricount;
+  int opindex;
+} mdBatchJob;
+
+typedef struct
+{
+  mdOperation *operationlist;
+  mdBatchJob *joblist;
+  int jobcount;
+  int flags;
+#if MD_CONFIG_ATOMIC_SUPPORT
+  mmAtomic32 jobindex;
+  mmAtomicL failcount;
+#else
+  int jobindex;
+  long failcount;
+  mtSpin spinlock;
+#endif
+} mdBatch;
+
+typedef struct
+{
+  mdBatch *batch;
+  mdContext *context;
+} mdBatchWorker;
+
+static int mdBatchCompareJob( const void *p0, const void *p1 )
+{
+  const mdBatchJob *job0, *job1;
+  job0 = p0;
+  job1 = p1;
+  if( job0->tricount != job1->tricount )
+    return ( job0->tricount > job1->tricount ? -1 : 1 );
+  return ( job0->opindex < job1->opindex ? -1 : 1 );
+}
+
+static void *mdBatchWorkerMain( void *value )
+{
+  int jobindex;
+  mdBatchWorker *worker;
+  mdBatch *batch;
+
+  worker = value;
+  batch = worker->batch;
+  for( ; ; )
+  {
+#if MD_CONFIG_ATOMIC_SUPPORT
+    jobindex = mmAtomicAddRead32( &batch->jobindex, 1 ) - 1;
+#else
+    mtSpinLock( &batch->spinlock );
+    jobindex = batch->jobindex++;
+    mtSpinUnlock( &batch->spinlock );
+#endif
+    if( jobindex >= batch->jobcount )
+      break;
+    /* Many workers share the cores, don't bind the threads of single-threaded decimations */
+    if( !( mdMeshDecimationInline( worker->context, &batch->operationlist[ batch->joblist[jobindex].opindex ], batch->flags | MD_FLAGS_DISABLE_NUMA ) ) )
+    {
+#if MD_CONFIG_ATOMIC_SUPPORT
+      mmAtomicAddL( &batch->failcount, 1 );
+#else
+      mtSpinLock( &batch->spinlock );
+      batch->failcount++;
+      mtSpinUnlock( &batch->spinlock );
+#endif
+    }
+  }
+
+  return 0;
 }
 
+int mdMeshDecimationBatch( mdOperation *operationlist, int operationcount, int threadcount, int flags, mdBatchReport *report )
+{
+  int index, jobcount, workerindex, workercount, failcount;
+  long msecs;
+  size_t tricount, paralleltricount;
+  mdBatchJob *joblist;
+  mdContext *context;
+  mdBatch batch;
+  mdBatchWorker worker[MD_THREAD_COUNT_MAX];
+  mtThread thread[MD_THREAD_COUNT_MAX];
+
+  if( threadcount <= 0 )
+  {
+    threadcount = mmcore.cpucount;
+    if( threadcount <= 0 )
+      threadcount = MD_THREAD_COUNT_DEFAULT;
+  }
+  if( threadcount > MD_THREAD_COUNT_MAX )
+    threadcount = MD_THREAD_COUNT_MAX;
+
+  msecs = mmGetMillisecondsTime();
+  failcount = 0;
+
+  /* Schedule the largest meshes first */
+  joblist = malloc( operationcount * sizeof(mdBatchJob) );
+  tricount = 0;
+  for( index = 0 ; index < operationcount ; index++ )
+  {
+    joblist[index].tricount = operationlist[index].tricount;
+    joblist[index].opindex = index;
+    tricount += operationlist[index].tricount;
+  }
+  qsort( joblist, operationcount, sizeof(mdBatchJob), mdBatchCompareJob );
+
+  /* Large meshes are decimated one at a time by all threads, the context is then handed to the first worker */
+  context = mdContextCreate();
+  paralleltricount = (size_t)threadcount * MD_BATCH_PARALLEL_TRIPERTHREAD;
+  for( index = 0 ; index < operationcount ; index++ )
+  {
+    if( ( threadcount == 1 ) || ( joblist[index].tricount < paralleltricount ) )
+      break;
+    if( !( mdMeshDecimationRun( context, &operationlist[ joblist[index].opindex ], threadcount, flags ) ) )
+      failcount++;
+  }
+  if( report )
+    report->parallelcount = index;
+
+  /* Small meshes are packed one per worker, each worker keeping its own memory pools */
+  jobcount = operationcount - index;
+  batch.operationlist = operationlist;
+  batch.joblist = &joblist[index];
+  batch.jobcount = jobcount;
+  batch.flags = flags;
+#if MD_CONFIG_ATOMIC_SUPPORT
+  mmAtomicWrite32( &batch.jobindex, 0 );
+  mmAtomicWriteL( &batch.failcount, 0 );
+#else
+  batch.jobindex = 0;
+  batch.failcount = 0;
+  mtSpinInit( &batch.spinlock );
+#endif
+  workercount = ( jobcount < threadcount ? jobcount : threadcount );
+  for( workerindex = 0 ; workerindex < workercount ; workerindex++ )
+  {
+    worker[workerindex].batch = &batch;
+    worker[workerindex].context = ( workerindex ? mdContextCreate() : context );
+    mtThreadCreate( &thread[workerindex], mdBatchWorkerMain, &worker[workerindex], MT_THREAD_FLAGS_JOINABLE );
+  }
+  for( workerindex = 0 ; workerindex < workercount ; workerindex++ )
+  {
+    mtThreadJoin( &thread[workerindex] );
+    if( workerindex )
+      mdContextDestroy( worker[workerindex].context );
+  }
+  mdContextDestroy( context );
+#if MD_CONFIG_ATOMIC_SUPPORT
+  failcount += mmAtomicReadL( &batch.failcount );
+#else
+  failcount += batch.failcount;
+  mtSpinDestroy( &batch.spinlock );
+#endif
+  free( joblist );
+
+  msecs = mmGetMillisecondsTime() - msecs;
+  if( report )
+  {
+    report->meshcount = operationcount - failcount;
+    report->failcount = failcount;
+    report->tricount = tricount;
+    report->msecs = msecs;
+    report->tripersec = (double)tricount / ( msecs > 0 ? 0.001 * (double)msecs : 0.001 );
+  }
+
+  return ( failcount == 0 );
+}
 
+#endif
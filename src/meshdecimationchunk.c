@@ -0,0 +1,921 @@
+/* *****************************************************************************
+ *
+ * Copyright (c) 2012-2023 Alexis Naveros.
+ * Portions developed under contract to the SURVICE Engineering Company.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * *****************************************************************************
+ */
+
+/*
+ * Chunked decimation of meshes too large to be decimated whole within the
+ * mdOperation.maxmemoryusage budget.
+ *
+ * Triangles are binned in cells by the Morton code of their centroid. Cells
+ * start as a coarse grid and are split in 8 until small enough, dense areas
+ * of the mesh get smaller cells. The cells are walked in Morton order and
+ * cut into spatial chunks of a triangle count that fits the budget. The
+ * index array is permuted in place so that each chunk is a contiguous range
+ * of triangles, then each chunk is copied to compact local arrays and
+ * decimated by mdMeshDecimation() with its boundary vertices locked. A seam
+ * pass repeats the process with the cuts shifted by half a chunk, to
+ * decimate the vertices that were locked along the first cuts.
+ *
+ * Besides the chunk being decimated, memory usage is limited to a few bytes
+ * per vertex ; the vertex and indices arrays of the operation are only
+ * walked through and can be memory mapped files, leaving the paging to disk
+ * to the operating system.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "cc.h"
+#include "mmcore.h"
+#include "mm.h"
+
+#include "meshdecimation.h"
+
+
+////
+
+
+/* Bits per axis of Morton codes, cells can be split down to a single code */
+#define MD_CHUNK_CODE_BITS (21)
+#define MD_CHUNK_CODE_AXIS (1<<MD_CHUNK_CODE_BITS)
+
+/* Bits per axis of the initial grid of cells */
+#define MD_CHUNK_CELL_INIT_BITS (3)
+#define MD_CHUNK_CELL_INIT_COUNT (1<<(3*MD_CHUNK_CELL_INIT_BITS))
+
+/* Split cells above a quarter of a chunk, for chunks to be filled to about three quarters or more */
+#define MD_CHUNK_CELL_SPLIT_SHIFT (2)
+
+/* Memory per cell : code, triangle count, code bits and chunk, plus the triangle ranges of as many chunks */
+#define MD_CHUNK_CELL_SIZE ( sizeof(uint64_t) + sizeof(size_t) + sizeof(uint8_t) + sizeof(uint32_t) + ( 2 * sizeof(size_t) ) )
+
+/* Cells take up to 1/64 of the budget, with room for at least this many */
+#define MD_CHUNK_CELL_BUDGET_SHIFT (6)
+#define MD_CHUNK_CELL_MIN (4096)
+
+/* Don't bother chunking below this count of triangles per chunk, the budget is just too small */
+#define MD_CHUNK_TRICOUNT_MIN (4096)
+
+/* Estimate of memory per triangle for the local copy of a chunk: indices, half a vertex with its global index and hash entry */
+#define MD_CHUNK_LOCAL_TRISIZE (48)
+
+
+typedef struct
+{
+  /* Operation data, modified in place */
+  void *vertex;
+  int vertexformat;
+  size_t vertexstride;
+  void *indices;
+  int indicesformat;
+  size_t indicesstride;
+  size_t vertexcount;
+  size_t tricount;
+
+  /* Bounding box of the mesh, scale to Morton code coordinates */
+  double boxmin[3];
+  double codescale[3];
+
+  /* Cells in Morton order, each cell holds the codes from its cellcode up to the next cell's */
+  uint64_t *cellcode;
+  /* Count of low code bits spanned by each cell, zero when it can't be split any further */
+  uint8_t *cellshift;
+  /* Histogram of triangles per cell */
+  size_t *cellcount;
+  /* Chunk of each cell */
+  uint32_t *cellchunk;
+  size_t celltotal;
+  size_t cellalloc;
+  /* Triangle ranges of chunks, chunkcount+1 entries, up to cellalloc+1 */
+  size_t *chunkbase;
+  size_t *chunknext;
+  size_t chunkcount;
+
+  /* Bitmap of vertices locked for the current pass, in the lockmap format */
+  uint32_t *boundarymap;
+  size_t boundarymapsize;
+  /* Bitmap of vertices locked by the first pass, the only ones left unlocked by the seam pass */
+  uint32_t *seammap;
+  /* Bitmap of vertices shared by triangles of different chunks */
+  uint32_t *crossmap;
+} mdChunkMesh;
+
+
+////
+
+
+static inline size_t mdChunkReadIndex( mdChunkMesh *cm, size_t triindex, int corner )
+{
+  void *src;
+  src = ADDRESS( cm->indices, triindex * cm->indicesstride );
+  switch( cm->indicesformat )
+  {
+    case MD_FORMAT_UBYTE:
+    case MD_FORMAT_UINT8:
+      return ((uint8_t *)src)[corner];
+    case MD_FORMAT_USHORT:
+    case MD_FORMAT_UINT16:
+      return ((uint16_t *)src)[corner];
+    case MD_FORMAT_UINT:
+      return ((unsigned int *)src)[corner];
+    case MD_FORMAT_UINT32:
+      return ((uint32_t *)src)[corner];
+    case MD_FORMAT_UINT64:
+      return (size_t)((uint64_t *)src)[corner];
+    default:
+      break;
+  }
+  return 0;
+}
+
+static inline void mdChunkWriteIndex( mdChunkMesh *cm, size_t triindex, int corner, size_t value )
+{
+  void *dst;
+  dst = ADDRESS( cm->indices, triindex * cm->indicesstride );
+  switch( cm->indicesformat )
+  {
+    case MD_FORMAT_UBYTE:
+    case MD_FORMAT_UINT8:
+      ((uint8_t *)dst)[corner] = (uint8_t)value;
+      break;
+    case MD_FORMAT_USHORT:
+    case MD_FORMAT_UINT16:
+      ((uint16_t *)dst)[corner] = (uint16_t)value;
+      break;
+    case MD_FORMAT_UINT:
+      ((unsigned int *)dst)[corner] = (unsigned int)value;
+      break;
+    case MD_FORMAT_UINT32:
+      ((uint32_t *)dst)[corner] = (uint32_t)value;
+      break;
+    case MD_FORMAT_UINT64:
+      ((uint64_t *)dst)[corner] = (uint64_t)value;
+      break;
+    default:
+      break;
+  }
+  return;
+}
+
+static inline void mdChunkReadVertex( mdChunkMesh *cm, size_t vertexindex, double *point )
+{
+  float *pointf;
+  double *pointd;
+  if( cm->vertexformat == MD_FORMAT_FLOAT )
+  {
+    pointf = ADDRESS( cm->vertex, vertexindex * cm->vertexstride );
+    point[0] = (double)pointf[0];
+    point[1] = (double)pointf[1];
+    point[2] = (double)pointf[2];
+  }
+  else
+  {
+    pointd = ADDRESS( cm->vertex, vertexindex * cm->vertexstride );
+    point[0] = pointd[0];
+    point[1] = pointd[1];
+    point[2] = pointd[2];
+  }
+  return;
+}
+
+static inline size_t mdChunkVertexSize( mdChunkMesh *cm )
+{
+  return ( cm->vertexformat == MD_FORMAT_FLOAT ? 3 * sizeof(float) : 3 * sizeof(double) );
+}
+
+static inline int mdChunkIsLocked( uint32_t *map, size_t vertexindex )
+{
+  return ( map[ vertexindex >> 5 ] & (((uint32_t)1)<<(vertexindex&(32-1))) ) != 0;
+}
+
+static inline void mdChunkLock( uint32_t *map, size_t vertexindex )
+{
+  map[ vertexindex >> 5 ] |= ((uint32_t)1) << ( vertexindex & (32-1) );
+  return;
+}
+
+
+////
+
+
+/* Spread the low MD_CHUNK_CODE_BITS bits of value two bits apart */
+static inline uint64_t mdChunkMortonSpread( uint64_t value )
+{
+  value &= MD_CHUNK_CODE_AXIS - 1;
+  value = ( value | ( value << 32 ) ) & 0x001f00000000ffffULL;
+  value = ( value | ( value << 16 ) ) & 0x001f0000ff0000ffULL;
+  value = ( value | ( value << 8 ) ) & 0x100f00f00f00f00fULL;
+  value = ( value | ( value << 4 ) ) & 0x10c30c30c30c30c3ULL;
+  value = ( value | ( value << 2 ) ) & 0x1249249249249249ULL;
+  return value;
+}
+
+static inline uint64_t mdChunkPointCode( mdChunkMesh *cm, double *point )
+{
+  int axis;
+  long coord;
+  uint64_t code;
+  code = 0;
+  for( axis = 0 ; axis < 3 ; axis++ )
+  {
+    coord = (long)( ( point[axis] - cm->boxmin[axis] ) * cm->codescale[axis] );
+    if( coord < 0 )
+      coord = 0;
+    else if( coord >= MD_CHUNK_CODE_AXIS )
+      coord = MD_CHUNK_CODE_AXIS - 1;
+    code |= mdChunkMortonSpread( (uint64_t)coord ) << axis;
+  }
+  return code;
+}
+
+static inline uint64_t mdChunkTriCode( mdChunkMesh *cm, size_t triindex )
+{
+  int corner;
+  double point[3], centroid[3];
+  centroid[0] = 0.0;
+  centroid[1] = 0.0;
+  centroid[2] = 0.0;
+  for( corner = 0 ; corner < 3 ; corner++ )
+  {
+    mdChunkReadVertex( cm, mdChunkReadIndex( cm, triindex, corner ), point );
+    centroid[0] += point[0];
+    centroid[1] += point[1];
+    centroid[2] += point[2];
+  }
+  centroid[0] *= 1.0/3.0;
+  centroid[1] *= 1.0/3.0;
+  centroid[2] *= 1.0/3.0;
+  return mdChunkPointCode( cm, centroid );
+}
+
+/* Cell holding the code, cells cover the whole code space in order */
+static inline size_t mdChunkFindCell( mdChunkMesh *cm, uint64_t code )
+{
+  size_t low, high, mid;
+  low = 0;
+  high = cm->celltotal;
+  while( ( high - low ) > 1 )
+  {
+    mid = ( low + high ) >> 1;
+    if( cm->cellcode[mid] <= code )
+      low = mid;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+static inline uint32_t mdChunkTriChunk( mdChunkMesh *cm, size_t triindex )
+{
+  return cm->cellchunk[ mdChunkFindCell( cm, mdChunkTriCode( cm, triindex ) ) ];
+}
+
+static inline uint32_t mdChunkPointChunk( mdChunkMesh *cm, double *point )
+{
+  return cm->cellchunk[ mdChunkFindCell( cm, mdChunkPointCode( cm, point ) ) ];
+}
+
+
+static void mdChunkBuildBox( mdChunkMesh *cm )
+{
+  int axis;
+  size_t vertexindex;
+  double point[3], boxmax[3], extent;
+
+  for( axis = 0 ; axis < 3 ; axis++ )
+  {
+    cm->boxmin[axis] = DBL_MAX;
+    boxmax[axis] = -DBL_MAX;
+  }
+  for( vertexindex = 0 ; vertexindex < cm->vertexcount ; vertexindex++ )
+  {
+    mdChunkReadVertex( cm, vertexindex, point );
+    for( axis = 0 ; axis < 3 ; axis++ )
+    {
+      cm->boxmin[axis] = fmin( cm->boxmin[axis], point[axis] );
+      boxmax[axis] = fmax( boxmax[axis], point[axis] );
+    }
+  }
+  for( axis = 0 ; axis < 3 ; axis++ )
+  {
+    extent = boxmax[axis] - cm->boxmin[axis];
+    cm->codescale[axis] = ( extent > 0.0 ? (double)MD_CHUNK_CODE_AXIS / extent : 0.0 );
+  }
+  return;
+}
+
+
+/* Count of cells above splitmin triangles that can still be split */
+static size_t mdChunkCountSplits( mdChunkMesh *cm, size_t splitmin )
+{
+  size_t cellindex, splitcount;
+  splitcount = 0;
+  for( cellindex = 0 ; cellindex < cm->celltotal ; cellindex++ )
+  {
+    if( ( cm->cellcount[cellindex] > splitmin ) && ( cm->cellshift[cellindex] ) )
+      splitcount++;
+  }
+  return splitcount;
+}
+
+/* Split in 8 the cells above splitmin triangles, in place from the end of the list */
+static void mdChunkSplitCells( mdChunkMesh *cm, size_t splitmin, size_t splitcount )
+{
+  int child;
+  size_t cellindex, dstindex;
+  uint64_t code;
+  uint8_t shift;
+
+  dstindex = cm->celltotal + ( 7 * splitcount );
+  for( cellindex = cm->celltotal ; cellindex-- ; )
+  {
+    code = cm->cellcode[cellindex];
+    shift = cm->cellshift[cellindex];
+    if( ( cm->cellcount[cellindex] > splitmin ) && ( shift ) )
+    {
+      shift -= 3;
+      for( child = 7 ; child >= 0 ; child-- )
+      {
+        dstindex--;
+        cm->cellcode[dstindex] = code + ( (uint64_t)child << shift );
+        cm->cellshift[dstindex] = shift;
+      }
+    }
+    else
+    {
+      dstindex--;
+      cm->cellcode[dstindex] = code;
+      cm->cellshift[dstindex] = shift;
+    }
+  }
+  cm->celltotal += 7 * splitcount;
+  return;
+}
+
+/* Split cells until small enough, then cut them in Morton order into chunks of about chunktricount triangles, the first chunk receives firsttricount */
+/* Only reads the mesh ; returns zero if a cell of more than chunktricount triangles can't be split, the mesh is too dense for the budget */
+static int mdChunkPartition( mdChunkMesh *cm, size_t chunktricount, size_t firsttricount )
+{
+  size_t triindex, cellindex, splitmin, splitcount, chunksum, chunktarget;
+
+  cm->celltotal = MD_CHUNK_CELL_INIT_COUNT;
+  for( cellindex = 0 ; cellindex < cm->celltotal ; cellindex++ )
+  {
+    cm->cellshift[cellindex] = 3 * ( MD_CHUNK_CODE_BITS - MD_CHUNK_CELL_INIT_BITS );
+    cm->cellcode[cellindex] = (uint64_t)cellindex << cm->cellshift[cellindex];
+  }
+  splitmin = chunktricount >> MD_CHUNK_CELL_SPLIT_SHIFT;
+  for( ; ; )
+  {
+    memset( cm->cellcount, 0, cm->celltotal * sizeof(size_t) );
+    for( triindex = 0 ; triindex < cm->tricount ; triindex++ )
+      cm->cellcount[ mdChunkFindCell( cm, mdChunkTriCode( cm, triindex ) ) ]++;
+    splitcount = mdChunkCountSplits( cm, splitmin );
+    /* Out of room for cells, only split the ones that must be */
+    if( ( cm->celltotal + ( 7 * splitcount ) > cm->cellalloc ) && ( splitmin < chunktricount ) )
+    {
+      splitmin = chunktricount;
+      splitcount = mdChunkCountSplits( cm, splitmin );
+    }
+    if( !( splitcount ) || ( cm->celltotal + ( 7 * splitcount ) > cm->cellalloc ) )
+      break;
+    mdChunkSplitCells( cm, splitmin, splitcount );
+  }
+  for( cellindex = 0 ; cellindex < cm->celltotal ; cellindex++ )
+  {
+    if( cm->cellcount[cellindex] > chunktricount )
+      return 0;
+  }
+
+  cm->chunkcount = 0;
+  cm->chunkbase[0] = 0;
+  chunksum = 0;
+  chunktarget = firsttricount;
+  for( cellindex = 0 ; cellindex < cm->celltotal ; cellindex++ )
+  {
+    if( ( chunksum ) && ( chunksum + cm->cellcount[cellindex] > chunktarget ) )
+    {
+      cm->chunkcount++;
+      cm->chunkbase[ cm->chunkcount ] = cm->chunkbase[ cm->chunkcount - 1 ] + chunksum;
+      chunksum = 0;
+      chunktarget = chunktricount;
+    }
+    cm->cellchunk[cellindex] = (uint32_t)cm->chunkcount;
+    chunksum += cm->cellcount[cellindex];
+  }
+  cm->chunkcount++;
+  cm->chunkbase[ cm->chunkcount ] = cm->tricount;
+  return 1;
+}
+
+
+static void mdChunkSwapTriangles( mdChunkMesh *cm, size_t triindex0, size_t triindex1 )
+{
+  int corner;
+  size_t index0, index1;
+  for( corner = 0 ; corner < 3 ; corner++ )
+  {
+    index0 = mdChunkReadIndex( cm, triindex0, corner );
+    index1 = mdChunkReadIndex( cm, triindex1, corner );
+    mdChunkWriteIndex( cm, triindex0, corner, index1 );
+    mdChunkWriteIndex( cm, triindex1, corner, index0 );
+  }
+  return;
+}
+
+/* Permute triangles in place so that each chunk is a contiguous range */
+static void mdChunkSortTriangles( mdChunkMesh *cm )
+{
+  size_t chunkindex, dstchunk;
+
+  memcpy( cm->chunknext, cm->chunkbase, cm->chunkcount * sizeof(size_t) );
+  for( chunkindex = 0 ; chunkindex < cm->chunkcount ; chunkindex++ )
+  {
+    while( cm->chunknext[chunkindex] < cm->chunkbase[chunkindex+1] )
+    {
+      dstchunk = mdChunkTriChunk( cm, cm->chunknext[chunkindex] );
+      if( dstchunk != chunkindex )
+        mdChunkSwapTriangles( cm, cm->chunknext[chunkindex], cm->chunknext[dstchunk] );
+      cm->chunknext[dstchunk]++;
+    }
+  }
+  return;
+}
+
+
+/* Lock vertices shared by triangles of different chunks with their one-ring, the vertices locked by the user, and for the seam pass all vertices but the seams */
+static void mdChunkBuildBoundary( mdChunkMesh *cm, uint32_t *lockmap, uint32_t *seammap )
+{
+  int corner;
+  size_t triindex, vertexindex, wordindex, wordcount;
+  uint32_t trichunk;
+  double point[3];
+
+  if( lockmap )
+    memcpy( cm->boundarymap, lockmap, cm->boundarymapsize );
+  else
+    memset( cm->boundarymap, 0, cm->boundarymapsize );
+  if( seammap )
+  {
+    wordcount = cm->boundarymapsize / sizeof(uint32_t);
+    for( wordindex = 0 ; wordindex < wordcount ; wordindex++ )
+      cm->boundarymap[wordindex] |= ~seammap[wordindex];
+  }
+  /* A vertex crosses chunks when a triangle using it is in a different chunk than the cell of the vertex itself */
+  memset( cm->crossmap, 0, cm->boundarymapsize );
+  for( triindex = 0 ; triindex < cm->tricount ; triindex++ )
+  {
+    trichunk = mdChunkTriChunk( cm, triindex );
+    for( corner = 0 ; corner < 3 ; corner++ )
+    {
+      vertexindex = mdChunkReadIndex( cm, triindex, corner );
+      mdChunkReadVertex( cm, vertexindex, point );
+      if( mdChunkPointChunk( cm, point ) != trichunk )
+        mdChunkLock( cm->crossmap, vertexindex );
+    }
+  }
+  /* Lock all vertices of triangles using a crossing vertex : a chunk only sees its own triangles, */
+  /* collapsing a neighbor onto a crossing vertex could link it to another crossing vertex through an edge owned by the next chunk */
+  for( triindex = 0 ; triindex < cm->tricount ; triindex++ )
+  {
+    for( corner = 0 ; corner < 3 ; corner++ )
+    {
+      if( mdChunkIsLocked( cm->crossmap, mdChunkReadIndex( cm, triindex, corner ) ) )
+        break;
+    }
+    if( corner == 3 )
+      continue;
+    for( corner = 0 ; corner < 3 ; corner++ )
+      mdChunkLock( cm->boundarymap, mdChunkReadIndex( cm, triindex, corner ) );
+  }
+  return;
+}
+
+
+////
+
+
+typedef struct
+{
+  /* Open addressing hash table of global vertex indices plus one, zero for empty slots */
+  size_t *keylist;
+  uint32_t *localindex;
+  size_t size;
+  size_t count;
+} mdChunkHash;
+
+static int mdChunkHashInit( mdChunkHash *hash, size_t size )
+{
+  hash->size = size;
+  hash->count = 0;
+  hash->keylist = calloc( size, sizeof(size_t) );
+  hash->localindex = malloc( size * sizeof(uint32_t) );
+  return ( ( hash->keylist ) && ( hash->localindex ) );
+}
+
+static void mdChunkHashFree( mdChunkHash *hash )
+{
+  free( hash->keylist );
+  free( hash->localindex );
+  hash->keylist = 0;
+  hash->localindex = 0;
+  return;
+}
+
+static inline size_t mdChunkHashSlot( mdChunkHash *hash, size_t key )
+{
+  size_t slot;
+  slot = (size_t)( ( (uint64_t)key * 0x9e3779b97f4a7c15ULL ) >> 17 ) & ( hash->size - 1 );
+  while( ( hash->keylist[slot] ) && ( hash->keylist[slot] != key ) )
+    slot = ( slot + 1 ) & ( hash->size - 1 );
+  return slot;
+}
+
+/* Double the size of the table when half full */
+static int mdChunkHashGrow( mdChunkHash *hash )
+{
+  size_t index, slot;
+  mdChunkHash newhash;
+  if( !( mdChunkHashInit( &newhash, hash->size << 1 ) ) )
+  {
+    mdChunkHashFree( &newhash );
+    return 0;
+  }
+  for( index = 0 ; index < hash->size ; index++ )
+  {
+    if( !( hash->keylist[index] ) )
+      continue;
+    slot = mdChunkHashSlot( &newhash, hash->keylist[index] );
+    newhash.keylist[slot] = hash->keylist[index];
+    newhash.localindex[slot] = hash->localindex[index];
+  }
+  newhash.count = hash->count;
+  mdChunkHashFree( hash );
+  *hash = newhash;
+  return 1;
+}
+
+
+////
+
+
+typedef struct
+{
+  /* Local copy of the chunk */
+  void *vertex;
+  size_t *globalindex;
+  size_t vertexcount;
+  size_t vertexalloc;
+  uint32_t *indices;
+  uint32_t *lockmap;
+  mdChunkHash hash;
+} mdChunkLocal;
+
+static void mdChunkLocalFree( mdChunkLocal *local )
+{
+  free( local->vertex );
+  free( local->globalindex );
+  free( local->indices );
+  free( local->lockmap );
+  mdChunkHashFree( &local->hash );
+  return;
+}
+
+/* Return local index of global vertex, adding it to the local copy if not present ; returns -1 on allocation failure */
+static long mdChunkLocalVertex( mdChunkLocal *local, size_t globalindex )
+{
+  size_t slot, vertexalloc;
+  size_t *globallist;
+
+  slot = mdChunkHashSlot( &local->hash, globalindex + 1 );
+  if( local->hash.keylist[slot] )
+    return local->hash.localindex[slot];
+  if( local->vertexcount >= local->vertexalloc )
+  {
+    vertexalloc = local->vertexalloc << 1;
+    globallist = realloc( local->globalindex, vertexalloc * sizeof(size_t) );
+    if( !( globallist ) )
+      return -1;
+    local->globalindex = globallist;
+    local->vertexalloc = vertexalloc;
+  }
+  local->hash.keylist[slot] = globalindex + 1;
+  local->hash.localindex[slot] = (uint32_t)local->vertexcount;
+  local->hash.count++;
+  local->globalindex[ local->vertexcount ] = globalindex;
+  if( ( local->hash.count << 1 ) > local->hash.size )
+  {
+    if( !( mdChunkHashGrow( &local->hash ) ) )
+      return -1;
+  }
+  return (long)local->vertexcount++;
+}
+
+
+/* Decimate one chunk, write its triangles back at outtricount */
+static int mdChunkDecimate( mdChunkMesh *cm, mdOperation *op, size_t chunkindex, int threadcount, int flags, size_t budget, size_t *outtricount )
+{
+  int corner, retval;
+  size_t triindex, tribase, tricount, localtri, vertexindex, vertexsize, hashsize, mapsize, localsize;
+  long localindex;
+  mdChunkLocal local;
+  mdOperation subop;
+
+  tribase = cm->chunkbase[chunkindex];
+  tricount = cm->chunkbase[chunkindex+1] - tribase;
+  if( !( tricount ) )
+    return 1;
+  vertexsize = mdChunkVertexSize( cm );
+
+  /* Collect vertices of the chunk, expecting about half as many as triangles */
+  memset( &local, 0, sizeof(mdChunkLocal) );
+  local.vertexalloc = ( tricount >> 1 ) + 16;
+  for( hashsize = 64 ; hashsize < ( local.vertexalloc << 1 ) ; hashsize <<= 1 );
+  local.globalindex = malloc( local.vertexalloc * sizeof(size_t) );
+  local.indices = malloc( 3 * tricount * sizeof(uint32_t) );
+  retval = 0;
+  if( !( mdChunkHashInit( &local.hash, hashsize ) ) || !( local.globalindex ) || !( local.indices ) )
+    goto end;
+  for( triindex = 0 ; triindex < tricount ; triindex++ )
+  {
+    for( corner = 0 ; corner < 3 ; corner++ )
+    {
+      localindex = mdChunkLocalVertex( &local, mdChunkReadIndex( cm, tribase + triindex, corner ) );
+      if( localindex < 0 )
+        goto end;
+      local.indices[ ( triindex * 3 ) + corner ] = (uint32_t)localindex;
+    }
+  }
+  mdChunkHashFree( &local.hash );
+
+  /* Copy vertices and locks */
+  mapsize = ( ( local.vertexcount + (32-1) ) >> 5 ) * sizeof(uint32_t);
+  local.vertex = malloc( local.vertexcount * vertexsize );
+  local.lockmap = calloc( 1, mapsize );
+  if( !( local.vertex ) || !( local.lockmap ) )
+    goto end;
+  for( vertexindex = 0 ; vertexindex < local.vertexcount ; vertexindex++ )
+  {
+    memcpy( ADDRESS( local.vertex, vertexindex * vertexsize ), ADDRESS( cm->vertex, local.globalindex[vertexindex] * cm->vertexstride ), vertexsize );
+    if( mdChunkIsLocked( cm->boundarymap, local.globalindex[vertexindex] ) )
+      mdChunkLock( local.lockmap, vertexindex );
+  }
+
+  /* The decimation of the chunk gets what remains of the budget */
+  localsize = ( local.vertexcount * ( vertexsize + sizeof(size_t) ) ) + ( 3 * tricount * sizeof(uint32_t) ) + mapsize;
+  if( localsize >= budget )
+    goto end;
+  subop = *op;
+  subop.vertexcount = local.vertexcount;
+  subop.vertex = local.vertex;
+  subop.vertexstride = vertexsize;
+  subop.vertexalloc = 0;
+  subop.indices = local.indices;
+  subop.indicesformat = MD_FORMAT_UINT32;
+  subop.indicesstride = 3 * sizeof(uint32_t);
+  subop.tricount = tricount;
+  subop.lockmap = local.lockmap;
+  subop.maxmemoryusage = budget - localsize;
+  subop.statuscallback = 0;
+  if( !( mdMeshDecimation( &subop, threadcount, flags | MD_FLAGS_NO_VERTEX_PACKING ) ) )
+    goto end;
+  op->decimationcount += subop.decimationcount;
+  op->collisioncount += subop.collisioncount;
+  op->stealcount += subop.stealcount;
+  op->idlemsecs += subop.idlemsecs;
+  op->globallockcount += subop.globallockcount;
+
+  /* Unlocked vertices only belong to this chunk, write them back in place */
+  for( vertexindex = 0 ; vertexindex < local.vertexcount ; vertexindex++ )
+  {
+    if( !( mdChunkIsLocked( local.lockmap, vertexindex ) ) )
+      memcpy( ADDRESS( cm->vertex, local.globalindex[vertexindex] * cm->vertexstride ), ADDRESS( local.vertex, vertexindex * vertexsize ), vertexsize );
+  }
+  /* Triangles can only shrink in count, packed ahead of the chunks still to decimate */
+  for( localtri = 0 ; localtri < subop.tricount ; localtri++ )
+  {
+    for( corner = 0 ; corner < 3 ; corner++ )
+      mdChunkWriteIndex( cm, *outtricount, corner, local.globalindex[ local.indices[ ( localtri * 3 ) + corner ] ] );
+    (*outtricount)++;
+  }
+  retval = 1;
+
+  end:
+  mdChunkLocalFree( &local );
+  return retval;
+}
+
+
+/* Run one pass over all chunks as cut by mdChunkPartition(), returns the count of chunks or zero on failure */
+static size_t mdChunkPass( mdChunkMesh *cm, mdOperation *op, int threadcount, int flags, size_t budget, uint32_t *seammap )
+{
+  size_t chunkindex, outtricount;
+
+  mdChunkSortTriangles( cm );
+  mdChunkBuildBoundary( cm, op->lockmap, seammap );
+  outtricount = 0;
+  for( chunkindex = 0 ; chunkindex < cm->chunkcount ; chunkindex++ )
+  {
+    if( !( mdChunkDecimate( cm, op, chunkindex, threadcount, flags, budget, &outtricount ) ) )
+      return 0;
+  }
+  cm->tricount = outtricount;
+  return cm->chunkcount;
+}
+
+
+/* Remove vertices no longer referenced by any triangle, preserving their order */
+static int mdChunkPackVertices( mdChunkMesh *cm )
+{
+  int corner;
+  size_t triindex, vertexindex, wordindex, wordcount, packcount, vertexsize;
+  uint32_t *usedmap;
+  size_t *wordbase;
+
+  /* Reuse the boundary bitmap to flag used vertices */
+  usedmap = cm->boundarymap;
+  wordcount = ( cm->vertexcount + (32-1) ) >> 5;
+  wordbase = malloc( ( wordcount + 1 ) * sizeof(size_t) );
+  if( !( wordbase ) )
+    return 0;
+  memset( usedmap, 0, cm->boundarymapsize );
+  for( triindex = 0 ; triindex < cm->tricount ; triindex++ )
+  {
+    for( corner = 0 ; corner < 3 ; corner++ )
+      mdChunkLock( usedmap, mdChunkReadIndex( cm, triindex, corner ) );
+  }
+  packcount = 0;
+  for( wordindex = 0 ; wordindex < wordcount ; wordindex++ )
+  {
+    wordbase[wordindex] = packcount;
+    packcount += ccCountBits32( usedmap[wordindex] );
+  }
+
+  /* Move used vertices down, then remap indices to their rank */
+  vertexsize = mdChunkVertexSize( cm );
+  packcount = 0;
+  for( vertexindex = 0 ; vertexindex < cm->vertexcount ; vertexindex++ )
+  {
+    if( !( mdChunkIsLocked( usedmap, vertexindex ) ) )
+      continue;
+    if( packcount != vertexindex )
+      memmove( ADDRESS( cm->vertex, packcount * cm->vertexstride ), ADDRESS( cm->vertex, vertexindex * cm->vertexstride ), vertexsize );
+    packcount++;
+  }
+  for( triindex = 0 ; triindex < cm->tricount ; triindex++ )
+  {
+    for( corner = 0 ; corner < 3 ; corner++ )
+    {
+      vertexindex = mdChunkReadIndex( cm, triindex, corner );
+      wordindex = vertexindex >> 5;
+      mdChunkWriteIndex( cm, triindex, corner, wordbase[wordindex] + ccCountBits32( usedmap[wordindex] & ( ( ((uint32_t)1) << ( vertexindex & (32-1) ) ) - 1 ) ) );
+    }
+  }
+  cm->vertexcount = packcount;
+
+  free( wordbase );
+  return 1;
+}
+
+
+////
+
+
+int mdMeshDecimationChunked( mdOperation *operation, int threadcount, int flags )
+{
+  int retval;
+  size_t budget, fixedsize, pertrisize, chunktricount, chunkcount;
+  uint32_t *map;
+  long msecs;
+  mdChunkMesh chunkmesh;
+  mdChunkMesh *cm;
+  mdOperation probe;
+
+  /* Decimate the whole mesh at once if it fits */
+  budget = operation->maxmemoryusage;
+  if( !( budget ) || !( operation->tricount ) || ( mdMeshDecimationMemoryUsage( operation, flags ) <= budget ) )
+    return mdMeshDecimation( operation, threadcount, flags );
+
+  /* Chunks are decimated independently, reject what needs to see the whole mesh at once */
+  if( ( operation->vertexformat != MD_FORMAT_FLOAT ) && ( operation->vertexformat != MD_FORMAT_DOUBLE ) )
+    return 0;
+  if( ( operation->tridata ) || ( operation->vertexmerge ) || ( operation->vertexcopy ) || ( operation->normalbase ) || ( operation->levelcount ) || ( operation->collapsestream ) )
+    return 0;
+  if( ( operation->targetvertexcountmin ) || ( operation->targetvertexcountmax ) || ( flags & MD_FLAGS_NO_DECIMATION ) )
+    return 0;
+
+  msecs = (long)mmGetMillisecondsTime();
+  cm = &chunkmesh;
+  memset( cm, 0, sizeof(mdChunkMesh) );
+  cm->vertex = operation->vertex;
+  cm->vertexformat = operation->vertexformat;
+  cm->vertexstride = operation->vertexstride;
+  cm->indices = operation->indices;
+  cm->indicesformat = operation->indicesformat;
+  cm->indicesstride = operation->indicesstride;
+  cm->vertexcount = operation->vertexcount;
+  cm->tricount = operation->tricount;
+  cm->boundarymapsize = ( ( cm->vertexcount + (32-1) ) >> 5 ) * sizeof(uint32_t);
+
+  /* Memory held through the whole chunked decimation, the remainder of the budget is for one chunk */
+  cm->cellalloc = ( budget >> MD_CHUNK_CELL_BUDGET_SHIFT ) / MD_CHUNK_CELL_SIZE;
+  if( cm->cellalloc < MD_CHUNK_CELL_MIN )
+    cm->cellalloc = MD_CHUNK_CELL_MIN;
+  fixedsize = ( cm->cellalloc * MD_CHUNK_CELL_SIZE ) + ( 2 * sizeof(size_t) ) + ( 5 * cm->boundarymapsize );
+  /* Chunks cut through the mesh have more vertices per triangle, assume as many as triangles */
+  probe = *operation;
+  probe.vertexcount = probe.tricount;
+  probe.vertexalloc = 0;
+  pertrisize = ( mdMeshDecimationMemoryUsage( &probe, flags ) / probe.tricount ) + MD_CHUNK_LOCAL_TRISIZE;
+  if( fixedsize >= budget )
+    return 0;
+  chunktricount = ( budget - fixedsize ) / pertrisize;
+  if( chunktricount < MD_CHUNK_TRICOUNT_MIN )
+    return 0;
+
+  retval = 0;
+  cm->cellcode = malloc( cm->cellalloc * sizeof(uint64_t) );
+  cm->cellshift = malloc( cm->cellalloc * sizeof(uint8_t) );
+  cm->cellcount = malloc( cm->cellalloc * sizeof(size_t) );
+  cm->cellchunk = malloc( cm->cellalloc * sizeof(uint32_t) );
+  cm->chunkbase = malloc( ( cm->cellalloc + 1 ) * sizeof(size_t) );
+  cm->chunknext = malloc( ( cm->cellalloc + 1 ) * sizeof(size_t) );
+  cm->boundarymap = malloc( cm->boundarymapsize );
+  cm->seammap = malloc( cm->boundarymapsize );
+  cm->crossmap = malloc( cm->boundarymapsize );
+  if( !( cm->cellcode ) || !( cm->cellshift ) || !( cm->cellcount ) || !( cm->cellchunk ) || !( cm->chunkbase ) || !( cm->chunknext ) || !( cm->boundarymap ) || !( cm->seammap ) || !( cm->crossmap ) )
+    goto end;
+
+  operation->decimationcount = 0;
+  operation->collisioncount = 0;
+  operation->stealcount = 0;
+  operation->idlemsecs = 0;
+  operation->globallockcount = 0;
+  mdChunkBuildBox( cm );
+  budget -= fixedsize;
+
+  /* Cut all chunks before touching the mesh, a mesh too dense to be cut within the budget fails untouched */
+  if( !( mdChunkPartition( cm, chunktricount, chunktricount ) ) )
+    goto end;
+
+  /* First pass, then a seam pass with cuts shifted by half a chunk to decimate what was locked along the first cuts */
+  chunkcount = mdChunkPass( cm, operation, threadcount, flags, budget, 0 );
+  if( !( chunkcount ) )
+    goto end;
+  if( chunkcount > 1 )
+  {
+    map = cm->seammap;
+    cm->seammap = cm->boundarymap;
+    cm->boundarymap = map;
+    /* If the decimated mesh can't be cut again, the seams just stay as the first pass left them */
+    if( ( mdChunkPartition( cm, chunktricount, chunktricount >> 1 ) ) && !( mdChunkPass( cm, operation, threadcount, flags, budget, cm->seammap ) ) )
+      goto end;
+  }
+
+  if( !( flags & MD_FLAGS_NO_VERTEX_PACKING ) )
+  {
+    if( !( mdChunkPackVertices( cm ) ) )
+      goto end;
+  }
+  operation->vertexcount = cm->vertexcount;
+  operation->tricount = cm->tricount;
+  retval = 1;
+
+  end:
+  free( cm->cellcode );
+  free( cm->cellshift );
+  free( cm->cellcount );
+  free( cm->cellchunk );
+  free( cm->chunkbase );
+  free( cm->chunknext );
+  free( cm->boundarymap );
+  free( cm->seammap );
+  free( cm->crossmap );
+  operation->msecs = (long)mmGetMillisecondsTime() - msecs;
+  return retval;
+}
@@ -0,0 +1,1763 @@
+/* *****************************************************************************
+ *
+ * Copyright (c) 2012-2023 Alexis Naveros.
+ * Portions developed under contract to the SURVICE Engineering Company.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * *****************************************************************************
+ */
+
+/*
+ * Parallel mesh file loaders, OBJ, PLY and STL.
+ *
+ * Files are memory mapped. Text files are split in one chunk per thread at
+ * line boundaries, a first parallel pass counts the vertices and triangles of
+ * each chunk, and after a prefix sum a second pass parses each chunk directly
+ * at its place in the output arrays. Binary PLY records are of fixed size as
+ * long as all faces are triangles, they are converted in parallel or used in
+ * place when already laid out as floats and 32 bits indices. STL vertices are
+ * welded in parallel by a hash table per thread, each thread owning a range
+ * of hash values.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "cc.h"
+#include "mmcore.h"
+#include "mm.h"
+#include "mmthread.h"
+
+#if MM_UNIX
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <sys/types.h>
+ #include <sys/stat.h>
+ #include <sys/mman.h>
+#elif MM_WINDOWS
+ #include <windows.h>
+#endif
+
+#include "meshloader.h"
+
+
+////
+
+
+#define ML_THREAD_COUNT_MAX (64)
+
+/* Don't split text files in chunks smaller than that */
+#define ML_TEXT_CHUNK_SIZE_MIN (1<<20)
+
+#define ML_PLY_PROPERTY_MAX (32)
+#define ML_PLY_ELEMENT_MAX (16)
+#define ML_PLY_NAME_SIZE (32)
+
+
+enum
+{
+  ML_PLY_TYPE_NONE,
+  ML_PLY_TYPE_INT8,
+  ML_PLY_TYPE_UINT8,
+  ML_PLY_TYPE_INT16,
+  ML_PLY_TYPE_UINT16,
+  ML_PLY_TYPE_INT32,
+  ML_PLY_TYPE_UINT32,
+  ML_PLY_TYPE_FLOAT32,
+  ML_PLY_TYPE_FLOAT64
+};
+
+enum
+{
+  ML_PLY_ASCII,
+  ML_PLY_BINARY_LE,
+  ML_PLY_BINARY_BE
+};
+
+typedef struct
+{
+  char name[ML_PLY_NAME_SIZE];
+  int type;
+  /* Type of the count of list properties, ML_PLY_TYPE_NONE for scalar properties */
+  int counttype;
+  /* Byte offset within fixed size binary records */
+  size_t offset;
+} mlPlyProperty;
+
+typedef struct
+{
+  char name[ML_PLY_NAME_SIZE];
+  size_t count;
+  mlPlyProperty property[ML_PLY_PROPERTY_MAX];
+  int propertycount;
+  /* Size of binary records, zero if the element holds list properties */
+  size_t recordsize;
+  /* Offset in file of binary data, or first line of ASCII data */
+  size_t base;
+} mlPlyElement;
+
+typedef struct
+{
+  int format;
+  mlPlyElement element[ML_PLY_ELEMENT_MAX];
+  int elementcount;
+  mlPlyElement *vertex;
+  mlPlyElement *face;
+  /* Properties of positions and face indices */
+  mlPlyProperty *px, *py, *pz;
+  int xindex, yindex, zindex;
+  mlPlyProperty *plist;
+  int listindex;
+  size_t bodyoffset;
+} mlPly;
+
+
+typedef struct
+{
+  const char *start;
+  const char *end;
+  /* Counts of the chunk and bases in the output arrays */
+  size_t linecount;
+  size_t vertexcount;
+  size_t tricount;
+  size_t linebase;
+  size_t vertexbase;
+  size_t tribase;
+  int errorflag;
+} mlChunk;
+
+typedef struct
+{
+  mlMesh *mesh;
+  const char *data;
+  size_t size;
+  int threadcount;
+  int flags;
+  int swapflag;
+
+  mlChunk chunk[ML_THREAD_COUNT_MAX];
+  int chunkcount;
+
+  mlPly ply;
+
+  /* STL corners, 3 floats at cornerstride, grouped by triangles of tristride bytes */
+  const char *cornerbase;
+  size_t cornercount;
+  size_t tristride;
+  uint32_t *hashlist;
+  uint32_t *rankbase;
+  float *cornerlist;
+} mlLoader;
+
+
+////
+
+
+typedef struct
+{
+  void (*func)( mlLoader *loader, int threadindex );
+  mlLoader *loader;
+  int threadindex;
+} mlLaunch;
+
+static void *mlThreadMain( void *value )
+{
+  mlLaunch *launch;
+  launch = value;
+  launch->func( launch->loader, launch->threadindex );
+  return 0;
+}
+
+/* Run func on threadcount threads, the calling thread being the first */
+static void mlParallel( mlLoader *loader, int threadcount, void (*func)( mlLoader *loader, int threadindex ) )
+{
+  int threadindex;
+  mtThread thread[ML_THREAD_COUNT_MAX];
+  mlLaunch launch[ML_THREAD_COUNT_MAX];
+
+  for( threadindex = 1 ; threadindex < threadcount ; threadindex++ )
+  {
+    launch[threadindex].func = func;
+    launch[threadindex].loader = loader;
+    launch[threadindex].threadindex = threadindex;
+    mtThreadCreate( &thread[threadindex], mlThreadMain, &launch[threadindex], MT_THREAD_FLAGS_JOINABLE );
+  }
+  func( loader, 0 );
+  for( threadindex = 1 ; threadindex < threadcount ; threadindex++ )
+    mtThreadJoin( &thread[threadindex] );
+  return;
+}
+
+/* Range of items processed by a thread */
+static void mlThreadRange( size_t count, int threadcount, int threadindex, size_t *base, size_t *max )
+{
+  size_t perthread;
+  perthread = ( count / threadcount ) + 1;
+  *base = (size_t)threadindex * perthread;
+  *max = *base + perthread;
+  if( *max > count )
+    *max = count;
+  if( *base > *max )
+    *base = *max;
+  return;
+}
+
+
+////
+
+
+static int mlMapFile( mlMesh *mesh, const char *path )
+{
+#if MM_UNIX
+  int fd;
+  struct stat filestat;
+  void *address;
+  fd = open( path, O_RDONLY );
+  if( fd == -1 )
+    return 0;
+  if( ( fstat( fd, &filestat ) ) || !( filestat.st_size ) )
+  {
+    close( fd );
+    return 0;
+  }
+  /* Private copy-on-write mapping, the mesh can be decimated in place without touching the file */
+  address = mmap( 0, (size_t)filestat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+  close( fd );
+  if( address == MAP_FAILED )
+    return 0;
+  mesh->mapaddress = address;
+  mesh->mapsize = (size_t)filestat.st_size;
+  return 1;
+#elif MM_WINDOWS
+  HANDLE filehandle, maphandle;
+  LARGE_INTEGER filesize;
+  void *address;
+  filehandle = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
+  if( filehandle == INVALID_HANDLE_VALUE )
+    return 0;
+  if( !( GetFileSizeEx( filehandle, &filesize ) ) || !( filesize.QuadPart ) )
+  {
+    CloseHandle( filehandle );
+    return 0;
+  }
+  maphandle = CreateFileMappingA( filehandle, 0, PAGE_WRITECOPY, 0, 0, 0 );
+  if( !( maphandle ) )
+  {
+    CloseHandle( filehandle );
+    return 0;
+  }
+  address = MapViewOfFile( maphandle, FILE_MAP_COPY, 0, 0, 0 );
+  if( !( address ) )
+  {
+    CloseHandle( maphandle );
+    CloseHandle( filehandle );
+    return 0;
+  }
+  mesh->mapaddress = address;
+  mesh->mapsize = (size_t)filesize.QuadPart;
+  mesh->filehandle = filehandle;
+  mesh->maphandle = maphandle;
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+static void mlUnmapFile( mlMesh *mesh )
+{
+  if( !( mesh->mapaddress ) )
+    return;
+#if MM_UNIX
+  munmap( mesh->mapaddress, mesh->mapsize );
+#elif MM_WINDOWS
+  UnmapViewOfFile( mesh->mapaddress );
+  CloseHandle( (HANDLE)mesh->maphandle );
+  CloseHandle( (HANDLE)mesh->filehandle );
+#endif
+  mesh->mapaddress = 0;
+  mesh->mapsize = 0;
+  return;
+}
+
+
+////
+
+
+static inline int mlIsSpace( char c )
+{
+  return ( ( c == ' ' ) || ( c == '\t' ) || ( c == '\r' ) );
+}
+
+static inline const char *mlSkipSpace( const char *s, const char *end )
+{
+  while( ( s < end ) && mlIsSpace( *s ) )
+    s++;
+  return s;
+}
+
+static inline const char *mlSkipToken( const char *s, const char *end )
+{
+  while( ( s < end ) && !( mlIsSpace( *s ) ) && ( *s != '\n' ) )
+    s++;
+  return s;
+}
+
+static inline const char *mlNextLine( const char *s, const char *end )
+{
+  s = memchr( s, '\n', end - s );
+  return ( s ? s + 1 : end );
+}
+
+/* End of the line content, a '#' starts a comment up to the end of the line */
+static inline const char *mlSkipComment( const char *s, const char *next )
+{
+  s = memchr( s, '#', next - s );
+  return ( s ? s : next );
+}
+
+/* Parse a signed integer, the mapped file isn't null terminated so never read past end */
+static int mlParseInt( const char **sp, const char *end, long *value )
+{
+  int negflag;
+  long v;
+  const char *s;
+  s = *sp;
+  negflag = 0;
+  if( ( s < end ) && ( ( *s == '-' ) || ( *s == '+' ) ) )
+  {
+    negflag = ( *s == '-' );
+    s++;
+  }
+  if( ( s >= end ) || ( (unsigned)( *s - '0' ) > 9 ) )
+    return 0;
+  for( v = 0 ; ( s < end ) && ( (unsigned)( *s - '0' ) <= 9 ) ; s++ )
+    v = ( v * 10 ) + ( *s - '0' );
+  *value = ( negflag ? -v : v );
+  *sp = s;
+  return 1;
+}
+
+static const double mlPow10[] =
+{
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Parse a decimal floating point number, accurate to float precision */
+static int mlParseFloat( const char **sp, const char *end, float *value )
+{
+  int negflag, digitcount, exponent, expnegflag;
+  long expvalue;
+  uint64_t mantissa;
+  double v;
+  const char *s;
+
+  s = *sp;
+  negflag = 0;
+  if( ( s < end ) && ( ( *s == '-' ) || ( *s == '+' ) ) )
+  {
+    negflag = ( *s == '-' );
+    s++;
+  }
+  mantissa = 0;
+  digitcount = 0;
+  exponent = 0;
+  for( ; ( s < end ) && ( (unsigned)( *s - '0' ) <= 9 ) ; s++, digitcount++ )
+  {
+    if( mantissa < 100000000000000000ULL )
+      mantissa = ( mantissa * 10 ) + ( *s - '0' );
+    else
+      exponent++;
+  }
+  if( ( s < end ) && ( *s == '.' ) )
+  {
+    for( s++ ; ( s < end ) && ( (unsigned)( *s - '0' ) <= 9 ) ; s++, digitcount++ )
+    {
+      if( mantissa < 100000000000000000ULL )
+      {
+        mantissa = ( mantissa * 10 ) + ( *s - '0' );
+        exponent--;
+      }
+    }
+  }
+  if( !( digitcount ) )
+    return 0;
+  if( ( s < end ) && ( ( *s == 'e' ) || ( *s == 'E' ) ) )
+  {
+    s++;
+    expnegflag = 0;
+    if( ( s < end ) && ( ( *s == '-' ) || ( *s == '+' ) ) )
+    {
+      expnegflag = ( *s == '-' );
+      s++;
+    }
+    for( expvalue = 0 ; ( s < end ) && ( (unsigned)( *s - '0' ) <= 9 ) ; s++ )
+    {
+      if( expvalue < 100000 )
+        expvalue = ( expvalue * 10 ) + ( *s - '0' );
+    }
+    exponent += (int)( expnegflag ? -expvalue : expvalue );
+  }
+  v = (double)mantissa;
+  if( !( exponent ) )
+    ;
+  else if( ( exponent > 0 ) && ( exponent <= 22 ) )
+    v *= mlPow10[exponent];
+  else if( ( exponent < 0 ) && ( exponent >= -22 ) )
+    v /= mlPow10[-exponent];
+  else
+    v *= pow( 10.0, (double)exponent );
+  *value = (float)( negflag ? -v : v );
+  *sp = s;
+  return 1;
+}
+
+
+////
+
+
+/* Split the text in one chunk per thread, cut at line boundaries */
+static void mlSplitText( mlLoader *loader, const char *start, const char *end )
+{
+  int chunkindex, chunkcount;
+  size_t size;
+  const char *s;
+  mlChunk *chunk;
+
+  size = end - start;
+  chunkcount = (int)( size / ML_TEXT_CHUNK_SIZE_MIN ) + 1;
+  if( chunkcount > loader->threadcount )
+    chunkcount = loader->threadcount;
+  s = start;
+  for( chunkindex = 0 ; chunkindex < chunkcount ; chunkindex++ )
+  {
+    chunk = &loader->chunk[chunkindex];
+    memset( chunk, 0, sizeof(mlChunk) );
+    chunk->start = s;
+    if( chunkindex == chunkcount - 1 )
+      s = end;
+    else
+    {
+      s = start + ( ( size * ( chunkindex + 1 ) ) / chunkcount );
+      if( s < chunk->start )
+        s = chunk->start;
+      if( s > start )
+        s = mlNextLine( s - 1, end );
+    }
+    chunk->end = s;
+  }
+  loader->chunkcount = chunkcount;
+  return;
+}
+
+/* Prefix sums of chunk counts, returns 0 if a chunk failed */
+static int mlSumChunks( mlLoader *loader, size_t *vertexcount, size_t *tricount )
+{
+  int chunkindex;
+  size_t linesum, vertexsum, trisum;
+  mlChunk *chunk;
+  linesum = 0;
+  vertexsum = 0;
+  trisum = 0;
+  for( chunkindex = 0 ; chunkindex < loader->chunkcount ; chunkindex++ )
+  {
+    chunk = &loader->chunk[chunkindex];
+    if( chunk->errorflag )
+      return 0;
+    chunk->linebase = linesum;
+    chunk->vertexbase = vertexsum;
+    chunk->tribase = trisum;
+    linesum += chunk->linecount;
+    vertexsum += chunk->vertexcount;
+    trisum += chunk->tricount;
+  }
+  *vertexcount = vertexsum;
+  *tricount = trisum;
+  return 1;
+}
+
+static int mlAllocArrays( mlMesh *mesh, size_t vertexcount, size_t tricount )
+{
+  if( ( vertexcount > 0xffffffff ) || ( tricount > ( SIZE_MAX / ( 3 * sizeof(uint32_t) ) ) ) )
+    return 0;
+  mesh->vertexcount = vertexcount;
+  mesh->tricount = tricount;
+  mesh->vertexalloc = malloc( ( vertexcount ? vertexcount : 1 ) * 3 * sizeof(float) );
+  mesh->indicesalloc = malloc( ( tricount ? tricount : 1 ) * 3 * sizeof(uint32_t) );
+  mesh->vertex = mesh->vertexalloc;
+  mesh->vertexstride = 3 * sizeof(float);
+  mesh->indices = mesh->indicesalloc;
+  mesh->indicesstride = 3 * sizeof(uint32_t);
+  return ( ( mesh->vertexalloc ) && ( mesh->indicesalloc ) );
+}
+
+static inline void mlStoreTriangle( mlMesh *mesh, size_t triindex, uint32_t v0, uint32_t v1, uint32_t v2 )
+{
+  uint32_t *indices;
+  indices = ADDRESS( mesh->indices, triindex * mesh->indicesstride );
+  indices[0] = v0;
+  indices[1] = v1;
+  indices[2] = v2;
+  return;
+}
+
+
+////
+
+
+static void mlObjCountThread( mlLoader *loader, int threadindex )
+{
+  int cornercount;
+  const char *s, *next, *lineend, *end;
+  mlChunk *chunk;
+
+  if( threadindex >= loader->chunkcount )
+    return;
+  chunk = &loader->chunk[threadindex];
+  end = chunk->end;
+  for( s = chunk->start ; s < end ; s = next )
+  {
+    next = mlNextLine( s, end );
+    s = mlSkipSpace( s, next );
+    if( ( next - s < 2 ) || !( mlIsSpace( s[1] ) ) )
+      continue;
+    if( s[0] == 'v' )
+      chunk->vertexcount++;
+    else if( s[0] == 'f' )
+    {
+      cornercount = 0;
+      lineend = mlSkipComment( s, next );
+      for( s = mlSkipSpace( s + 1, lineend ) ; ( s < lineend ) && ( *s != '\n' ) ; s = mlSkipSpace( mlSkipToken( s, lineend ), lineend ) )
+        cornercount++;
+      if( cornercount >= 3 )
+        chunk->tricount += cornercount - 2;
+    }
+  }
+  return;
+}
+
+static void mlObjParseThread( mlLoader *loader, int threadindex )
+{
+  int cornercount;
+  long value;
+  size_t vertexindex, triindex, vertexcount;
+  uint32_t index, first, prev;
+  float *point;
+  const char *s, *next, *lineend, *end;
+  mlChunk *chunk;
+  mlMesh *mesh;
+
+  if( threadindex >= loader->chunkcount )
+    return;
+  mesh = loader->mesh;
+  chunk = &loader->chunk[threadindex];
+  end = chunk->end;
+  vertexindex = chunk->vertexbase;
+  triindex = chunk->tribase;
+  vertexcount = mesh->vertexcount;
+  for( s = chunk->start ; s < end ; s = next )
+  {
+    next = mlNextLine( s, end );
+    s = mlSkipSpace( s, next );
+    if( ( next - s < 2 ) || !( mlIsSpace( s[1] ) ) )
+      continue;
+    if( s[0] == 'v' )
+    {
+      point = ADDRESS( mesh->vertex, vertexindex * mesh->vertexstride );
+      s = mlSkipSpace( s + 1, next );
+      if( !( mlParseFloat( &s, next, &point[0] ) ) )
+        goto error;
+      s = mlSkipSpace( s, next );
+      if( !( mlParseFloat( &s, next, &point[1] ) ) )
+        goto error;
+      s = mlSkipSpace( s, next );
+      if( !( mlParseFloat( &s, next, &point[2] ) ) )
+        goto error;
+      vertexindex++;
+    }
+    else if( s[0] == 'f' )
+    {
+      first = 0;
+      prev = 0;
+      cornercount = 0;
+      lineend = mlSkipComment( s, next );
+      for( s = mlSkipSpace( s + 1, lineend ) ; ( s < lineend ) && ( *s != '\n' ) ; s = mlSkipSpace( mlSkipToken( s, lineend ), lineend ) )
+      {
+        /* Corners are "v", "v/t", "v//n" or "v/t/n", negative indices are relative to the last vertex defined */
+        if( !( mlParseInt( &s, lineend, &value ) ) )
+          goto error;
+        value = ( value < 0 ? (long)vertexindex + value : value - 1 );
+        if( ( value < 0 ) || ( (size_t)value >= vertexcount ) )
+          goto error;
+        index = (uint32_t)value;
+        if( !( cornercount ) )
+          first = index;
+        else if( cornercount >= 2 )
+          mlStoreTriangle( mesh, triindex++, first, prev, index );
+        prev = index;
+        cornercount++;
+      }
+    }
+  }
+  return;
+
+  error:
+  chunk->errorflag = 1;
+  return;
+}
+
+static int mlLoadObj( mlLoader *loader )
+{
+  int chunkindex;
+  size_t vertexcount, tricount;
+
+  mlSplitText( loader, loader->data, loader->data + loader->size );
+  mlParallel( loader, loader->chunkcount, mlObjCountThread );
+  if( !( mlSumChunks( loader, &vertexcount, &tricount ) ) )
+    return 0;
+  if( !( mlAllocArrays( loader->mesh, vertexcount, tricount ) ) )
+    return 0;
+  mlParallel( loader, loader->chunkcount, mlObjParseThread );
+  for( chunkindex = 0 ; chunkindex < loader->chunkcount ; chunkindex++ )
+  {
+    if( loader->chunk[chunkindex].errorflag )
+      return 0;
+  }
+  return 1;
+}
+
+
+////
+
+
+static const struct
+{
+  const char *name;
+  int type;
+  int size;
+} mlPlyTypeList[] =
+{
+  { "char", ML_PLY_TYPE_INT8, 1 },
+  { "int8", ML_PLY_TYPE_INT8, 1 },
+  { "uchar", ML_PLY_TYPE_UINT8, 1 },
+  { "uint8", ML_PLY_TYPE_UINT8, 1 },
+  { "short", ML_PLY_TYPE_INT16, 2 },
+  { "int16", ML_PLY_TYPE_INT16, 2 },
+  { "ushort", ML_PLY_TYPE_UINT16, 2 },
+  { "uint16", ML_PLY_TYPE_UINT16, 2 },
+  { "int", ML_PLY_TYPE_INT32, 4 },
+  { "int32", ML_PLY_TYPE_INT32, 4 },
+  { "uint", ML_PLY_TYPE_UINT32, 4 },
+  { "uint32", ML_PLY_TYPE_UINT32, 4 },
+  { "float", ML_PLY_TYPE_FLOAT32, 4 },
+  { "float32", ML_PLY_TYPE_FLOAT32, 4 },
+  { "double", ML_PLY_TYPE_FLOAT64, 8 },
+  { "float64", ML_PLY_TYPE_FLOAT64, 8 }
+};
+
+static const int mlPlyTypeSize[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+
+/* Copy the next word of a header line, returns 0 if there was none */
+static int mlPlyWord( const char **sp, const char *end, char *word )
+{
+  int len;
+  const char *s;
+  s = mlSkipSpace( *sp, end );
+  for( len = 0 ; ( s < end ) && !( mlIsSpace( *s ) ) && ( *s != '\n' ) ; s++ )
+  {
+    if( len < ML_PLY_NAME_SIZE - 1 )
+      word[len++] = *s;
+  }
+  word[len] = 0;
+  *sp = s;
+  return ( len != 0 );
+}
+
+static int mlPlyType( const char *word )
+{
+  int index;
+  for( index = 0 ; index < (int)( sizeof(mlPlyTypeList) / sizeof(mlPlyTypeList[0]) ) ; index++ )
+  {
+    if( !( strcmp( word, mlPlyTypeList[index].name ) ) )
+      return mlPlyTypeList[index].type;
+  }
+  return ML_PLY_TYPE_NONE;
+}
+
+static int mlPlyParseHeader( mlLoader *loader )
+{
+  int index;
+  long count;
+  char word[ML_PLY_NAME_SIZE];
+  const char *s, *next, *end;
+  mlPly *ply;
+  mlPlyElement *element;
+  mlPlyProperty *property;
+
+  ply = &loader->ply;
+  memset( ply, 0, sizeof(mlPly) );
+  end = loader->data + loader->size;
+  element = 0;
+  s = mlNextLine( loader->data, end );
+  for( ; ; s = next )
+  {
+    if( s >= end )
+      return 0;
+    next = mlNextLine( s, end );
+    if( !( mlPlyWord( &s, next, word ) ) )
+      continue;
+    if( !( strcmp( word, "format" ) ) )
+    {
+      mlPlyWord( &s, next, word );
+      if( !( strcmp( word, "ascii" ) ) )
+        ply->format = ML_PLY_ASCII;
+      else if( !( strcmp( word, "binary_little_endian" ) ) )
+        ply->format = ML_PLY_BINARY_LE;
+      else if( !( strcmp( word, "binary_big_endian" ) ) )
+        ply->format = ML_PLY_BINARY_BE;
+      else
+        return 0;
+    }
+    else if( !( strcmp( word, "element" ) ) )
+    {
+      if( ply->elementcount >= ML_PLY_ELEMENT_MAX )
+        return 0;
+      element = &ply->element[ ply->elementcount++ ];
+      mlPlyWord( &s, next, element->name );
+      s = mlSkipSpace( s, next );
+      if( !( mlParseInt( &s, next, &count ) ) || ( count < 0 ) )
+        return 0;
+      element->count = (size_t)count;
+    }
+    else if( !( strcmp( word, "property" ) ) )
+    {
+      if( !( element ) || ( element->propertycount >= ML_PLY_PROPERTY_MAX ) )
+        return 0;
+      property = &element->property[ element->propertycount++ ];
+      mlPlyWord( &s, next, word );
+      if( !( strcmp( word, "list" ) ) )
+      {
+        mlPlyWord( &s, next, word );
+        property->counttype = mlPlyType( word );
+        mlPlyWord( &s, next, word );
+        property->type = mlPlyType( word );
+        if( ( property->counttype == ML_PLY_TYPE_NONE ) || ( property->counttype == ML_PLY_TYPE_FLOAT32 ) || ( property->counttype == ML_PLY_TYPE_FLOAT64 ) )
+          return 0;
+      }
+      else
+        property->type = mlPlyType( word );
+      if( property->type == ML_PLY_TYPE_NONE )
+        return 0;
+      mlPlyWord( &s, next, property->name );
+    }
+    else if( !( strcmp( word, "end_header" ) ) )
+      break;
+  }
+  ply->bodyoffset = next - loader->data;
+
+  /* Find vertex positions and face indices, compute layout of fixed size records */
+  for( index = 0 ; index < ply->elementcount ; index++ )
+  {
+    element = &ply->element[index];
+    element->recordsize = 0;
+    for( count = 0 ; count < element->propertycount ; count++ )
+    {
+      property = &element->property[count];
+      property->offset = element->recordsize;
+      if( property->counttype != ML_PLY_TYPE_NONE )
+        element->recordsize = SIZE_MAX;
+      else if( element->recordsize != SIZE_MAX )
+        element->recordsize += mlPlyTypeSize[ property->type ];
+    }
+    if( element->recordsize == SIZE_MAX )
+      element->recordsize = 0;
+    if( !( strcmp( element->name, "vertex" ) ) )
+      ply->vertex = element;
+    else if( !( strcmp( element->name, "face" ) ) )
+      ply->face = element;
+  }
+  if( !( ply->vertex ) )
+    return 0;
+  element = ply->vertex;
+  ply->xindex = ply->yindex = ply->zindex = -1;
+  for( index = 0 ; index < element->propertycount ; index++ )
+  {
+    property = &element->property[index];
+    if( property->counttype != ML_PLY_TYPE_NONE )
+      return 0;
+    if( !( strcmp( property->name, "x" ) ) )
+      ply->xindex = index;
+    else if( !( strcmp( property->name, "y" ) ) )
+      ply->yindex = index;
+    else if( !( strcmp( property->name, "z" ) ) )
+      ply->zindex = index;
+  }
+  if( ( ply->xindex < 0 ) || ( ply->yindex < 0 ) || ( ply->zindex < 0 ) )
+    return 0;
+  ply->px = &element->property[ ply->xindex ];
+  ply->py = &element->property[ ply->yindex ];
+  ply->pz = &element->property[ ply->zindex ];
+  ply->listindex = -1;
+  if( ply->face )
+  {
+    /* The face indices are the first list property, other properties must be scalars */
+    element = ply->face;
+    for( index = 0 ; index < element->propertycount ; index++ )
+    {
+      property = &element->property[index];
+      if( property->counttype == ML_PLY_TYPE_NONE )
+        continue;
+      if( ply->listindex >= 0 )
+        return 0;
+      ply->listindex = index;
+    }
+    if( ply->listindex < 0 )
+      return 0;
+    ply->plist = &element->property[ ply->listindex ];
+  }
+  return 1;
+}
+
+
+////
+
+
+static void mlPlyAsciiLineThread( mlLoader *loader, int threadindex )
+{
+  const char *s, *end;
+  mlChunk *chunk;
+  if( threadindex >= loader->chunkcount )
+    return;
+  chunk = &loader->chunk[threadindex];
+  end = chunk->end;
+  for( s = chunk->start ; s < end ; s = mlNextLine( s, end ) )
+    chunk->linecount++;
+  return;
+}
+
+/* Line range of chunk within element lines, returns 0 if none */
+static int mlPlyAsciiRange( mlChunk *chunk, mlPlyElement *element, size_t *linebase, size_t *linemax )
+{
+  *linebase = chunk->linebase;
+  *linemax = chunk->linebase + chunk->linecount;
+  if( *linebase < element->base )
+    *linebase = element->base;
+  if( *linemax > element->base + element->count )
+    *linemax = element->base + element->count;
+  return ( *linebase < *linemax );
+}
+
+/* Skip to the line of the chunk of index lineindex */
+static const char *mlPlyAsciiSeek( mlChunk *chunk, size_t lineindex )
+{
+  size_t line;
+  const char *s;
+  s = chunk->start;
+  for( line = chunk->linebase ; line < lineindex ; line++ )
+    s = mlNextLine( s, chunk->end );
+  return s;
+}
+
+static void mlPlyAsciiCountThread( mlLoader *loader, int threadindex )
+{
+  int propindex;
+  long count;
+  size_t line, linebase, linemax;
+  const char *s, *next;
+  mlChunk *chunk;
+  mlPly *ply;
+
+  if( threadindex >= loader->chunkcount )
+    return;
+  ply = &loader->ply;
+  chunk = &loader->chunk[threadindex];
+  if( !( ply->face ) || !( mlPlyAsciiRange( chunk, ply->face, &linebase, &linemax ) ) )
+    return;
+  s = mlPlyAsciiSeek( chunk, linebase );
+  for( line = linebase ; line < linemax ; line++, s = next )
+  {
+    next = mlNextLine( s, chunk->end );
+    s = mlSkipSpace( s, next );
+    for( propindex = 0 ; propindex < ply->listindex ; propindex++ )
+      s = mlSkipSpace( mlSkipToken( s, next ), next );
+    if( !( mlParseInt( &s, next, &count ) ) )
+    {
+      chunk->errorflag = 1;
+      return;
+    }
+    if( count >= 3 )
+      chunk->tricount += count - 2;
+  }
+  return;
+}
+
+static void mlPlyAsciiParseThread( mlLoader *loader, int threadindex )
+{
+  int propindex;
+  long count, corner, value;
+  size_t line, linebase, linemax, triindex, vertexcount;
+  uint32_t index, first, prev;
+  float v;
+  float *point;
+  const char *s, *next;
+  mlChunk *chunk;
+  mlPly *ply;
+  mlMesh *mesh;
+
+  if( threadindex >= loader->chunkcount )
+    return;
+  ply = &loader->ply;
+  mesh = loader->mesh;
+  chunk = &loader->chunk[threadindex];
+  vertexcount = mesh->vertexcount;
+
+  if( mlPlyAsciiRange( chunk, ply->vertex, &linebase, &linemax ) )
+  {
+    s = mlPlyAsciiSeek( chunk, linebase );
+    for( line = linebase ; line < linemax ; line++, s = next )
+    {
+      next = mlNextLine( s, chunk->end );
+      point = ADDRESS( mesh->vertex, ( line - ply->vertex->base ) * mesh->vertexstride );
+      s = mlSkipSpace( s, next );
+      for( propindex = 0 ; propindex < ply->vertex->propertycount ; propindex++ )
+      {
+        if( !( mlParseFloat( &s, next, &v ) ) )
+          goto error;
+        if( propindex == ply->xindex )
+          point[0] = v;
+        else if( propindex == ply->yindex )
+          point[1] = v;
+        else if( propindex == ply->zindex )
+          point[2] = v;
+        s = mlSkipSpace( s, next );
+      }
+    }
+  }
+
+  if( ( ply->face ) && mlPlyAsciiRange( chunk, ply->face, &linebase, &linemax ) )
+  {
+    triindex = chunk->tribase;
+    s = mlPlyAsciiSeek( chunk, linebase );
+    for( line = linebase ; line < linemax ; line++, s = next )
+    {
+      next = mlNextLine( s, chunk->end );
+      s = mlSkipSpace( s, next );
+      for( propindex = 0 ; propindex < ply->listindex ; propindex++ )
+        s = mlSkipSpace( mlSkipToken( s, next ), next );
+      if( !( mlParseInt( &s, next, &count ) ) )
+        goto error;
+      first = 0;
+      prev = 0;
+      for( corner = 0 ; corner < count ; corner++ )
+      {
+        s = mlSkipSpace( s, next );
+        if( !( mlParseInt( &s, next, &value ) ) || ( value < 0 ) || ( (size_t)value >= vertexcount ) )
+          goto error;
+        index = (uint32_t)value;
+        if( !( corner ) )
+          first = index;
+        else if( corner >= 2 )
+          mlStoreTriangle( mesh, triindex++, first, prev, index );
+        prev = index;
+      }
+    }
+  }
+  return;
+
+  error:
+  chunk->errorflag = 1;
+  return;
+}
+
+static int mlLoadPlyAscii( mlLoader *loader )
+{
+  int index;
+  size_t vertexcount, tricount, linebase;
+  mlPly *ply;
+
+  ply = &loader->ply;
+  mlSplitText( loader, loader->data + ply->bodyoffset, loader->data + loader->size );
+  mlParallel( loader, loader->chunkcount, mlPlyAsciiLineThread );
+  mlSumChunks( loader, &vertexcount, &tricount );
+  /* Each element takes one line per item */
+  linebase = 0;
+  for( index = 0 ; index < ply->elementcount ; index++ )
+  {
+    ply->element[index].base = linebase;
+    linebase += ply->element[index].count;
+  }
+  mlParallel( loader, loader->chunkcount, mlPlyAsciiCountThread );
+  if( !( mlSumChunks( loader, &vertexcount, &tricount ) ) )
+    return 0;
+  if( !( mlAllocArrays( loader->mesh, ply->vertex->count, tricount ) ) )
+    return 0;
+  mlParallel( loader, loader->chunkcount, mlPlyAsciiParseThread );
+  for( index = 0 ; index < loader->chunkcount ; index++ )
+  {
+    if( loader->chunk[index].errorflag )
+      return 0;
+  }
+  return 1;
+}
+
+
+////
+
+
+static inline void mlSwapBytes( unsigned char *dst, const unsigned char *src, int size, int swapflag )
+{
+  int index;
+  if( !( swapflag ) )
+    memcpy( dst, src, size );
+  else
+  {
+    for( index = 0 ; index < size ; index++ )
+      dst[index] = src[ size - 1 - index ];
+  }
+  return;
+}
+
+static double mlPlyReadValue( const char *src, int type, int swapflag )
+{
+  union
+  {
+    int8_t i8;
+    uint8_t u8;
+    int16_t i16;
+    uint16_t u16;
+    int32_t i32;
+    uint32_t u32;
+    float f;
+    double d;
+    unsigned char bytes[8];
+  } value;
+  mlSwapBytes( value.bytes, (const unsigned char *)src, mlPlyTypeSize[type], swapflag );
+  switch( type )
+  {
+    case ML_PLY_TYPE_INT8:
+      return (double)value.i8;
+    case ML_PLY_TYPE_UINT8:
+      return (double)value.u8;
+    case ML_PLY_TYPE_INT16:
+      return (double)value.i16;
+    case ML_PLY_TYPE_UINT16:
+      return (double)value.u16;
+    case ML_PLY_TYPE_INT32:
+      return (double)value.i32;
+    case ML_PLY_TYPE_UINT32:
+      return (double)value.u32;
+    case ML_PLY_TYPE_FLOAT32:
+      return (double)value.f;
+    case ML_PLY_TYPE_FLOAT64:
+      return value.d;
+    default:
+      break;
+  }
+  return 0.0;
+}
+
+/* Index values are converted through double, exact for all integer types up to 32 bits */
+static inline long mlPlyReadIndex( const char *src, int type, int swapflag )
+{
+  return (long)mlPlyReadValue( src, type, swapflag );
+}
+
+static void mlPlyBinaryVertexThread( mlLoader *loader, int threadindex )
+{
+  size_t vertexindex, vertexmax;
+  float *point;
+  const char *record;
+  mlPly *ply;
+  mlMesh *mesh;
+
+  ply = &loader->ply;
+  mesh = loader->mesh;
+  mlThreadRange( ply->vertex->count, loader->threadcount, threadindex, &vertexindex, &vertexmax );
+  record = loader->data + ply->vertex->base + ( vertexindex * ply->vertex->recordsize );
+  for( ; vertexindex < vertexmax ; vertexindex++, record += ply->vertex->recordsize )
+  {
+    point = ADDRESS( mesh->vertex, vertexindex * mesh->vertexstride );
+    point[0] = (float)mlPlyReadValue( record + ply->px->offset, ply->px->type, loader->swapflag );
+    point[1] = (float)mlPlyReadValue( record + ply->py->offset, ply->py->type, loader->swapflag );
+    point[2] = (float)mlPlyReadValue( record + ply->pz->offset, ply->pz->type, loader->swapflag );
+  }
+  return;
+}
+
+/* With all faces being triangles, face records are of fixed size ; check counts and indices, convert them unless used in place */
+static void mlPlyBinaryFaceThread( mlLoader *loader, int threadindex )
+{
+  int corner, countsize, indexsize;
+  long count, value;
+  size_t triindex, trimax, vertexcount;
+  uint32_t v[3];
+  const char *record, *list;
+  mlPly *ply;
+  mlMesh *mesh;
+  mlChunk *chunk;
+
+  ply = &loader->ply;
+  mesh = loader->mesh;
+  chunk = &loader->chunk[threadindex];
+  vertexcount = ply->vertex->count;
+  countsize = mlPlyTypeSize[ ply->plist->counttype ];
+  indexsize = mlPlyTypeSize[ ply->plist->type ];
+  mlThreadRange( ply->face->count, loader->threadcount, threadindex, &triindex, &trimax );
+  record = loader->data + ply->face->base + ( triindex * ply->face->recordsize );
+  for( ; triindex < trimax ; triindex++, record += ply->face->recordsize )
+  {
+    list = record + ply->plist->offset;
+    count = mlPlyReadIndex( list, ply->plist->counttype, loader->swapflag );
+    if( count != 3 )
+      goto error;
+    list += countsize;
+    for( corner = 0 ; corner < 3 ; corner++, list += indexsize )
+    {
+      value = mlPlyReadIndex( list, ply->plist->type, loader->swapflag );
+      if( ( value < 0 ) || ( (size_t)value >= vertexcount ) )
+        goto error;
+      v[corner] = (uint32_t)value;
+    }
+    if( !( mesh->zerocopyflags & ML_ZERO_COPY_INDICES ) )
+      mlStoreTriangle( mesh, triindex, v[0], v[1], v[2] );
+  }
+  return;
+
+  error:
+  chunk->errorflag = 1;
+  return;
+}
+
+/* Walk records of variable size, returns offset past the element or 0 on error ; triangulate faces if storeflag is set */
+static size_t mlPlyBinaryWalk( mlLoader *loader, mlPlyElement *element, size_t offset, int storeflag )
+{
+  int propindex;
+  long count, corner, value;
+  size_t recordindex, triindex, vertexcount;
+  uint32_t index, first, prev;
+  mlPly *ply;
+  mlPlyProperty *property;
+  mlMesh *mesh;
+
+  ply = &loader->ply;
+  mesh = loader->mesh;
+  vertexcount = ply->vertex->count;
+  triindex = 0;
+  for( recordindex = 0 ; recordindex < element->count ; recordindex++ )
+  {
+    for( propindex = 0 ; propindex < element->propertycount ; propindex++ )
+    {
+      property = &element->property[propindex];
+      if( property->counttype == ML_PLY_TYPE_NONE )
+      {
+        offset += mlPlyTypeSize[ property->type ];
+        continue;
+      }
+      if( offset + mlPlyTypeSize[ property->counttype ] > loader->size )
+        return 0;
+      count = mlPlyReadIndex( loader->data + offset, property->counttype, loader->swapflag );
+      offset += mlPlyTypeSize[ property->counttype ];
+      if( ( count < 0 ) || ( offset + ( count * mlPlyTypeSize[ property->type ] ) > loader->size ) )
+        return 0;
+      if( ( storeflag ) && ( property == ply->plist ) )
+      {
+        first = 0;
+        prev = 0;
+        for( corner = 0 ; corner < count ; corner++ )
+        {
+          value = mlPlyReadIndex( loader->data + offset + ( corner * mlPlyTypeSize[ property->type ] ), property->type, loader->swapflag );
+          if( ( value < 0 ) || ( (size_t)value >= vertexcount ) )
+            return 0;
+          index = (uint32_t)value;
+          if( !( corner ) )
+            first = index;
+          else if( corner >= 2 )
+            mlStoreTriangle( mesh, triindex++, first, prev, index );
+          prev = index;
+        }
+      }
+      else if( ( property == ply->plist ) && ( count >= 3 ) )
+        triindex += count - 2;
+      offset += count * mlPlyTypeSize[ property->type ];
+    }
+    if( offset > loader->size )
+      return 0;
+  }
+  /* Without storing, count the triangles */
+  if( !( storeflag ) && ( element == ply->face ) )
+    mesh->tricount = triindex;
+  return offset;
+}
+
+static int mlLoadPlyBinary( mlLoader *loader )
+{
+  int index, facefixedflag, hostle;
+  size_t offset, trioffset;
+  uint32_t one;
+  mlPly *ply;
+  mlPlyElement *element;
+  mlMesh *mesh;
+
+  ply = &loader->ply;
+  mesh = loader->mesh;
+  one = 1;
+  hostle = ( *(unsigned char *)&one == 1 );
+  loader->swapflag = ( ( ply->format == ML_PLY_BINARY_LE ) != hostle );
+
+  /* Locate elements, faces are assumed to all be triangles for fixed size records, walked one at a time otherwise */
+  facefixedflag = 0;
+  offset = ply->bodyoffset;
+  for( index = 0 ; index < ply->elementcount ; index++ )
+  {
+    element = &ply->element[index];
+    element->base = offset;
+    if( element->recordsize )
+      offset += element->count * element->recordsize;
+    else if( ( element == ply->face ) && ( element->count ) && ( offset + ply->plist->offset + mlPlyTypeSize[ ply->plist->counttype ] <= loader->size ) && ( mlPlyReadIndex( loader->data + offset + ply->plist->offset, ply->plist->counttype, loader->swapflag ) == 3 ) )
+    {
+      element->recordsize = ply->plist->offset + mlPlyTypeSize[ ply->plist->counttype ] + ( 3 * mlPlyTypeSize[ ply->plist->type ] );
+      for( trioffset = ply->listindex + 1 ; trioffset < (size_t)element->propertycount ; trioffset++ )
+        element->recordsize += mlPlyTypeSize[ element->property[trioffset].type ];
+      offset += element->count * element->recordsize;
+      facefixedflag = 1;
+    }
+    else if( !( offset = mlPlyBinaryWalk( loader, element, offset, 0 ) ) )
+      return 0;
+    if( offset > loader->size )
+    {
+      if( !( facefixedflag ) || ( element != ply->face ) )
+        return 0;
+      /* Faces aren't all triangles after all */
+      facefixedflag = 0;
+      element->recordsize = 0;
+      if( !( offset = mlPlyBinaryWalk( loader, element, element->base, 0 ) ) )
+        return 0;
+    }
+    /* Elements past the faces are of no interest */
+    if( ( element == ply->face ) || ( ( element == ply->vertex ) && !( ply->face ) ) )
+      break;
+  }
+  if( ( ply->face ) && ( facefixedflag ) )
+    mesh->tricount = ply->face->count;
+  if( !( ply->face ) )
+    mesh->tricount = 0;
+
+  /* Vertices are used in place if already 3 consecutive floats of proper endianness and alignment */
+  mesh->vertexcount = ply->vertex->count;
+  if( !( loader->flags & ML_FLAGS_NO_ZERO_COPY ) && !( loader->swapflag ) && ( ply->px->type == ML_PLY_TYPE_FLOAT32 ) && ( ply->py->type == ML_PLY_TYPE_FLOAT32 ) && ( ply->pz->type == ML_PLY_TYPE_FLOAT32 ) && ( ply->py->offset == ply->px->offset + 4 ) && ( ply->pz->offset == ply->px->offset + 8 ) && !( ( (uintptr_t)loader->data + ply->vertex->base + ply->px->offset ) & 0x3 ) && !( ply->vertex->recordsize & 0x3 ) )
+  {
+    mesh->vertex = (void *)( loader->data + ply->vertex->base + ply->px->offset );
+    mesh->vertexstride = ply->vertex->recordsize;
+    mesh->zerocopyflags |= ML_ZERO_COPY_VERTEX;
+  }
+  else
+  {
+    mesh->vertexalloc = malloc( ( mesh->vertexcount ? mesh->vertexcount : 1 ) * 3 * sizeof(float) );
+    if( !( mesh->vertexalloc ) )
+      return 0;
+    mesh->vertex = mesh->vertexalloc;
+    mesh->vertexstride = 3 * sizeof(float);
+    mlParallel( loader, loader->threadcount, mlPlyBinaryVertexThread );
+  }
+
+  /* Same for indices, as 32 bits integers after the list count */
+  if( ( facefixedflag ) && !( loader->flags & ML_FLAGS_NO_ZERO_COPY ) && !( loader->swapflag ) && ( ( ply->plist->type == ML_PLY_TYPE_INT32 ) || ( ply->plist->type == ML_PLY_TYPE_UINT32 ) ) && !( ( (uintptr_t)loader->data + ply->face->base + ply->plist->offset + mlPlyTypeSize[ ply->plist->counttype ] ) & 0x3 ) && !( ply->face->recordsize & 0x3 ) )
+  {
+    mesh->indices = (void *)( loader->data + ply->face->base + ply->plist->offset + mlPlyTypeSize[ ply->plist->counttype ] );
+    mesh->indicesstride = ply->face->recordsize;
+    mesh->zerocopyflags |= ML_ZERO_COPY_INDICES;
+  }
+  else
+  {
+    mesh->indicesalloc = malloc( ( mesh->tricount ? mesh->tricount : 1 ) * 3 * sizeof(uint32_t) );
+    if( !( mesh->indicesalloc ) )
+      return 0;
+    mesh->indices = mesh->indicesalloc;
+    mesh->indicesstride = 3 * sizeof(uint32_t);
+  }
+  if( !( ply->face ) )
+    return 1;
+
+  /* Validate face records in parallel, even those used in place */
+  if( facefixedflag )
+  {
+    for( index = 0 ; index < loader->threadcount ; index++ )
+      loader->chunk[index].errorflag = 0;
+    loader->chunkcount = loader->threadcount;
+    mlParallel( loader, loader->threadcount, mlPlyBinaryFaceThread );
+    for( index = 0 ; index < loader->threadcount ; index++ )
+    {
+      if( loader->chunk[index].errorflag )
+        facefixedflag = 0;
+    }
+    if( facefixedflag )
+      return 1;
+    /* Not all triangles after all, or bad indices ; count again and walk the faces one at a time */
+    mesh->zerocopyflags &= ~ML_ZERO_COPY_INDICES;
+    free( mesh->indicesalloc );
+    mesh->indicesalloc = 0;
+    if( !( mlPlyBinaryWalk( loader, ply->face, ply->face->base, 0 ) ) )
+      return 0;
+    mesh->indicesalloc = malloc( ( mesh->tricount ? mesh->tricount : 1 ) * 3 * sizeof(uint32_t) );
+    if( !( mesh->indicesalloc ) )
+      return 0;
+    mesh->indices = mesh->indicesalloc;
+    mesh->indicesstride = 3 * sizeof(uint32_t);
+  }
+  return ( mlPlyBinaryWalk( loader, ply->face, ply->face->base, 1 ) != 0 );
+}
+
+static int mlLoadPly( mlLoader *loader )
+{
+  if( !( mlPlyParseHeader( loader ) ) )
+    return 0;
+  if( loader->ply.format == ML_PLY_ASCII )
+    return mlLoadPlyAscii( loader );
+  return mlLoadPlyBinary( loader );
+}
+
+
+////
+
+
+static inline void mlStlCorner( mlLoader *loader, size_t cornerindex, uint32_t *bits )
+{
+  int axis;
+  const char *src;
+  src = loader->cornerbase + ( ( cornerindex / 3 ) * loader->tristride ) + ( ( cornerindex % 3 ) * ( 3 * sizeof(float) ) );
+  for( axis = 0 ; axis < 3 ; axis++ )
+  {
+    mlSwapBytes( (unsigned char *)&bits[axis], (const unsigned char *)&src[ axis * sizeof(float) ], sizeof(float), loader->swapflag );
+    /* Weld -0.0 with 0.0 */
+    if( bits[axis] == 0x80000000 )
+      bits[axis] = 0;
+  }
+  return;
+}
+
+static inline uint32_t mlStlHash( uint32_t *bits )
+{
+  uint32_t hash;
+  hash = bits[0] * 0x9e3779b1;
+  hash = ( hash ^ ( hash >> 15 ) ) + ( bits[1] * 0x85ebca77 );
+  hash = ( hash ^ ( hash >> 13 ) ) + ( bits[2] * 0xc2b2ae3d );
+  hash ^= hash >> 16;
+  return hash;
+}
+
+/* Thread owning a hash value */
+static inline int mlStlHashOwner( uint32_t hash, int threadcount )
+{
+  return (int)( ( (uint64_t)hash * (uint64_t)threadcount ) >> 32 );
+}
+
+static void mlStlHashThread( mlLoader *loader, int threadindex )
+{
+  size_t cornerindex, cornermax;
+  uint32_t bits[3];
+  mlThreadRange( loader->cornercount, loader->threadcount, threadindex, &cornerindex, &cornermax );
+  for( ; cornerindex < cornermax ; cornerindex++ )
+  {
+    mlStlCorner( loader, cornerindex, bits );
+    loader->hashlist[cornerindex] = mlStlHash( bits );
+  }
+  return;
+}
+
+/* Each thread welds the corners of its range of hash values, each corner pointing to the first corner of equal position */
+static void mlStlWeldThread( mlLoader *loader, int threadindex )
+{
+  size_t cornerindex, ownedcount, tablesize, slot;
+  uint32_t hash, entry;
+  uint32_t bits[3], entrybits[3];
+  uint32_t *table, *cornerref;
+  mlChunk *chunk;
+
+  chunk = &loader->chunk[threadindex];
+  cornerref = loader->mesh->indices;
+  ownedcount = 0;
+  for( cornerindex = 0 ; cornerindex < loader->cornercount ; cornerindex++ )
+  {
+    if( mlStlHashOwner( loader->hashlist[cornerindex], loader->threadcount ) == threadindex )
+      ownedcount++;
+  }
+  for( tablesize = 64 ; tablesize < ( ownedcount << 1 ) ; tablesize <<= 1 );
+  table = malloc( tablesize * sizeof(uint32_t) );
+  if( !( table ) )
+  {
+    chunk->errorflag = 1;
+    return;
+  }
+  memset( table, 0xff, tablesize * sizeof(uint32_t) );
+  for( cornerindex = 0 ; cornerindex < loader->cornercount ; cornerindex++ )
+  {
+    hash = loader->hashlist[cornerindex];
+    if( mlStlHashOwner( hash, loader->threadcount ) != threadindex )
+      continue;
+    mlStlCorner( loader, cornerindex, bits );
+    for( slot = hash & ( tablesize - 1 ) ; ; slot = ( slot + 1 ) & ( tablesize - 1 ) )
+    {
+      entry = table[slot];
+      if( entry == 0xffffffff )
+      {
+        table[slot] = (uint32_t)cornerindex;
+        cornerref[cornerindex] = (uint32_t)cornerindex;
+        break;
+      }
+      if( loader->hashlist[entry] != hash )
+        continue;
+      mlStlCorner( loader, entry, entrybits );
+      if( ( bits[0] == entrybits[0] ) && ( bits[1] == entrybits[1] ) && ( bits[2] == entrybits[2] ) )
+      {
+        cornerref[cornerindex] = entry;
+        break;
+      }
+    }
+  }
+  free( table );
+  return;
+}
+
+/* Count the first corners of each position, they become vertices in corner order */
+static void mlStlCountThread( mlLoader *loader, int threadindex )
+{
+  size_t cornerindex, cornermax;
+  uint32_t *cornerref;
+  mlChunk *chunk;
+  chunk = &loader->chunk[threadindex];
+  cornerref = loader->mesh->indices;
+  mlThreadRange( loader->cornercount, loader->threadcount, threadindex, &cornerindex, &cornermax );
+  chunk->vertexcount = 0;
+  for( ; cornerindex < cornermax ; cornerindex++ )
+  {
+    if( cornerref[cornerindex] == cornerindex )
+      chunk->vertexcount++;
+  }
+  return;
+}
+
+/* Store vertices, their index is kept in hashlist for the corners referencing them */
+static void mlStlVertexThread( mlLoader *loader, int threadindex )
+{
+  size_t cornerindex, cornermax, vertexindex;
+  uint32_t bits[3];
+  uint32_t *cornerref;
+  float *point;
+  mlMesh *mesh;
+  mesh = loader->mesh;
+  cornerref = mesh->indices;
+  mlThreadRange( loader->cornercount, loader->threadcount, threadindex, &cornerindex, &cornermax );
+  vertexindex = loader->chunk[threadindex].vertexbase;
+  for( ; cornerindex < cornermax ; cornerindex++ )
+  {
+    if( cornerref[cornerindex] != cornerindex )
+      continue;
+    mlStlCorner( loader, cornerindex, bits );
+    point = ADDRESS( mesh->vertex, vertexindex * mesh->vertexstride );
+    memcpy( point, bits, 3 * sizeof(float) );
+    loader->hashlist[cornerindex] = (uint32_t)vertexindex;
+    vertexindex++;
+  }
+  return;
+}
+
+static void mlStlIndexThread( mlLoader *loader, int threadindex )
+{
+  size_t cornerindex, cornermax;
+  uint32_t *cornerref;
+  cornerref = loader->mesh->indices;
+  mlThreadRange( loader->cornercount, loader->threadcount, threadindex, &cornerindex, &cornermax );
+  for( ; cornerindex < cornermax ; cornerindex++ )
+    cornerref[cornerindex] = loader->hashlist[ cornerref[cornerindex] ];
+  return;
+}
+
+/* Without welding, each corner is its own vertex */
+static void mlStlCopyThread( mlLoader *loader, int threadindex )
+{
+  size_t cornerindex, cornermax;
+  uint32_t bits[3];
+  uint32_t *indices;
+  mlMesh *mesh;
+  mesh = loader->mesh;
+  indices = mesh->indices;
+  mlThreadRange( loader->cornercount, loader->threadcount, threadindex, &cornerindex, &cornermax );
+  for( ; cornerindex < cornermax ; cornerindex++ )
+  {
+    mlStlCorner( loader, cornerindex, bits );
+    memcpy( ADDRESS( mesh->vertex, cornerindex * mesh->vertexstride ), bits, 3 * sizeof(float) );
+    indices[cornerindex] = (uint32_t)cornerindex;
+  }
+  return;
+}
+
+static int mlStlBuild( mlLoader *loader )
+{
+  int index;
+  size_t vertexsum;
+  mlMesh *mesh;
+
+  mesh = loader->mesh;
+  if( loader->cornercount > 0xffffffff )
+    return 0;
+  mesh->tricount = loader->cornercount / 3;
+  mesh->indicesalloc = malloc( ( loader->cornercount ? loader->cornercount : 1 ) * sizeof(uint32_t) );
+  if( !( mesh->indicesalloc ) )
+    return 0;
+  mesh->indices = mesh->indicesalloc;
+  mesh->indicesstride = 3 * sizeof(uint32_t);
+
+  if( loader->flags & ML_FLAGS_NO_WELD )
+  {
+    mesh->vertexcount = loader->cornercount;
+    mesh->vertexalloc = malloc( ( mesh->vertexcount ? mesh->vertexcount : 1 ) * 3 * sizeof(float) );
+    if( !( mesh->vertexalloc ) )
+      return 0;
+    mesh->vertex = mesh->vertexalloc;
+    mesh->vertexstride = 3 * sizeof(float);
+    mlParallel( loader, loader->threadcount, mlStlCopyThread );
+    return 1;
+  }
+
+  /* Weld corners of bitwise equal positions, the indices array holds the reference to the first corner meanwhile */
+  loader->hashlist = malloc( ( loader->cornercount ? loader->cornercount : 1 ) * sizeof(uint32_t) );
+  if( !( loader->hashlist ) )
+    return 0;
+  for( index = 0 ; index < loader->threadcount ; index++ )
+    loader->chunk[index].errorflag = 0;
+  mlParallel( loader, loader->threadcount, mlStlHashThread );
+  mlParallel( loader, loader->threadcount, mlStlWeldThread );
+  mlParallel( loader, loader->threadcount, mlStlCountThread );
+  vertexsum = 0;
+  for( index = 0 ; index < loader->threadcount ; index++ )
+  {
+    if( loader->chunk[index].errorflag )
+      return 0;
+    loader->chunk[index].vertexbase = vertexsum;
+    vertexsum += loader->chunk[index].vertexcount;
+  }
+  mesh->vertexcount = vertexsum;
+  mesh->vertexalloc = malloc( ( vertexsum ? vertexsum : 1 ) * 3 * sizeof(float) );
+  if( !( mesh->vertexalloc ) )
+    return 0;
+  mesh->vertex = mesh->vertexalloc;
+  mesh->vertexstride = 3 * sizeof(float);
+  mlParallel( loader, loader->threadcount, mlStlVertexThread );
+  mlParallel( loader, loader->threadcount, mlStlIndexThread );
+  return 1;
+}
+
+
+static void mlStlAsciiCountThread( mlLoader *loader, int threadindex )
+{
+  const char *s, *next, *end;
+  mlChunk *chunk;
+  if( threadindex >= loader->chunkcount )
+    return;
+  chunk = &loader->chunk[threadindex];
+  end = chunk->end;
+  for( s = chunk->start ; s < end ; s = next )
+  {
+    next = mlNextLine( s, end );
+    s = mlSkipSpace( s, next );
+    if( ( next - s > 6 ) && !( memcmp( s, "vertex", 6 ) ) && mlIsSpace( s[6] ) )
+      chunk->vertexcount++;
+  }
+  return;
+}
+
+static void mlStlAsciiParseThread( mlLoader *loader, int threadindex )
+{
+  int axis;
+  float *point;
+  const char *s, *next, *end;
+  mlChunk *chunk;
+  if( threadindex >= loader->chunkcount )
+    return;
+  chunk = &loader->chunk[threadindex];
+  end = chunk->end;
+  point = &loader->cornerlist[ chunk->vertexbase * 3 ];
+  for( s = chunk->start ; s < end ; s = next )
+  {
+    next = mlNextLine( s, end );
+    s = mlSkipSpace( s, next );
+    if( !( ( next - s > 6 ) && !( memcmp( s, "vertex", 6 ) ) && mlIsSpace( s[6] ) ) )
+      continue;
+    s += 6;
+    for( axis = 0 ; axis < 3 ; axis++ )
+    {
+      s = mlSkipSpace( s, next );
+      if( !( mlParseFloat( &s, next, &point[axis] ) ) )
+      {
+        chunk->errorflag = 1;
+        return;
+      }
+    }
+    point += 3;
+  }
+  return;
+}
+
+static int mlLoadStl( mlLoader *loader )
+{
+  uint32_t tricount, one;
+  size_t vertexcount, unused;
+
+  /* Binary if the size matches the triangle count, some binary files start with "solid" too */
+  if( loader->size >= 84 )
+  {
+    one = 1;
+    loader->swapflag = ( *(unsigned char *)&one != 1 );
+    mlSwapBytes( (unsigned char *)&tricount, (const unsigned char *)loader->data + 80, sizeof(uint32_t), loader->swapflag );
+    if( 84 + ( (size_t)tricount * 50 ) == loader->size )
+    {
+      loader->cornerbase = loader->data + 84 + 12;
+      loader->cornercount = (size_t)tricount * 3;
+      loader->tristride = 50;
+      return mlStlBuild( loader );
+    }
+  }
+
+  /* ASCII, gather corners before welding */
+  if( ( loader->size < 5 ) || ( memcmp( loader->data, "solid", 5 ) ) )
+    return 0;
+  loader->swapflag = 0;
+  mlSplitText( loader, loader->data, loader->data + loader->size );
+  mlParallel( loader, loader->chunkcount, mlStlAsciiCountThread );
+  if( !( mlSumChunks( loader, &vertexcount, &unused ) ) )
+    return 0;
+  vertexcount -= vertexcount % 3;
+  loader->cornerlist = malloc( ( vertexcount ? vertexcount : 1 ) * 3 * sizeof(float) + ( 3 * 3 * sizeof(float) ) );
+  if( !( loader->cornerlist ) )
+    return 0;
+  mlParallel( loader, loader->chunkcount, mlStlAsciiParseThread );
+  if( !( mlSumChunks( loader, &unused, &unused ) ) )
+    return 0;
+  loader->cornerbase = (const char *)loader->cornerlist;
+  loader->cornercount = vertexcount;
+  loader->tristride = 3 * 3 * sizeof(float);
+  return mlStlBuild( loader );
+}
+
+
+////
+
+
+static int mlHasExtension( const char *path, const char *ext )
+{
+  size_t pathlen, extlen;
+  const char *s;
+  pathlen = strlen( path );
+  extlen = strlen( ext );
+  if( pathlen <= extlen )
+    return 0;
+  for( s = &path[ pathlen - extlen ] ; *ext ; s++, ext++ )
+  {
+    if( ( ( *s >= 'A' ) && ( *s <= 'Z' ) ? *s + ( 'a' - 'A' ) : *s ) != *ext )
+      return 0;
+  }
+  return 1;
+}
+
+static int mlDetectFormat( mlLoader *loader, const char *path )
+{
+  if( mlHasExtension( path, ".obj" ) )
+    return ML_FILE_OBJ;
+  if( mlHasExtension( path, ".ply" ) )
+    return ML_FILE_PLY;
+  if( mlHasExtension( path, ".stl" ) )
+    return ML_FILE_STL;
+  if( ( loader->size >= 4 ) && !( memcmp( loader->data, "ply", 3 ) ) && ( ( loader->data[3] == '\n' ) || ( loader->data[3] == '\r' ) ) )
+    return ML_FILE_PLY;
+  if( ( loader->size >= 84 ) || ( ( loader->size >= 5 ) && !( memcmp( loader->data, "solid", 5 ) ) ) )
+    return ML_FILE_STL;
+  return ML_FILE_OBJ;
+}
+
+
+int mlMeshLoad( mlMesh *mesh, const char *path, int fileformat, int threadcount, int flags )
+{
+  int retval;
+  long msecs;
+  mlLoader *loader;
+
+  mmInit();
+  memset( mesh, 0, sizeof(mlMesh) );
+  msecs = (long)mmGetMillisecondsTime();
+  if( threadcount <= 0 )
+    threadcount = ( mmcore.cpucount > 0 ? mmcore.cpucount : 1 );
+  if( threadcount > ML_THREAD_COUNT_MAX )
+    threadcount = ML_THREAD_COUNT_MAX;
+  if( !( mlMapFile( mesh, path ) ) )
+    return 0;
+
+  loader = malloc( sizeof(mlLoader) );
+  if( !( loader ) )
+  {
+    mlMeshFree( mesh );
+    return 0;
+  }
+  memset( loader, 0, sizeof(mlLoader) );
+  loader->mesh = mesh;
+  loader->data = mesh->mapaddress;
+  loader->size = mesh->mapsize;
+  loader->threadcount = threadcount;
+  loader->flags = flags;
+
+  if( fileformat == ML_FILE_AUTO )
+    fileformat = mlDetectFormat( loader, path );
+  mesh->fileformat = fileformat;
+  retval = 0;
+  if( fileformat == ML_FILE_OBJ )
+    retval = mlLoadObj( loader );
+  else if( fileformat == ML_FILE_PLY )
+    retval = mlLoadPly( loader );
+  else if( fileformat == ML_FILE_STL )
+    retval = mlLoadStl( loader );
+
+  free( loader->hashlist );
+  free( loader->cornerlist );
+  free( loader );
+  /* Release the mapping if nothing points into it */
+  if( ( retval ) && !( mesh->zerocopyflags ) )
+    mlUnmapFile( mesh );
+  if( !( retval ) )
+    mlMeshFree( mesh );
+  mesh->msecs = (long)mmGetMillisecondsTime() - msecs;
+  return retval;
+}
+
+void mlMeshFree( mlMesh *mesh )
+{
+  free( mesh->vertexalloc );
+  free( mesh->indicesalloc );
+  mlUnmapFile( mesh );
+  mesh->vertexalloc = 0;
+  mesh->indicesalloc = 0;
+  mesh->vertex = 0;
+  mesh->indices = 0;
+  mesh->vertexcount = 0;
+  mesh->tricount = 0;
+  mesh->zerocopyflags = 0;
+  return;
+}
@@ -1332,6 +1332,34 @@ void MM_FUNC(BlockFreeAll)( mmBlockHead *head MM_PARAMS )
 }
 
 
+/**
+ * Release all chunks of memory allocated from a block head.
+ *
+ * Unlike mmBlockFreeAll(), the memory blocks are kept and the block head
+ * remains initialized, ready to allocate chunks again.
+ */
+void MM_FUNC(BlockReleaseAll)( mmBlockHead *head MM_PARAMS )
+{
+  int a, chunkcount;
+  mmBlock *block;
+  void *chunk;
+  mtSpinLock( &head->spinlock );
+  head->freelist = 0;
+  head->chunkfreecount = 0;
+  for( block = head->blocklist ; block ; block = block->listnode.next )
+  {
+    chunkcount = block->blockwidth * head->chunkperblock;
+    block->freecount = chunkcount;
+    chunk = ADDRESS( block, sizeof(mmBlock) );
+    for( a = 0 ; a < chunkcount ; a++, chunk = ADDRESS( chunk, head->chunksize ) )
+      mmListAdd( &head->freelist, chunk, 0 );
+    head->chunkfreecount += chunkcount;
+  }
+  mtSpinUnlock( &head->spinlock );
+  return;
+}
+
+
 void MM_FUNC(BlockProcessList)( mmBlockHead *head, void *userpointer, int (*processchunk)( void *chunk, void *userpointer ) MM_PARAMS )
 {
   int i, blockcount, blockrefsize, chunkperblock, chuckcount, blockwidth;
@@ -524,6 +524,7 @@ void MM_FUNC(BlockLockRelease)( mmBlockHead *head, void *v MM_PARAMS );
 void MM_FUNC(BlockFree)( mmBlockHead *head, void *v MM_PARAMS );
 void MM_FUNC(BlockLockFree)( mmBlockHead *head, void *v MM_PARAMS );
 void MM_FUNC(BlockFreeAll)( mmBlockHead *head MM_PARAMS );
+void MM_FUNC(BlockReleaseAll)( mmBlockHead *head MM_PARAMS );
 void MM_FUNC(BlockProcessList)( mmBlockHead *head, void *userpointer, int (*processchunk)( void *chunk, void *userpointer ) MM_PARAMS );
 int MM_FUNC(BlockUseCount)( mmBlockHead *head MM_PARAMS );
 int MM_FUNC(BlockFreeCount)( mmBlockHead *head MM_PARAMS );
@@ -538,6 +539,7 @@ int MM_FUNC(BlockFreeCount)( mmBlockHead *head MM_PARAMS );
  #define mmBlockFree(x,y) MM_FUNC(BlockFree)(x,y,__FILE__,__LINE__)
  #define mmBlockLockFree(x,y) MM_FUNC(BlockLockFree)(x,y,__FILE__,__LINE__)
  #define mmBlockFreeAll(x) MM_FUNC(BlockFreeAll)(x,__FILE__,__LINE__)
+ #define mmBlockReleaseAll(x) MM_FUNC(BlockReleaseAll)(x,__FILE__,__LINE__)
  #define mmBlockProcessList(x,y,z) MM_FUNC(BlockProcessList)(x,y,z,__FILE__,__LINE__)
  #define mmBlockUseCount(x) MM_FUNC(BlockProcessList)(x,__FILE__,__LINE__)
  #define mmBlockFreeCount(x) MM_FUNC(BlockProcessList)(x,__FILE__,__LINE__)
@@ -794,6 +796,34 @@ static inline uint64_t mmGetNanosecondsTime()
 }
 
 
+/* Cheap timestamp for profiling short code paths, in cycles of the timestamp counter, or nanoseconds if not available */
+#if ( MM_ARCH_AMD64 || MM_ARCH_IA32 ) && defined(_MSC_VER)
+ #include <intrin.h>
+static inline uint64_t mmReadCycleCounter()
+{
+  return (uint64_t)__rdtsc();
+}
+#elif ( MM_ARCH_AMD64 || MM_ARCH_IA32 ) && defined(__GNUC__)
+ #include <x86intrin.h>
+static inline uint64_t mmReadCycleCounter()
+{
+  return (uint64_t)__rdtsc();
+}
+#elif MM_ARCH_ARM64 && defined(__GNUC__)
+static inline uint64_t mmReadCycleCounter()
+{
+  uint64_t value;
+  __asm__ __volatile__( "mrs %0, cntvct_el0" : "=r" (value) );
+  return value;
+}
+#else
+static inline uint64_t mmReadCycleCounter()
+{
+  return mmGetNanosecondsTime();
+}
+#endif
+
+
 ////
 
 
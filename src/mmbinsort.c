@@ -169,6 +169,37 @@ void mmBinSortFree( mmBinSort *binsort )
 }
 
 
+/* Remove all items and set a new range, keeping the memory allocated for reuse */
+void mmBinSortReset( mmBinSort *binsort, double rootmin, double rootmax, int bucketmaxsize )
+{
+  int bucketindex;
+  mmBinSortGroup *group;
+  mmBinSortBucket *bucket;
+
+  mmBlockReleaseAll( &binsort->bucketblock );
+  mmBlockReleaseAll( &binsort->groupblock );
+
+  binsort->bucketmaxsize = bucketmaxsize;
+  binsort->collapsethreshold = bucketmaxsize >> 2;
+
+  group = &binsort->root;
+  group->groupbase = rootmin;
+  group->groupmax = rootmax;
+  group->bucketrange = ( rootmax - rootmin ) / (double)binsort->rootbucketcount;
+  group->bucketmax = binsort->rootbucketcount - 1;
+  bucket = group->bucket;
+  for( bucketindex = 0 ; bucketindex < binsort->rootbucketcount ; bucketindex++ )
+  {
+    bucket->flags = 0;
+    bucket->itemcount = 0;
+    bucket->p = 0;
+    bucket++;
+  }
+
+  return;
+}
+
+
 static int MM_NOINLINE mmBinSortBucketIndex( mmBinSortGroup *group, mmbsf value )
 {
   int bucketindex = (int)mmbsffloor( ( value - group->groupbase ) / group->bucketrange );
@@ -28,6 +28,7 @@ typedef struct mmBinSort mmBinSort;
 
 mmBinSort *mmBinSortInit( size_t itemlistoffset, int rootbucketcount, int groupbucketcount, double rootmin, double rootmax, int bucketmaxsize, double (*itemvaluecallback)( void *item ), int maxdepth, int numanodeindex );
 void mmBinSortFree( mmBinSort *binsort );
+void mmBinSortReset( mmBinSort *binsort, double rootmin, double rootmax, int bucketmaxsize );
 
 void mmBinSortAdd( mmBinSort *binsort, void *item, double itemvalue );
 void mmBinSortRemove( mmBinSort *binsort, void *item, double itemvalue );
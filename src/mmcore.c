@@ -57,6 +57,10 @@
  #include <sched.h>
 #endif
 
+#if defined(_MSC_VER)
+ #include <immintrin.h>
+#endif
+
 #include "mm.h"
 
 
@@ -486,6 +490,67 @@ static int mmGetCpuid( uint32_t level, uint32_t index, uint32_t *eax, uint32_t *
 }
 
 
+/* Read the XCR0 register, the state components enabled by the OS for XSAVE */
+static uint64_t mmGetXcr0()
+{
+#if defined(__GNUC__) && ( MM_ARCH_AMD64 || MM_ARCH_IA32 )
+  uint32_t eax, edx;
+  asm( ".byte 0x0f, 0x01, 0xd0" /* xgetbv */
+    : "=a" (eax), "=d" (edx)
+    : "c" (0) );
+  return ( (uint64_t)edx << 32 ) | eax;
+#elif defined(_MSC_VER)
+  return _xgetbv( 0 );
+#else
+  return 0;
+#endif
+}
+
+
+static void cpuGetIsa( int intellevel )
+{
+  uint32_t eax, ebx, ecx, edx;
+  uint64_t xcr0;
+
+  mmcore.cpuid.isaflags = 0;
+  if( ( intellevel < 0x00000001 ) || ( intellevel > 0x0000ffff ) )
+    return;
+  mmGetCpuid( 0x00000001, 0, &eax, &ebx, &ecx, &edx );
+  if( edx & ( 1 << 26 ) )
+    mmcore.cpuid.isaflags |= MM_CPUID_ISA_SSE2;
+  if( ecx & ( 1 << 0 ) )
+    mmcore.cpuid.isaflags |= MM_CPUID_ISA_SSE3;
+  if( ecx & ( 1 << 9 ) )
+    mmcore.cpuid.isaflags |= MM_CPUID_ISA_SSSE3;
+  if( ecx & ( 1 << 19 ) )
+    mmcore.cpuid.isaflags |= MM_CPUID_ISA_SSE4_1;
+
+  /* AVX registers are only usable if the OS saves the YMM state (OSXSAVE, then XCR0 bits 1 and 2) */
+  if( !( ecx & ( 1 << 27 ) ) )
+    return;
+  xcr0 = mmGetXcr0();
+  if( ( xcr0 & 0x6 ) != 0x6 )
+    return;
+  if( ecx & ( 1 << 28 ) )
+    mmcore.cpuid.isaflags |= MM_CPUID_ISA_AVX;
+  if( ecx & ( 1 << 12 ) )
+    mmcore.cpuid.isaflags |= MM_CPUID_ISA_FMA;
+  if( intellevel < 0x00000007 )
+    return;
+  mmGetCpuid( 0x00000007, 0, &eax, &ebx, &ecx, &edx );
+  if( ebx & ( 1 << 5 ) )
+    mmcore.cpuid.isaflags |= MM_CPUID_ISA_AVX2;
+  /* AVX-512 also requires the opmask and ZMM states, XCR0 bits 5 to 7 */
+  if( ( xcr0 & 0xe0 ) != 0xe0 )
+    return;
+  if( ebx & ( 1 << 16 ) )
+    mmcore.cpuid.isaflags |= MM_CPUID_ISA_AVX512F;
+  if( ebx & ( (uint32_t)1 << 31 ) )
+    mmcore.cpuid.isaflags |= MM_CPUID_ISA_AVX512VL;
+  return;
+}
+
+
 static void cpuGetCores( int intellevel, int amdlevel )
 {
   uint32_t eax, ebx, ecx, edx;
@@ -693,6 +758,7 @@ static void mmCpuidInit()
       *c = 0;
   }
 
+  cpuGetIsa( intellevel );
   cpuGetCores( intellevel, amdlevel );
   cpuGetCacheOld( intellevel, amdlevel );
   cpuGetCacheNew( intellevel, amdlevel );
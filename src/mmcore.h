@@ -61,6 +61,8 @@ typedef struct
   int socketlogicalcores;
   char vendorstring[12+1];
   char identifier[48+1];
+  /* Instruction set extensions usable by the CPU and enabled by the OS, MM_CPUID_ISA_* bits */
+  uint32_t isaflags;
 } mmCoreCpuid;
 
 typedef struct
@@ -106,6 +108,16 @@ enum
   MM_CPUID_VENDOR_UNKNOWN
 };
 
+#define MM_CPUID_ISA_SSE2 (0x1)
+#define MM_CPUID_ISA_SSE3 (0x2)
+#define MM_CPUID_ISA_SSSE3 (0x4)
+#define MM_CPUID_ISA_SSE4_1 (0x8)
+#define MM_CPUID_ISA_AVX (0x10)
+#define MM_CPUID_ISA_FMA (0x20)
+#define MM_CPUID_ISA_AVX2 (0x40)
+#define MM_CPUID_ISA_AVX512F (0x80)
+#define MM_CPUID_ISA_AVX512VL (0x100)
+
 
 
 ////
@@ -57,6 +57,16 @@ static void mmHashSetBounds( mmHashTable *table )
   return;
 }
 
+/* Account for one access that skipped probelength entries before a match or a free entry */
+static inline void mmHashStatAccess( mmHashStatistics *stat, mmHashIndex probelength )
+{
+  stat->accesscount++;
+  stat->probecount += (long)probelength;
+  if( (long)probelength > stat->probemax )
+    stat->probemax = (long)probelength;
+  return;
+}
+
 
 size_t mmHashRequiredSize( size_t entrysize, size_t hashsize, uint32_t pageshift )
 {
@@ -138,12 +148,6 @@ void mmHashInit( void *hashtable, const mmHashAccess *access, size_t entrysize,
   mtMutexInit( &table->globalmutex );
 #endif
 
-  mmHashResetStatistics( hashtable );
-#if MM_HASH_DEBUG_STATISTICS
-  table->statentrycountmax = 0;
-  mmAtomicWriteL( &table->statentrycount, 0 );
-#endif
-
   return;
 }
 
@@ -209,10 +213,6 @@ void *mmHashDirectFindEntry( void *hashtable, const mmHashAccess *access, void *
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = access->entrykey( table->context, findentry );
   if( table->flags & MM_HASH_FLAGS_HASHSIZE_ISPOW2 )
@@ -229,9 +229,6 @@ void *mmHashDirectFindEntry( void *hashtable, const mmHashAccess *access, void *
       break;
     else if( cmpvalue == MM_HASH_ENTRYCMP_FOUND )
       return entry;
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
@@ -241,16 +238,14 @@ void *mmHashDirectFindEntry( void *hashtable, const mmHashAccess *access, void *
 }
 
 
-static int mmHashTryFindEntry( mmHashTable *table, const mmHashAccess *access, void *findentry, void **retentry )
+static int mmHashTryFindEntry( mmHashTable *table, const mmHashAccess *access, void *findentry, void **retentry, mmHashStatistics *stat )
 {
   mmHashIndex hashkey;
-  mmHashIndex pageindex, pagestart, pagefinal;
+  mmHashIndex pageindex, pagestart, pagefinal, probelength;
   int cmpvalue, retvalue;
   void *entry;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
+  probelength = 0;
 
   /* Hash key of entry */
   hashkey = access->entrykey( table->context, findentry );
@@ -293,14 +288,15 @@ static int mmHashTryFindEntry( mmHashTable *table, const mmHashAccess *access, v
     }
     else if( cmpvalue == MM_HASH_ENTRYCMP_FOUND )
       break;
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
+    probelength++;
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
   }
 
+  if( ( stat ) && ( retvalue != MM_HASH_TRYAGAIN ) )
+    mmHashStatAccess( stat, probelength );
+
   /* Unlock all pages */
   for( pageindex = pagestart ; ; pageindex = ( pageindex + 1 ) & table->pagemask )
   {
@@ -314,20 +310,24 @@ static int mmHashTryFindEntry( mmHashTable *table, const mmHashAccess *access, v
 }
 
 
-void *mmHashLockFindEntry( void *hashtable, const mmHashAccess *access, void *findentry )
+void *mmHashLockFindEntry( void *hashtable, const mmHashAccess *access, void *findentry, mmHashStatistics *stat )
 {
   int retvalue;
   void *entry;
   mmHashTable *table;
 
   table = hashtable;
-  retvalue = mmHashTryFindEntry( table, access, findentry, &entry );
+  retvalue = mmHashTryFindEntry( table, access, findentry, &entry, stat );
   if( retvalue == MM_HASH_TRYAGAIN )
   {
+    if( stat )
+      stat->globallockcount++;
     MM_HASH_GLOBAL_LOCK( table );
     do
     {
-      retvalue = mmHashTryFindEntry( table, access, findentry, &entry );
+      if( stat )
+        stat->pagelockfailcount++;
+      retvalue = mmHashTryFindEntry( table, access, findentry, &entry, stat );
     } while( retvalue == MM_HASH_TRYAGAIN );
     MM_HASH_GLOBAL_UNLOCK( table );
   }
@@ -350,10 +350,6 @@ void mmHashDirectListEntry( void *hashtable, const mmHashAccess *access, void *l
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = access->entrykey( table->context, listentry );
   if( table->flags & MM_HASH_FLAGS_HASHSIZE_ISPOW2 )
@@ -368,9 +364,6 @@ void mmHashDirectListEntry( void *hashtable, const mmHashAccess *access, void *l
     cmpvalue = access->entrylist( table->context, opaque, entry, listentry );
     if( cmpvalue == MM_HASH_ENTRYLIST_BREAK )
       break;
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
@@ -380,16 +373,14 @@ void mmHashDirectListEntry( void *hashtable, const mmHashAccess *access, void *l
 }
 
 
-static int mmHashTryListEntry( mmHashTable *table, const mmHashAccess *access, void *listentry, void *opaque )
+static int mmHashTryListEntry( mmHashTable *table, const mmHashAccess *access, void *listentry, void *opaque, mmHashStatistics *stat )
 {
   mmHashIndex hashkey;
-  mmHashIndex pageindex, pagestart, pagefinal;
+  mmHashIndex pageindex, pagestart, pagefinal, probelength;
   int cmpvalue, retvalue;
   void *entry;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
+  probelength = 0;
 
   /* Hash key of entry */
   hashkey = access->entrykey( table->context, listentry );
@@ -426,14 +417,15 @@ static int mmHashTryListEntry( mmHashTable *table, const mmHashAccess *access, v
     cmpvalue = access->entrylist( table->context, opaque, entry, listentry );
     if( cmpvalue == MM_HASH_ENTRYLIST_BREAK )
       break;
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
+    probelength++;
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
   }
 
+  if( ( stat ) && ( retvalue != MM_HASH_TRYAGAIN ) )
+    mmHashStatAccess( stat, probelength );
+
   /* Unlock all pages */
   for( pageindex = pagestart ; ; pageindex = ( pageindex + 1 ) & table->pagemask )
   {
@@ -446,19 +438,23 @@ static int mmHashTryListEntry( mmHashTable *table, const mmHashAccess *access, v
 }
 
 
-void mmHashLockListEntry( void *hashtable, const mmHashAccess *access, void *listentry, void *opaque )
+void mmHashLockListEntry( void *hashtable, const mmHashAccess *access, void *listentry, void *opaque, mmHashStatistics *stat )
 {
   int retvalue;
   mmHashTable *table;
 
   table = hashtable;
-  retvalue = mmHashTryListEntry( table, access, listentry, opaque );
+  retvalue = mmHashTryListEntry( table, access, listentry, opaque, stat );
   if( retvalue == MM_HASH_TRYAGAIN )
   {
+    if( stat )
+      stat->globallockcount++;
     MM_HASH_GLOBAL_LOCK( table );
     do
     {
-      retvalue = mmHashTryListEntry( table, access, listentry, opaque );
+      if( stat )
+        stat->pagelockfailcount++;
+      retvalue = mmHashTryListEntry( table, access, listentry, opaque, stat );
     } while( retvalue == MM_HASH_TRYAGAIN );
     MM_HASH_GLOBAL_UNLOCK( table );
   }
@@ -481,10 +477,6 @@ int mmHashDirectReadEntry( void *hashtable, const mmHashAccess *access, void *re
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = access->entrykey( table->context, readentry );
   if( table->flags & MM_HASH_FLAGS_HASHSIZE_ISPOW2 )
@@ -504,9 +496,6 @@ int mmHashDirectReadEntry( void *hashtable, const mmHashAccess *access, void *re
       memcpy( readentry, entry, table->entrysize );
       return MM_HASH_SUCCESS;
     }
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
@@ -516,10 +505,10 @@ int mmHashDirectReadEntry( void *hashtable, const mmHashAccess *access, void *re
 }
 
 
-static int mmHashTryReadEntry( mmHashTable *table, const mmHashAccess *access, void *readentry )
+static int mmHashTryReadEntry( mmHashTable *table, const mmHashAccess *access, void *readentry, mmHashStatistics *stat )
 {
   mmHashIndex hashkey;
-  mmHashIndex pageindex, pagestart, pagefinal;
+  mmHashIndex pageindex, pagestart, pagefinal, probelength;
   int cmpvalue, retvalue;
   void *entry;
 
@@ -530,9 +519,7 @@ static int mmHashTryReadEntry( mmHashTable *table, const mmHashAccess *access, v
   else
     hashkey %= table->hashsize;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
+  probelength = 0;
 
   /* Lock first page */
   pagestart = hashkey >> table->pageshift;
@@ -568,9 +555,7 @@ static int mmHashTryReadEntry( mmHashTable *table, const mmHashAccess *access, v
     }
     else if( cmpvalue == MM_HASH_ENTRYCMP_FOUND )
       break;
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
+    probelength++;
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
@@ -579,6 +564,9 @@ static int mmHashTryReadEntry( mmHashTable *table, const mmHashAccess *access, v
   if( entry )
     memcpy( readentry, entry, table->entrysize );
 
+  if( ( stat ) && ( retvalue != MM_HASH_TRYAGAIN ) )
+    mmHashStatAccess( stat, probelength );
+
   /* Unlock all pages */
   for( pageindex = pagestart ; ; pageindex = ( pageindex + 1 ) & table->pagemask )
   {
@@ -591,19 +579,23 @@ static int mmHashTryReadEntry( mmHashTable *table, const mmHashAccess *access, v
 }
 
 
-int mmHashLockReadEntry( void *hashtable, const mmHashAccess *access, void *readentry )
+int mmHashLockReadEntry( void *hashtable, const mmHashAccess *access, void *readentry, mmHashStatistics *stat )
 {
   int retvalue;
   mmHashTable *table;
 
   table = hashtable;
-  retvalue = mmHashTryReadEntry( table, access, readentry );
+  retvalue = mmHashTryReadEntry( table, access, readentry, stat );
   if( retvalue == MM_HASH_TRYAGAIN )
   {
+    if( stat )
+      stat->globallockcount++;
     MM_HASH_GLOBAL_LOCK( table );
     do
     {
-      retvalue = mmHashTryReadEntry( table, access, readentry );
+      if( stat )
+        stat->pagelockfailcount++;
+      retvalue = mmHashTryReadEntry( table, access, readentry, stat );
     } while( retvalue == MM_HASH_TRYAGAIN );
     MM_HASH_GLOBAL_UNLOCK( table );
   }
@@ -633,10 +625,6 @@ int mmHashDirectCallEntry( void *hashtable, const mmHashAccess *access, void *ca
   else
     hashkey %= table->hashsize;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Search an available entry */
   for( ; ; )
   {
@@ -649,9 +637,6 @@ int mmHashDirectCallEntry( void *hashtable, const mmHashAccess *access, void *ca
       callback( opaque, entry, 0 );
       return MM_HASH_SUCCESS;
     }
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
@@ -674,20 +659,14 @@ int mmHashDirectCallEntry( void *hashtable, const mmHashAccess *access, void *ca
       table->status = MM_HASH_STATUS_NORMAL;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  int statentrycount = mmAtomicAddReadL( &table->statentrycount, 1 );
-  if( statentrycount > table->statentrycountmax )
-    table->statentrycountmax = statentrycount;
-#endif
-
   return MM_HASH_SUCCESS;
 }
 
 
-static int mmHashTryCallEntry( mmHashTable *table, const mmHashAccess *access, void *callentry, void (*callback)( void *opaque, void *entry, int newflag ), void *opaque, int addflag )
+static int mmHashTryCallEntry( mmHashTable *table, const mmHashAccess *access, void *callentry, void (*callback)( void *opaque, void *entry, int newflag ), void *opaque, int addflag, mmHashStatistics *stat )
 {
   mmHashIndex hashkey, entrycount;
-  mmHashIndex pageindex, pagestart, pagefinal;
+  mmHashIndex pageindex, pagestart, pagefinal, probelength;
   int cmpvalue, retvalue;
   void *entry;
 
@@ -698,9 +677,7 @@ static int mmHashTryCallEntry( mmHashTable *table, const mmHashAccess *access, v
   else
     hashkey %= table->hashsize;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
+  probelength = 0;
 
   /* Lock first page */
   pagestart = hashkey >> table->pageshift;
@@ -735,9 +712,7 @@ static int mmHashTryCallEntry( mmHashTable *table, const mmHashAccess *access, v
       retvalue = MM_HASH_SUCCESS;
       goto end;
     }
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
+    probelength++;
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
@@ -763,14 +738,11 @@ static int mmHashTryCallEntry( mmHashTable *table, const mmHashAccess *access, v
       table->status = MM_HASH_STATUS_NORMAL;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  int statentrycount = mmAtomicAddReadL( &table->statentrycount, 1 );
-  if( statentrycount > table->statentrycountmax )
-    table->statentrycountmax = statentrycount;
-#endif
-
   end:
 
+  if( ( stat ) && ( retvalue != MM_HASH_TRYAGAIN ) )
+    mmHashStatAccess( stat, probelength );
+
   /* Unlock all pages */
   for( pageindex = pagestart ; ; pageindex = ( pageindex + 1 ) & table->pagemask )
   {
@@ -783,19 +755,23 @@ static int mmHashTryCallEntry( mmHashTable *table, const mmHashAccess *access, v
 }
 
 
-int mmHashLockCallEntry( void *hashtable, const mmHashAccess *access, void *callentry, void (*callback)( void *opaque, void *entry, int newflag ), void *opaque, int addflag )
+int mmHashLockCallEntry( void *hashtable, const mmHashAccess *access, void *callentry, void (*callback)( void *opaque, void *entry, int newflag ), void *opaque, int addflag, mmHashStatistics *stat )
 {
   int retvalue;
   mmHashTable *table;
 
   table = hashtable;
-  retvalue = mmHashTryCallEntry( table, access, callentry, callback, opaque, addflag );
+  retvalue = mmHashTryCallEntry( table, access, callentry, callback, opaque, addflag, stat );
   if( retvalue == MM_HASH_TRYAGAIN )
   {
+    if( stat )
+      stat->globallockcount++;
     MM_HASH_GLOBAL_LOCK( table );
     do
     {
-      retvalue = mmHashTryCallEntry( table, access, callentry, callback, opaque, addflag );
+      if( stat )
+        stat->pagelockfailcount++;
+      retvalue = mmHashTryCallEntry( table, access, callentry, callback, opaque, addflag, stat );
     } while( retvalue == MM_HASH_TRYAGAIN );
     MM_HASH_GLOBAL_UNLOCK( table );
   }
@@ -825,10 +801,6 @@ int mmHashDirectReplaceEntry( void *hashtable, const mmHashAccess *access, void
   else
     hashkey %= table->hashsize;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Search an available entry */
   for( ; ; )
   {
@@ -841,9 +813,6 @@ int mmHashDirectReplaceEntry( void *hashtable, const mmHashAccess *access, void
       memcpy( entry, replaceentry, table->entrysize );
       return MM_HASH_SUCCESS;
     }
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
@@ -865,20 +834,14 @@ int mmHashDirectReplaceEntry( void *hashtable, const mmHashAccess *access, void
       table->status = MM_HASH_STATUS_NORMAL;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  int statentrycount = mmAtomicAddReadL( &table->statentrycount, 1 );
-  if( statentrycount > table->statentrycountmax )
-    table->statentrycountmax = statentrycount;
-#endif
-
   return MM_HASH_SUCCESS;
 }
 
 
-static int mmHashTryReplaceEntry( mmHashTable *table, const mmHashAccess *access, void *replaceentry, int addflag )
+static int mmHashTryReplaceEntry( mmHashTable *table, const mmHashAccess *access, void *replaceentry, int addflag, mmHashStatistics *stat )
 {
   mmHashIndex hashkey, entrycount;
-  mmHashIndex pageindex, pagestart, pagefinal;
+  mmHashIndex pageindex, pagestart, pagefinal, probelength;
   int cmpvalue, retvalue;
   void *entry;
 
@@ -889,9 +852,7 @@ static int mmHashTryReplaceEntry( mmHashTable *table, const mmHashAccess *access
   else
     hashkey %= table->hashsize;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
+  probelength = 0;
 
   /* Lock first page */
   pagestart = hashkey >> table->pageshift;
@@ -926,9 +887,7 @@ static int mmHashTryReplaceEntry( mmHashTable *table, const mmHashAccess *access
       retvalue = MM_HASH_SUCCESS;
       goto end;
     }
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
+    probelength++;
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
@@ -953,14 +912,11 @@ static int mmHashTryReplaceEntry( mmHashTable *table, const mmHashAccess *access
       table->status = MM_HASH_STATUS_NORMAL;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  int statentrycount = mmAtomicAddReadL( &table->statentrycount, 1 );
-  if( statentrycount > table->statentrycountmax )
-    table->statentrycountmax = statentrycount;
-#endif
-
   end:
 
+  if( ( stat ) && ( retvalue != MM_HASH_TRYAGAIN ) )
+    mmHashStatAccess( stat, probelength );
+
   /* Unlock all pages */
   for( pageindex = pagestart ; ; pageindex = ( pageindex + 1 ) & table->pagemask )
   {
@@ -973,19 +929,23 @@ static int mmHashTryReplaceEntry( mmHashTable *table, const mmHashAccess *access
 }
 
 
-int mmHashLockReplaceEntry( void *hashtable, const mmHashAccess *access, void *replaceentry, int addflag )
+int mmHashLockReplaceEntry( void *hashtable, const mmHashAccess *access, void *replaceentry, int addflag, mmHashStatistics *stat )
 {
   int retvalue;
   mmHashTable *table;
 
   table = hashtable;
-  retvalue = mmHashTryReplaceEntry( table, access, replaceentry, addflag );
+  retvalue = mmHashTryReplaceEntry( table, access, replaceentry, addflag, stat );
   if( retvalue == MM_HASH_TRYAGAIN )
   {
+    if( stat )
+      stat->globallockcount++;
     MM_HASH_GLOBAL_LOCK( table );
     do
     {
-      retvalue = mmHashTryReplaceEntry( table, access, replaceentry, addflag );
+      if( stat )
+        stat->pagelockfailcount++;
+      retvalue = mmHashTryReplaceEntry( table, access, replaceentry, addflag, stat );
     } while( retvalue == MM_HASH_TRYAGAIN );
     MM_HASH_GLOBAL_UNLOCK( table );
   }
@@ -1008,10 +968,6 @@ int mmHashDirectAddEntry( void *hashtable, const mmHashAccess *access, void *add
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = access->entrykey( table->context, addentry );
   if( table->flags & MM_HASH_FLAGS_HASHSIZE_ISPOW2 )
@@ -1037,9 +993,6 @@ int mmHashDirectAddEntry( void *hashtable, const mmHashAccess *access, void *add
       if( !( access->entryvalid( table->context, entry ) ) )
         break;
     }
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
@@ -1058,20 +1011,67 @@ int mmHashDirectAddEntry( void *hashtable, const mmHashAccess *access, void *add
       table->status = MM_HASH_STATUS_NORMAL;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  int statentrycount = mmAtomicAddReadL( &table->statentrycount, 1 );
-  if( statentrycount > table->statentrycountmax )
-    table->statentrycountmax = statentrycount;
-#endif
+  return MM_HASH_SUCCESS;
+}
+
+
+mmHashIndex mmHashGetEntryIndex( void *hashtable, const mmHashAccess *access, void *entry )
+{
+  mmHashIndex hashkey;
+  mmHashTable *table;
+
+  table = hashtable;
+  hashkey = access->entrykey( table->context, entry );
+  if( table->flags & MM_HASH_FLAGS_HASHSIZE_ISPOW2 )
+    hashkey &= table->hashmask;
+  else
+    hashkey %= table->hashsize;
+
+  return hashkey;
+}
+
+
+int mmHashDirectAddEntryRange( void *hashtable, const mmHashAccess *access, void *addentry, mmHashIndex indexlimit )
+{
+  mmHashIndex hashkey, entrycount;
+  void *entry;
+  mmHashTable *table;
+
+  table = hashtable;
+  hashkey = mmHashGetEntryIndex( hashtable, access, addentry );
+
+  /* Search an available entry, without wrapping around past indexlimit */
+  for( ; ; )
+  {
+    entry = MM_HASH_ENTRY( table, hashkey );
+    if( !( access->entryvalid( table->context, entry ) ) )
+      break;
+    hashkey++;
+    if( hashkey >= indexlimit )
+      return MM_HASH_TRYAGAIN;
+  }
+
+  /* Store new entry */
+  memcpy( entry, addentry, table->entrysize );
+
+  /* Increment count of entries in table */
+  if( !( table->flags & MM_HASH_FLAGS_NO_COUNT ) )
+  {
+    entrycount = MM_HASH_ENTRYCOUNT_ADD_READ( table, 1 );
+    if( entrycount >= table->highcount )
+      table->status = MM_HASH_STATUS_MUSTGROW;
+    else if( table->status != MM_HASH_STATUS_NORMAL )
+      table->status = MM_HASH_STATUS_NORMAL;
+  }
 
   return MM_HASH_SUCCESS;
 }
 
 
-static int mmHashTryAddEntry( mmHashTable *table, const mmHashAccess *access, void *addentry, int nodupflag )
+static int mmHashTryAddEntry( mmHashTable *table, const mmHashAccess *access, void *addentry, int nodupflag, mmHashStatistics *stat )
 {
   mmHashIndex hashkey, entrycount;
-  mmHashIndex pageindex, pagestart, pagefinal;
+  mmHashIndex pageindex, pagestart, pagefinal, probelength;
   int cmpvalue, retvalue;
   void *entry;
 
@@ -1082,9 +1082,7 @@ static int mmHashTryAddEntry( mmHashTable *table, const mmHashAccess *access, vo
   else
     hashkey %= table->hashsize;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
+  probelength = 0;
 
   /* Lock first page */
   pagestart = hashkey >> table->pageshift;
@@ -1127,9 +1125,7 @@ static int mmHashTryAddEntry( mmHashTable *table, const mmHashAccess *access, vo
       if( !( access->entryvalid( table->context, entry ) ) )
         break;
     }
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
+    probelength++;
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
@@ -1148,14 +1144,11 @@ static int mmHashTryAddEntry( mmHashTable *table, const mmHashAccess *access, vo
       table->status = MM_HASH_STATUS_NORMAL;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  int statentrycount = mmAtomicAddReadL( &table->statentrycount, 1 );
-  if( statentrycount > table->statentrycountmax )
-    table->statentrycountmax = statentrycount;
-#endif
-
   end:
 
+  if( ( stat ) && ( retvalue != MM_HASH_TRYAGAIN ) )
+    mmHashStatAccess( stat, probelength );
+
   /* Unlock all pages */
   for( pageindex = pagestart ; ; pageindex = ( pageindex + 1 ) & table->pagemask )
   {
@@ -1169,19 +1162,23 @@ static int mmHashTryAddEntry( mmHashTable *table, const mmHashAccess *access, vo
 
 
 
-int mmHashLockAddEntry( void *hashtable, const mmHashAccess *access, void *addentry, int nodupflag )
+int mmHashLockAddEntry( void *hashtable, const mmHashAccess *access, void *addentry, int nodupflag, mmHashStatistics *stat )
 {
   int retvalue;
   mmHashTable *table;
 
   table = hashtable;
-  retvalue = mmHashTryAddEntry( table, access, addentry, nodupflag );
+  retvalue = mmHashTryAddEntry( table, access, addentry, nodupflag, stat );
   if( retvalue == MM_HASH_TRYAGAIN )
   {
+    if( stat )
+      stat->globallockcount++;
     MM_HASH_GLOBAL_LOCK( table );
     do
     {
-      retvalue = mmHashTryAddEntry( table, access, addentry, nodupflag );
+      if( stat )
+        stat->pagelockfailcount++;
+      retvalue = mmHashTryAddEntry( table, access, addentry, nodupflag, stat );
     } while( retvalue == MM_HASH_TRYAGAIN );
     MM_HASH_GLOBAL_UNLOCK( table );
   }
@@ -1204,10 +1201,6 @@ int mmHashDirectReadOrAddEntry( void *hashtable, const mmHashAccess *access, voi
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = access->entrykey( table->context, readaddentry );
   if( table->flags & MM_HASH_FLAGS_HASHSIZE_ISPOW2 )
@@ -1229,9 +1222,6 @@ int mmHashDirectReadOrAddEntry( void *hashtable, const mmHashAccess *access, voi
       *retreadflag = 1;
       return MM_HASH_SUCCESS;
     }
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
@@ -1250,20 +1240,14 @@ int mmHashDirectReadOrAddEntry( void *hashtable, const mmHashAccess *access, voi
       table->status = MM_HASH_STATUS_NORMAL;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  int statentrycount = mmAtomicAddReadL( &table->statentrycount, 1 );
-  if( statentrycount > table->statentrycountmax )
-    table->statentrycountmax = statentrycount;
-#endif
-
   return MM_HASH_SUCCESS;
 }
 
 
-static int mmHashTryReadOrAddEntry( mmHashTable *table, const mmHashAccess *access, void *readaddentry, int *retreadflag )
+static int mmHashTryReadOrAddEntry( mmHashTable *table, const mmHashAccess *access, void *readaddentry, int *retreadflag, mmHashStatistics *stat )
 {
   mmHashIndex hashkey, entrycount;
-  mmHashIndex pageindex, pagestart, pagefinal;
+  mmHashIndex pageindex, pagestart, pagefinal, probelength;
   int cmpvalue, retvalue;
   void *entry;
 
@@ -1274,9 +1258,7 @@ static int mmHashTryReadOrAddEntry( mmHashTable *table, const mmHashAccess *acce
   else
     hashkey %= table->hashsize;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
+  probelength = 0;
 
   /* Lock first page */
   pagestart = hashkey >> table->pageshift;
@@ -1314,9 +1296,7 @@ static int mmHashTryReadOrAddEntry( mmHashTable *table, const mmHashAccess *acce
       goto end;
     }
 
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
+    probelength++;
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
@@ -1335,14 +1315,11 @@ static int mmHashTryReadOrAddEntry( mmHashTable *table, const mmHashAccess *acce
       table->status = MM_HASH_STATUS_NORMAL;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  int statentrycount = mmAtomicAddReadL( &table->statentrycount, 1 );
-  if( statentrycount > table->statentrycountmax )
-    table->statentrycountmax = statentrycount;
-#endif
-
   end:
 
+  if( ( stat ) && ( retvalue != MM_HASH_TRYAGAIN ) )
+    mmHashStatAccess( stat, probelength );
+
   /* Unlock all pages */
   for( pageindex = pagestart ; ; pageindex = ( pageindex + 1 ) & table->pagemask )
   {
@@ -1356,19 +1333,23 @@ static int mmHashTryReadOrAddEntry( mmHashTable *table, const mmHashAccess *acce
 
 
 
-int mmHashLockReadOrAddEntry( void *hashtable, const mmHashAccess *access, void *readaddentry, int *retreadflag )
+int mmHashLockReadOrAddEntry( void *hashtable, const mmHashAccess *access, void *readaddentry, int *retreadflag, mmHashStatistics *stat )
 {
   int retvalue;
   mmHashTable *table;
 
   table = hashtable;
-  retvalue = mmHashTryReadOrAddEntry( table, access, readaddentry, retreadflag );
+  retvalue = mmHashTryReadOrAddEntry( table, access, readaddentry, retreadflag, stat );
   if( retvalue == MM_HASH_TRYAGAIN )
   {
+    if( stat )
+      stat->globallockcount++;
     MM_HASH_GLOBAL_LOCK( table );
     do
     {
-      retvalue = mmHashTryReadOrAddEntry( table, access, readaddentry, retreadflag );
+      if( stat )
+        stat->pagelockfailcount++;
+      retvalue = mmHashTryReadOrAddEntry( table, access, readaddentry, retreadflag, stat );
     } while( retvalue == MM_HASH_TRYAGAIN );
     MM_HASH_GLOBAL_UNLOCK( table );
   }
@@ -1392,10 +1373,6 @@ int mmHashDirectDeleteEntry( void *hashtable, const mmHashAccess *access, void *
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = access->entrykey( table->context, deleteentry );
   if( table->flags & MM_HASH_FLAGS_HASHSIZE_ISPOW2 )
@@ -1412,9 +1389,6 @@ int mmHashDirectDeleteEntry( void *hashtable, const mmHashAccess *access, void *
       return MM_HASH_FAILURE;
     else if( cmpvalue == MM_HASH_ENTRYCMP_FOUND )
       break;
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
@@ -1423,10 +1397,6 @@ int mmHashDirectDeleteEntry( void *hashtable, const mmHashAccess *access, void *
   if( readflag )
     memcpy( deleteentry, entry, table->entrysize );
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->statdeletecount, 1 );
-#endif
-
   for( delbase = hashkey ; ; )
   {
     if( delbase == 0 )
@@ -1434,9 +1404,6 @@ int mmHashDirectDeleteEntry( void *hashtable, const mmHashAccess *access, void *
     delbase--;
     if( !( access->entryvalid( table->context, MM_HASH_ENTRY( table, delbase ) ) ) )
       break;
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statdelrewindcount, 1 );
-#endif
   }
   delbase++;
   if( delbase == table->hashsize )
@@ -1487,10 +1454,6 @@ int mmHashDirectDeleteEntry( void *hashtable, const mmHashAccess *access, void *
     /* Move entry in place and continue the repair process */
     memcpy( entry, targetentry, table->entrysize );
 
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statrelocationcount, 1 );
-#endif
-
     hashkey = targetpos;
   }
 
@@ -1504,19 +1467,15 @@ int mmHashDirectDeleteEntry( void *hashtable, const mmHashAccess *access, void *
       table->status = MM_HASH_STATUS_NORMAL;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->statentrycount, -1 );
-#endif
-
   return MM_HASH_SUCCESS;
 }
 
 
-static int mmHashTryDeleteEntry( mmHashTable *table, const mmHashAccess *access, void *deleteentry, int readflag )
+static int mmHashTryDeleteEntry( mmHashTable *table, const mmHashAccess *access, void *deleteentry, int readflag, mmHashStatistics *stat )
 {
   mmHashIndex hashkey, srckey, srcpos, srcend, targetpos, targetkey, entrycount;
-  mmHashIndex pageindex, pagestart, pagefinal;
-  mmHashIndex delbase;
+  mmHashIndex pageindex, pagestart, pagefinal, probelength;
+  mmHashIndex delbase, rewindlength;
   int cmpvalue, retvalue;
   void *entry, *srcentry, *targetentry;
 
@@ -1527,9 +1486,7 @@ static int mmHashTryDeleteEntry( mmHashTable *table, const mmHashAccess *access,
   else
     hashkey %= table->hashsize;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
+  probelength = 0;
 
   /* Lock first page */
   pagestart = hashkey >> table->pageshift;
@@ -1563,9 +1520,7 @@ static int mmHashTryDeleteEntry( mmHashTable *table, const mmHashAccess *access,
     }
     else if( cmpvalue == MM_HASH_ENTRYCMP_FOUND )
       break;
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
+    probelength++;
     hashkey++;
     if( hashkey == table->hashsize )
       hashkey = 0;
@@ -1574,10 +1529,7 @@ static int mmHashTryDeleteEntry( mmHashTable *table, const mmHashAccess *access,
   if( readflag )
     memcpy( deleteentry, entry, table->entrysize );
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->statdeletecount, 1 );
-#endif
-
+  rewindlength = 0;
   for( delbase = hashkey ; ; )
   {
     if( delbase == 0 )
@@ -1585,9 +1537,7 @@ static int mmHashTryDeleteEntry( mmHashTable *table, const mmHashAccess *access,
     delbase--;
     if( !( access->entryvalid( table->context, MM_HASH_ENTRY( table, delbase ) ) ) )
       break;
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statdelrewindcount, 1 );
-#endif
+    rewindlength++;
   }
   delbase++;
   if( delbase == table->hashsize )
@@ -1618,6 +1568,12 @@ static int mmHashTryDeleteEntry( mmHashTable *table, const mmHashAccess *access,
       break;
   }
 
+  if( stat )
+  {
+    stat->deletecount++;
+    stat->delrewindcount += rewindlength;
+  }
+
   /* Entry found, delete it and reorder the hash stream of entries */
   for( ; ; )
   {
@@ -1664,9 +1620,8 @@ static int mmHashTryDeleteEntry( mmHashTable *table, const mmHashAccess *access,
     /* Move entry in place and continue the repair process */
     memcpy( entry, targetentry, table->entrysize );
 
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statrelocationcount, 1 );
-#endif
+    if( stat )
+      stat->relocationcount++;
 
     hashkey = targetpos;
   }
@@ -1681,12 +1636,11 @@ static int mmHashTryDeleteEntry( mmHashTable *table, const mmHashAccess *access,
       table->status = MM_HASH_STATUS_NORMAL;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->statentrycount, -1 );
-#endif
-
   end:
 
+  if( ( stat ) && ( retvalue != MM_HASH_TRYAGAIN ) )
+    mmHashStatAccess( stat, probelength );
+
   /* Unlock all pages */
   for( pageindex = pagestart ; ; pageindex = ( pageindex + 1 ) & table->pagemask )
   {
@@ -1699,19 +1653,23 @@ static int mmHashTryDeleteEntry( mmHashTable *table, const mmHashAccess *access,
 }
 
 
-int mmHashLockDeleteEntry( void *hashtable, const mmHashAccess *access, void *deleteentry, int readflag )
+int mmHashLockDeleteEntry( void *hashtable, const mmHashAccess *access, void *deleteentry, int readflag, mmHashStatistics *stat )
 {
   int retvalue;
   mmHashTable *table;
 
   table = hashtable;
-  retvalue = mmHashTryDeleteEntry( table, access, deleteentry, readflag );
+  retvalue = mmHashTryDeleteEntry( table, access, deleteentry, readflag, stat );
   if( retvalue == MM_HASH_TRYAGAIN )
   {
+    if( stat )
+      stat->globallockcount++;
     MM_HASH_GLOBAL_LOCK( table );
     do
     {
-      retvalue = mmHashTryDeleteEntry( table, access, deleteentry, readflag );
+      if( stat )
+        stat->pagelockfailcount++;
+      retvalue = mmHashTryDeleteEntry( table, access, deleteentry, readflag, stat );
     } while( retvalue == MM_HASH_TRYAGAIN );
     MM_HASH_GLOBAL_UNLOCK( table );
   }
@@ -1843,16 +1801,6 @@ void mmHashResize( void *newtable, void *oldtable, const mmHashAccess *access, s
     }
   }
 
-#ifdef MM_HASH_DEBUG_STATISTICS
-  dst->statentrycountmax = src->statentrycountmax;
-  dst->statentrycount = src->statentrycount;
-  dst->stataccesscount = src->stataccesscount;
-  dst->statfindskipcount = src->statfindskipcount;
-  dst->statdeletecount = src->statdeletecount;
-  dst->statdelrewindcount = src->statdelrewindcount;
-  dst->statrelocationcount = src->statrelocationcount;
-#endif
-
   return;
 }
 
@@ -1876,6 +1824,17 @@ void mmHashListAll( void *hashtable, int (*list)( void *opaque, void *entry ), v
   return;
 }
 
+void mmHashGetPages( void *hashtable, size_t *retpagesize, size_t *retpagecount )
+{
+  mmHashTable *table;
+  table = hashtable;
+  if( retpagesize )
+    *retpagesize = (size_t)1 << table->pageshift;
+  if( retpagecount )
+    *retpagecount = (size_t)table->pagecount;
+  return;
+}
+
 mmHashIndex mmHashGetEntryCount( void *hashtable )
 {
   mmHashIndex entrycount;
@@ -2229,75 +2188,41 @@ void mmHashDirectDebugContent( void *hashtable, void (*callback)( mmHashIndex ha
 
 
 
-void mmHashGetStatistics( void *hashtable, long *accesscount, long *findskipcount, long *deletecount, long *delrewindcount, long *relocationcount, long *entrycount, long *entrycountmax, size_t *hashsize )
+void mmHashResetStatistics( mmHashStatistics *stat )
 {
-  mmHashTable *table;
-  table = hashtable;
-#if MM_HASH_DEBUG_STATISTICS
-  if( accesscount )
-    *accesscount = mmAtomicReadL( &table->stataccesscount );
-  if( findskipcount )
-    *findskipcount = mmAtomicReadL( &table->statfindskipcount );
-  if( deletecount )
-    *deletecount = mmAtomicReadL( &table->statdeletecount );
-  if( delrewindcount )
-    *delrewindcount = mmAtomicReadL( &table->statdelrewindcount );
-  if( relocationcount )
-    *relocationcount = mmAtomicReadL( &table->statrelocationcount );
-  if( entrycount )
-    *entrycount = mmAtomicReadL( &table->statentrycount );
-  if( entrycountmax )
-    *entrycountmax = table->statentrycountmax;
-#else
-  if( accesscount )
-    *accesscount = 0;
-  if( findskipcount )
-    *findskipcount = 0;
-  if( deletecount )
-    *deletecount = 0;
-  if( delrewindcount )
-    *delrewindcount = 0;
-  if( relocationcount )
-    *relocationcount = 0;
-  if( entrycount )
-    *entrycount = MM_HASH_ENTRYCOUNT_READ( table );
-  if( entrycountmax )
-    *entrycountmax = 0;
-#endif
-  if( hashsize )
-    *hashsize = table->hashsize;
+  memset( stat, 0, sizeof(mmHashStatistics) );
   return;
 }
 
-void mmHashResetStatistics( void *hashtable )
+void mmHashAddStatistics( mmHashStatistics *dst, const mmHashStatistics *src )
 {
-  mmHashTable *table;
-  table = hashtable;
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicWriteL( &table->stataccesscount, 0 );
-  mmAtomicWriteL( &table->statfindskipcount, 0 );
-  mmAtomicWriteL( &table->statdeletecount, 0 );
-  mmAtomicWriteL( &table->statrelocationcount, 0 );
-  mmAtomicWriteL( &table->statdelrewindcount, 0 );
-#endif
+  dst->accesscount += src->accesscount;
+  dst->probecount += src->probecount;
+  if( src->probemax > dst->probemax )
+    dst->probemax = src->probemax;
+  dst->deletecount += src->deletecount;
+  dst->delrewindcount += src->delrewindcount;
+  dst->relocationcount += src->relocationcount;
+  dst->pagelockfailcount += src->pagelockfailcount;
+  dst->globallockcount += src->globallockcount;
   return;
 }
 
-void mmHashPrintStatistics( void *hashtable )
+void mmHashPrintStatistics( void *hashtable, const mmHashStatistics *stat )
 {
-  long statentrycount, stataccesscount, statfindskipcount, statdeletecount, statdelrewindcount, statrelocationcount;
-  size_t stathashsize;
+  mmHashTable *table;
+  table = hashtable;
   printf( "-= Hash table statistics =-\n" );
-  mmHashGetStatistics( hashtable, &stataccesscount, &statfindskipcount, &statdeletecount, &statdelrewindcount, &statrelocationcount, &statentrycount, 0, &stathashsize );
-  printf( "  Hash size  : % 12ld\n", (long)stathashsize );
-  printf( "  Entry count: % 12ld\n", statentrycount );
-#if MM_HASH_DEBUG_STATISTICS
-  printf( "  Access count    : % 12ld\n", stataccesscount );
-  printf( "  Find skip count : % 12ld\n", statfindskipcount );
-  printf( "  Delete count    : % 12ld\n", statdeletecount );
-  printf( "  Del Rewind count: % 12ld\n", statdelrewindcount );
-  printf( "  Relocation count: % 12ld\n", statrelocationcount );
-#endif
+  printf( "  Hash size  : % 12ld\n", (long)table->hashsize );
+  printf( "  Page count : % 12ld\n", (long)table->pagecount );
+  printf( "  Access count    : % 12ld\n", stat->accesscount );
+  printf( "  Probe count     : % 12ld\n", stat->probecount );
+  printf( "  Probe max       : % 12ld\n", stat->probemax );
+  printf( "  Delete count    : % 12ld\n", stat->deletecount );
+  printf( "  Del Rewind count: % 12ld\n", stat->delrewindcount );
+  printf( "  Relocation count: % 12ld\n", stat->relocationcount );
+  printf( "  Page lock fails : % 12ld\n", stat->pagelockfailcount );
+  printf( "  Global locks    : % 12ld\n", stat->globallockcount );
   fflush( stdout );
   return;
 }
@@ -2449,7 +2374,7 @@ void mmHashPrintHealth( void *hashtable, const mmHashAccess *access )
 
   printf( "-* Hash table health report *-\n" );
   printf( "  Hash size  : % 12ld\n", (long)table->hashsize );
-  printf( "  Entry count: %lld (%lld ~ %lld)\n", (long long)totalentrycount, (long long)MM_HASH_ENTRYCOUNT_READ( table ), (long long)mmAtomicReadL( &table->statentrycount ) );
+  printf( "  Entry count: %lld (%lld)\n", (long long)totalentrycount, (long long)MM_HASH_ENTRYCOUNT_READ( table ) );
   printf( "  Occupancy: %.2f %%\n", 100.0 * (double)totalentrycount / (double)table->hashsize );
   printf( "  Hash ideal placement: %.2f %%\n", 100.0 * (double)totalhashidealplace / (double)totalentrycount );
   printf( "  Placement average distance: %.2f\n", (double)totaldistance / (double)totalentrycount );
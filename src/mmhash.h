@@ -49,8 +49,21 @@
 #endif
 
 
-/* Enable the collection of statistics for mmHashGetStatistics() */
-#define MM_HASH_DEBUG_STATISTICS (0)
+/* Statistics of the Lock*() calls, each thread accumulates in its own struct, passed as a null pointer to skip them */
+typedef struct
+{
+  /* Count of accesses, total and longest count of entries skipped searching for a match or a free entry */
+  long accesscount;
+  long probecount;
+  long probemax;
+  /* Count of deletions, steps backwards to the start of the stream of entries, entries moved to fill the gap */
+  long deletecount;
+  long delrewindcount;
+  long relocationcount;
+  /* Attempts aborted on a lock page owned by another thread, and accesses retried under the global lock */
+  long pagelockfailcount;
+  long globallockcount;
+} mmHashStatistics;
 
 
 
@@ -112,29 +125,35 @@ enum
 
 
 void *mmHashDirectFindEntry( void *hashtable, const mmHashAccess *access, void *findentry );
-void *mmHashLockFindEntry( void *hashtable, const mmHashAccess *access, void *findentry );
+void *mmHashLockFindEntry( void *hashtable, const mmHashAccess *access, void *findentry, mmHashStatistics *stat );
 
 void mmHashDirectListEntry( void *hashtable, const mmHashAccess *access, void *listentry, void *opaque );
-void mmHashLockListEntry( void *hashtable, const mmHashAccess *access, void *listentry, void *opaque );
+void mmHashLockListEntry( void *hashtable, const mmHashAccess *access, void *listentry, void *opaque, mmHashStatistics *stat );
 
 int mmHashDirectReadEntry( void *hashtable, const mmHashAccess *access, void *readentry );
-int mmHashLockReadEntry( void *hashtable, const mmHashAccess *access, void *readentry );
+int mmHashLockReadEntry( void *hashtable, const mmHashAccess *access, void *readentry, mmHashStatistics *stat );
 
 int mmHashDirectCallEntry( void *hashtable, const mmHashAccess *access, void *callentry, void (*callback)( void *opaque, void *entry, int newflag ), void *opaque, int addflag );
-int mmHashLockCallEntry( void *hashtable, const mmHashAccess *access, void *callentry, void (*callback)( void *opaque, void *entry, int newflag ), void *opaque, int addflag );
+int mmHashLockCallEntry( void *hashtable, const mmHashAccess *access, void *callentry, void (*callback)( void *opaque, void *entry, int newflag ), void *opaque, int addflag, mmHashStatistics *stat );
 
 /* The hash key for replaced entries must remain the same! */
 int mmHashDirectReplaceEntry( void *hashtable, const mmHashAccess *access, void *replaceentry, int addflag );
-int mmHashLockReplaceEntry( void *hashtable, const mmHashAccess *access, void *replaceentry, int addflag );
+int mmHashLockReplaceEntry( void *hashtable, const mmHashAccess *access, void *replaceentry, int addflag, mmHashStatistics *stat );
 
 int mmHashDirectAddEntry( void *hashtable, const mmHashAccess *access, void *addentry, int nodupflag );
-int mmHashLockAddEntry( void *hashtable, const mmHashAccess *access, void *addentry, int nodupflag );
+int mmHashLockAddEntry( void *hashtable, const mmHashAccess *access, void *addentry, int nodupflag, mmHashStatistics *stat );
+
+/* Index of the hash entry where the search for an entry starts */
+mmHashIndex mmHashGetEntryIndex( void *hashtable, const mmHashAccess *access, void *entry );
+/* Add an entry without locking nor duplicate check, searching only indices below indexlimit ; return MM_HASH_TRYAGAIN if none was free */
+/* Threads may fill disjoint ranges of indices concurrently, adding the entries starting in their range */
+int mmHashDirectAddEntryRange( void *hashtable, const mmHashAccess *access, void *addentry, mmHashIndex indexlimit );
 
 int mmHashDirectReadOrAddEntry( void *hashtable, const mmHashAccess *access, void *readaddentry, int *readflag );
-int mmHashLockReadOrAddEntry( void *hashtable, const mmHashAccess *access, void *readaddentry, int *readflag );
+int mmHashLockReadOrAddEntry( void *hashtable, const mmHashAccess *access, void *readaddentry, int *readflag, mmHashStatistics *stat );
 
 int mmHashDirectDeleteEntry( void *hashtable, const mmHashAccess *access, void *deleteentry, int readflag );
-int mmHashLockDeleteEntry( void *hashtable, const mmHashAccess *access, void *deleteentry, int readflag );
+int mmHashLockDeleteEntry( void *hashtable, const mmHashAccess *access, void *deleteentry, int readflag, mmHashStatistics *stat );
 
 void mmHashResize( void *newtable, void *oldtable, const mmHashAccess *access, size_t hashsize, uint32_t pageshift );
 
@@ -190,11 +209,15 @@ void mmHashDirectDebugPages( void *hashtable );
 
 void mmHashDirectDebugContent( void *hashtable, void (*callback)( mmHashIndex hashkey, void *entry ) );
 
-void mmHashGetStatistics( void *hashtable, long *accesscount, long *findskipcount, long *deletecount, long *delrewindcount, long *relocationcount, long *entrycount, long *entrycountmax, size_t *hashsize );
+void mmHashResetStatistics( mmHashStatistics *stat );
+
+/* Sum the statistics of src into dst, as gathered by another thread */
+void mmHashAddStatistics( mmHashStatistics *dst, const mmHashStatistics *src );
 
-void mmHashResetStatistics( void *hashtable );
+void mmHashPrintStatistics( void *hashtable, const mmHashStatistics *stat );
 
-void mmHashPrintStatistics( void *hashtable );
+/* Retrieve the count of entries covered by each lock page, and the count of lock pages */
+void mmHashGetPages( void *hashtable, size_t *retpagesize, size_t *retpagecount );
 
 double mmHashGetHealthScore( void *hashtable, const mmHashAccess *access );
 
@@ -72,10 +72,6 @@ void *HASH_DECLARE_DIRECTFINDENTRY( void *hashtable, void *findentry )
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = HASH_ENTRYKEY( table->context, findentry );
 #if HASH_HASHSIZE_IS_POW2
@@ -100,9 +96,6 @@ void *HASH_DECLARE_DIRECTFINDENTRY( void *hashtable, void *findentry )
       break;
     else if( cmpvalue == MM_HASH_ENTRYCMP_FOUND )
       return entry;
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
 #if HASH_HASHSIZE_IS_POW2
     hashkey = ( hashkey + 1 ) & table->hashmask;
 #else
@@ -129,10 +122,6 @@ void HASH_DECLARE_DIRECTLISTENTRY( void *hashtable, void *listentry, void *opaqu
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = HASH_ENTRYKEY( table->context, listentry );
 #if HASH_HASHSIZE_IS_POW2
@@ -155,9 +144,6 @@ void HASH_DECLARE_DIRECTLISTENTRY( void *hashtable, void *listentry, void *opaqu
     cmpvalue = HASH_ENTRYLIST( table->context, opaque, entry, listentry );
     if( cmpvalue == MM_HASH_ENTRYLIST_BREAK )
       break;
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
 #if HASH_HASHSIZE_IS_POW2
     hashkey = ( hashkey + 1 ) & table->hashmask;
 #else
@@ -184,10 +170,6 @@ int HASH_DECLARE_DIRECTREADENTRY( void *hashtable, void *readentry )
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = HASH_ENTRYKEY( table->context, readentry );
 #if HASH_HASHSIZE_IS_POW2
@@ -219,9 +201,6 @@ int HASH_DECLARE_DIRECTREADENTRY( void *hashtable, void *readentry )
 #endif
       return MM_HASH_SUCCESS;
     }
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
 #if HASH_HASHSIZE_IS_POW2
     hashkey = ( hashkey + 1 ) & table->hashmask;
 #else
@@ -248,10 +227,6 @@ int HASH_DECLARE_DIRECTCALLENTRY( void *hashtable, void *callentry, void (*callb
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = HASH_ENTRYKEY( table->context, callentry );
 #if HASH_HASHSIZE_IS_POW2
@@ -279,9 +254,6 @@ int HASH_DECLARE_DIRECTCALLENTRY( void *hashtable, void *callentry, void (*callb
       callback( opaque, entry, 0 );
       return MM_HASH_SUCCESS;
     }
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
 #if HASH_HASHSIZE_IS_POW2
     hashkey = ( hashkey + 1 ) & table->hashmask;
 #else
@@ -310,12 +282,6 @@ int HASH_DECLARE_DIRECTCALLENTRY( void *hashtable, void *callentry, void (*callb
       table->status = MM_HASH_STATUS_MUSTGROW;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  int statentrycount = mmAtomicAddReadL( &table->statentrycount, 1 );
-  if( statentrycount > table->statentrycountmax )
-    table->statentrycountmax = statentrycount;
-#endif
-
   return MM_HASH_SUCCESS;
 }
 
@@ -333,10 +299,6 @@ int HASH_DECLARE_DIRECTREPLACEENTRY( void *hashtable, void *replaceentry, int ad
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = HASH_ENTRYKEY( table->context, replaceentry );
 #if HASH_HASHSIZE_IS_POW2
@@ -368,9 +330,6 @@ int HASH_DECLARE_DIRECTREPLACEENTRY( void *hashtable, void *replaceentry, int ad
 #endif
       return MM_HASH_SUCCESS;
     }
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
 #if HASH_HASHSIZE_IS_POW2
     hashkey = ( hashkey + 1 ) & table->hashmask;
 #else
@@ -398,12 +357,6 @@ int HASH_DECLARE_DIRECTREPLACEENTRY( void *hashtable, void *replaceentry, int ad
       table->status = MM_HASH_STATUS_MUSTGROW;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  int statentrycount = mmAtomicAddReadL( &table->statentrycount, 1 );
-  if( statentrycount > table->statentrycountmax )
-    table->statentrycountmax = statentrycount;
-#endif
-
   return MM_HASH_SUCCESS;
 }
 
@@ -421,10 +374,6 @@ int HASH_DECLARE_DIRECTADDENTRY( void *hashtable, void *addentry, int nodupflag
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = HASH_ENTRYKEY( table->context, addentry );
 #if HASH_HASHSIZE_IS_POW2
@@ -458,9 +407,6 @@ int HASH_DECLARE_DIRECTADDENTRY( void *hashtable, void *addentry, int nodupflag
       if( !( HASH_ENTRYVALID( table->context, entry ) ) )
         break;
     }
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
 #if HASH_HASHSIZE_IS_POW2
     hashkey = ( hashkey + 1 ) & table->hashmask;
 #else
@@ -485,12 +431,6 @@ int HASH_DECLARE_DIRECTADDENTRY( void *hashtable, void *addentry, int nodupflag
       table->status = MM_HASH_STATUS_MUSTGROW;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  int statentrycount = mmAtomicAddReadL( &table->statentrycount, 1 );
-  if( statentrycount > table->statentrycountmax )
-    table->statentrycountmax = statentrycount;
-#endif
-
   return MM_HASH_SUCCESS;
 }
 
@@ -508,10 +448,6 @@ void *HASH_DECLARE_DIRECTADDRETENTRY( void *hashtable, void *addentry, int nodup
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = HASH_ENTRYKEY( table->context, addentry );
 #if HASH_HASHSIZE_IS_POW2
@@ -545,9 +481,6 @@ void *HASH_DECLARE_DIRECTADDRETENTRY( void *hashtable, void *addentry, int nodup
       if( !( HASH_ENTRYVALID( table->context, entry ) ) )
         break;
     }
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
 #if HASH_HASHSIZE_IS_POW2
     hashkey = ( hashkey + 1 ) & table->hashmask;
 #else
@@ -572,12 +505,6 @@ void *HASH_DECLARE_DIRECTADDRETENTRY( void *hashtable, void *addentry, int nodup
       table->status = MM_HASH_STATUS_MUSTGROW;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  int statentrycount = mmAtomicAddReadL( &table->statentrycount, 1 );
-  if( statentrycount > table->statentrycountmax )
-    table->statentrycountmax = statentrycount;
-#endif
-
   return entry;
 }
 
@@ -595,10 +522,6 @@ int HASH_DECLARE_DIRECTREADORADDENTRY( void *hashtable, void *readaddentry, int
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = HASH_ENTRYKEY( table->context, readaddentry );
 #if HASH_HASHSIZE_IS_POW2
@@ -632,9 +555,6 @@ int HASH_DECLARE_DIRECTREADORADDENTRY( void *hashtable, void *readaddentry, int
       *retreadflag = 1;
       return MM_HASH_SUCCESS;
     }
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
 #if HASH_HASHSIZE_IS_POW2
     hashkey = ( hashkey + 1 ) & table->hashmask;
 #else
@@ -659,12 +579,6 @@ int HASH_DECLARE_DIRECTREADORADDENTRY( void *hashtable, void *readaddentry, int
       table->status = MM_HASH_STATUS_MUSTGROW;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  int statentrycount = mmAtomicAddReadL( &table->statentrycount, 1 );
-  if( statentrycount > table->statentrycountmax )
-    table->statentrycountmax = statentrycount;
-#endif
-
   return MM_HASH_SUCCESS;
 }
 
@@ -683,10 +597,6 @@ int HASH_DECLARE_DIRECTDELETEENTRY( void *hashtable, void *deleteentry, int read
 
   table = hashtable;
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->stataccesscount, 1 );
-#endif
-
   /* Hash key of entry */
   hashkey = HASH_ENTRYKEY( table->context, deleteentry );
 #if HASH_HASHSIZE_IS_POW2
@@ -711,9 +621,6 @@ int HASH_DECLARE_DIRECTDELETEENTRY( void *hashtable, void *deleteentry, int read
       return MM_HASH_FAILURE;
     else if( cmpvalue == MM_HASH_ENTRYCMP_FOUND )
       break;
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statfindskipcount, 1 );
-#endif
 #if HASH_HASHSIZE_IS_POW2
     hashkey = ( hashkey + 1 ) & table->hashmask;
 #else
@@ -732,10 +639,6 @@ int HASH_DECLARE_DIRECTDELETEENTRY( void *hashtable, void *deleteentry, int read
 #endif
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->statdeletecount, 1 );
-#endif
-
 #if HASH_HASHSIZE_IS_POW2
   for( delbase = hashkey ; ; )
   {
@@ -746,9 +649,6 @@ int HASH_DECLARE_DIRECTDELETEENTRY( void *hashtable, void *deleteentry, int read
  #else
     if( !( HASH_ENTRYVALID( table->context, MM_HASH_ENTRY( table, delbase ) ) ) )
       break;
- #endif
- #if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statdelrewindcount, 1 );
  #endif
   }
   delbase = ( delbase + 1 ) & table->hashmask;
@@ -764,9 +664,6 @@ int HASH_DECLARE_DIRECTDELETEENTRY( void *hashtable, void *deleteentry, int read
  #else
       if( !( HASH_ENTRYVALID( table->context, MM_HASH_ENTRY( table, delbase ) ) ) )
         break;
- #endif
- #if MM_HASH_DEBUG_STATISTICS
-      mmAtomicAddL( &table->statdelrewindcount, 1 );
  #endif
     }
     delbase = ( delbase + 1 ) & table->hashmask;
@@ -784,9 +681,6 @@ int HASH_DECLARE_DIRECTDELETEENTRY( void *hashtable, void *deleteentry, int read
  #else
       if( !( HASH_ENTRYVALID( table->context, MM_HASH_ENTRY( table, delbase ) ) ) )
         break;
- #endif
- #if MM_HASH_DEBUG_STATISTICS
-      mmAtomicAddL( &table->statdelrewindcount, 1 );
  #endif
     }
     delbase++;
@@ -855,10 +749,6 @@ int HASH_DECLARE_DIRECTDELETEENTRY( void *hashtable, void *deleteentry, int read
     memcpy( entry, targetentry, table->entrysize );
 #endif
 
-#if MM_HASH_DEBUG_STATISTICS
-    mmAtomicAddL( &table->statrelocationcount, 1 );
-#endif
-
     hashkey = targetpos;
   }
 
@@ -870,10 +760,6 @@ int HASH_DECLARE_DIRECTDELETEENTRY( void *hashtable, void *deleteentry, int read
       table->status = MM_HASH_STATUS_MUSTSHRINK;
   }
 
-#if MM_HASH_DEBUG_STATISTICS
-  mmAtomicAddL( &table->statentrycount, -1 );
-#endif
-
   return MM_HASH_SUCCESS;
 }
 
@@ -99,22 +99,6 @@ typedef struct
 #endif
   char paddingB[64];
 
-#ifdef MM_HASH_DEBUG_STATISTICS
-  /* Highest count of entry reached */
-  long statentrycountmax;
-  mmAtomicL statentrycount;
-  /* Count of function calls accessing the hash table */
-  mmAtomicL stataccesscount;
-  /* Count of hash entries being skipped while searching for a match */
-  mmAtomicL statfindskipcount;
-  /* Count of succesful delete operations */
-  mmAtomicL statdeletecount;
-  /* Count of steps backwards while correcting for entry deletion */
-  mmAtomicL statdelrewindcount;
-  /* Count of hash entries being moved due to a deletion */
-  mmAtomicL statrelocationcount;
-#endif
-
 } mmHashTable;
 
 
@@ -0,0 +1,226 @@
+/* *****************************************************************************
+ *
+ * Copyright (c) 2012-2023 Alexis Naveros.
+ * Portions developed under contract to the SURVICE Engineering Company.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * *****************************************************************************
+ */
+
+
+/*
+ * Shared helpers of the test programs : generated meshes and output checks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "meshdecimation.h"
+
+#ifndef M_PI
+ #define M_PI (3.14159265358979323846)
+#endif
+
+
+typedef struct
+{
+  size_t vertexcount;
+  size_t vertexalloc;
+  float *vertex;
+  size_t tricount;
+  uint32_t *indices;
+} mtMesh;
+
+
+static int mtFailCount = 0;
+
+#define MT_CHECK(cond,...) do { if( !( cond ) ) { printf( "FAIL %s:%d : ", __FILE__, __LINE__ ); printf( __VA_ARGS__ ); printf( "\n" ); mtFailCount++; } } while(0)
+
+
+/* Closed manifold torus of usegs*vsegs vertices, with a deterministic bumpy surface */
+/* The tube is round, or a polygon of tubesides sides with sharp creases for normal splitting */
+static inline void mtMeshTorus( mtMesh *mesh, int usegs, int vsegs, int tubesides, size_t vertexalloc )
+{
+  int u, v;
+  double a, b, r, sideangle;
+  float *point;
+  uint32_t *indices, i0, i1, i2, i3;
+
+  mesh->vertexcount = (size_t)usegs * vsegs;
+  mesh->vertexalloc = ( vertexalloc > mesh->vertexcount ? vertexalloc : mesh->vertexcount );
+  mesh->tricount = (size_t)usegs * vsegs * 2;
+  mesh->vertex = calloc( mesh->vertexalloc, 3 * sizeof(float) );
+  mesh->indices = malloc( mesh->tricount * 3 * sizeof(uint32_t) );
+  for( u = 0 ; u < usegs ; u++ )
+  {
+    for( v = 0 ; v < vsegs ; v++ )
+    {
+      a = ( 2.0 * M_PI * u ) / usegs;
+      b = ( 2.0 * M_PI * v ) / vsegs;
+      r = 1.0 + 0.05 * sin( 5.0 * a ) * cos( 3.0 * b ) + 0.01 * sin( 37.0 * a + 11.0 * b );
+      if( tubesides )
+      {
+        sideangle = ( 2.0 * M_PI ) / tubesides;
+        r = cos( 0.5 * sideangle ) / cos( fmod( b, sideangle ) - ( 0.5 * sideangle ) );
+      }
+      point = &mesh->vertex[ ( u * vsegs + v ) * 3 ];
+      point[0] = (float)( ( 3.0 + r * cos( b ) ) * cos( a ) );
+      point[1] = (float)( ( 3.0 + r * cos( b ) ) * sin( a ) );
+      point[2] = (float)( r * sin( b ) );
+    }
+  }
+  indices = mesh->indices;
+  for( u = 0 ; u < usegs ; u++ )
+  {
+    for( v = 0 ; v < vsegs ; v++ )
+    {
+      i0 = u * vsegs + v;
+      i1 = ( ( u + 1 ) % usegs ) * vsegs + v;
+      i2 = ( ( u + 1 ) % usegs ) * vsegs + ( ( v + 1 ) % vsegs );
+      i3 = u * vsegs + ( ( v + 1 ) % vsegs );
+      *indices++ = i0; *indices++ = i1; *indices++ = i2;
+      *indices++ = i0; *indices++ = i2; *indices++ = i3;
+    }
+  }
+  return;
+}
+
+/* Open grid of size*size vertices over a gentle height field, with a boundary */
+static inline void mtMeshGrid( mtMesh *mesh, int size )
+{
+  int x, y;
+  float *point;
+  uint32_t *indices, i0, i1, i2, i3;
+
+  mesh->vertexcount = (size_t)size * size;
+  mesh->vertexalloc = mesh->vertexcount;
+  mesh->tricount = (size_t)( size - 1 ) * ( size - 1 ) * 2;
+  mesh->vertex = malloc( mesh->vertexcount * 3 * sizeof(float) );
+  mesh->indices = malloc( mesh->tricount * 3 * sizeof(uint32_t) );
+  for( y = 0 ; y < size ; y++ )
+  {
+    for( x = 0 ; x < size ; x++ )
+    {
+      point = &mesh->vertex[ ( y * size + x ) * 3 ];
+      point[0] = (float)x / (float)size;
+      point[1] = (float)y / (float)size;
+      point[2] = 0.05f * sinf( (float)x * 0.21f ) * cosf( (float)y * 0.17f ) + 0.0005f * (float)( ( x * 7919 + y * 104729 ) % 97 ) / 97.0f;
+    }
+  }
+  indices = mesh->indices;
+  for( y = 0 ; y < size - 1 ; y++ )
+  {
+    for( x = 0 ; x < size - 1 ; x++ )
+    {
+      i0 = y * size + x;
+      i1 = i0 + 1;
+      i2 = i0 + size + 1;
+      i3 = i0 + size;
+      *indices++ = i0; *indices++ = i1; *indices++ = i2;
+      *indices++ = i0; *indices++ = i2; *indices++ = i3;
+    }
+  }
+  return;
+}
+
+static inline void mtMeshCopy( mtMesh *dst, mtMesh *src )
+{
+  *dst = *src;
+  dst->vertex = malloc( src->vertexalloc * 3 * sizeof(float) );
+  memcpy( dst->vertex, src->vertex, src->vertexalloc * 3 * sizeof(float) );
+  dst->indices = malloc( src->tricount * 3 * sizeof(uint32_t) );
+  memcpy( dst->indices, src->indices, src->tricount * 3 * sizeof(uint32_t) );
+  return;
+}
+
+static inline void mtMeshFree( mtMesh *mesh )
+{
+  free( mesh->vertex );
+  free( mesh->indices );
+  mesh->vertex = 0;
+  mesh->indices = 0;
+  return;
+}
+
+static inline void mtMeshOperation( mdOperation *op, mtMesh *mesh, double featuresize )
+{
+  mdOperationInit( op );
+  mdOperationData( op, mesh->vertexcount, mesh->vertex, MD_FORMAT_FLOAT, 3 * sizeof(float), mesh->tricount, mesh->indices, MD_FORMAT_UINT32, 3 * sizeof(uint32_t) );
+  mdOperationStrength( op, featuresize );
+  op->vertexalloc = mesh->vertexalloc;
+  return;
+}
+
+
+static inline int mtEdgeKeyCompare( const void *p0, const void *p1 )
+{
+  uint64_t key0, key1;
+  key0 = *(const uint64_t *)p0;
+  key1 = *(const uint64_t *)p1;
+  return ( key0 > key1 ) - ( key0 < key1 );
+}
+
+/* Count invalid indices, degenerate triangles and directed edges used more than once */
+static inline int mtMeshCheckManifold( const char *name, uint32_t *indices, size_t tricount, size_t vertexcount )
+{
+  size_t triindex, keyindex;
+  int degeneratecount, duplicatecount, rangecount;
+  uint32_t *v;
+  uint64_t *keylist;
+
+  keylist = malloc( tricount * 3 * sizeof(uint64_t) );
+  degeneratecount = 0;
+  rangecount = 0;
+  for( triindex = 0 ; triindex < tricount ; triindex++ )
+  {
+    v = &indices[ triindex * 3 ];
+    if( ( v[0] >= vertexcount ) || ( v[1] >= vertexcount ) || ( v[2] >= vertexcount ) )
+      rangecount++;
+    if( ( v[0] == v[1] ) || ( v[1] == v[2] ) || ( v[2] == v[0] ) )
+      degeneratecount++;
+    keylist[ triindex * 3 + 0 ] = ( (uint64_t)v[0] << 32 ) | v[1];
+    keylist[ triindex * 3 + 1 ] = ( (uint64_t)v[1] << 32 ) | v[2];
+    keylist[ triindex * 3 + 2 ] = ( (uint64_t)v[2] << 32 ) | v[0];
+  }
+  qsort( keylist, tricount * 3, sizeof(uint64_t), mtEdgeKeyCompare );
+  duplicatecount = 0;
+  for( keyindex = 1 ; keyindex < tricount * 3 ; keyindex++ )
+  {
+    if( keylist[ keyindex ] == keylist[ keyindex - 1 ] )
+      duplicatecount++;
+  }
+  free( keylist );
+  MT_CHECK( !( rangecount ), "%s : %d triangles with out of range indices", name, rangecount );
+  MT_CHECK( !( degeneratecount ), "%s : %d degenerate triangles", name, degeneratecount );
+  MT_CHECK( !( duplicatecount ), "%s : %d duplicate directed edges", name, duplicatecount );
+  return !( rangecount | degeneratecount | duplicatecount );
+}
+
+static inline int mtReport( const char *name )
+{
+  if( mtFailCount )
+  {
+    printf( "%s : %d checks failed\n", name, mtFailCount );
+    return EXIT_FAILURE;
+  }
+  printf( "%s : passed\n", name );
+  return EXIT_SUCCESS;
+}
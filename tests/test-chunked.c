@@ -0,0 +1,136 @@
+/* *****************************************************************************
+ *
+ * Copyright (c) 2012-2023 Alexis Naveros.
+ * Portions developed under contract to the SURVICE Engineering Company.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * *****************************************************************************
+ */
+
+
+/*
+ * Chunked decimation under a memory budget, for a fraction of the memory a
+ * whole mesh decimation would need.
+ *
+ * Each chunk only sees its own triangles, yet the output must stay as
+ * manifold as the input : no directed edge used twice, no degenerate
+ * triangle, and no topology error reported through collisioncount.
+ *
+ * A dense torus next to a distant sparse one packs most triangles in a tiny
+ * part of the bounding box, which must be cut finer. Scaled down enough, no
+ * cut fits the budget and the decimation must fail with the mesh untouched.
+ */
+
+#include "mmtest.h"
+
+
+static void testChunked( mtMesh *input, int threadcount, double budgetfactor )
+{
+  size_t estimate;
+  mtMesh mesh;
+  mdOperation op;
+  char name[128];
+
+  snprintf( name, sizeof(name), "threads %d budget %.3f", threadcount, budgetfactor );
+  mtMeshCopy( &mesh, input );
+  mtMeshOperation( &op, &mesh, 0.3 );
+  estimate = mdMeshDecimationMemoryUsage( &op, 0 );
+  op.maxmemoryusage = (size_t)( budgetfactor * (double)estimate );
+  MT_CHECK( mdMeshDecimationChunked( &op, threadcount, 0 ), "%s : decimation failed", name );
+  MT_CHECK( op.tricount < input->tricount / 4, "%s : %d triangles left of %d", name, (int)op.tricount, (int)input->tricount );
+  MT_CHECK( !( op.collisioncount ), "%s : %ld collisions", name, op.collisioncount );
+  mtMeshCheckManifold( name, mesh.indices, op.tricount, op.vertexcount );
+  mtMeshFree( &mesh );
+  return;
+}
+
+
+/* Torus of 120k triangles scaled by densescale at the origin, next to a torus of 1200 triangles far away on all axes */
+static void testMeshCluster( mtMesh *mesh, double densescale )
+{
+  size_t index;
+  mtMesh dense, sparse;
+
+  mtMeshTorus( &dense, 400, 150, 0, 0 );
+  mtMeshTorus( &sparse, 40, 15, 0, 0 );
+  mesh->vertexcount = dense.vertexcount + sparse.vertexcount;
+  mesh->vertexalloc = mesh->vertexcount;
+  mesh->tricount = dense.tricount + sparse.tricount;
+  mesh->vertex = malloc( mesh->vertexcount * 3 * sizeof(float) );
+  mesh->indices = malloc( mesh->tricount * 3 * sizeof(uint32_t) );
+  for( index = 0 ; index < dense.vertexcount * 3 ; index++ )
+    mesh->vertex[index] = (float)( densescale * dense.vertex[index] );
+  for( index = 0 ; index < sparse.vertexcount * 3 ; index++ )
+    mesh->vertex[ ( dense.vertexcount * 3 ) + index ] = sparse.vertex[index] + 1000.0f;
+  memcpy( mesh->indices, dense.indices, dense.tricount * 3 * sizeof(uint32_t) );
+  for( index = 0 ; index < sparse.tricount * 3 ; index++ )
+    mesh->indices[ ( dense.tricount * 3 ) + index ] = (uint32_t)dense.vertexcount + sparse.indices[index];
+  mtMeshFree( &dense );
+  mtMeshFree( &sparse );
+  return;
+}
+
+/* Too dense to be cut within the budget, the decimation fails before touching the mesh */
+static void testChunkedTooDense( mtMesh *input, double budgetfactor )
+{
+  size_t estimate;
+  mtMesh mesh;
+  mdOperation op;
+  char name[128];
+
+  snprintf( name, sizeof(name), "too dense budget %.3f", budgetfactor );
+  mtMeshCopy( &mesh, input );
+  mtMeshOperation( &op, &mesh, 0.3 );
+  estimate = mdMeshDecimationMemoryUsage( &op, 0 );
+  op.maxmemoryusage = (size_t)( budgetfactor * (double)estimate );
+  MT_CHECK( !( mdMeshDecimationChunked( &op, 4, 0 ) ), "%s : decimation succeeded", name );
+  MT_CHECK( !( memcmp( mesh.indices, input->indices, input->tricount * 3 * sizeof(uint32_t) ) ), "%s : indices modified", name );
+  MT_CHECK( !( memcmp( mesh.vertex, input->vertex, input->vertexcount * 3 * sizeof(float) ) ), "%s : vertices modified", name );
+  mtMeshFree( &mesh );
+  return;
+}
+
+
+int main( void )
+{
+  int index;
+  mtMesh input;
+  static const double budgetlist[] = { 0.45, 0.2, 0.1 };
+
+  /* Manifold torus of 120k triangles */
+  mtMeshTorus( &input, 400, 150, 0, 0 );
+  for( index = 0 ; index < (int)( sizeof(budgetlist) / sizeof(double) ) ; index++ )
+  {
+    testChunked( &input, 1, budgetlist[index] );
+    testChunked( &input, 4, budgetlist[index] );
+  }
+  mtMeshFree( &input );
+
+  /* Dense torus in a corner of the bounding box */
+  testMeshCluster( &input, 1.0 );
+  testChunked( &input, 1, 0.2 );
+  testChunked( &input, 4, 0.1 );
+  mtMeshFree( &input );
+
+  /* Dense torus within a single code of the finest cells */
+  testMeshCluster( &input, 0.00001 );
+  testChunkedTooDense( &input, 0.2 );
+  mtMeshFree( &input );
+
+  return mtReport( "test-chunked" );
+}
@@ -0,0 +1,95 @@
+/* *****************************************************************************
+ *
+ * Copyright (c) 2012-2023 Alexis Naveros.
+ * Portions developed under contract to the SURVICE Engineering Company.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * *****************************************************************************
+ */
+
+
+/*
+ * MD_FLAGS_DETERMINISTIC output must be bit-identical at any count of threads.
+ */
+
+#include "mmtest.h"
+
+
+static void testDeterministic( mtMesh *input, int flags, size_t targetmax, int withnormals )
+{
+  int threadcount;
+  mtMesh mesh, reference;
+  mdOperation op;
+  float *normals, *referencenormals;
+  char name[128];
+
+  referencenormals = 0;
+  memset( &reference, 0, sizeof(mtMesh) );
+  for( threadcount = 1 ; threadcount <= 4 ; threadcount++ )
+  {
+    snprintf( name, sizeof(name), "threads %d flags 0x%x max %d normals %d", threadcount, flags, (int)targetmax, withnormals );
+    mtMeshCopy( &mesh, input );
+    mtMeshOperation( &op, &mesh, 0.05 );
+    op.targetvertexcountmax = targetmax;
+    normals = 0;
+    if( withnormals )
+    {
+      normals = calloc( mesh.vertexalloc, 3 * sizeof(float) );
+      mdOperationComputeNormals( &op, normals, MD_FORMAT_FLOAT, 3 * sizeof(float) );
+    }
+    MT_CHECK( mdMeshDecimation( &op, threadcount, MD_FLAGS_DETERMINISTIC | flags ), "%s : decimation failed", name );
+    mesh.vertexcount = op.vertexcount;
+    mesh.tricount = op.tricount;
+    mtMeshCheckManifold( name, mesh.indices, mesh.tricount, mesh.vertexcount );
+    if( threadcount == 1 )
+    {
+      reference = mesh;
+      referencenormals = normals;
+      continue;
+    }
+    MT_CHECK( ( mesh.vertexcount == reference.vertexcount ) && ( mesh.tricount == reference.tricount ), "%s : %d vertices %d triangles, %d %d with one thread", name, (int)mesh.vertexcount, (int)mesh.tricount, (int)reference.vertexcount, (int)reference.tricount );
+    if( ( mesh.vertexcount == reference.vertexcount ) && ( mesh.tricount == reference.tricount ) )
+    {
+      MT_CHECK( !( memcmp( mesh.vertex, reference.vertex, mesh.vertexcount * 3 * sizeof(float) ) ), "%s : vertices differ", name );
+      MT_CHECK( !( memcmp( mesh.indices, reference.indices, mesh.tricount * 3 * sizeof(uint32_t) ) ), "%s : indices differ", name );
+      if( withnormals )
+        MT_CHECK( !( memcmp( normals, referencenormals, mesh.vertexcount * 3 * sizeof(float) ) ), "%s : normals differ", name );
+    }
+    mtMeshFree( &mesh );
+    free( normals );
+  }
+  mtMeshFree( &reference );
+  free( referencenormals );
+  return;
+}
+
+
+int main( void )
+{
+  mtMesh input;
+
+  mtMeshTorus( &input, 120, 60, 0, 0 );
+  testDeterministic( &input, 0, 0, 0 );
+  testDeterministic( &input, 0, 0, 1 );
+  testDeterministic( &input, 0, 900, 0 );
+  testDeterministic( &input, MD_FLAGS_WORK_STEALING | MD_FLAGS_ASYNC_STEPS, 0, 0 );
+  testDeterministic( &input, MD_FLAGS_REORDER_MESH, 0, 0 );
+  mtMeshFree( &input );
+
+  return mtReport( "test-deterministic" );
+}
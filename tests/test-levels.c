@@ -0,0 +1,176 @@
+/* *****************************************************************************
+ *
+ * Copyright (c) 2012-2023 Alexis Naveros.
+ * Portions developed under contract to the SURVICE Engineering Company.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * *****************************************************************************
+ */
+
+
+/*
+ * Levels of detail snapshot during the decimation, and the input vertex each
+ * level vertex derives from.
+ *
+ * Level vertices are in the order of the input vertices, whether or not the
+ * mesh was reordered internally by MD_FLAGS_REORDER_MESH.
+ */
+
+#include "mmtest.h"
+
+
+#define TEST_LEVEL_COUNT (3)
+
+
+/* Triangles rotated to start with their lowest index, then sorted, to compare meshes written in different triangle orders */
+static int testCompareTriangle( const void *p0, const void *p1 )
+{
+  const uint32_t *t0, *t1;
+  int corner;
+  t0 = p0;
+  t1 = p1;
+  for( corner = 0 ; corner < 3 ; corner++ )
+  {
+    if( t0[corner] != t1[corner] )
+      return ( t0[corner] < t1[corner] ? -1 : 1 );
+  }
+  return 0;
+}
+
+static uint32_t *testSortTriangles( uint32_t *indices, size_t tricount )
+{
+  size_t triindex;
+  uint32_t *sorted, *t, t0;
+  sorted = malloc( tricount * 3 * sizeof(uint32_t) );
+  memcpy( sorted, indices, tricount * 3 * sizeof(uint32_t) );
+  for( triindex = 0 ; triindex < tricount ; triindex++ )
+  {
+    t = &sorted[ triindex * 3 ];
+    while( ( t[1] < t[0] ) || ( t[2] < t[0] ) )
+    {
+      t0 = t[0];
+      t[0] = t[1];
+      t[1] = t[2];
+      t[2] = t0;
+    }
+  }
+  qsort( sorted, tricount, 3 * sizeof(uint32_t), testCompareTriangle );
+  return sorted;
+}
+
+static void testLevels( mtMesh *input, int threadcount, int flags )
+{
+  int levelindex;
+  size_t vertexindex;
+  float *point, *inputpoint;
+  uint32_t *sorted, *inputsorted;
+  mtMesh mesh;
+  mdOperation op;
+  mdLevel levellist[TEST_LEVEL_COUNT], *level;
+  char name[128];
+
+  mtMeshCopy( &mesh, input );
+  mtMeshOperation( &op, &mesh, 0.8 );
+  memset( levellist, 0, TEST_LEVEL_COUNT * sizeof(mdLevel) );
+  /* First level is taken before any collapse, none is that cheap */
+  levellist[0].featuresize = 0.0001;
+  levellist[1].targetvertexcount = input->vertexcount / 4;
+  levellist[2].targetvertexcount = input->vertexcount / 16;
+  for( levelindex = 0 ; levelindex < TEST_LEVEL_COUNT ; levelindex++ )
+  {
+    level = &levellist[levelindex];
+    level->vertexalloc = input->vertexcount;
+    level->trialloc = input->tricount;
+    level->vertexstride = 3 * sizeof(float);
+    level->indicesstride = 3 * sizeof(uint32_t);
+    level->vertex = malloc( level->vertexalloc * level->vertexstride );
+    level->indices = malloc( level->trialloc * level->indicesstride );
+    level->vertexsource = malloc( level->vertexalloc * sizeof(uint32_t) );
+  }
+  mdOperationLevels( &op, levellist, TEST_LEVEL_COUNT );
+  snprintf( name, sizeof(name), "threads %d flags 0x%x", threadcount, flags );
+  MT_CHECK( mdMeshDecimation( &op, threadcount, flags ), "%s : decimation failed", name );
+
+  for( levelindex = 0 ; levelindex < TEST_LEVEL_COUNT ; levelindex++ )
+  {
+    level = &levellist[levelindex];
+    snprintf( name, sizeof(name), "threads %d flags 0x%x level %d", threadcount, flags, levelindex );
+    MT_CHECK( ( level->vertexcount ) && ( level->vertexcount <= level->vertexalloc ), "%s : %d vertices not written", name, (int)level->vertexcount );
+    if( !( level->vertexcount ) || ( level->vertexcount > level->vertexalloc ) )
+      continue;
+    mtMeshCheckManifold( name, level->indices, level->tricount, level->vertexcount );
+    /* Level vertices keep the relative order of the input vertices they derive from */
+    for( vertexindex = 0 ; vertexindex < level->vertexcount ; vertexindex++ )
+    {
+      if( ( level->vertexsource[vertexindex] >= input->vertexcount ) || ( ( vertexindex ) && ( level->vertexsource[vertexindex] <= level->vertexsource[vertexindex-1] ) ) )
+        break;
+    }
+    MT_CHECK( vertexindex == level->vertexcount, "%s : vertex %d has source %d, out of range or out of order", name, (int)vertexindex, (int)level->vertexsource[vertexindex] );
+  }
+
+  /* Nothing was collapsed yet, the first level is the input mesh */
+  level = &levellist[0];
+  snprintf( name, sizeof(name), "threads %d flags 0x%x level 0", threadcount, flags );
+  MT_CHECK( ( level->vertexcount == input->vertexcount ) && ( level->tricount == input->tricount ), "%s : %d vertices %d triangles, input has %d %d", name, (int)level->vertexcount, (int)level->tricount, (int)input->vertexcount, (int)input->tricount );
+  if( level->vertexcount == input->vertexcount )
+  {
+    for( vertexindex = 0 ; vertexindex < level->vertexcount ; vertexindex++ )
+    {
+      if( level->vertexsource[vertexindex] != vertexindex )
+        break;
+      point = &((float *)level->vertex)[ vertexindex * 3 ];
+      inputpoint = &input->vertex[ vertexindex * 3 ];
+      if( ( fabsf( point[0] - inputpoint[0] ) > 0.0001f ) || ( fabsf( point[1] - inputpoint[1] ) > 0.0001f ) || ( fabsf( point[2] - inputpoint[2] ) > 0.0001f ) )
+        break;
+    }
+    MT_CHECK( vertexindex == level->vertexcount, "%s : vertex %d doesn't match the input vertex", name, (int)vertexindex );
+  }
+  if( level->tricount == input->tricount )
+  {
+    sorted = testSortTriangles( level->indices, level->tricount );
+    inputsorted = testSortTriangles( input->indices, input->tricount );
+    MT_CHECK( !( memcmp( sorted, inputsorted, input->tricount * 3 * sizeof(uint32_t) ) ), "%s : triangles don't match the input triangles", name );
+    free( inputsorted );
+    free( sorted );
+  }
+
+  for( levelindex = 0 ; levelindex < TEST_LEVEL_COUNT ; levelindex++ )
+  {
+    level = &levellist[levelindex];
+    free( level->vertex );
+    free( level->indices );
+    free( level->vertexsource );
+  }
+  mtMeshFree( &mesh );
+  return;
+}
+
+
+int main( void )
+{
+  mtMesh input;
+
+  mtMeshTorus( &input, 100, 50, 0, 0 );
+  testLevels( &input, 1, 0 );
+  testLevels( &input, 4, 0 );
+  testLevels( &input, 1, MD_FLAGS_REORDER_MESH );
+  testLevels( &input, 4, MD_FLAGS_REORDER_MESH );
+  mtMeshFree( &input );
+
+  return mtReport( "test-levels" );
+}
@@ -0,0 +1,107 @@
+/* *****************************************************************************
+ *
+ * Copyright (c) 2012-2023 Alexis Naveros.
+ * Portions developed under contract to the SURVICE Engineering Company.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * *****************************************************************************
+ */
+
+
+/*
+ * OBJ files with comments, on lines of their own and trailing vertex and face
+ * lines.
+ */
+
+#include "mmtest.h"
+
+#include "meshloader.h"
+
+
+static const char testObjText[] =
+  "# Square pyramid\n"
+  "v 0 0 0\n"
+  "v 1 0 0 # trailing comment\n"
+  "v 1 1 0\n"
+  "v 0 1 0#comment without space\n"
+  "  # indented comment\n"
+  "v 0.5 0.5 1\n"
+  "f 4 3 2 1 # base quad\n"
+  "f 1 2 5#comment without space\n"
+  "f 2/2 3/3 5/5 #\n"
+  "f 3//3 4//4 5//5 # 1 2 3\n"
+  "f 4/4/4 1/1/1 5/5/5\t# tab\r\n";
+
+static const uint32_t testObjIndices[] =
+{
+  3, 2, 1,
+  3, 1, 0,
+  0, 1, 4,
+  1, 2, 4,
+  2, 3, 4,
+  3, 0, 4
+};
+
+static void testObj( const char *path, int threadcount )
+{
+  size_t triindex;
+  uint32_t *indices;
+  float *point;
+  mlMesh mesh;
+  char name[128];
+
+  snprintf( name, sizeof(name), "threads %d", threadcount );
+  memset( &mesh, 0, sizeof(mlMesh) );
+  MT_CHECK( mlMeshLoad( &mesh, path, ML_FILE_OBJ, threadcount, 0 ), "%s : load failed", name );
+  MT_CHECK( ( mesh.vertexcount == 5 ) && ( mesh.tricount == 6 ), "%s : %d vertices %d triangles, expected 5 6", name, (int)mesh.vertexcount, (int)mesh.tricount );
+  if( ( mesh.vertexcount == 5 ) && ( mesh.tricount == 6 ) )
+  {
+    for( triindex = 0 ; triindex < mesh.tricount ; triindex++ )
+    {
+      indices = (uint32_t *)( (char *)mesh.indices + ( triindex * mesh.indicesstride ) );
+      if( memcmp( indices, &testObjIndices[ triindex * 3 ], 3 * sizeof(uint32_t) ) )
+        break;
+    }
+    MT_CHECK( triindex == mesh.tricount, "%s : triangle %d doesn't match", name, (int)triindex );
+    point = (float *)( (char *)mesh.vertex + ( 4 * mesh.vertexstride ) );
+    MT_CHECK( ( point[0] == 0.5f ) && ( point[1] == 0.5f ) && ( point[2] == 1.0f ), "%s : vertex 4 is %f %f %f", name, point[0], point[1], point[2] );
+  }
+  mlMeshFree( &mesh );
+  return;
+}
+
+
+int main( void )
+{
+  const char *path;
+  FILE *file;
+
+  path = "test-loader.obj";
+  file = fopen( path, "wb" );
+  MT_CHECK( file != 0, "failed to write %s", path );
+  if( file )
+  {
+    fwrite( testObjText, 1, sizeof(testObjText) - 1, file );
+    fclose( file );
+    testObj( path, 1 );
+    testObj( path, 4 );
+    remove( path );
+  }
+
+  return mtReport( "test-loader" );
+}
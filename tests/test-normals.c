@@ -0,0 +1,137 @@
+/* *****************************************************************************
+ *
+ * Copyright (c) 2012-2023 Alexis Naveros.
+ * Portions developed under contract to the SURVICE Engineering Company.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * *****************************************************************************
+ */
+
+
+/*
+ * Vertex normals built by the worker threads, with and without vertex
+ * splitting, with spare vertices allocated for clones.
+ *
+ * Each thread appends its clones to its own part of the spare vertices. The
+ * output must hold exactly the input vertices plus the clones, without the
+ * unused spare vertices in between.
+ */
+
+#include "mmtest.h"
+
+
+typedef struct
+{
+  uint32_t *sourcelist;
+} testCopy;
+
+static void testVertexCopy( void *copycontext, int dstindex, int srcindex )
+{
+  testCopy *copy;
+  copy = copycontext;
+  copy->sourcelist[dstindex] = copy->sourcelist[srcindex];
+  return;
+}
+
+
+static void testNormals( mtMesh *input, int threadcount, int flags, int decimate )
+{
+  size_t vertexindex;
+  mtMesh mesh;
+  mdOperation op;
+  float *normals, *normal, length;
+  uint8_t *usedlist;
+  testCopy copy;
+  char name[128];
+
+  snprintf( name, sizeof(name), "threads %d flags 0x%x decimate %d", threadcount, flags, decimate );
+  mtMeshCopy( &mesh, input );
+  mtMeshOperation( &op, &mesh, 0.2 );
+  normals = calloc( mesh.vertexalloc, 3 * sizeof(float) );
+  mdOperationComputeNormals( &op, normals, MD_FORMAT_FLOAT, 3 * sizeof(float) );
+  copy.sourcelist = malloc( mesh.vertexalloc * sizeof(uint32_t) );
+  for( vertexindex = 0 ; vertexindex < mesh.vertexalloc ; vertexindex++ )
+    copy.sourcelist[vertexindex] = (uint32_t)vertexindex;
+  mdOperationVertexCopy( &op, testVertexCopy, &copy );
+  if( !( decimate ) )
+    flags |= MD_FLAGS_NO_DECIMATION;
+  MT_CHECK( mdMeshDecimation( &op, threadcount, flags ), "%s : decimation failed", name );
+  mtMeshCheckManifold( name, mesh.indices, op.tricount, op.vertexcount );
+  MT_CHECK( op.vertexcount <= mesh.vertexalloc, "%s : %d vertices above vertexalloc", name, (int)op.vertexcount );
+  if( !( flags & MD_FLAGS_NORMAL_VERTEX_SPLITTING ) && ( flags & MD_FLAGS_NO_VERTEX_PACKING ) )
+    MT_CHECK( op.vertexcount == input->vertexcount, "%s : %d vertices, expected %d", name, (int)op.vertexcount, (int)input->vertexcount );
+  if( flags & MD_FLAGS_NORMAL_VERTEX_SPLITTING )
+    MT_CHECK( op.vertexcount > ( decimate ? op.tricount / 2 : input->vertexcount ), "%s : %d vertices, no vertex was split", name, (int)op.vertexcount );
+
+  /* Every vertex past the input vertices is a clone, used by triangles, with a unit normal */
+  usedlist = calloc( mesh.vertexalloc, 1 );
+  for( vertexindex = 0 ; vertexindex < op.tricount * 3 ; vertexindex++ )
+  {
+    if( mesh.indices[vertexindex] < op.vertexcount )
+      usedlist[ mesh.indices[vertexindex] ] = 1;
+  }
+  for( vertexindex = 0 ; vertexindex < op.vertexcount ; vertexindex++ )
+  {
+    if( !( usedlist[vertexindex] ) )
+    {
+      if( ( vertexindex >= input->vertexcount ) || !( flags & MD_FLAGS_NO_VERTEX_PACKING ) )
+        break;
+      continue;
+    }
+    normal = &normals[ vertexindex * 3 ];
+    length = sqrtf( ( normal[0] * normal[0] ) + ( normal[1] * normal[1] ) + ( normal[2] * normal[2] ) );
+    if( fabsf( length - 1.0f ) > 0.001f )
+      break;
+  }
+  MT_CHECK( vertexindex == op.vertexcount, "%s : vertex %d of %d is unused or has no normal", name, (int)vertexindex, (int)op.vertexcount );
+  for( vertexindex = input->vertexcount ; vertexindex < op.vertexcount ; vertexindex++ )
+  {
+    if( ( copy.sourcelist[vertexindex] >= input->vertexcount ) || memcmp( &mesh.vertex[ vertexindex * 3 ], &mesh.vertex[ copy.sourcelist[vertexindex] * 3 ], 3 * sizeof(float) ) )
+      break;
+  }
+  if( flags & MD_FLAGS_NO_VERTEX_PACKING )
+    MT_CHECK( vertexindex >= op.vertexcount, "%s : clone %d doesn't match its source vertex %d", name, (int)vertexindex, (int)copy.sourcelist[vertexindex] );
+
+  free( usedlist );
+  free( copy.sourcelist );
+  free( normals );
+  mtMeshFree( &mesh );
+  return;
+}
+
+
+int main( void )
+{
+  int threadcount, flagsindex;
+  mtMesh input;
+  static const int flagslist[] = { 0, MD_FLAGS_NO_VERTEX_PACKING, MD_FLAGS_NORMAL_VERTEX_SPLITTING, MD_FLAGS_NORMAL_VERTEX_SPLITTING | MD_FLAGS_NO_VERTEX_PACKING };
+
+  /* Hexagonal tube, 20000 vertices with room for as many clones */
+  mtMeshTorus( &input, 400, 50, 6, 40000 );
+  for( threadcount = 1 ; threadcount <= 4 ; threadcount += 3 )
+  {
+    for( flagsindex = 0 ; flagsindex < (int)( sizeof(flagslist) / sizeof(int) ) ; flagsindex++ )
+    {
+      testNormals( &input, threadcount, flagslist[flagsindex], 0 );
+      testNormals( &input, threadcount, flagslist[flagsindex], 1 );
+    }
+  }
+  mtMeshFree( &input );
+
+  return mtReport( "test-normals" );
+}
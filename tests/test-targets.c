@@ -0,0 +1,80 @@
+/* *****************************************************************************
+ *
+ * Copyright (c) 2012-2023 Alexis Naveros.
+ * Portions developed under contract to the SURVICE Engineering Company.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * *****************************************************************************
+ */
+
+
+/*
+ * Multithreaded decimation to a target vertex count.
+ *
+ * When one thread reached targetvertexcountmin or targetvertexcountmax, it
+ * used to leave the decimation loop while the other threads waited for it at
+ * the next step barrier, and the decimation never returned. A hang fails
+ * this test through the ctest timeout.
+ */
+
+#include "mmtest.h"
+
+
+static void testTarget( mtMesh *input, int threadcount, int flags, size_t targetmin, size_t targetmax )
+{
+  mtMesh mesh;
+  mdOperation op;
+  char name[128];
+
+  snprintf( name, sizeof(name), "threads %d flags 0x%x min %d max %d", threadcount, flags, (int)targetmin, (int)targetmax );
+  mtMeshCopy( &mesh, input );
+  mtMeshOperation( &op, &mesh, 0.02 );
+  op.targetvertexcountmin = targetmin;
+  op.targetvertexcountmax = targetmax;
+  MT_CHECK( mdMeshDecimation( &op, threadcount, flags ), "%s : decimation failed", name );
+  if( targetmax )
+    MT_CHECK( op.vertexcount <= targetmax, "%s : %d vertices above the target", name, (int)op.vertexcount );
+  if( targetmin )
+    MT_CHECK( op.vertexcount + threadcount >= targetmin, "%s : %d vertices below the target", name, (int)op.vertexcount );
+  mtMeshCheckManifold( name, mesh.indices, op.tricount, op.vertexcount );
+  mtMeshFree( &mesh );
+  return;
+}
+
+
+int main( void )
+{
+  int threadindex;
+  mtMesh input;
+  static const int threadcountlist[] = { 1, 2, 4 };
+  static const int flagslist[] = { 0, MD_FLAGS_WORK_STEALING, MD_FLAGS_ASYNC_STEPS };
+  int flagsindex;
+
+  mtMeshGrid( &input, 80 );
+  for( threadindex = 0 ; threadindex < (int)( sizeof(threadcountlist) / sizeof(int) ) ; threadindex++ )
+  {
+    for( flagsindex = 0 ; flagsindex < (int)( sizeof(flagslist) / sizeof(int) ) ; flagsindex++ )
+    {
+      testTarget( &input, threadcountlist[threadindex], flagslist[flagsindex], 0, 800 );
+      testTarget( &input, threadcountlist[threadindex], flagslist[flagsindex], 3000, 0 );
+    }
+  }
+  mtMeshFree( &input );
+
+  return mtReport( "test-targets" );
+}
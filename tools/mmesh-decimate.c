@@ -0,0 +1,589 @@
+/* *****************************************************************************
+ *
+ * Copyright (c) 2012-2023 Alexis Naveros.
+ * Portions developed under contract to the SURVICE Engineering Company.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * *****************************************************************************
+ */
+
+/*
+ * Batch decimation of a directory or manifest of meshes.
+ *
+ * Meshes are loaded in groups bounded by a count of triangles, and each group
+ * is decimated by mdMeshDecimationBatch(): large meshes get all threads one
+ * at a time, small meshes are decimated concurrently one per thread. Per-mesh
+ * counts and timings are written to a CSV or JSON report.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32)
+ #include <windows.h>
+#else
+ #include <dirent.h>
+#endif
+
+#include "meshdecimation.h"
+#include "meshloader.h"
+
+
+#define DEC_GROUP_TRICOUNT_DEFAULT (1<<26)
+
+
+////
+
+
+typedef struct
+{
+  char *path;
+  char *name;
+  /* Name written in the output directory, the source name with .obj appended unless already OBJ */
+  char *outname;
+  /* Same output name as an earlier mesh, not decimated */
+  int collision;
+
+  /* Mesh data, MD_FORMAT_FLOAT vertices and MD_FORMAT_UINT32 indices, possibly pointing into the file mapping */
+  mlMesh data;
+  size_t vertexcount;
+  size_t tricount;
+
+  /* Input counts, load time and result */
+  size_t invertexcount;
+  size_t intricount;
+  long loadmsecs;
+  int loaded;
+  int done;
+  mdOperation op;
+} decMesh;
+
+typedef struct
+{
+  decMesh *meshlist;
+  int meshcount;
+  int meshalloc;
+} decList;
+
+
+static long decGetMilliseconds( void )
+{
+  struct timespec ts;
+  timespec_get( &ts, TIME_UTC );
+  return ( (long)ts.tv_sec * 1000 ) + ( (long)ts.tv_nsec / 1000000 );
+}
+
+static const char *decPathName( const char *path )
+{
+  const char *name;
+  for( name = path ; *path ; path++ )
+  {
+    if( ( *path == '/' ) || ( *path == '\\' ) )
+      name = path + 1;
+  }
+  return name;
+}
+
+static int decHasExtension( const char *path, const char *ext )
+{
+  size_t pathlen, extlen;
+  const char *s;
+  pathlen = strlen( path );
+  extlen = strlen( ext );
+  if( pathlen <= extlen )
+    return 0;
+  for( s = &path[ pathlen - extlen ] ; *ext ; s++, ext++ )
+  {
+    if( ( ( *s >= 'A' ) && ( *s <= 'Z' ) ? *s + ( 'a' - 'A' ) : *s ) != *ext )
+      return 0;
+  }
+  return 1;
+}
+
+static int decIsMeshFile( const char *path )
+{
+  return ( decHasExtension( path, ".obj" ) || decHasExtension( path, ".ply" ) || decHasExtension( path, ".stl" ) );
+}
+
+static char *decStrDup( const char *s )
+{
+  char *d;
+  d = malloc( strlen( s ) + 1 );
+  if( d )
+    strcpy( d, s );
+  return d;
+}
+
+
+////
+
+
+static void decListAdd( decList *list, const char *path )
+{
+  decMesh *mesh;
+  if( list->meshcount >= list->meshalloc )
+  {
+    list->meshalloc = ( list->meshalloc ? list->meshalloc << 1 : 64 );
+    list->meshlist = realloc( list->meshlist, list->meshalloc * sizeof(decMesh) );
+  }
+  mesh = &list->meshlist[ list->meshcount++ ];
+  memset( mesh, 0, sizeof(decMesh) );
+  mesh->path = decStrDup( path );
+  mesh->name = decStrDup( decPathName( path ) );
+  /* Keep the source extension, x.ply and x.obj must not both be written as x.obj */
+  mesh->outname = malloc( strlen( mesh->name ) + 5 );
+  strcpy( mesh->outname, mesh->name );
+  if( !( decHasExtension( mesh->name, ".obj" ) ) )
+    strcat( mesh->outname, ".obj" );
+  return;
+}
+
+static int decListCompare( const void *p0, const void *p1 )
+{
+  const decMesh *mesh0, *mesh1;
+  mesh0 = p0;
+  mesh1 = p1;
+  return strcmp( mesh0->path, mesh1->path );
+}
+
+static int decListCompareOutName( const void *p0, const void *p1 )
+{
+  int cmp;
+  const decMesh *mesh0, *mesh1;
+  mesh0 = *(const decMesh * const *)p0;
+  mesh1 = *(const decMesh * const *)p1;
+  cmp = strcmp( mesh0->outname, mesh1->outname );
+  /* Ties in list order, the first mesh listed keeps the name */
+  if( !( cmp ) )
+    cmp = ( mesh0 < mesh1 ? -1 : 1 );
+  return cmp;
+}
+
+/* Flag meshes that would overwrite the output of an earlier mesh, as listed from different directories of a manifest */
+static int decListCheckCollisions( decList *list )
+{
+  int index, collisioncount;
+  decMesh **sortlist;
+
+  collisioncount = 0;
+  if( list->meshcount < 2 )
+    return 0;
+  sortlist = malloc( list->meshcount * sizeof(decMesh *) );
+  for( index = 0 ; index < list->meshcount ; index++ )
+    sortlist[index] = &list->meshlist[index];
+  qsort( sortlist, list->meshcount, sizeof(decMesh *), decListCompareOutName );
+  for( index = 1 ; index < list->meshcount ; index++ )
+  {
+    if( strcmp( sortlist[index]->outname, sortlist[index-1]->outname ) )
+      continue;
+    sortlist[index]->collision = 1;
+    fprintf( stderr, "ERROR: %s would overwrite the output %s of %s, skipped\n", sortlist[index]->path, sortlist[index]->outname, sortlist[index-1]->path );
+    collisioncount++;
+  }
+  free( sortlist );
+  return collisioncount;
+}
+
+/* Add all supported meshes of a directory, sorted by name */
+static int decListDirectory( decList *list, const char *dirpath )
+{
+  int basecount;
+  char path[4096];
+#if defined(_WIN32)
+  HANDLE handle;
+  WIN32_FIND_DATAA finddata;
+  snprintf( path, sizeof(path), "%s\\*", dirpath );
+  handle = FindFirstFileA( path, &finddata );
+  if( handle == INVALID_HANDLE_VALUE )
+    return 0;
+  basecount = list->meshcount;
+  do
+  {
+    if( finddata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY )
+      continue;
+    if( !( decIsMeshFile( finddata.cFileName ) ) )
+      continue;
+    snprintf( path, sizeof(path), "%s\\%s", dirpath, finddata.cFileName );
+    decListAdd( list, path );
+  } while( FindNextFileA( handle, &finddata ) );
+  FindClose( handle );
+#else
+  DIR *dir;
+  struct dirent *entry;
+  dir = opendir( dirpath );
+  if( !( dir ) )
+    return 0;
+  basecount = list->meshcount;
+  while( ( entry = readdir( dir ) ) )
+  {
+    if( !( decIsMeshFile( entry->d_name ) ) )
+      continue;
+    snprintf( path, sizeof(path), "%s/%s", dirpath, entry->d_name );
+    decListAdd( list, path );
+  }
+  closedir( dir );
+#endif
+  qsort( &list->meshlist[basecount], list->meshcount - basecount, sizeof(decMesh), decListCompare );
+  return 1;
+}
+
+/* Add the meshes listed in a manifest, one path per line, blank lines and lines starting with '#' are skipped */
+static int decListManifest( decList *list, const char *manifestpath )
+{
+  size_t len;
+  char line[4096];
+  FILE *file;
+  file = fopen( manifestpath, "r" );
+  if( !( file ) )
+    return 0;
+  while( fgets( line, sizeof(line), file ) )
+  {
+    len = strlen( line );
+    while( ( len ) && ( ( line[len-1] == '\n' ) || ( line[len-1] == '\r' ) || ( line[len-1] == ' ' ) || ( line[len-1] == '\t' ) ) )
+      line[--len] = 0;
+    if( !( len ) || ( line[0] == '#' ) )
+      continue;
+    decListAdd( list, line );
+  }
+  fclose( file );
+  return 1;
+}
+
+
+////
+
+
+static int decMeshSaveObj( decMesh *mesh, const char *path )
+{
+  size_t index;
+  float *vertex;
+  uint32_t *indices;
+  mlMesh *data;
+  FILE *file;
+
+  file = fopen( path, "w" );
+  if( !( file ) )
+    return 0;
+  fprintf( file, "# %s decimated by mmesh-decimate, %ld vertices, %ld triangles\n", mesh->name, (long)mesh->vertexcount, (long)mesh->tricount );
+  data = &mesh->data;
+  for( index = 0 ; index < mesh->vertexcount ; index++ )
+  {
+    vertex = (float *)( (char *)data->vertex + ( index * data->vertexstride ) );
+    fprintf( file, "v %.9g %.9g %.9g\n", vertex[0], vertex[1], vertex[2] );
+  }
+  for( index = 0 ; index < mesh->tricount ; index++ )
+  {
+    indices = (uint32_t *)( (char *)data->indices + ( index * data->indicesstride ) );
+    fprintf( file, "f %lu %lu %lu\n", (unsigned long)indices[0] + 1, (unsigned long)indices[1] + 1, (unsigned long)indices[2] + 1 );
+  }
+  if( fclose( file ) )
+    return 0;
+  return 1;
+}
+
+static void decMeshFree( decMesh *mesh )
+{
+  mlMeshFree( &mesh->data );
+  return;
+}
+
+
+////
+
+
+typedef struct
+{
+  int threadcount;
+  int flags;
+  int precision;
+  double featuresize;
+  size_t grouptricount;
+  const char *outputdir;
+  const char *reportpath;
+  int verbose;
+} decConfig;
+
+/* Decimate a group of loaded meshes on the shared pool of threads, then write them out */
+static void decRunGroup( decConfig *config, decMesh *meshlist, int meshcount )
+{
+  int index, opcount;
+  char path[4096];
+  mdOperation *oplist, *op;
+  decMesh *mesh;
+  mdBatchReport report;
+
+  oplist = malloc( meshcount * sizeof(mdOperation) );
+  opcount = 0;
+  for( index = 0 ; index < meshcount ; index++ )
+  {
+    mesh = &meshlist[index];
+    if( !( mesh->loaded ) )
+      continue;
+    op = &oplist[opcount++];
+    mdOperationInit( op );
+    mdOperationData( op, mesh->data.vertexcount, mesh->data.vertex, MD_FORMAT_FLOAT, mesh->data.vertexstride, mesh->data.tricount, mesh->data.indices, MD_FORMAT_UINT32, mesh->data.indicesstride );
+    mdOperationStrength( op, config->featuresize );
+    mdOperationPrecision( op, config->precision );
+  }
+  if( opcount )
+  {
+    mdMeshDecimationBatch( oplist, opcount, config->threadcount, config->flags, &report );
+    if( config->verbose )
+      printf( "Group of %ld meshes, %ld triangles : %ld msecs, %.0f triangles/sec\n", report.meshcount + report.failcount, (long)report.tricount, report.msecs, report.tripersec );
+  }
+
+  opcount = 0;
+  for( index = 0 ; index < meshcount ; index++ )
+  {
+    mesh = &meshlist[index];
+    if( !( mesh->loaded ) )
+      continue;
+    mesh->op = oplist[opcount++];
+    mesh->done = !( mesh->op.failureflag );
+    if( mesh->done )
+    {
+      mesh->vertexcount = mesh->op.vertexcount;
+      mesh->tricount = mesh->op.tricount;
+      if( config->outputdir )
+      {
+        snprintf( path, sizeof(path), "%s/%s", config->outputdir, mesh->outname );
+        if( !( decMeshSaveObj( mesh, path ) ) )
+        {
+          fprintf( stderr, "ERROR: Failed to write %s\n", path );
+          mesh->done = 0;
+        }
+      }
+    }
+    if( config->verbose )
+      printf( "  %-40s %s\n", mesh->name, ( mesh->done ? "done" : "FAILED" ) );
+    decMeshFree( mesh );
+  }
+
+  free( oplist );
+  return;
+}
+
+
+////
+
+
+static void decWriteJsonString( FILE *file, const char *s )
+{
+  fputc( '"', file );
+  for( ; *s ; s++ )
+  {
+    if( ( *s == '"' ) || ( *s == '\\' ) )
+      fputc( '\\', file );
+    if( (unsigned char)*s < 0x20 )
+      continue;
+    fputc( *s, file );
+  }
+  fputc( '"', file );
+  return;
+}
+
+/* Quoted CSV field, quotes within are doubled */
+static void decWriteCsvString( FILE *file, const char *s )
+{
+  fputc( '"', file );
+  for( ; *s ; s++ )
+  {
+    if( *s == '"' )
+      fputc( '"', file );
+    fputc( *s, file );
+  }
+  fputc( '"', file );
+  return;
+}
+
+/* Write per-mesh counts and timings, as JSON if the path ends with .json, CSV otherwise */
+static int decWriteReport( decConfig *config, decList *list )
+{
+  int index, jsonflag;
+  const char *status;
+  decMesh *mesh;
+  FILE *file;
+
+  file = fopen( config->reportpath, "w" );
+  if( !( file ) )
+    return 0;
+  jsonflag = decHasExtension( config->reportpath, ".json" );
+  if( jsonflag )
+    fprintf( file, "[\n" );
+  else
+    fprintf( file, "mesh,status,vertices_in,triangles_in,vertices_out,triangles_out,decimations,collisions,msecs,load_msecs\n" );
+  for( index = 0 ; index < list->meshcount ; index++ )
+  {
+    mesh = &list->meshlist[index];
+    status = ( mesh->collision ? "name_collision" : ( !( mesh->loaded ) ? "load_failed" : ( mesh->done ? "ok" : "failed" ) ) );
+    if( jsonflag )
+    {
+      fprintf( file, "  { \"mesh\": " );
+      decWriteJsonString( file, mesh->path );
+      fprintf( file, ", \"status\": \"%s\", \"vertices_in\": %lu, \"triangles_in\": %lu, \"vertices_out\": %lu, \"triangles_out\": %lu, \"decimations\": %ld, \"collisions\": %ld, \"msecs\": %ld, \"load_msecs\": %ld }%s\n", status, (unsigned long)mesh->invertexcount, (unsigned long)mesh->intricount, (unsigned long)mesh->vertexcount, (unsigned long)mesh->tricount, mesh->op.decimationcount, mesh->op.collisioncount, mesh->op.msecs, mesh->loadmsecs, ( index + 1 < list->meshcount ? "," : "" ) );
+    }
+    else
+    {
+      decWriteCsvString( file, mesh->path );
+      fprintf( file, ",%s,%lu,%lu,%lu,%lu,%ld,%ld,%ld,%ld\n", status, (unsigned long)mesh->invertexcount, (unsigned long)mesh->intricount, (unsigned long)mesh->vertexcount, (unsigned long)mesh->tricount, mesh->op.decimationcount, mesh->op.collisioncount, mesh->op.msecs, mesh->loadmsecs );
+    }
+  }
+  if( jsonflag )
+    fprintf( file, "]\n" );
+  if( fclose( file ) )
+    return 0;
+  return 1;
+}
+
+
+////
+
+
+static void decUsage( const char *argv0 )
+{
+  printf( "Usage: %s [options] <directory|manifest>\n", argv0 );
+  printf( "  Decimate all .obj, .ply and .stl meshes of a directory, or all meshes listed in a manifest, one path per line\n" );
+  printf( "  -o outputdir    Write decimated meshes to this directory as OBJ, under their original name\n" );
+  printf( "                  with .obj appended unless already OBJ, as x.ply.obj for x.ply\n" );
+  printf( "  -r report       Write per-mesh report, JSON if the name ends with .json, CSV otherwise\n" );
+  printf( "  -t threadcount  Decimation thread count, shared by concurrent meshes (default all cpus)\n" );
+  printf( "  -f featuresize  Decimation feature size (default 0.01)\n" );
+  printf( "  -p precision    Decimation precision, double or float (default double)\n" );
+  printf( "  -F flags        Decimation MD_FLAGS_* value (default 0)\n" );
+  printf( "  -g tricount     Triangles loaded in memory at once, per group of meshes (default %d)\n", DEC_GROUP_TRICOUNT_DEFAULT );
+  printf( "  -q              Quiet, only report errors\n" );
+  return;
+}
+
+
+int main( int argc, char **argv )
+{
+  int argindex, index, groupbase, donecount, failcount;
+  size_t grouptricount;
+  long msecs;
+  const char *inputpath;
+  decConfig config;
+  decList list;
+  decMesh *mesh;
+
+  memset( &config, 0, sizeof(decConfig) );
+  config.threadcount = 0;
+  config.featuresize = 0.01;
+  config.precision = MD_PRECISION_DOUBLE;
+  config.grouptricount = DEC_GROUP_TRICOUNT_DEFAULT;
+  config.verbose = 1;
+  inputpath = 0;
+  for( argindex = 1 ; argindex < argc ; argindex++ )
+  {
+    if( ( !( strcmp( argv[argindex], "-o" ) ) ) && ( argindex + 1 < argc ) )
+      config.outputdir = argv[++argindex];
+    else if( ( !( strcmp( argv[argindex], "-r" ) ) ) && ( argindex + 1 < argc ) )
+      config.reportpath = argv[++argindex];
+    else if( ( !( strcmp( argv[argindex], "-t" ) ) ) && ( argindex + 1 < argc ) )
+      config.threadcount = atoi( argv[++argindex] );
+    else if( ( !( strcmp( argv[argindex], "-f" ) ) ) && ( argindex + 1 < argc ) )
+      config.featuresize = atof( argv[++argindex] );
+    else if( ( !( strcmp( argv[argindex], "-p" ) ) ) && ( argindex + 1 < argc ) )
+      config.precision = ( strcmp( argv[++argindex], "float" ) ? MD_PRECISION_DOUBLE : MD_PRECISION_FLOAT );
+    else if( ( !( strcmp( argv[argindex], "-F" ) ) ) && ( argindex + 1 < argc ) )
+      config.flags = (int)strtol( argv[++argindex], 0, 0 );
+    else if( ( !( strcmp( argv[argindex], "-g" ) ) ) && ( argindex + 1 < argc ) )
+      config.grouptricount = (size_t)strtoul( argv[++argindex], 0, 0 );
+    else if( !( strcmp( argv[argindex], "-q" ) ) )
+      config.verbose = 0;
+    else if( ( argv[argindex][0] != '-' ) && !( inputpath ) )
+      inputpath = argv[argindex];
+    else
+    {
+      decUsage( argv[0] );
+      return 1;
+    }
+  }
+  if( !( inputpath ) )
+  {
+    decUsage( argv[0] );
+    return 1;
+  }
+
+  memset( &list, 0, sizeof(decList) );
+  if( !( decListDirectory( &list, inputpath ) ) && !( decListManifest( &list, inputpath ) ) )
+  {
+    fprintf( stderr, "ERROR: Failed to read directory or manifest %s\n", inputpath );
+    return 1;
+  }
+  if( config.outputdir )
+    decListCheckCollisions( &list );
+
+  /* Load meshes until the group is full, then decimate the whole group on all threads */
+  msecs = decGetMilliseconds();
+  groupbase = 0;
+  grouptricount = 0;
+  for( index = 0 ; index < list.meshcount ; index++ )
+  {
+    mesh = &list.meshlist[index];
+    if( !( mesh->collision ) )
+      mesh->loaded = mlMeshLoad( &mesh->data, mesh->path, ML_FILE_AUTO, config.threadcount, 0 );
+    mesh->loadmsecs = mesh->data.msecs;
+    mesh->vertexcount = mesh->data.vertexcount;
+    mesh->tricount = mesh->data.tricount;
+    mesh->invertexcount = mesh->vertexcount;
+    mesh->intricount = mesh->tricount;
+    if( !( mesh->loaded ) && !( mesh->collision ) )
+    {
+      fprintf( stderr, "ERROR: Failed to load %s\n", mesh->path );
+      decMeshFree( mesh );
+    }
+    grouptricount += mesh->tricount;
+    if( ( grouptricount >= config.grouptricount ) || ( index + 1 == list.meshcount ) )
+    {
+      decRunGroup( &config, &list.meshlist[groupbase], index + 1 - groupbase );
+      groupbase = index + 1;
+      grouptricount = 0;
+    }
+  }
+  msecs = decGetMilliseconds() - msecs;
+
+  donecount = 0;
+  failcount = 0;
+  for( index = 0 ; index < list.meshcount ; index++ )
+  {
+    if( list.meshlist[index].done )
+      donecount++;
+    else
+      failcount++;
+  }
+  if( config.verbose )
+    printf( "Decimated %d meshes, %d failed, %ld msecs\n", donecount, failcount, msecs );
+  if( ( config.reportpath ) && !( decWriteReport( &config, &list ) ) )
+  {
+    fprintf( stderr, "ERROR: Failed to write report %s\n", config.reportpath );
+    failcount++;
+  }
+
+  for( index = 0 ; index < list.meshcount ; index++ )
+  {
+    free( list.meshlist[index].path );
+    free( list.meshlist[index].name );
+    free( list.meshlist[index].outname );
+  }
+  free( list.meshlist );
+  return ( failcount ? 1 : 0 );
+}